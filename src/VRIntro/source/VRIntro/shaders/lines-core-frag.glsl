@@ -0,0 +1,7 @@
+#version 150
+in vec4 oColor;
+out vec4 fragColor;
+
+void main(void) {
+  fragColor = oColor;
+}
@@ -0,0 +1,22 @@
+#version 150
+// shaders/lines for core profile contexts, where attribute and varying are gone.
+uniform mat4 projection_times_model_view_matrix;
+uniform vec4 color;
+uniform vec3 offset;
+// The alpha falls off as fade_brightness/(fade_softness + squared distance from fade_center),
+// unless fade_brightness is zero.
+uniform vec3 fade_center;
+uniform float fade_brightness;
+uniform float fade_softness;
+in vec3 position;
+out vec4 oColor;
+
+void main(void) {
+  vec3 p = position + offset;
+  gl_Position = projection_times_model_view_matrix * vec4(p, 1.0);
+  oColor = color;
+  if (fade_brightness > 0.0) {
+    vec3 d = p - fade_center;
+    oColor.a *= min(1.0, fade_brightness/(fade_softness + dot(d, d)));
+  }
+}
@@ -0,0 +1,6 @@
+#version 120
+varying vec4 oColor;
+
+void main(void) {
+  gl_FragColor = oColor;
+}
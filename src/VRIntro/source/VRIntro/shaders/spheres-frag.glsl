@@ -0,0 +1,17 @@
+#version 120
+// The lighting of the material shader, with the sphere's color as both its diffuse and ambient color.
+uniform vec3 light_position;
+uniform float ambient_lighting_proportion;
+uniform float alpha;
+
+varying vec3 out_position;
+varying vec3 out_normal;
+varying vec3 out_color;
+
+void main(void) {
+  vec3 surface_normal = normalize(out_normal);
+  vec3 light_dir = normalize(light_position - out_position);
+  float diffuse_brightness = max(0.0, dot(light_dir, surface_normal));
+  float brightness = ambient_lighting_proportion + (1.0 - ambient_lighting_proportion)*diffuse_brightness;
+  gl_FragColor = vec4(brightness*out_color, alpha);
+}
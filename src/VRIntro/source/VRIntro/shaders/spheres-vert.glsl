@@ -0,0 +1,23 @@
+#version 120
+uniform mat4 projection_times_model_view_matrix;
+uniform mat4 model_view_matrix;
+uniform mat4 normal_matrix;
+
+// A point of the unit sphere, which is also its normal.
+attribute vec3 position;
+// The center (xyz) and radius (w) of the sphere, and its color.  These advance once per instance
+// when the spheres are drawn instanced, and are otherwise set as constants before each sphere.
+attribute vec4 sphere;
+attribute vec3 sphere_color;
+
+varying vec3 out_position;
+varying vec3 out_normal;
+varying vec3 out_color;
+
+void main(void) {
+  vec4 world = vec4(sphere.xyz + sphere.w*position, 1.0);
+  gl_Position = projection_times_model_view_matrix * world;
+  out_position = (model_view_matrix * world).xyz;
+  out_normal = (normal_matrix * vec4(position, 0.0)).xyz;
+  out_color = sphere_color;
+}
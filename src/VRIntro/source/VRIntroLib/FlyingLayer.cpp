@@ -33,6 +33,19 @@ FlyingLayer::FlyingLayer(const EigenTypes::Vector3f& initialEyePos) :
   m_PopupBuffer.Bind();
   m_PopupBuffer.Allocate(edges, sizeof(edges), GL_STATIC_DRAW);
   m_PopupBuffer.Unbind();
+
+  for (int i = -50; i < 50; i+=2) {
+    for (int j = -30; j < 50; j+=20) {
+      for (int k = -50; k < 50; k+=2) {
+        EigenTypes::Vector3f a(static_cast<float>(i), static_cast<float>(j), static_cast<float>(k));
+        EigenTypes::Vector3f b(static_cast<float>(i + 2), static_cast<float>(j), static_cast<float>(k));
+        EigenTypes::Vector3f d(static_cast<float>(i), static_cast<float>(j), static_cast<float>(k + 2));
+        m_Grid.AddLine(a, b);
+        m_Grid.AddLine(a, d);
+      }
+    }
+  }
+  m_Grid.Upload();
 }
 
 void FlyingLayer::Update(TimeDelta real_time_delta) {
@@ -97,49 +110,23 @@ void FlyingLayer::Render(TimeDelta real_time_delta) const {
   //PrimitiveBase::DrawSceneGraph(m_Sphere, m_Renderer);
   m_Shader->Unbind();
 
-  glBegin(GL_LINES);
-  glVertex3fv(EigenTypes::Vector3f::Zero().eval().data());
-  glVertex3fv(m_Velocity.eval().data());
-  glEnd();
-
   //glMatrixMode(GL_MODELVIEW);
   EigenTypes::Vector3f centerpoint = m_EyePos - m_GridCenter;
   //glScalef(2.0f, 2.0f, 2.0f);
-  glMultMatrixf(m_GridOrientation.eval().data());
-  glTranslatef(m_GridCenter.x(), m_GridCenter.y(), m_GridCenter.z());
+  EigenTypes::Matrix4x4f modelView = m_ModelView*m_GridOrientation;
+  modelView.block<3, 1>(0, 3) += modelView.block<3, 3>(0, 0)*m_GridCenter;
 
   int xShift = 2*static_cast<int>(0.5f*centerpoint.x() + 0.5f);
   int yShift = 20*static_cast<int>(0.05f*centerpoint.y() + 0.5f);
   int zShift = 2*static_cast<int>(0.5f*centerpoint.z() + 0.5f);
-  glLineWidth(m_LineThickness);
-  glBegin(GL_LINES);
-  for (int i = -50 + xShift; i < 50 + xShift; i+=2) {
-    for (int j = -30 + yShift; j < 50 + yShift; j+=20) {
-      for (int k = -50 + zShift; k < 50 + zShift; k+=2) {
-        EigenTypes::Vector3f a(static_cast<float>(i), static_cast<float>(j), static_cast<float>(k));
-        EigenTypes::Vector3f b(static_cast<float>(i + 2), static_cast<float>(j), static_cast<float>(k));
-        //EigenTypes::Vector3f c(static_cast<float>(i), static_cast<float>(j + 2), static_cast<float>(k));
-        EigenTypes::Vector3f d(static_cast<float>(i), static_cast<float>(j), static_cast<float>(k + 2));
-        float aColor = std::min(1.0f, static_cast<float>(m_GridBrightness)/(20.0f + (a - centerpoint).squaredNorm()));
-        float bColor = std::min(1.0f, static_cast<float>(m_GridBrightness)/(20.0f + (b - centerpoint).squaredNorm()));
-        //float cColor = std::min(1.1f9 100.02/(10.0f + (c - centerpoint).squaredNorm()));
-        float dColor = std::min(1.0f, static_cast<float>(m_GridBrightness)/(20.0f + (d - centerpoint).squaredNorm()));
-
-        glColor4f(1.0f, 1.0f, 1.0f, m_Alpha*aColor);
-        glVertex3fv((a).eval().data());
-
-        glColor4f(1.0f, 1.0f, 1.0f, m_Alpha*bColor);
-        glVertex3fv((b).eval().data());
-
-        glColor4f(1.0f, 1.0f, 1.0f, m_Alpha*aColor);
-        glVertex3fv((a).eval().data());
-
-        glColor4f(1.0f, 1.0f, 1.0f, m_Alpha*dColor);
-        glVertex3fv((d).eval().data());
-      }
-    }
-  }
-  glEnd();
+  LineMesh::Appearance appearance;
+  appearance.color << 1.0f, 1.0f, 1.0f, m_Alpha;
+  appearance.offset << static_cast<float>(xShift), static_cast<float>(yShift), static_cast<float>(zShift);
+  appearance.fadeCenter = centerpoint;
+  appearance.fadeBrightness = static_cast<float>(m_GridBrightness);
+  appearance.fadeSoftness = 20.0f;
+  appearance.width = m_LineThickness;
+  m_Grid.Draw(modelView, m_Projection, appearance);
   //double elapsed = timer.Stop();
   //std::cout << __LINE__ << ":\t   elapsed = " << (elapsed) << std::endl;
   if (m_Palms.size() == 0) {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Interactionlayer.h"
+#include "LineMesh.h"
 
 class GLShader;
 
@@ -24,6 +25,10 @@ private:
 
   void RenderPopup() const;
 
+  // The lattice of lines around the grid's origin, which is shifted along in whole cells to
+  // stay around the eye, and faded with the distance from it, when drawn.
+  LineMesh m_Grid;
+
   EigenTypes::Vector3f m_GridCenter;
   //EigenTypes::Vector3f m_AveragePalm;
   EigenTypes::Vector3f m_Velocity;
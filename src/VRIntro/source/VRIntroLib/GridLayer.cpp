@@ -9,7 +9,13 @@ GridLayer::GridLayer(const EigenTypes::Vector3f& initialEyePos) :
   m_DivTheta(22),
   m_DivPhi(40),
   m_Radius(0.7f) {
+  BuildGrid();
+}
 
+void GridLayer::BuildGrid() {
+  m_Grid.Clear();
+  m_Grid.AddSphereGrid(m_DivTheta, m_DivPhi);
+  m_Grid.Upload();
 }
 
 void GridLayer::Update(TimeDelta real_time_delta) {
@@ -17,23 +23,13 @@ void GridLayer::Update(TimeDelta real_time_delta) {
 }
 
 void GridLayer::Render(TimeDelta real_time_delta) const {
-  glTranslatef(m_EyePos.x(), m_EyePos.y(), m_EyePos.z());
-  glColor4f(0.2f, 0.6f, 1.0f, m_Alpha*0.5f);
-  glLineWidth(1.0f);
-  glBegin(GL_LINES);
-  for (int i = 0; i < m_DivPhi; i++) {
-    float phi0 = (float)M_PI*(i/static_cast<float>(m_DivPhi) - 0.5f);
-    float phi1 = (float)M_PI*((i + 1)/static_cast<float>(m_DivPhi) - 0.5f);
-    for (int j = 0; j < m_DivTheta; j++) {
-      float theta0 = 2*(float)M_PI*(j/static_cast<float>(m_DivTheta));
-      float theta1 = 2*(float)M_PI*((j + 1)/static_cast<float>(m_DivTheta));
-      glVertex3f(m_Radius*cos(phi0)*cos(theta0), m_Radius*sin(phi0), m_Radius*cos(phi0)*sin(theta0));
-      glVertex3f(m_Radius*cos(phi0)*cos(theta1), m_Radius*sin(phi0), m_Radius*cos(phi0)*sin(theta1));
-      glVertex3f(m_Radius*cos(phi0)*cos(theta0), m_Radius*sin(phi0), m_Radius*cos(phi0)*sin(theta0));
-      glVertex3f(m_Radius*cos(phi1)*cos(theta0), m_Radius*sin(phi1), m_Radius*cos(phi1)*sin(theta0));
-    }
-  }
-  glEnd();
+  EigenTypes::Matrix4x4f modelView = m_ModelView;
+  modelView.block<3, 1>(0, 3) += modelView.block<3, 3>(0, 0)*m_EyePos;
+  modelView.block<3, 3>(0, 0) *= m_Radius;
+
+  LineMesh::Appearance appearance;
+  appearance.color << 0.2f, 0.6f, 1.0f, m_Alpha*0.5f;
+  m_Grid.Draw(modelView, m_Projection, appearance);
 }
 
 EventHandlerAction GridLayer::HandleKeyboardEvent(const SDL_KeyboardEvent &ev) {
@@ -45,6 +41,7 @@ EventHandlerAction GridLayer::HandleKeyboardEvent(const SDL_KeyboardEvent &ev) {
       } else {
         m_DivPhi = std::max(4, m_DivPhi - 2);
       }
+      BuildGrid();
       return EventHandlerAction::CONSUME;
     case 't':
       if (SDL_GetModState() & KMOD_SHIFT) {
@@ -52,6 +49,7 @@ EventHandlerAction GridLayer::HandleKeyboardEvent(const SDL_KeyboardEvent &ev) {
       } else {
         m_DivTheta = std::max(8, m_DivTheta - 4);
       }
+      BuildGrid();
       return EventHandlerAction::CONSUME;
     case 'r':
       if (SDL_GetModState() & KMOD_SHIFT) {
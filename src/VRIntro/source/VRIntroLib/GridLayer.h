@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Interactionlayer.h"
+#include "LineMesh.h"
 
 class GLShader;
 
@@ -15,6 +16,10 @@ public:
 
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 private:
+  void BuildGrid();
+
+  // A unit sphere's grid, which is scaled to m_Radius when drawn.
+  LineMesh m_Grid;
   int m_DivTheta;
   int m_DivPhi;
   float m_Radius;
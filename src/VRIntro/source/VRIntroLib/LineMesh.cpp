@@ -0,0 +1,100 @@
+#include "stdafx.h"
+#include "LineMesh.h"
+
+#include "GLShader.h"
+#include "GLShaderLoader.h"
+#include "GLShaderMatrices.h"
+#include "Resource.h"
+
+namespace {
+  bool IsCoreProfile() {
+    if (!GLEW_VERSION_3_2) {
+      return false;
+    }
+    GLint profile = 0;
+    glGetIntegerv(GL_CONTEXT_PROFILE_MASK, &profile);
+    return (profile & GL_CONTEXT_CORE_PROFILE_BIT) != 0;
+  }
+}
+
+LineMesh::LineMesh() :
+  m_CoreProfile(IsCoreProfile()),
+  m_VertexArray(0),
+  m_NumVertices(0) {
+  m_Shader = Resource<GLShader>(m_CoreProfile ? "shaders/lines-core" : "shaders/lines");
+}
+
+LineMesh::~LineMesh() {
+  if (m_VertexArray) {
+    glDeleteVertexArrays(1, &m_VertexArray);
+  }
+}
+
+void LineMesh::AddLine(const EigenTypes::Vector3f& a, const EigenTypes::Vector3f& b) {
+  m_Vertices.insert(m_Vertices.end(), a.data(), a.data() + 3);
+  m_Vertices.insert(m_Vertices.end(), b.data(), b.data() + 3);
+}
+
+void LineMesh::AddSphereGrid(int divTheta, int divPhi) {
+  for (int i = 0; i < divPhi; i++) {
+    float phi0 = (float)M_PI*(i/static_cast<float>(divPhi) - 0.5f);
+    float phi1 = (float)M_PI*((i + 1)/static_cast<float>(divPhi) - 0.5f);
+    for (int j = 0; j < divTheta; j++) {
+      float theta0 = 2*(float)M_PI*(j/static_cast<float>(divTheta));
+      float theta1 = 2*(float)M_PI*((j + 1)/static_cast<float>(divTheta));
+      const EigenTypes::Vector3f corner(cos(phi0)*cos(theta0), sin(phi0), cos(phi0)*sin(theta0));
+      AddLine(corner, EigenTypes::Vector3f(cos(phi0)*cos(theta1), sin(phi0), cos(phi0)*sin(theta1)));
+      AddLine(corner, EigenTypes::Vector3f(cos(phi1)*cos(theta0), sin(phi1), cos(phi1)*sin(theta0)));
+    }
+  }
+}
+
+void LineMesh::Upload() {
+  if (!m_Buffer.IsCreated()) {
+    m_Buffer.Create(GL_ARRAY_BUFFER);
+  }
+  m_Buffer.Bind();
+  m_Buffer.Allocate(m_Vertices.data(), m_Vertices.size()*sizeof(float), GL_STATIC_DRAW);
+  if (!m_VertexArray && (GLEW_VERSION_3_0 || GLEW_ARB_vertex_array_object)) {
+    const GLint positionLoc = m_Shader->LocationOfAttribute("position");
+    glGenVertexArrays(1, &m_VertexArray);
+    glBindVertexArray(m_VertexArray);
+    glEnableVertexAttribArray(positionLoc);
+    glVertexAttribPointer(positionLoc, 3, GL_FLOAT, GL_FALSE, 3*sizeof(float), 0);
+    glBindVertexArray(0);
+  }
+  m_Buffer.Unbind();
+  m_NumVertices = static_cast<int>(m_Vertices.size()/3);
+  m_Vertices.clear();
+}
+
+void LineMesh::Draw(const EigenTypes::Matrix4x4f& modelView, const EigenTypes::Matrix4x4f& projection, const Appearance& appearance) const {
+  if (m_NumVertices == 0) {
+    return;
+  }
+  m_Shader->Bind();
+  GLShaderMatrices::UploadUniforms(*m_Shader, modelView.cast<double>(), projection.cast<double>(), BindFlags::NONE);
+  m_Shader->SetUniformf("color", appearance.color);
+  m_Shader->SetUniformf("offset", appearance.offset);
+  m_Shader->SetUniformf("fade_center", appearance.fadeCenter);
+  m_Shader->SetUniformf("fade_brightness", appearance.fadeBrightness);
+  m_Shader->SetUniformf("fade_softness", appearance.fadeSoftness);
+
+  glLineWidth(m_CoreProfile ? 1.0f : appearance.width);
+
+  if (m_VertexArray) {
+    glBindVertexArray(m_VertexArray);
+    glDrawArrays(GL_LINES, 0, m_NumVertices);
+    glBindVertexArray(0);
+  } else {
+    const GLint positionLoc = m_Shader->LocationOfAttribute("position");
+    m_Buffer.Bind();
+    glEnableVertexAttribArray(positionLoc);
+    glVertexAttribPointer(positionLoc, 3, GL_FLOAT, GL_FALSE, 3*sizeof(float), 0);
+    glDrawArrays(GL_LINES, 0, m_NumVertices);
+    glDisableVertexAttribArray(positionLoc);
+    m_Buffer.Unbind();
+  }
+
+  m_Shader->Unbind();
+}
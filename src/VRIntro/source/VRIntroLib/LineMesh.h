@@ -0,0 +1,68 @@
+#pragma once
+
+#include "EigenTypes.h"
+#include "GLBuffer.h"
+
+#include <memory>
+#include <vector>
+
+class GLShader;
+
+// Line segments kept in a vertex buffer, so that lines which don't change, such as a layer's
+// grid, are built and uploaded once rather than resent with glBegin/glEnd every frame.  They're
+// drawn with shaders/lines, which takes whatever does change (where the lines are, their color
+// and how they fade with distance) as uniforms, or with shaders/lines-core in a core profile
+// context, where the attribute binding is kept in a vertex array object.
+class LineMesh {
+public:
+  // The uniforms of shaders/lines besides the matrices.  Each vertex is drawn at its position
+  // plus offset, and if fadeBrightness is positive, its alpha is scaled by
+  // min(1, fadeBrightness/(fadeSoftness + |vertex - fadeCenter|^2)).  Core profiles don't support
+  // lines wider than 1 pixel, so width is clamped to 1 there.
+  struct Appearance {
+    Appearance() :
+      color(1.0f, 1.0f, 1.0f, 1.0f),
+      offset(EigenTypes::Vector3f::Zero()),
+      fadeCenter(EigenTypes::Vector3f::Zero()),
+      fadeBrightness(0.0f),
+      fadeSoftness(1.0f),
+      width(1.0f) {}
+    EigenTypes::Vector4f color;
+    EigenTypes::Vector3f offset;
+    EigenTypes::Vector3f fadeCenter;
+    float fadeBrightness;
+    float fadeSoftness;
+    float width;
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  };
+
+  LineMesh();
+  ~LineMesh();
+
+  // The lines are collected here until Upload, which replaces the buffer's contents.
+  void Clear() { m_Vertices.clear(); }
+  void AddLine(const EigenTypes::Vector3f& a, const EigenTypes::Vector3f& b);
+  // Adds the grid of a unit sphere which GridLayer shows: for each of divPhi bands of latitude,
+  // the divTheta segments of its lower parallel and the meridians up to the next parallel.
+  void AddSphereGrid(int divTheta, int divPhi);
+  void Upload();
+
+  int NumLines() const { return m_NumVertices/2; }
+
+  // Binds the lines shader, sets its uniforms and the line width, and draws the uploaded lines.
+  void Draw(const EigenTypes::Matrix4x4f& modelView, const EigenTypes::Matrix4x4f& projection, const Appearance& appearance) const;
+
+private:
+  LineMesh(const LineMesh&);
+  LineMesh& operator=(const LineMesh&);
+
+  std::shared_ptr<GLShader> m_Shader;
+  bool m_CoreProfile;
+  // Zero unless vertex array objects are supported, in which case Upload binds the buffer to the
+  // position attribute here once, rather than Draw doing it every time.
+  GLuint m_VertexArray;
+  std::vector<float> m_Vertices;
+  mutable GLBuffer m_Buffer;
+  int m_NumVertices;
+};
@@ -6,17 +6,31 @@
 #include "GLTexture2Loader.h"
 #include "GLShaderLoader.h"
 
-SpaceLayer::SpaceLayer(const EigenTypes::Vector3f& initialEyePos) :
+#include <algorithm>
+
+namespace {
+
+// How long to wait for the draws from a region before writing it through glBufferSubData instead
+// (which the driver synchronizes itself).
+const GLuint64 REGION_FENCE_TIMEOUT_NS = 100*1000*1000;
+
+}
+
+SpaceLayer::SpaceLayer(const EigenTypes::Vector3f& initialEyePos, int numStars) :
   InteractionLayer(initialEyePos, "shaders/solid"),
   m_PopupShader(Resource<GLShader>("shaders/transparent")),
   m_PopupTexture(Resource<GLTexture2>("images/level3_popup.png")),
-  m_OddEven(0),
+  m_NumStars(0),
+  m_Region(0),
+  m_UploadMode(UploadMode::MAP_UNSYNCHRONIZED),
   m_StarShowMode(0),
-  m_StarsToShow(NUM_STARS) {
+  m_StarsToShow(0) {
+  for (GLsync& fence : m_RegionFences) {
+    fence = nullptr;
+  }
   m_Buffer.Create(GL_ARRAY_BUFFER);
-  m_Buffer.Bind();
-  m_Buffer.Allocate(NULL, 12*sizeof(float)*NUM_STARS, GL_DYNAMIC_DRAW);
-  m_Buffer.Unbind();
+  m_TrailIndices.Create(GL_ELEMENT_ARRAY_BUFFER);
+  SetUploadMode(UploadMode::MAP_UNSYNCHRONIZED);
 
   // Define popup text coordinates
   static const float edges[] = {
@@ -31,30 +45,64 @@ SpaceLayer::SpaceLayer(const EigenTypes::Vector3f& initialEyePos) :
   m_PopupBuffer.Allocate(edges, sizeof(edges), GL_STATIC_DRAW);
   m_PopupBuffer.Unbind();
 
-  m_Buf = new float[NUM_STARS*12];
-  InitPhysics();
+  SetNumStars(numStars);
 }
 
 SpaceLayer::~SpaceLayer() {
-  delete[] m_Buf;
+  DeleteRegionFences();
   m_Buffer.Destroy();
+  m_TrailIndices.Destroy();
 }
 
+void SpaceLayer::SetNumStars(int numStars) {
+  m_NumStars = numStars < MIN_NUM_STARS ? MIN_NUM_STARS : (numStars > MAX_NUM_STARS ? MAX_NUM_STARS : numStars);
+  m_StarsToShow = static_cast<int>(0.5f + m_NumStars*exp(-0.4*static_cast<float>(m_StarShowMode % 10)));
+  m_Stars.Resize(m_NumStars);
+  m_Buf.assign(6*m_NumStars, 0.0f);
+  InitPhysics();
+
+  // Every region starts out with the new stars where they are, so the first frame's trails (from
+  // the region before it) have no length, rather than reaching from wherever the region was.
+  std::vector<float> initial(NUM_STREAMED_FRAMES*6*m_NumStars);
+  for (int i = 0; i < m_NumStars; i++) {
+    const EigenTypes::Vector3f position = m_Stars.Position(i);
+    const EigenTypes::Vector3f velocity = m_Stars.Velocity(i);
+    std::copy(position.data(), position.data() + 3, &initial[6*i]);
+    std::copy(velocity.data(), velocity.data() + 3, &initial[6*i + 3]);
+  }
+  for (int region = 1; region < NUM_STREAMED_FRAMES; region++) {
+    std::copy(initial.begin(), initial.begin() + 6*m_NumStars, initial.begin() + region*6*m_NumStars);
+  }
+  DeleteRegionFences();
+  m_Buffer.Bind();
+  m_Buffer.Allocate(initial.data(), initial.size()*sizeof(float), GL_STREAM_DRAW);
+  m_Buffer.Unbind();
+
+  // The lines from each star in the previous region to the same star in the current one, first
+  // for regions which are next to each other (indexed from the previous region), and then for
+  // the last region followed by the first (indexed from the first).
+  std::vector<GLuint> indices(4*m_NumStars);
+  const GLuint starCount = static_cast<GLuint>(m_NumStars);
+  for (GLuint i = 0; i < starCount; i++) {
+    indices[2*i] = i;
+    indices[2*i + 1] = starCount + i;
+    indices[2*(starCount + i)] = (NUM_STREAMED_FRAMES - 1)*starCount + i;
+    indices[2*(starCount + i) + 1] = i;
+  }
+  m_TrailIndices.Bind();
+  m_TrailIndices.Allocate(indices.data(), indices.size()*sizeof(GLuint), GL_STATIC_DRAW);
+  m_TrailIndices.Unbind();
+  m_Region = 0;
+}
+
+void SpaceLayer::SetUploadMode(UploadMode mode) {
+  const bool canMap = GLBuffer::IsMapRangeSupported() && (GLEW_VERSION_3_2 || GLEW_ARB_sync);
+  m_UploadMode = mode == UploadMode::MAP_UNSYNCHRONIZED && !canMap ? UploadMode::SUB_DATA : mode;
+}
 
 void SpaceLayer::Update(TimeDelta real_time_delta) {
-  m_OddEven ^= 1;
+  m_Region = (m_Region + 1) % NUM_STREAMED_FRAMES;
   UpdateAllPhysics();
-  for (int i = 6*m_OddEven, j = 0; j < NUM_STARS; j++) {
-    const EigenTypes::Vector3f& r = pos[j];
-    m_Buf[i++] = r.x();
-    m_Buf[i++] = r.y();
-    m_Buf[i++] = r.z();
-    const EigenTypes::Vector3f& v = vel[j];
-    m_Buf[i++] = v.x();
-    m_Buf[i++] = v.y();
-    m_Buf[i++] = v.z();
-    i += 6;
-  }
 }
 
 void SpaceLayer::Render(TimeDelta real_time_delta) const {
@@ -69,21 +117,36 @@ void SpaceLayer::Render(TimeDelta real_time_delta) const {
   m_Shader->Bind();
   GLShaderMatrices::UploadUniforms(*m_Shader, m_ModelView.cast<double>(), m_Projection.cast<double>(), BindFlags::NONE);
 
+  // Nothing is uploaded here, since both eyes draw the same stars.
+  const size_t regionSize = 6*sizeof(float)*m_NumStars;
+  const bool wrapped = m_Region == 0;
+  const size_t lineStart = wrapped ? 0 : (m_Region - 1)*regionSize;
   m_Buffer.Bind();
+  m_TrailIndices.Bind();
   glEnableVertexAttribArray(m_Shader->LocationOfAttribute("position"));
   glEnableVertexAttribArray(m_Shader->LocationOfAttribute("velocity"));
-  glVertexAttribPointer(m_Shader->LocationOfAttribute("position"), 3, GL_FLOAT, GL_TRUE, 6*sizeof(float), 0);
-  glVertexAttribPointer(m_Shader->LocationOfAttribute("velocity"), 3, GL_FLOAT, GL_TRUE, 6*sizeof(float), (GLvoid*)(3*sizeof(float)));
-
-  m_Buffer.Write(m_Buf, 12*m_StarsToShow*sizeof(float));
-  glDrawArrays(GL_LINES, 0, 2*m_StarsToShow);
+  glVertexAttribPointer(m_Shader->LocationOfAttribute("position"), 3, GL_FLOAT, GL_TRUE, 6*sizeof(float), (GLvoid*)lineStart);
+  glVertexAttribPointer(m_Shader->LocationOfAttribute("velocity"), 3, GL_FLOAT, GL_TRUE, 6*sizeof(float), (GLvoid*)(lineStart + 3*sizeof(float)));
+  glDrawElements(GL_LINES, 2*m_StarsToShow, GL_UNSIGNED_INT, (GLvoid*)((wrapped ? 2*m_NumStars : 0)*sizeof(GLuint)));
 
-  glVertexAttribPointer(m_Shader->LocationOfAttribute("position"), 3, GL_FLOAT, GL_TRUE, 12*sizeof(float), (GLvoid*)((6*m_OddEven)*sizeof(float)));
-  glVertexAttribPointer(m_Shader->LocationOfAttribute("velocity"), 3, GL_FLOAT, GL_TRUE, 12*sizeof(float), (GLvoid*)((6*m_OddEven + 3)*sizeof(float)));
+  const size_t pointStart = m_Region*regionSize;
+  glVertexAttribPointer(m_Shader->LocationOfAttribute("position"), 3, GL_FLOAT, GL_TRUE, 6*sizeof(float), (GLvoid*)pointStart);
+  glVertexAttribPointer(m_Shader->LocationOfAttribute("velocity"), 3, GL_FLOAT, GL_TRUE, 6*sizeof(float), (GLvoid*)(pointStart + 3*sizeof(float)));
   glDrawArrays(GL_POINTS, 0, m_StarsToShow);
 
+  // These were the last draws from the previous region, which is mapped again next.  (The other
+  // eye replaces the fence with its own.)
+  if (m_UploadMode == UploadMode::MAP_UNSYNCHRONIZED) {
+    GLsync& fence = m_RegionFences[(m_Region + NUM_STREAMED_FRAMES - 1) % NUM_STREAMED_FRAMES];
+    if (fence) {
+      glDeleteSync(fence);
+    }
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  }
+
   glDisableVertexAttribArray(m_Shader->LocationOfAttribute("position"));
   glDisableVertexAttribArray(m_Shader->LocationOfAttribute("velocity"));
+  m_TrailIndices.Unbind();
   m_Buffer.Unbind();
 
   m_Shader->Unbind();
@@ -139,27 +202,26 @@ EigenTypes::Vector3f SpaceLayer::InitialVelocity(float mass, const EigenTypes::V
 }
 
 void SpaceLayer::InitPhysics() {
-  pos.resize(NUM_STARS);
-  vel.resize(NUM_STARS);
-
+  const int starsPerGalaxy = m_NumStars/NUM_GALAXIES;
   for (int i = 0; i < NUM_GALAXIES; i++) {
     m_GalaxyPos[i] = GenerateVector(1.2f*m_EyePos.cast<float>(), 1.0f);
     if (i == 0) {
       m_GalaxyPos[i] = m_EyePos.cast<float>() + m_EyeView.transpose().cast<float>()*EigenTypes::Vector3f(0, -0.2f, -1.2f);
     }
     m_GalaxyVel[i] = GenerateVector(-1e-3f*(m_GalaxyPos[i] - 1.1f*m_EyePos.cast<float>()), 0.0004f);
-    m_GalaxyMass[i] = static_cast<float>(STARS_PER)*5e-11f;
+    // The mass doesn't depend on the number of stars, so neither do their orbits.
+    m_GalaxyMass[i] = static_cast<float>(DEFAULT_NUM_STARS/NUM_GALAXIES)*5e-11f;
     m_GalaxyNormal[i] = GenerateVector(EigenTypes::Vector3f::Zero(), 1.0).normalized();
 
-    for (int j = 0; j < STARS_PER; j++) {
-      const size_t index = i*STARS_PER + j;
+    const int numStars = i + 1 < NUM_GALAXIES ? starsPerGalaxy : m_NumStars - i*starsPerGalaxy;
+    for (int j = 0; j < numStars; j++) {
+      const int index = i*starsPerGalaxy + j;
       EigenTypes::Vector3f dr = GenerateVector(EigenTypes::Vector3f::Zero(), 0.5);
 
       // Project to disc
       dr -= 0.4f*atan(dr.dot(m_GalaxyNormal[i])/0.5f)*m_GalaxyNormal[i];
 
-      pos[index] = m_GalaxyPos[i] + dr;
-      vel[index] = m_GalaxyVel[i] + InitialVelocity(m_GalaxyMass[i], m_GalaxyNormal[i], dr);
+      m_Stars.SetStar(index, m_GalaxyPos[i] + dr, m_GalaxyVel[i] + InitialVelocity(m_GalaxyMass[i], m_GalaxyNormal[i], dr));
     }
   }
 }
@@ -177,23 +239,17 @@ void SpaceLayer::UpdateV(int type, const EigenTypes::Vector3f& p, EigenTypes::Ve
 
 void SpaceLayer::UpdateAllPhysics() {
   // Update stars
-  for (int i = 0; i < m_StarsToShow; i++) {
-    int type = static_cast<int>(static_cast<float>(i)*NUM_STARS/m_StarsToShow);
-    EigenTypes::Vector3f tempV = vel[i];
-    for (size_t j = 0; j < NUM_GALAXIES + m_SkeletonHands.size(); j++) {
-      UpdateV(type, pos[i], tempV, j);
-    }
-    const EigenTypes::Vector3f tempP = pos[i] + 0.667f*tempV;
-    for (size_t j = 0; j < NUM_GALAXIES + m_SkeletonHands.size(); j++) {
-      UpdateV(type, tempP, vel[i], j);
-    }
-    pos[i] += 0.25*tempV + 0.75*vel[i];
-
-    if ((pos[i] - m_EyePos.cast<float>()).squaredNorm() > 50) {
-      pos[i] = m_EyePos.cast<float>() - 10*vel[i] + m_EyeView.transpose().cast<float>()*EigenTypes::Vector3f(0, 0.5, 0);
-      vel[i].setZero();
-    }
+  StarSimulation::Attractors attractors;
+  for (int i = 0; i < NUM_GALAXIES; i++) {
+    attractors.galaxyPositions.push_back(m_GalaxyPos[i]);
+    attractors.galaxyMasses.push_back(m_GalaxyMass[i]);
+  }
+  for (size_t i = 0; i < m_SkeletonHands.size(); i++) {
+    attractors.handPositions.push_back(m_SkeletonHands[i].avgExtended.cast<float>());
   }
+  attractors.eyePos = m_EyePos.cast<float>();
+  attractors.respawnOffset = m_EyeView.transpose().cast<float>()*EigenTypes::Vector3f(0, 0.5, 0);
+  UploadStars(attractors);
 
   // Update galaxies
   for (size_t i = 0; i < NUM_GALAXIES; i++) {
@@ -213,12 +269,68 @@ void SpaceLayer::UpdateAllPhysics() {
   }
 }
 
+void SpaceLayer::UploadStars(const StarSimulation::Attractors& attractors) {
+  const GLintptr offset = m_Region*6*sizeof(float)*m_NumStars;
+  const GLsizeiptr size = 6*sizeof(float)*m_StarsToShow;
+  if (size == 0) {
+    return;
+  }
+  // The region was last drawn from NUM_STREAMED_FRAMES - 1 frames ago, so its fence has usually
+  // signaled already; then it's written without the driver waiting for the GPU, and its old
+  // contents are discarded.
+  float* region = nullptr;
+  if (m_UploadMode == UploadMode::MAP_UNSYNCHRONIZED && WaitForRegion(m_Region)) {
+    region = static_cast<float*>(m_Buffer.MapRange(offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+  }
+  if (region) {
+    m_Stars.Step(attractors, m_StarsToShow, region, 6);
+    if (!m_Buffer.Unmap()) {
+      // The buffer's contents were lost (e.g. to a mode switch); the next frames rewrite them.
+      m_UploadMode = UploadMode::SUB_DATA;
+    }
+  } else {
+    m_Stars.Step(attractors, m_StarsToShow, m_Buf.data(), 6);
+    m_Buffer.Bind();
+    m_Buffer.Write(m_Buf.data(), static_cast<int>(size), offset);
+    m_Buffer.Unbind();
+  }
+  m_UploadCounters.frames++;
+  m_UploadCounters.bytesUploaded += size;
+  m_UploadCounters.bytesLastFrame = size;
+}
+
+bool SpaceLayer::WaitForRegion(int region) {
+  GLsync& fence = m_RegionFences[region];
+  if (!fence) {
+    return true;
+  }
+  const GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, REGION_FENCE_TIMEOUT_NS);
+  glDeleteSync(fence);
+  fence = nullptr;
+  return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+}
+
+void SpaceLayer::DeleteRegionFences() {
+  for (GLsync& fence : m_RegionFences) {
+    if (fence) {
+      glDeleteSync(fence);
+      fence = nullptr;
+    }
+  }
+}
+
 EventHandlerAction SpaceLayer::HandleKeyboardEvent(const SDL_KeyboardEvent &ev) {
   if (ev.type == SDL_KEYDOWN) {
     switch (ev.keysym.sym) {
     case 's':
       m_StarShowMode++;
-      m_StarsToShow = static_cast<int>(0.5f + NUM_STARS*exp(-0.4*static_cast<float>(m_StarShowMode % 10)));
+      m_StarsToShow = static_cast<int>(0.5f + m_NumStars*exp(-0.4*static_cast<float>(m_StarShowMode % 10)));
+      return EventHandlerAction::CONSUME;
+    case SDLK_LEFTBRACKET:
+      SetNumStars(m_NumStars/2);
+      return EventHandlerAction::CONSUME;
+    case SDLK_RIGHTBRACKET:
+      SetNumStars(2*m_NumStars);
       return EventHandlerAction::CONSUME;
     case SDLK_SPACE:
       InitPhysics();
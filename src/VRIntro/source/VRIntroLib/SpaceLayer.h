@@ -1,33 +1,77 @@
 #pragma once
 
 #include "Interactionlayer.h"
+#include "StarSimulation.h"
+
+#include <cstdint>
 
 class GLShader;
 
 class SpaceLayer : public InteractionLayer {
 public:
-  SpaceLayer(const EigenTypes::Vector3f& initialEyePos);
+  static const int DEFAULT_NUM_STARS = 30000;
+
+  // How each frame's stars reach m_Buffer.  Either way only the region of the frame's new
+  // endpoints is written, but mapping it lets the simulation write straight into the buffer.
+  enum class UploadMode {
+    MAP_UNSYNCHRONIZED, // glMapBufferRange, fenced (GL 3.2, or ARB_map_buffer_range and ARB_sync)
+    SUB_DATA            // glBufferSubData from m_Buf
+  };
+
+  struct UploadCounters {
+    UploadCounters() : frames(0), bytesUploaded(0), bytesLastFrame(0) {}
+    uint64_t frames;
+    uint64_t bytesUploaded;
+    uint64_t bytesLastFrame;
+  };
+
+  SpaceLayer(const EigenTypes::Vector3f& initialEyePos, int numStars = DEFAULT_NUM_STARS);
   virtual ~SpaceLayer();
 
   virtual void Update(TimeDelta real_time_delta) override;
   virtual void Render(TimeDelta real_time_delta) const override;
   EventHandlerAction HandleKeyboardEvent(const SDL_KeyboardEvent &ev) override;
 
+  // Replaces the stars with the given number of new ones.
+  void SetNumStars(int numStars);
+  int NumStars() const { return m_NumStars; }
+
+  // Falls back to SUB_DATA if mapping ranges or fences aren't supported.
+  void SetUploadMode(UploadMode mode);
+  UploadMode GetUploadMode() const { return m_UploadMode; }
+  const UploadCounters& GetUploadCounters() const { return m_UploadCounters; }
+  void ResetUploadCounters() { m_UploadCounters = UploadCounters(); }
+
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
 private:
   static const int NUM_GALAXIES = 1;
-  static const int STARS_PER = 30000;
-  static const int NUM_STARS = STARS_PER*NUM_GALAXIES;
+  static const int MIN_NUM_STARS = 1000;
+  static const int MAX_NUM_STARS = 10*DEFAULT_NUM_STARS;
+  // The regions of m_Buffer which frames write to in turn.  A region is rewritten two frames
+  // after the last frame which drew from it, which the driver should have finished with by then
+  // (and which its fence makes sure of, when it's mapped).
+  static const int NUM_STREAMED_FRAMES = 3;
 
   void InitPhysics();
   EigenTypes::Vector3f GenerateVector(const EigenTypes::Vector3f& center, float radius);
   EigenTypes::Vector3f InitialVelocity(float mass, const EigenTypes::Vector3f& normal, const EigenTypes::Vector3f& dr);
   void UpdateV(int type, const EigenTypes::Vector3f& p, EigenTypes::Vector3f& v, int galaxy);
   void UpdateAllPhysics();
+  void UploadStars(const StarSimulation::Attractors& attractors);
+  // Waits for the draws from the given region to finish.  Returns false if they didn't finish in
+  // time, in which case the region must be written through the driver instead of mapped.
+  bool WaitForRegion(int region);
+  void DeleteRegionFences();
   void RenderPopup() const;
 
+  // NUM_STREAMED_FRAMES regions of one vertex (position and velocity) per star, of which
+  // m_Region holds the last step.  The stars are drawn as lines from the previous region to
+  // m_Region, through the pairs of indices in m_TrailIndices.
   mutable GLBuffer m_Buffer;
+  // Set (in MAP_UNSYNCHRONIZED mode) after the last draw from each region, if it's still pending.
+  mutable GLsync m_RegionFences[NUM_STREAMED_FRAMES];
+  mutable GLBuffer m_TrailIndices;
   mutable GLBuffer m_PopupBuffer;
   std::shared_ptr<GLTexture2> m_PopupTexture;
   std::shared_ptr<GLShader> m_PopupShader;
@@ -37,13 +81,14 @@ private:
   EigenTypes::Vector3f m_GalaxyNormal[NUM_GALAXIES];
   float m_GalaxyMass[NUM_GALAXIES];
 
-  EigenTypes::stdvectorV3f pos;
-  EigenTypes::stdvectorV3f vel;
-
-  float *m_Buf;
+  StarSimulation m_Stars;
+  int m_NumStars;
 
-  static float buf[NUM_STARS];
-  int m_OddEven;
+  // Where the stars are written before glBufferSubData, when m_Buffer isn't mapped.
+  std::vector<float> m_Buf;
+  int m_Region;
+  UploadMode m_UploadMode;
+  UploadCounters m_UploadCounters;
 
   int m_StarShowMode;
   int m_StarsToShow;
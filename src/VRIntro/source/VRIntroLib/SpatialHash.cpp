@@ -0,0 +1,102 @@
+#include "stdafx.h"
+#include "SpatialHash.h"
+
+#include <algorithm>
+
+namespace {
+
+// std::floor is a library call on x86 without SSE4.1.
+int Floor(float x) {
+  const int i = static_cast<int>(x);
+  return x < static_cast<float>(i) ? i - 1 : i;
+}
+
+}
+
+SpatialHash::SpatialHash(float cellSize, size_t numBuckets) :
+  m_CellSize(cellSize),
+  m_BucketMask(1) {
+  while (m_BucketMask < numBuckets) {
+    m_BucketMask *= 2;
+  }
+  m_BucketMask--;
+}
+
+void SpatialHash::Build(const EigenTypes::stdvectorV3f& centers, float radius) {
+  // List each ball in every cell within its radius, skipping the cells in the corners of its
+  // bounding box, which it doesn't reach.
+  const float radiusSq = radius*radius;
+  m_Unsorted.clear();
+  for (size_t i = 0; i < centers.size(); i++) {
+    const EigenTypes::Vector3f& center = centers[i];
+    const Eigen::Vector3i lower = Cell(center - EigenTypes::Vector3f::Constant(radius));
+    const Eigen::Vector3i upper = Cell(center + EigenTypes::Vector3f::Constant(radius));
+    Entry entry;
+    entry.index = static_cast<int>(i);
+    for (entry.cell.z() = lower.z(); entry.cell.z() <= upper.z(); entry.cell.z()++) {
+      const float dz = AxisDistance(center.z(), entry.cell.z());
+      for (entry.cell.y() = lower.y(); entry.cell.y() <= upper.y(); entry.cell.y()++) {
+        const float dy = AxisDistance(center.y(), entry.cell.y());
+        for (entry.cell.x() = lower.x(); entry.cell.x() <= upper.x(); entry.cell.x()++) {
+          const float dx = AxisDistance(center.x(), entry.cell.x());
+          if (dx*dx + dy*dy + dz*dz <= radiusSq) {
+            m_Unsorted.push_back(entry);
+          }
+        }
+      }
+    }
+  }
+
+  // Sort the entries by bucket, keeping them in order within each one.
+  const size_t numBuckets = m_BucketMask + 1;
+  m_BucketStart.assign(numBuckets + 1, 0);
+  m_Buckets.resize(m_Unsorted.size());
+  for (size_t e = 0; e < m_Unsorted.size(); e++) {
+    m_Buckets[e] = static_cast<int>(Bucket(m_Unsorted[e].cell));
+    m_BucketStart[m_Buckets[e] + 1]++;
+  }
+  for (size_t b = 0; b < numBuckets; b++) {
+    m_BucketStart[b + 1] += m_BucketStart[b];
+  }
+  m_Next.assign(m_BucketStart.begin(), m_BucketStart.end() - 1);
+  m_Entries.resize(m_Unsorted.size());
+  for (size_t e = 0; e < m_Unsorted.size(); e++) {
+    m_Entries[m_Next[m_Buckets[e]]++] = m_Unsorted[e];
+  }
+}
+
+void SpatialHash::Query(const EigenTypes::Vector3f& point, std::vector<int>& result) const {
+  if (m_Entries.empty()) {
+    return;
+  }
+  const Eigen::Vector3i cell = Cell(point);
+  const size_t bucket = Bucket(cell);
+  for (int e = m_BucketStart[bucket]; e < m_BucketStart[bucket + 1]; e++) {
+    // Other cells can share the bucket.
+    if (m_Entries[e].cell == cell) {
+      result.push_back(m_Entries[e].index);
+    }
+  }
+}
+
+Eigen::Vector3i SpatialHash::Cell(const EigenTypes::Vector3f& point) const {
+  const float scale = 1.0f/m_CellSize;
+  return Eigen::Vector3i(Floor(point.x()*scale), Floor(point.y()*scale), Floor(point.z()*scale));
+}
+
+size_t SpatialHash::Bucket(const Eigen::Vector3i& cell) const {
+  // The hash of Teschner et al., "Optimized Spatial Hashing for Collision Detection of
+  // Deformable Objects".
+  const unsigned int hash = static_cast<unsigned int>(cell.x())*73856093u ^
+                            static_cast<unsigned int>(cell.y())*19349663u ^
+                            static_cast<unsigned int>(cell.z())*83492791u;
+  return hash & m_BucketMask;
+}
+
+float SpatialHash::AxisDistance(float coordinate, int cell) const {
+  const float lower = cell*m_CellSize;
+  if (coordinate < lower) {
+    return lower - coordinate;
+  }
+  return std::max(0.0f, coordinate - (lower + m_CellSize));
+}
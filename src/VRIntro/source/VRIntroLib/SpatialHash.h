@@ -0,0 +1,50 @@
+#pragma once
+
+#include "EigenTypes.h"
+
+#include <vector>
+
+// A uniform grid of balls (e.g. the reach of each fingertip), for finding the balls which might
+// contain a point.  Each ball is listed in every cell it overlaps, and the cells are hashed into
+// a fixed table of buckets, so the grid needs no bounds and a lookup is a single bucket.  It
+// doesn't follow the balls around, so it's rebuilt whenever they move.
+class SpatialHash {
+public:
+  static const size_t DEFAULT_NUM_BUCKETS = 1024;
+
+  // Cells of about the balls' radius keep both the number of cells per ball and the number of
+  // points which look a ball up without being in it small.  The table should have a few times
+  // as many buckets as there are occupied cells, and is rounded up to a power of two.
+  explicit SpatialHash(float cellSize, size_t numBuckets = DEFAULT_NUM_BUCKETS);
+
+  void Build(const EigenTypes::stdvectorV3f& centers, float radius);
+
+  // Appends to result the index of each ball which overlaps point's cell, in increasing order.
+  // The caller checks whether point is actually in each one.
+  void Query(const EigenTypes::Vector3f& point, std::vector<int>& result) const;
+
+  float CellSize() const { return m_CellSize; }
+
+private:
+  Eigen::Vector3i Cell(const EigenTypes::Vector3f& point) const;
+  size_t Bucket(const Eigen::Vector3i& cell) const;
+  // The distance from coordinate to the given cell's interval along one axis.
+  float AxisDistance(float coordinate, int cell) const;
+
+  // A ball listed in a cell.
+  struct Entry {
+    Eigen::Vector3i cell;
+    int index;
+  };
+
+  float m_CellSize;
+  size_t m_BucketMask;
+  // The entries of bucket b are m_Entries[m_BucketStart[b]] up to m_Entries[m_BucketStart[b + 1]].
+  std::vector<int> m_BucketStart;
+  std::vector<Entry> m_Entries;
+
+  // Scratch space for Build: the entries in the order they were found, and their buckets.
+  std::vector<Entry> m_Unsorted;
+  std::vector<int> m_Buckets;
+  std::vector<int> m_Next;
+};
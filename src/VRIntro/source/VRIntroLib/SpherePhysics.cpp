@@ -0,0 +1,71 @@
+#include "stdafx.h"
+#include "SpherePhysics.h"
+
+#include <cmath>
+
+namespace {
+
+const float K = 10;
+const float D = 3;
+const float A = 0.0015f;
+const float AA = 0.00005f;
+
+// The pull of a tip at distance sqrt(distSq) is A*diff/(AA + distSq^2).  Its magnitude at
+// INFLUENCE_RADIUS is subtracted from it, so that it drops to zero there rather than jumping.
+float PullScale(float distSq) {
+  const float R = SpherePhysics::INFLUENCE_RADIUS;
+  const float pullAtRadius = R/(AA + R*R*R*R);
+  return A*(1.0f/(AA + distSq*distSq) - pullAtRadius/std::sqrt(distSq));
+}
+
+}
+
+const float SpherePhysics::INFLUENCE_RADIUS = 0.3f;
+
+SpherePhysics::SpherePhysics() :
+  m_Grid(INFLUENCE_RADIUS) {}
+
+float SpherePhysics::ShellOuterRadius(int numSpheres) {
+  const float INNER = 0.4f;
+  const float OUTER = 0.6f;
+  // The shell was made for 300 spheres, so its volume grows in proportion beyond that.
+  const float SPHERES = 300.0f;
+  return std::pow(INNER*INNER*INNER + (OUTER*OUTER*OUTER - INNER*INNER*INNER)*numSpheres/SPHERES, 1.0f/3.0f);
+}
+
+void SpherePhysics::AddSphere(const EigenTypes::Vector3f& position, float radius) {
+  m_Pos.push_back(position);
+  m_Disp.push_back(EigenTypes::Vector3f::Zero());
+  m_Vel.push_back(EigenTypes::Vector3f::Zero());
+  m_Radius.push_back(radius);
+}
+
+void SpherePhysics::Step(const EigenTypes::stdvectorV3f& tips, float deltaT, float spring, float damp, float well) {
+  const float influenceSq = INFLUENCE_RADIUS*INFLUENCE_RADIUS;
+  m_Grid.Build(tips, INFLUENCE_RADIUS);
+  for (int i = 0; i < NumSpheres(); i++) {
+    const EigenTypes::Vector3f center = m_Pos[i] + m_Disp[i];
+    EigenTypes::Vector3f accel = -K*spring*m_Disp[i] - D*damp*m_Vel[i];
+
+    // The tips are in order, so that (as before) a tip which is inside the sphere knocks it
+    // away, and the tips after it no longer affect it.
+    m_NearbyTips.clear();
+    m_Grid.Query(center, m_NearbyTips);
+    for (size_t n = 0; n < m_NearbyTips.size(); n++) {
+      const EigenTypes::Vector3f diff = tips[m_NearbyTips[n]] - center;
+      const float distSq = diff.squaredNorm();
+      if (distSq > influenceSq) {
+        continue;
+      }
+      if (distSq < m_Radius[i]*m_Radius[i]) {
+        m_Vel[i] += -diff.normalized();
+        break;
+      }
+      accel += well*PullScale(distSq)*diff;
+    }
+
+    m_Disp[i] += 0.5f*m_Vel[i]*deltaT;
+    m_Vel[i] += accel*deltaT;
+    m_Disp[i] += 0.5f*m_Vel[i]*deltaT;
+  }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "SpatialHash.h"
+
+#include "EigenTypes.h"
+
+#include <vector>
+
+// The spheres of SpheresLayer, each of which hangs on a spring at its rest position and is
+// pushed or pulled by the fingertips.  A tip only affects the spheres within INFLUENCE_RADIUS of
+// it, so each step puts the tips into a SpatialHash, in which each sphere looks up the few tips
+// which might reach it.  A step then costs about O(spheres + tips) rather than O(spheres*tips).
+// This doesn't make any GL calls.
+class SpherePhysics {
+public:
+  // The pull of a tip falls off with the cube of the distance.  Its strength at this radius
+  // (which would move a sphere about 6 mm against its spring) is subtracted from it, so that it
+  // fades out there instead of cutting off, and spheres don't jump as tips come and go.
+  static const float INFLUENCE_RADIUS;
+
+  SpherePhysics();
+
+  // The spheres of SpheresLayer are scattered between 0.4 and this distance from its center,
+  // which is 0.6 for its 300 spheres, and further out for more so that they're no more crowded.
+  static float ShellOuterRadius(int numSpheres);
+
+  void AddSphere(const EigenTypes::Vector3f& position, float radius);
+  int NumSpheres() const { return static_cast<int>(m_Pos.size()); }
+
+  const EigenTypes::Vector3f& Position(int i) const { return m_Pos[i]; }
+  const EigenTypes::Vector3f& Displacement(int i) const { return m_Disp[i]; }
+  const EigenTypes::Vector3f& Velocity(int i) const { return m_Vel[i]; }
+  float Radius(int i) const { return m_Radius[i]; }
+
+  // spring and damp scale the spring's stiffness and damping, and well scales the pull of the
+  // tips (which push instead if it's positive).
+  void Step(const EigenTypes::stdvectorV3f& tips, float deltaT, float spring, float damp, float well);
+
+private:
+  EigenTypes::stdvectorV3f m_Pos;
+  EigenTypes::stdvectorV3f m_Disp;
+  EigenTypes::stdvectorV3f m_Vel;
+  std::vector<float> m_Radius;
+
+  SpatialHash m_Grid;
+  std::vector<int> m_NearbyTips;
+};
@@ -2,19 +2,55 @@
 #include "SpheresLayer.h"
 
 #include "GLController.h"
+#include "GLShader.h"
+#include "GLShaderMatrices.h"
+#include "Resource.h"
+#include "TextFileLoader.h"
 
-SpheresLayer::SpheresLayer(const EigenTypes::Vector3f& initialEyePos) :
+namespace {
+
+// The resolution of the unit sphere which Sphere draws.
+const int SPHERE_WIDTH_RESOLUTION = 48;
+const int SPHERE_HEIGHT_RESOLUTION = 24;
+
+void VertexAttribDivisor(GLuint index, GLuint divisor) {
+  if (GLEW_VERSION_3_3) {
+    glVertexAttribDivisor(index, divisor);
+  } else {
+    glVertexAttribDivisorARB(index, divisor);
+  }
+}
+
+// In a compatibility context nothing is drawn unless attribute 0 is an enabled array, and without
+// instancing the other attributes are constants, so the sphere's positions have to be at 0.
+std::shared_ptr<GLShader> CreateSphereShader() {
+  GLShader::AttributeLocationMap attributeLocations;
+  attributeLocations["position"] = 0;
+  return std::make_shared<GLShader>(Resource<TextFile>("shaders/spheres-vert.glsl")->Contents(), Resource<TextFile>("shaders/spheres-frag.glsl")->Contents(), attributeLocations);
+}
+
+void DrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices, GLsizei primcount) {
+  if (GLEW_VERSION_3_3) {
+    glDrawElementsInstanced(mode, count, type, indices, primcount);
+  } else {
+    glDrawElementsInstancedARB(mode, count, type, indices, primcount);
+  }
+}
+
+}
+
+SpheresLayer::SpheresLayer(const EigenTypes::Vector3f& initialEyePos, int numSpheres, bool instanced) :
   InteractionLayer(initialEyePos),
-  m_Pos(NUM_SPHERES),
-  m_Disp(NUM_SPHERES, EigenTypes::Vector3f::Zero()),
-  m_Vel(NUM_SPHERES, EigenTypes::Vector3f::Zero()),
-  m_Colors(NUM_SPHERES),
-  m_Mono(NUM_SPHERES),
-  m_Radius(NUM_SPHERES),
+  m_SphereShader(CreateSphereShader()),
+  m_NumSphereIndices(0),
+  m_Instanced(instanced && IsInstancingSupported()),
+  m_Colors(numSpheres),
+  m_Mono(numSpheres),
   m_Spring(1.0f),
   m_Damp(1.0f),
   m_Well(-1.0f) {
-  for (int i = 0; i < NUM_SPHERES; i++) {
+  const float outer = SpherePhysics::ShellOuterRadius(numSpheres);
+  for (int i = 0; i < numSpheres; i++) {
     float z = (float)rand() / RAND_MAX * 2.0f - 1.0f;
     float theta = (float)rand() / RAND_MAX * 6.28318530718f;
     float xy = std::sqrt(1.0f - z*z);
@@ -24,65 +60,171 @@ SpheresLayer::SpheresLayer(const EigenTypes::Vector3f& initialEyePos) :
     float r = (float)rand() / RAND_MAX;
     float g = (float)rand() / RAND_MAX;
     float b = (float)rand() / RAND_MAX;
-    float dist = 0.40f + (float)rand() / RAND_MAX * 0.2f;
-    m_Radius[i] = 0.020f + (float)rand() / RAND_MAX * 0.03f;
-    m_Pos[i] = EigenTypes::Vector3f(0.0f, 1.7f, -5.0f) + EigenTypes::Vector3f(x, y, z)*dist;
+    float dist = 0.40f + (float)rand() / RAND_MAX * (outer - 0.40f);
+    const float radius = 0.020f + (float)rand() / RAND_MAX * 0.03f;
+    m_Physics.AddSphere(EigenTypes::Vector3f(0.0f, 1.7f, -5.0f) + EigenTypes::Vector3f(x, y, z)*dist, radius);
     m_Colors[i] = EigenTypes::Vector3f(r, g, b).normalized();
     m_Mono[i] = EigenTypes::Vector3f::Ones()*m_Colors[i].sum()*0.33f;
   }
+
+  m_Grid.AddSphereGrid(22, 40);
+  m_Grid.Upload();
+
+  CreateSphereMesh();
+  if (m_Instanced) {
+    m_InstanceBuffer.Create(GL_ARRAY_BUFFER);
+  }
+  UploadInstances();
+}
+
+SpheresLayer::~SpheresLayer() {
+  m_SphereVertices.Destroy();
+  m_SphereIndices.Destroy();
+  if (m_Instanced) {
+    m_InstanceBuffer.Destroy();
+  }
+}
+
+void SpheresLayer::CreateSphereMesh() {
+  std::vector<float> vertices;
+  for (int i = 0; i <= SPHERE_HEIGHT_RESOLUTION; i++) {
+    const float phi = (float)M_PI*(i/static_cast<float>(SPHERE_HEIGHT_RESOLUTION) - 0.5f);
+    for (int j = 0; j <= SPHERE_WIDTH_RESOLUTION; j++) {
+      const float theta = 2*(float)M_PI*(j/static_cast<float>(SPHERE_WIDTH_RESOLUTION));
+      vertices.push_back(cos(phi)*cos(theta));
+      vertices.push_back(sin(phi));
+      vertices.push_back(-cos(phi)*sin(theta));
+    }
+  }
+  std::vector<GLushort> indices;
+  const int rowSize = SPHERE_WIDTH_RESOLUTION + 1;
+  for (int i = 0; i < SPHERE_HEIGHT_RESOLUTION; i++) {
+    for (int j = 0; j < SPHERE_WIDTH_RESOLUTION; j++) {
+      const GLushort a = static_cast<GLushort>(i*rowSize + j);
+      const GLushort b = static_cast<GLushort>(a + rowSize);
+      // Counterclockwise from outside.
+      const GLushort quad[] = { a, static_cast<GLushort>(a + 1), static_cast<GLushort>(b + 1), a, static_cast<GLushort>(b + 1), b };
+      indices.insert(indices.end(), quad, quad + 6);
+    }
+  }
+  m_NumSphereIndices = static_cast<int>(indices.size());
+
+  m_SphereVertices.Create(GL_ARRAY_BUFFER);
+  m_SphereVertices.Bind();
+  m_SphereVertices.Allocate(vertices.data(), vertices.size()*sizeof(float), GL_STATIC_DRAW);
+  m_SphereVertices.Unbind();
+  m_SphereIndices.Create(GL_ELEMENT_ARRAY_BUFFER);
+  m_SphereIndices.Bind();
+  m_SphereIndices.Allocate(indices.data(), indices.size()*sizeof(GLushort), GL_STATIC_DRAW);
+  m_SphereIndices.Unbind();
 }
 
 void SpheresLayer::Update(TimeDelta real_time_delta) {
   ComputePhysics(real_time_delta);
+  UploadInstances();
+}
+
+void SpheresLayer::UploadInstances() {
+  const int numSpheres = m_Physics.NumSpheres();
+  m_Instances.resize(FLOATS_PER_INSTANCE*numSpheres);
+  for (int j = 0; j < numSpheres; j++) {
+    const EigenTypes::Vector3f& disp = m_Physics.Displacement(j);
+    float desaturation = 0.005f / (0.005f + disp.squaredNorm());
+    EigenTypes::Vector3f color = m_Colors[j]*(1.0f - desaturation) + m_Mono[j]*desaturation;
+    const EigenTypes::Vector3f center = m_Physics.Position(j) + disp;
+
+    float* instance = &m_Instances[FLOATS_PER_INSTANCE*j];
+    instance[0] = center.x();
+    instance[1] = center.y();
+    instance[2] = center.z();
+    instance[3] = m_Physics.Radius(j);
+    instance[4] = color.x();
+    instance[5] = color.y();
+    instance[6] = color.z();
+  }
+
+  // Both eyes draw the same instances, so they're uploaded once per step, into a fresh buffer
+  // rather than one the last frame may still be drawing from.
+  if (m_Instanced) {
+    m_InstanceBuffer.Bind();
+    m_InstanceBuffer.Allocate(m_Instances.data(), m_Instances.size()*sizeof(float), GL_STREAM_DRAW);
+    m_InstanceBuffer.Unbind();
+  }
 }
 
 void SpheresLayer::Render(TimeDelta real_time_delta) const {
   glEnable(GL_BLEND);
-  m_Shader->Bind();
+  RenderSpheres();
+  RenderGrid();
+}
+
+void SpheresLayer::RenderSpheres() const {
+  const int numSpheres = static_cast<int>(m_Instances.size())/FLOATS_PER_INSTANCE;
+  if (numSpheres == 0) {
+    return;
+  }
+
+  // The shader, matrices and lighting are set once for all the spheres.
+  m_SphereShader->Bind();
+  GLShaderMatrices::UploadUniforms(*m_SphereShader, m_ModelView.cast<double>(), m_Projection.cast<double>(), BindFlags::NONE);
   const EigenTypes::Vector3f desiredLightPos(0, 1.5, 0.5);
   const EigenTypes::Vector3f lightPos = m_EyeView*desiredLightPos;
-  const int lightPosLoc = m_Shader->LocationOfUniform("light_position");
-  glUniform3f(lightPosLoc, lightPos[0], lightPos[1], lightPos[2]);
+  m_SphereShader->SetUniformf("light_position", lightPos);
+  m_SphereShader->SetUniformf("ambient_lighting_proportion", 0.3f);
+  m_SphereShader->SetUniformf("alpha", m_Alpha);
 
-  // Common property
-  m_Sphere.Material().SetAmbientLightingProportion(0.3f);
+  const GLint positionLoc = m_SphereShader->LocationOfAttribute("position");
+  const GLint sphereLoc = m_SphereShader->LocationOfAttribute("sphere");
+  const GLint colorLoc = m_SphereShader->LocationOfAttribute("sphere_color");
+  m_SphereVertices.Bind();
+  glEnableVertexAttribArray(positionLoc);
+  glVertexAttribPointer(positionLoc, 3, GL_FLOAT, GL_FALSE, 3*sizeof(float), 0);
+  m_SphereVertices.Unbind();
+  m_SphereIndices.Bind();
 
-  for (size_t j = 0; j < NUM_SPHERES; j++) {
-    float desaturation = 0.005f / (0.005f + m_Disp[j].squaredNorm());
-    EigenTypes::Vector3f color = m_Colors[j]*(1.0f - desaturation) + m_Mono[j]*desaturation;
+  if (m_Instanced) {
+    const GLsizei stride = FLOATS_PER_INSTANCE*sizeof(float);
+    m_InstanceBuffer.Bind();
+    glEnableVertexAttribArray(sphereLoc);
+    glEnableVertexAttribArray(colorLoc);
+    glVertexAttribPointer(sphereLoc, 4, GL_FLOAT, GL_FALSE, stride, 0);
+    glVertexAttribPointer(colorLoc, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid*)(4*sizeof(float)));
+    VertexAttribDivisor(sphereLoc, 1);
+    VertexAttribDivisor(colorLoc, 1);
+    m_InstanceBuffer.Unbind();
+
+    DrawElementsInstanced(GL_TRIANGLES, m_NumSphereIndices, GL_UNSIGNED_SHORT, 0, numSpheres);
 
-    m_Sphere.SetRadius(m_Radius[j]);
-    m_Sphere.Translation() = (m_Pos[j] + m_Disp[j]).cast<double>();
-    m_Sphere.Material().SetDiffuseLightColor(Color(color.x(), color.y(), color.z(), m_Alpha));
-    m_Sphere.Material().SetAmbientLightColor(Color(color.x(), color.y(), color.z(), m_Alpha));
-    PrimitiveBase::DrawSceneGraph(m_Sphere, m_Renderer);
+    // The divisors belong to the attribute indices rather than to this shader.
+    VertexAttribDivisor(sphereLoc, 0);
+    VertexAttribDivisor(colorLoc, 0);
+    glDisableVertexAttribArray(sphereLoc);
+    glDisableVertexAttribArray(colorLoc);
+  } else {
+    // On GL 2.1 each sphere is still a draw call, but only its attributes change in between.
+    for (int j = 0; j < numSpheres; j++) {
+      const float* instance = &m_Instances[FLOATS_PER_INSTANCE*j];
+      glVertexAttrib4fv(sphereLoc, instance);
+      glVertexAttrib3fv(colorLoc, instance + 4);
+      glDrawElements(GL_TRIANGLES, m_NumSphereIndices, GL_UNSIGNED_SHORT, 0);
+    }
   }
-  m_Shader->Unbind();
-  RenderGrid();
+
+  m_SphereIndices.Unbind();
+  glDisableVertexAttribArray(positionLoc);
+  m_SphereShader->Unbind();
 }
 
 void SpheresLayer::RenderGrid() const {
-  const int divTheta = 22;
-  const int divPhi = 40;
   const float radius = 0.7f;
 
-  glTranslatef(m_EyePos.x(), m_EyePos.y(), m_EyePos.z());
-  glColor4f(0.2f, 0.6f, 1.0f, m_Alpha*0.5f);
-  glLineWidth(1.0f);
-  glBegin(GL_LINES);
-  for (int i = 0; i < divPhi; i++) {
-    float phi0 = (float)M_PI*(i/static_cast<float>(divPhi) - 0.5f);
-    float phi1 = (float)M_PI*((i + 1)/static_cast<float>(divPhi) - 0.5f);
-    for (int j = 0; j < divTheta; j++) {
-      float theta0 = 2*(float)M_PI*(j/static_cast<float>(divTheta));
-      float theta1 = 2*(float)M_PI*((j + 1)/static_cast<float>(divTheta));
-      glVertex3f(radius*cos(phi0)*cos(theta0), radius*sin(phi0), radius*cos(phi0)*sin(theta0));
-      glVertex3f(radius*cos(phi0)*cos(theta1), radius*sin(phi0), radius*cos(phi0)*sin(theta1));
-      glVertex3f(radius*cos(phi0)*cos(theta0), radius*sin(phi0), radius*cos(phi0)*sin(theta0));
-      glVertex3f(radius*cos(phi1)*cos(theta0), radius*sin(phi1), radius*cos(phi1)*sin(theta0));
-    }
-  }
-  glEnd();
+  EigenTypes::Matrix4x4f modelView = m_ModelView;
+  modelView.block<3, 1>(0, 3) += modelView.block<3, 3>(0, 0)*m_EyePos;
+  modelView.block<3, 3>(0, 0) *= radius;
+
+  LineMesh::Appearance appearance;
+  appearance.color << 0.2f, 0.6f, 1.0f, m_Alpha*0.5f;
+  m_Grid.Draw(modelView, m_Projection, appearance);
 }
 
 EventHandlerAction SpheresLayer::HandleKeyboardEvent(const SDL_KeyboardEvent &ev) {
@@ -93,31 +235,5 @@ EventHandlerAction SpheresLayer::HandleKeyboardEvent(const SDL_KeyboardEvent &ev
 }
 
 void SpheresLayer::ComputePhysics(TimeDelta real_time_delta) {
-  const int num_tips = static_cast<int>(m_Tips.size());
-  // std::cout << __LINE__ << ":\t   deltaT = " << (deltaT) << std::endl;
-  for (int i = 0; i < NUM_SPHERES; i++) {
-    static const float K = 10;
-    static const float D = 3;
-    static const float A = 0.0015f;
-    static const float AA = 0.00005f;
-
-    EigenTypes::Vector3f accel = -K*m_Spring*m_Disp[i] -D*m_Damp*m_Vel[i];
-    // std::cout << __LINE__ << ":\t     num_tips = " << (num_tips) << std::endl;
-    for (int j = 0; j < num_tips; j++) {
-
-      // std::cout << __LINE__ << ":\t       (positions[i] - tips[j]).squaredNorm() = " << ((positions[i] - tips[j]).squaredNorm()) << std::endl;
-      const EigenTypes::Vector3f diff = m_Tips[j] - (m_Pos[i] + m_Disp[i]);
-      float distSq = diff.squaredNorm();
-      if (distSq < m_Radius[i]*m_Radius[i]) {
-        m_Vel[i] += -diff.normalized();
-        break;
-      }
-      accel += A*m_Well*diff/(AA + distSq*distSq);
-      // accel += A*m_Well*diff/(AA + distSq*diff.norm());
-    }
-
-    m_Disp[i] += 0.5f*m_Vel[i]*static_cast<float>(real_time_delta);
-    m_Vel[i] += accel*static_cast<float>(real_time_delta);
-    m_Disp[i] += 0.5f*m_Vel[i]*static_cast<float>(real_time_delta);
-  }
+  m_Physics.Step(m_Tips, static_cast<float>(real_time_delta), m_Spring, m_Damp, m_Well);
 }
@@ -1,13 +1,18 @@
 #pragma once
 
 #include "Interactionlayer.h"
+#include "LineMesh.h"
+#include "SpherePhysics.h"
 
 class GLShader;
 
 class SpheresLayer : public InteractionLayer {
 public:
-  SpheresLayer(const EigenTypes::Vector3f& initialEyePos);
-  //virtual ~SpheresLayer ();
+  static const int DEFAULT_NUM_SPHERES = 300;
+
+  // If instanced is false, the spheres are drawn one per draw call even if instancing is supported.
+  SpheresLayer(const EigenTypes::Vector3f& initialEyePos, int numSpheres = DEFAULT_NUM_SPHERES, bool instanced = true);
+  virtual ~SpheresLayer();
 
   virtual void Update(TimeDelta real_time_delta) override;
   virtual void Render(TimeDelta real_time_delta) const override;
@@ -15,19 +20,39 @@ public:
 
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
+  // Whether the spheres are drawn with a single instanced draw call (GL 3.3 or
+  // ARB_instanced_arrays), rather than with one draw call per sphere.
+  static bool IsInstancingSupported() { return GLEW_VERSION_3_3 || GLEW_ARB_instanced_arrays; }
+
 private:
-  static const int NUM_SPHERES = 300;
+  // Each sphere's center, radius and color, as read by shaders/spheres.
+  static const int FLOATS_PER_INSTANCE = 7;
 
+  void CreateSphereMesh();
+  void UploadInstances();
+  void RenderSpheres() const;
   virtual void RenderGrid() const;
   void ComputePhysics(TimeDelta real_time_delta);
 
-  EigenTypes::stdvectorV3f m_Pos;
-  EigenTypes::stdvectorV3f m_Disp;
-  EigenTypes::stdvectorV3f m_Vel;
-  
+  SpherePhysics m_Physics;
+
+  // All the spheres are drawn from one unit sphere, whose positions are also its normals, with
+  // the same shader, whose position attribute is bound to location 0.  m_Instances is refilled after each step, and also uploaded to
+  // m_InstanceBuffer if instancing is supported; otherwise it's passed sphere by sphere as
+  // constant attributes.
+  std::shared_ptr<GLShader> m_SphereShader;
+  mutable GLBuffer m_SphereVertices;
+  mutable GLBuffer m_SphereIndices;
+  int m_NumSphereIndices;
+  mutable GLBuffer m_InstanceBuffer;
+  std::vector<float> m_Instances;
+  bool m_Instanced;
+
+  // The unit sphere grid around the eye.
+  LineMesh m_Grid;
+
   EigenTypes::stdvectorV3f m_Colors;
   EigenTypes::stdvectorV3f m_Mono;
-  std::vector<float> m_Radius;
 
   float m_Spring;
   float m_Damp;
@@ -0,0 +1,166 @@
+#include "stdafx.h"
+#include "StarSimulation.h"
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <future>
+
+namespace {
+
+typedef Eigen::Array4f Lanes;
+const int LANES = 4;
+
+// Large enough to amortize scheduling, and a multiple of LANES so only the last chunk is ragged.
+const int STARS_PER_TASK = 4096;
+
+// Loads count (at most LANES) consecutive values; missing lanes repeat the first value, so that
+// they stay finite.
+Lanes Load(const float* values, int count) {
+  if (count == LANES) {
+    return Eigen::Map<const Lanes>(values);
+  }
+  Lanes lanes = Lanes::Constant(values[0]);
+  for (int l = 1; l < count; l++) {
+    lanes[l] = values[l];
+  }
+  return lanes;
+}
+
+void Store(const Lanes& lanes, float* values, int count) {
+  if (count == LANES) {
+    Eigen::Map<Lanes> map(values);
+    map = lanes;
+  } else {
+    for (int l = 0; l < count; l++) {
+      values[l] = lanes[l];
+    }
+  }
+}
+
+// Applies the pull of every galaxy and then every hand to v, as SpaceLayer::UpdateV did for one
+// star; the hands pull towards a point lead*v ahead of the star.
+void Attract(const StarSimulation::Attractors& attractors, const Lanes& lead,
+             const Lanes& x, const Lanes& y, const Lanes& z, Lanes& vx, Lanes& vy, Lanes& vz) {
+  for (size_t g = 0; g < attractors.galaxyPositions.size(); g++) {
+    const EigenTypes::Vector3f& galaxy = attractors.galaxyPositions[g];
+    const Lanes dx = galaxy.x() - x;
+    const Lanes dy = galaxy.y() - y;
+    const Lanes dz = galaxy.z() - z;
+    const Lanes d2 = dx*dx + dy*dy + dz*dz;
+    // mass*normalized(dr)/(0.3e-3 + |dr|^2)
+    const Lanes scale = attractors.galaxyMasses[g]*(d2.sqrt()*(0.3e-3f + d2)).inverse();
+    vx += scale*dx;
+    vy += scale*dy;
+    vz += scale*dz;
+  }
+  for (size_t h = 0; h < attractors.handPositions.size(); h++) {
+    const EigenTypes::Vector3f& hand = attractors.handPositions[h];
+    const Lanes dx = hand.x() - (x + lead*vx);
+    const Lanes dy = hand.y() - (y + lead*vy);
+    const Lanes dz = hand.z() - (z + lead*vz);
+    const Lanes scale = 1e-3f*(1e-2f + dx*dx + dy*dy + dz*dz).inverse();
+    vx += scale*dx;
+    vy += scale*dy;
+    vz += scale*dz;
+  }
+}
+
+}
+
+void StarSimulation::Resize(int numStars) {
+  m_PosX.resize(numStars);
+  m_PosY.resize(numStars);
+  m_PosZ.resize(numStars);
+  m_VelX.resize(numStars);
+  m_VelY.resize(numStars);
+  m_VelZ.resize(numStars);
+}
+
+void StarSimulation::SetStar(int i, const EigenTypes::Vector3f& position, const EigenTypes::Vector3f& velocity) {
+  m_PosX[i] = position.x();
+  m_PosY[i] = position.y();
+  m_PosZ[i] = position.z();
+  m_VelX[i] = velocity.x();
+  m_VelY[i] = velocity.y();
+  m_VelZ[i] = velocity.z();
+}
+
+void StarSimulation::Step(const Attractors& attractors, int numActive, float* output, size_t outputStride) {
+  numActive = std::min(numActive, NumStars());
+  if (numActive <= 0) {
+    return;
+  }
+  // The first chunk is integrated on this thread, which would otherwise just wait.
+  std::vector<std::future<void>> results;
+  for (int begin = STARS_PER_TASK; begin < numActive; begin += STARS_PER_TASK) {
+    const int end = std::min(begin + STARS_PER_TASK, numActive);
+    results.push_back(ThreadPool::Shared().Submit([this, &attractors, numActive, begin, end, output, outputStride] {
+      StepRange(attractors, numActive, begin, end, output, outputStride);
+    }));
+  }
+  StepRange(attractors, numActive, 0, std::min(STARS_PER_TASK, numActive), output, outputStride);
+  for (std::future<void>& result : results) {
+    result.get();
+  }
+}
+
+void StarSimulation::StepRange(const Attractors& attractors, int numActive, int begin, int end, float* output, size_t outputStride) {
+  const Lanes respawnX = Lanes::Constant(attractors.eyePos.x() + attractors.respawnOffset.x());
+  const Lanes respawnY = Lanes::Constant(attractors.eyePos.y() + attractors.respawnOffset.y());
+  const Lanes respawnZ = Lanes::Constant(attractors.eyePos.z() + attractors.respawnOffset.z());
+  const float numStars = static_cast<float>(NumStars());
+
+  for (int i = begin; i < end; i += LANES) {
+    const int count = std::min(LANES, end - i);
+    Lanes lead;
+    for (int l = 0; l < LANES; l++) {
+      const int type = static_cast<int>(static_cast<float>(i + l)*numStars/numActive);
+      lead[l] = 0.1f + static_cast<float>(type)*0.00003f;
+    }
+    Lanes x = Load(&m_PosX[i], count);
+    Lanes y = Load(&m_PosY[i], count);
+    Lanes z = Load(&m_PosZ[i], count);
+    Lanes vx = Load(&m_VelX[i], count);
+    Lanes vy = Load(&m_VelY[i], count);
+    Lanes vz = Load(&m_VelZ[i], count);
+
+    // A predictor-corrector step: the velocity is first integrated at the current position, and
+    // then (from the old velocity) at the position that predicts.
+    Lanes tempVx = vx;
+    Lanes tempVy = vy;
+    Lanes tempVz = vz;
+    Attract(attractors, lead, x, y, z, tempVx, tempVy, tempVz);
+    Attract(attractors, lead, x + 0.667f*tempVx, y + 0.667f*tempVy, z + 0.667f*tempVz, vx, vy, vz);
+    x += 0.25f*tempVx + 0.75f*vx;
+    y += 0.25f*tempVy + 0.75f*vy;
+    z += 0.25f*tempVz + 0.75f*vz;
+
+    const Lanes ex = x - attractors.eyePos.x();
+    const Lanes ey = y - attractors.eyePos.y();
+    const Lanes ez = z - attractors.eyePos.z();
+    const Eigen::Array<bool, LANES, 1> lost = (ex*ex + ey*ey + ez*ez) > 50.0f;
+    x = lost.select(respawnX - 10.0f*vx, x);
+    y = lost.select(respawnY - 10.0f*vy, y);
+    z = lost.select(respawnZ - 10.0f*vz, z);
+    vx = lost.select(Lanes::Zero(), vx);
+    vy = lost.select(Lanes::Zero(), vy);
+    vz = lost.select(Lanes::Zero(), vz);
+
+    Store(x, &m_PosX[i], count);
+    Store(y, &m_PosY[i], count);
+    Store(z, &m_PosZ[i], count);
+    Store(vx, &m_VelX[i], count);
+    Store(vy, &m_VelY[i], count);
+    Store(vz, &m_VelZ[i], count);
+    for (int l = 0; l < count; l++) {
+      float* star = output + (i + l)*outputStride;
+      star[0] = x[l];
+      star[1] = y[l];
+      star[2] = z[l];
+      star[3] = vx[l];
+      star[4] = vy[l];
+      star[5] = vz[l];
+    }
+  }
+}
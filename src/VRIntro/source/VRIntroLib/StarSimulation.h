@@ -0,0 +1,49 @@
+#pragma once
+
+#include "EigenTypes.h"
+
+#include <vector>
+
+// The stars of SpaceLayer, which orbit the galaxies and are pulled along by the hands.  Their
+// positions and velocities are kept as separate x, y and z arrays, so that Step can integrate
+// four stars at a time with Eigen's SIMD arrays, and the stars are split into chunks which are
+// integrated across ThreadPool::Shared().  This doesn't make any GL calls.
+class StarSimulation {
+public:
+  // What the stars are integrated against, which doesn't change during a step.
+  struct Attractors {
+    EigenTypes::stdvectorV3f galaxyPositions;
+    std::vector<float> galaxyMasses;
+    EigenTypes::stdvectorV3f handPositions;
+    // Stars which stray too far from the eye are put back near it.
+    EigenTypes::Vector3f eyePos;
+    EigenTypes::Vector3f respawnOffset;
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  };
+
+  StarSimulation() {}
+
+  void Resize(int numStars);
+  int NumStars() const { return static_cast<int>(m_PosX.size()); }
+
+  void SetStar(int i, const EigenTypes::Vector3f& position, const EigenTypes::Vector3f& velocity);
+  EigenTypes::Vector3f Position(int i) const { return EigenTypes::Vector3f(m_PosX[i], m_PosY[i], m_PosZ[i]); }
+  EigenTypes::Vector3f Velocity(int i) const { return EigenTypes::Vector3f(m_VelX[i], m_VelY[i], m_VelZ[i]); }
+
+  // Advances the first numActive stars by one step, and writes each one's position and velocity
+  // (6 floats) to output + i*outputStride, e.g. straight into an interleaved vertex array.  The
+  // "type" of a star, which spreads out how far ahead of it the hands pull, depends on its index
+  // relative to numActive.
+  void Step(const Attractors& attractors, int numActive, float* output, size_t outputStride);
+
+private:
+  void StepRange(const Attractors& attractors, int numActive, int begin, int end, float* output, size_t outputStride);
+
+  std::vector<float> m_PosX;
+  std::vector<float> m_PosY;
+  std::vector<float> m_PosZ;
+  std::vector<float> m_VelX;
+  std::vector<float> m_VelY;
+  std::vector<float> m_VelZ;
+};
@@ -0,0 +1,39 @@
+#include "SpherePhysicsFixture.h"
+
+#include <chrono>
+#include <iostream>
+
+using namespace EigenTypes;
+
+// Reports the time per step of finding the tips near each sphere through the spatial hash, against
+// the loop over every sphere and every tip.  SpherePhysicsTest checks that the two agree.
+
+class SpherePhysicsBenchmark : public SpherePhysicsFixture {
+protected:
+  static double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+};
+
+TEST_F(SpherePhysicsBenchmark, ScalesToThousandsOfSpheres) {
+  const int counts[] = { 300, 3000, 30000 };
+  for (int c = 0; c < 3; c++) {
+    const int steps = 3000000/(counts[c]*10) + 1;
+    CreateSpheres(counts[c]);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int step = 0; step < steps; step++) {
+      m_Reference.Step(Tips(step), DELTA_T, 1.0f, 1.0f, -1.0f, false);
+    }
+    const double reference = MillisecondsSince(start)/steps;
+
+    start = std::chrono::steady_clock::now();
+    for (int step = 0; step < steps; step++) {
+      m_Physics.Step(Tips(step), DELTA_T, 1.0f, 1.0f, -1.0f);
+    }
+    const double hashed = MillisecondsSince(start)/steps;
+
+    std::cout << counts[c] << " spheres, 10 tips: " << reference << " ms/step for every pair, " << hashed
+              << " ms/step with the spatial hash (" << reference/hashed << "x)" << std::endl;
+  }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "SpherePhysics.h"
+
+#include <cmath>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+// The spheres and the reference loop shared by SpherePhysicsTest and SpherePhysicsBenchmark.
+
+// The loop over every sphere and every tip which SpheresLayer used before SpherePhysics, as a
+// reference.  If limited, the tips' pull is cut off as in SpherePhysics.
+class ReferenceSpheres {
+public:
+  void Step(const EigenTypes::stdvectorV3f& tips, float deltaT, float spring, float damp, float well, bool limited) {
+    const float radius = SpherePhysics::INFLUENCE_RADIUS;
+    static const float K = 10;
+    static const float D = 3;
+    static const float A = 0.0015f;
+    static const float AA = 0.00005f;
+    for (size_t i = 0; i < pos.size(); i++) {
+      EigenTypes::Vector3f accel = -K*spring*disp[i] - D*damp*vel[i];
+      for (size_t j = 0; j < tips.size(); j++) {
+        const EigenTypes::Vector3f diff = tips[j] - (pos[i] + disp[i]);
+        float distSq = diff.squaredNorm();
+        float shift = 0.0f;
+        if (limited) {
+          if (distSq > radius*radius) {
+            continue;
+          }
+          shift = radius/(AA + radius*radius*radius*radius)/std::sqrt(distSq);
+        }
+        if (distSq < radii[i]*radii[i]) {
+          vel[i] += -diff.normalized();
+          break;
+        }
+        accel += A*well*(1.0f/(AA + distSq*distSq) - shift)*diff;
+      }
+      disp[i] += 0.5f*vel[i]*deltaT;
+      vel[i] += accel*deltaT;
+      disp[i] += 0.5f*vel[i]*deltaT;
+    }
+  }
+
+  EigenTypes::stdvectorV3f pos;
+  EigenTypes::stdvectorV3f disp;
+  EigenTypes::stdvectorV3f vel;
+  std::vector<float> radii;
+};
+
+const float DELTA_T = 1.0f/75.0f;
+const EigenTypes::Vector3f CENTER(0.0f, 1.7f, -5.0f);
+
+// Spheres scattered through the shell of SpheresLayer (which grows with the number of spheres,
+// as in SpheresLayer), and two hands' worth of tips moving along its inside.
+class SpherePhysicsFixture : public testing::Test {
+protected:
+  void CreateSpheres(int numSpheres) {
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    m_Physics = SpherePhysics();
+    m_Reference = ReferenceSpheres();
+    const float outer = SpherePhysics::ShellOuterRadius(numSpheres);
+    for (int i = 0; i < numSpheres; i++) {
+      const float z = 2.0f*unit(random) - 1.0f;
+      const float theta = 6.28318530718f*unit(random);
+      const float xy = std::sqrt(1.0f - z*z);
+      const float dist = 0.40f + (outer - 0.40f)*unit(random);
+      const float radius = 0.020f + 0.03f*unit(random);
+      const EigenTypes::Vector3f position = CENTER + EigenTypes::Vector3f(xy*std::cos(theta), xy*std::sin(theta), z)*dist;
+      m_Physics.AddSphere(position, radius);
+      m_Reference.pos.push_back(position);
+      m_Reference.disp.push_back(EigenTypes::Vector3f::Zero());
+      m_Reference.vel.push_back(EigenTypes::Vector3f::Zero());
+      m_Reference.radii.push_back(radius);
+    }
+  }
+
+  static EigenTypes::stdvectorV3f Tips(int step) {
+    EigenTypes::stdvectorV3f tips;
+    for (int t = 0; t < 10; t++) {
+      const float angle = 0.05f*step + 0.3f*t;
+      tips.push_back(CENTER + EigenTypes::Vector3f((t < 5 ? -0.3f : 0.3f) + 0.05f*std::sin(angle), 0.5f*std::cos(angle), 0.02f*t));
+    }
+    return tips;
+  }
+
+  SpherePhysics m_Physics;
+  ReferenceSpheres m_Reference;
+};
@@ -0,0 +1,48 @@
+#include "SpherePhysicsFixture.h"
+
+#include <algorithm>
+
+using namespace EigenTypes;
+
+class SpherePhysicsTest : public SpherePhysicsFixture { };
+
+TEST_F(SpherePhysicsTest, MatchesTheReferenceWithinTheInfluenceRadius) {
+  CreateSpheres(2000);
+  int touched = 0;
+  for (int step = 0; step < 100; step++) {
+    const stdvectorV3f tips = Tips(step);
+    m_Physics.Step(tips, DELTA_T, 1.0f, 1.0f, -1.0f);
+    m_Reference.Step(tips, DELTA_T, 1.0f, 1.0f, -1.0f, true);
+  }
+  for (int i = 0; i < m_Physics.NumSpheres(); i++) {
+    ASSERT_TRUE((m_Physics.Displacement(i) - m_Reference.disp[i]).norm() < 1e-6f) << "sphere " << i;
+    ASSERT_TRUE((m_Physics.Velocity(i) - m_Reference.vel[i]).norm() < 1e-5f) << "sphere " << i;
+    if (m_Physics.Displacement(i).norm() > 0.05f) {
+      touched++;
+    }
+  }
+  // The tips did knock some spheres away.
+  EXPECT_GT(touched, 0);
+}
+
+TEST_F(SpherePhysicsTest, CuttingOffTheTipsMovesTheSpheresLittle) {
+  // The error at each sphere is at most the pull at INFLUENCE_RADIUS from each tip, which would
+  // move it about 6 mm.  First for one tip reaching towards the shell, and then for a cluster
+  // of five, which pull on the spheres without touching any.
+  for (int numTips = 1; numTips <= 5; numTips += 4) {
+    CreateSpheres(300);
+    stdvectorV3f tips;
+    for (int t = 0; t < numTips; t++) {
+      tips.push_back(CENTER + Vector3f(0.03f*t, 0.0f, -0.3f));
+    }
+    for (int step = 0; step < 300; step++) {
+      m_Physics.Step(tips, DELTA_T, 1.0f, 1.0f, -1.0f);
+      m_Reference.Step(tips, DELTA_T, 1.0f, 1.0f, -1.0f, false);
+    }
+    float largestError = 0.0f;
+    for (int i = 0; i < m_Physics.NumSpheres(); i++) {
+      largestError = std::max(largestError, (m_Physics.Displacement(i) - m_Reference.disp[i]).norm());
+    }
+    EXPECT_LT(largestError, numTips*0.006f) << numTips << " tips";
+  }
+}
@@ -0,0 +1,76 @@
+#include "SpheresLayer.h"
+
+#include "GLTestFramework.h"
+#include "Resource.h"
+#include "TextFileLoader.h"
+
+using namespace EigenTypes;
+
+namespace {
+
+const GLsizei WIDTH = 64;
+const GLsizei HEIGHT = 64;
+
+}
+
+// Draws a SpheresLayer looking at the shell of spheres, which is 5 m in front of the eye.
+class SpheresLayerTest : public GLTestFramework_Headless {
+protected:
+  virtual void SetUp() override {
+    GLTestFramework_Headless::SetUp();
+    Singleton<ResourceManager<TextFile>>::SafeRef().SetBasePath(VRINTRO_RESOURCE_PATH);
+    glViewport(0, 0, WIDTH, HEIGHT);
+  }
+
+  // Returns the number of pixels the layer draws onto a black background.
+  int DrawnPixels(SpheresLayer& layer) {
+    const Vector3f eyePos(0.0f, 1.7f, 0.0f);
+    Matrix4x4f modelView = Matrix4x4f::Identity();
+    modelView.block<3, 1>(0, 3) = -eyePos;
+    // A 30 degree field of view, from 0.1 m to 100 m.
+    const float n = 0.1f;
+    const float f = 100.0f;
+    const float focal = 1.0f/std::tan(0.5f*30.0f*(float)M_PI/180.0f);
+    Matrix4x4f projection = Matrix4x4f::Zero();
+    projection(0, 0) = focal;
+    projection(1, 1) = focal;
+    projection(2, 2) = (f + n)/(n - f);
+    projection(2, 3) = 2.0f*f*n/(n - f);
+    projection(3, 2) = -1.0f;
+
+    layer.UpdateEyePos(eyePos);
+    layer.UpdateEyeView(Matrix3x3f::Identity());
+    layer.SetModelView(modelView);
+    layer.SetProjection(projection);
+    layer.Alpha() = 1.0f;
+
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    layer.Render(0.0);
+    glDisable(GL_BLEND);
+
+    std::vector<GLubyte> pixels(4*WIDTH*HEIGHT);
+    glReadPixels(0, 0, WIDTH, HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    EXPECT_EQ(GLenum(GL_NO_ERROR), glGetError());
+    int drawn = 0;
+    for (size_t i = 0; i < pixels.size(); i += 4) {
+      if (pixels[i] != 0 || pixels[i + 1] != 0 || pixels[i + 2] != 0) {
+        drawn++;
+      }
+    }
+    return drawn;
+  }
+};
+
+TEST_F(SpheresLayerTest, DrawsSpheresWithoutInstancing) {
+  // Without any spheres only the grid around the eye is drawn.
+  SpheresLayer grid(Vector3f::Zero(), 0, false);
+  const int gridPixels = DrawnPixels(grid);
+
+  // Each sphere is then a separate draw call, whose center, radius and color are constant
+  // attributes, so only the sphere's positions are an array.
+  srand(0);
+  SpheresLayer spheres(Vector3f::Zero(), SpheresLayer::DEFAULT_NUM_SPHERES, false);
+  const int spheresPixels = DrawnPixels(spheres);
+  EXPECT_GT(spheresPixels, gridPixels + WIDTH*HEIGHT/20);
+}
@@ -0,0 +1,43 @@
+#include "StarSimulationFixture.h"
+
+#include <chrono>
+#include <iostream>
+
+using namespace EigenTypes;
+
+// Reports the time per step of integrating the stars in SIMD chunks across the thread pool, against
+// the loop over one star at a time.  StarSimulationTest checks that the two agree.
+
+class StarSimulationBenchmark : public StarSimulationFixture {
+protected:
+  static double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+};
+
+TEST_F(StarSimulationBenchmark, ScalesToTenTimesTheStars) {
+  const int STEPS = 10;
+  double millisecondsPerStar[2] = {0, 0};
+  const int counts[] = { 30000, 300000 };
+  for (int c = 0; c < 2; c++) {
+    CreateStars(counts[c]);
+    Step(counts[c]); // warm up the thread pool and the caches
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int step = 0; step < STEPS; step++) {
+      m_Reference.Step(m_Attractors, counts[c]);
+    }
+    const double reference = MillisecondsSince(start)/STEPS;
+
+    start = std::chrono::steady_clock::now();
+    for (int step = 0; step < STEPS; step++) {
+      Step(counts[c]);
+    }
+    const double simulation = MillisecondsSince(start)/STEPS;
+    millisecondsPerStar[c] = simulation/counts[c];
+
+    std::cout << counts[c] << " stars: " << reference << " ms/step one star at a time, " << simulation
+              << " ms/step in SIMD chunks (" << reference/simulation << "x)" << std::endl;
+  }
+  std::cout << "Cost per star at 10x the stars: " << millisecondsPerStar[1]/millisecondsPerStar[0] << "x" << std::endl;
+}
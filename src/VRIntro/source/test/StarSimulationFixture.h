@@ -0,0 +1,88 @@
+#pragma once
+
+#include "StarSimulation.h"
+
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+// The stars and the reference integration shared by StarSimulationTest and StarSimulationBenchmark.
+
+const int OUTPUT_STRIDE = 12;
+
+// The per-star loop which SpaceLayer used before StarSimulation, as a reference.
+class ReferenceStars {
+public:
+  void UpdateV(const StarSimulation::Attractors& attractors, int type, const EigenTypes::Vector3f& p, EigenTypes::Vector3f& v) const {
+    for (size_t g = 0; g < attractors.galaxyPositions.size(); g++) {
+      const EigenTypes::Vector3f dr = attractors.galaxyPositions[g] - p;
+      v += attractors.galaxyMasses[g]*dr.normalized()/(0.3e-3f + dr.squaredNorm());
+    }
+    for (size_t h = 0; h < attractors.handPositions.size(); h++) {
+      const EigenTypes::Vector3f dr = attractors.handPositions[h] - (p + (0.1f + static_cast<float>(type)*0.00003f)*v);
+      v += 1e-3f*dr/(1e-2f + dr.squaredNorm());
+    }
+  }
+
+  void Step(const StarSimulation::Attractors& attractors, int numActive) {
+    const int numStars = static_cast<int>(pos.size());
+    for (int i = 0; i < numActive; i++) {
+      const int type = static_cast<int>(static_cast<float>(i)*numStars/numActive);
+      EigenTypes::Vector3f tempV = vel[i];
+      UpdateV(attractors, type, pos[i], tempV);
+      const EigenTypes::Vector3f tempP = pos[i] + 0.667f*tempV;
+      UpdateV(attractors, type, tempP, vel[i]);
+      pos[i] += 0.25f*tempV + 0.75f*vel[i];
+
+      if ((pos[i] - attractors.eyePos).squaredNorm() > 50) {
+        pos[i] = attractors.eyePos - 10*vel[i] + attractors.respawnOffset;
+        vel[i].setZero();
+      }
+    }
+  }
+
+  EigenTypes::stdvectorV3f pos;
+  EigenTypes::stdvectorV3f vel;
+};
+
+// A disc of stars around one galaxy, as in SpaceLayer::InitPhysics, and a hand reaching into it.
+class StarSimulationFixture : public testing::Test {
+protected:
+  void SetUp() override {
+    m_Attractors.galaxyPositions.push_back(EigenTypes::Vector3f(0, -0.2f, -1.2f));
+    m_Attractors.galaxyMasses.push_back(30000*5e-11f);
+    m_Attractors.handPositions.push_back(EigenTypes::Vector3f(0.1f, -0.1f, -0.8f));
+    m_Attractors.eyePos.setZero();
+    m_Attractors.respawnOffset = EigenTypes::Vector3f(0, 0.5f, 0);
+  }
+
+  void CreateStars(int numStars) {
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> offset(-0.5f, 0.5f);
+    m_Stars.Resize(numStars);
+    m_Reference.pos.resize(numStars);
+    m_Reference.vel.resize(numStars);
+    for (int i = 0; i < numStars; i++) {
+      // Not too near the core, where close passes amplify the differences in rounding.
+      EigenTypes::Vector3f dr;
+      do {
+        dr = EigenTypes::Vector3f(offset(random), 0.1f*offset(random), offset(random));
+      } while (dr.norm() < 0.1f);
+      const EigenTypes::Vector3f position = m_Attractors.galaxyPositions[0] + dr;
+      const EigenTypes::Vector3f velocity = 1e-3f*EigenTypes::Vector3f(dr.z(), 0, -dr.x())/dr.norm();
+      m_Stars.SetStar(i, position, velocity);
+      m_Reference.pos[i] = position;
+      m_Reference.vel[i] = velocity;
+    }
+    m_Output.assign(OUTPUT_STRIDE*numStars, 0.0f);
+  }
+
+  void Step(int numActive) {
+    m_Stars.Step(m_Attractors, numActive, m_Output.data(), OUTPUT_STRIDE);
+  }
+
+  StarSimulation::Attractors m_Attractors;
+  StarSimulation m_Stars;
+  ReferenceStars m_Reference;
+  std::vector<float> m_Output;
+};
@@ -0,0 +1,36 @@
+#include "StarSimulationFixture.h"
+
+using namespace EigenTypes;
+
+class StarSimulationTest : public StarSimulationFixture { };
+
+TEST_F(StarSimulationTest, MatchesTheReference) {
+  // Not a multiple of the SIMD width, nor of the chunks which go to the thread pool.
+  const int numStars = 10003;
+  const int numActive = 9001;
+  CreateStars(numStars);
+  // One star far enough from the eye to be respawned.
+  m_Stars.SetStar(5, Vector3f(8, 0, 0), Vector3f(0, 0, 1e-3f));
+  m_Reference.pos[5] = Vector3f(8, 0, 0);
+  m_Reference.vel[5] = Vector3f(0, 0, 1e-3f);
+
+  for (int step = 0; step < 20; step++) {
+    Step(numActive);
+    m_Reference.Step(m_Attractors, numActive);
+  }
+
+  for (int i = 0; i < numStars; i++) {
+    ASSERT_TRUE(m_Stars.Position(i).isApprox(m_Reference.pos[i], 1e-4f)) << "star " << i;
+    ASSERT_TRUE((m_Stars.Velocity(i) - m_Reference.vel[i]).norm() < 1e-6f) << "star " << i;
+  }
+  // The output holds the last step, and nothing past the active stars was written.
+  for (int i = 0; i < numStars; i++) {
+    const float* star = &m_Output[OUTPUT_STRIDE*i];
+    if (i < numActive) {
+      EXPECT_EQ(m_Stars.Position(i), Vector3f(star[0], star[1], star[2]));
+      EXPECT_EQ(m_Stars.Velocity(i), Vector3f(star[3], star[4], star[5]));
+    } else {
+      EXPECT_EQ(Vector3f::Zero(), Vector3f(star[0], star[1], star[2]));
+    }
+  }
+}
@@ -34,6 +34,7 @@ void RiggedHandLayer::Update(TimeDelta real_time_delta) {
       for (int i=prevNumHands; i<numHands; i++) {
         mRiggedHands[i] = RiggedHandRef(new RiggedHand());
         mRiggedHands[i]->SetStyle(RiggedHand::MALE, RiggedHand::MEDIUM);
+        mRiggedHands[i]->SetSkinningMode(model::SkinnedVboMesh::GPU_PALETTE_SKINNING);
       }
       for (int i=0; i<numHands; i++) {
         setRiggedHandFromLeapHand(mRiggedHands[i], hands[i]);
@@ -90,7 +91,7 @@ void RiggedHandLayer::Render(TimeDelta real_time_delta) const {
 
   for (size_t i=0; i<mRiggedHands.size(); i++) {
     if (!mRiggedHands[i]->HandsShader()) {
-      mRiggedHands[i]->SetHandsShader(RiggedHand::getDefaultHandsShader());
+      mRiggedHands[i]->SetHandsShader(RiggedHand::getDefaultHandsShader(model::SkinnedVboMesh::GPU_PALETTE_SKINNING));
     }
 
     GLShaderRef shader = mRiggedHands[i]->HandsShader();
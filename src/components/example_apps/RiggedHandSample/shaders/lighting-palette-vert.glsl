@@ -0,0 +1,67 @@
+#version 120
+#extension GL_EXT_gpu_shader4 : require
+
+// As lighting-vert.glsl, but the bone matrices are fetched from a bone palette (see
+// model::BonePalette), which holds any number of bones: bone i's matrix is in texels 8*i to
+// 8*i+3 (one column each), and its inverse transposed matrix in the next 4.
+
+uniform mat4 projection_times_model_view_matrix;
+uniform mat4 model_view_matrix;
+uniform mat4 normal_matrix;
+
+// attribute arrays
+attribute vec3 position;
+attribute vec3 normal;
+attribute vec2 tex_coord;
+attribute vec4 boneWeights;
+attribute vec4 boneIndices;
+
+uniform bool isAnimated;
+uniform samplerBuffer bonePalette;
+
+varying vec3 outPosition;
+varying vec3 outNormal;
+varying vec2 outTexCoord;
+
+mat4 paletteMatrix(int texel)
+{
+	return mat4(texelFetchBuffer(bonePalette, texel),
+		texelFetchBuffer(bonePalette, texel + 1),
+		texelFetchBuffer(bonePalette, texel + 2),
+		texelFetchBuffer(bonePalette, texel + 3));
+}
+
+mat4 boneMatrix(float boneIndex)
+{
+	return paletteMatrix(8*int(boneIndex));
+}
+
+mat4 invTransposeMatrix(float boneIndex)
+{
+	return paletteMatrix(8*int(boneIndex) + 4);
+}
+
+void main()
+{	
+	vec4 pos = vec4(position, 1.0);
+	vec4 norm = vec4(normal, 0.0);
+	if( isAnimated ) {
+		pos =	boneMatrix(boneIndices.x) * pos * boneWeights.x +
+		boneMatrix(boneIndices.y) * pos * boneWeights.y +
+		boneMatrix(boneIndices.z) * pos * boneWeights.z +
+		boneMatrix(boneIndices.w) * pos * boneWeights.w ;
+		
+		norm =  invTransposeMatrix(boneIndices.x) * norm * boneWeights.x +
+		invTransposeMatrix(boneIndices.y) * norm * boneWeights.y +
+		invTransposeMatrix(boneIndices.z) * norm * boneWeights.z +
+		invTransposeMatrix(boneIndices.w) * norm * boneWeights.w ;
+		pos.w = 1.0;
+		norm.w = 0.0;
+	}
+	outPosition = (model_view_matrix * pos).xyz;
+	outNormal = (normal_matrix * norm).xyz;
+ 	outTexCoord = tex_coord;
+ 	outTexCoord.y = 1.0 - outTexCoord.y;
+
+	gl_Position = projection_times_model_view_matrix * pos;
+}
@@ -28,8 +28,8 @@ void GLBuffer::Allocate(const void* data, GLsizeiptr size_in_bytes, GLenum usage
   m_SizeInBytes = size_in_bytes;
 }
 
-void GLBuffer::Write(const void* data, int count) {
-  GL_THROW_UPON_ERROR(glBufferSubData(m_BufferType, 0, count, data));
+void GLBuffer::Write(const void* data, int count, GLintptr offset) {
+  GL_THROW_UPON_ERROR(glBufferSubData(m_BufferType, offset, count, data));
 }
 
 void* GLBuffer::Map(GLenum access) {
@@ -39,6 +39,13 @@ void* GLBuffer::Map(GLenum access) {
   return ptr;
 }
 
+void* GLBuffer::MapRange(GLintptr offset, GLsizeiptr size, GLbitfield access) {
+  Bind();
+  GL_THROW_UPON_ERROR(void *ptr = glMapBufferRange(m_BufferType, offset, size, access));
+  Unbind();
+  return ptr;
+}
+
 bool GLBuffer::Unmap() {
   Bind();
   GL_THROW_UPON_ERROR(bool result = glUnmapBuffer(m_BufferType) == GL_TRUE);
@@ -14,9 +14,14 @@ public:
   void Bind() const;
   void Unbind () const;
   void Allocate(const void* data, GLsizeiptr size, GLenum usage_pattern);
-  void Write(const void* data, int count);
+  void Write(const void* data, int count, GLintptr offset = 0);
   GLsizeiptr Size() const { return m_SizeInBytes; }
+  GLuint Address() const { return m_BufferAddress; }
   void* Map(GLenum access);
+  // Maps part of the buffer, with glMapBufferRange's access bits (e.g. GL_MAP_UNSYNCHRONIZED_BIT,
+  // so that writing to a range the GPU isn't reading from doesn't wait for it).
+  void* MapRange(GLintptr offset, GLsizeiptr size, GLbitfield access);
+  static bool IsMapRangeSupported() { return GLEW_VERSION_3_0 || GLEW_ARB_map_buffer_range; }
   bool Unmap();
   bool IsCreated() const;
   void Destroy();
@@ -0,0 +1,90 @@
+#include "GLUniformBufferRing.h"
+
+#include <cassert>
+#include <stdexcept>
+#include "GLError.h"
+
+namespace {
+
+GLUniformBufferRing *s_current_ring = nullptr;
+
+} // end of anonymous namespace
+
+const size_t GLUniformBufferRing::DEFAULT_FRAME_COUNT = 3;
+const GLsizeiptr GLUniformBufferRing::DEFAULT_BYTES_PER_FRAME = 256*1024;
+
+GLUniformBufferRing::GLUniformBufferRing (size_t frame_count, GLsizeiptr bytes_per_frame)
+  :
+  m_frames(frame_count),
+  m_bytes_per_frame(bytes_per_frame),
+  m_offset_alignment(0),
+  m_current_frame(0),
+  m_current_buffer(0),
+  m_offset(0)
+{
+  if (frame_count == 0 || bytes_per_frame <= 0) {
+    throw std::invalid_argument("GLUniformBufferRing must have a positive frame count and buffer size");
+  }
+}
+
+bool GLUniformBufferRing::IsSupported () {
+  return GLEW_VERSION_3_1 || GLEW_ARB_uniform_buffer_object;
+}
+
+GLUniformBufferRing *GLUniformBufferRing::Current () {
+  return s_current_ring;
+}
+
+void GLUniformBufferRing::SetCurrent (GLUniformBufferRing *ring) {
+  s_current_ring = ring;
+}
+
+void GLUniformBufferRing::BeginFrame () {
+  m_current_frame = (m_current_frame + 1) % m_frames.size();
+  m_current_buffer = 0;
+  m_offset = 0;
+}
+
+void GLUniformBufferRing::Upload (GLuint binding_point, const void *data, GLsizeiptr size) {
+  if (size <= 0 || size > m_bytes_per_frame) {
+    throw std::invalid_argument("GLUniformBufferRing: block size must be positive and at most the bytes per frame");
+  }
+  CreateBufferIfNecessary();
+  // Each range must start at a multiple of the alignment.
+  GLintptr offset = ((m_offset + m_offset_alignment - 1) / m_offset_alignment) * m_offset_alignment;
+  if (offset + size > m_bytes_per_frame) {
+    // Ranges which are already bound in this buffer must not be overwritten, so move on to another.
+    ++m_current_buffer;
+    m_offset = 0;
+    offset = 0;
+    CreateBufferIfNecessary();
+  }
+  GLBuffer &buffer = *m_frames[m_current_frame][m_current_buffer];
+  // glBindBufferRange also binds the buffer to the generic GL_UNIFORM_BUFFER binding, which Write uses.
+  GL_THROW_UPON_ERROR(glBindBufferRange(GL_UNIFORM_BUFFER, binding_point, buffer.Address(), offset, size));
+  buffer.Write(data, static_cast<int>(size), offset);
+  m_offset = offset + size;
+  ++m_counters.blocks_uploaded;
+  m_counters.bytes_uploaded += static_cast<uint64_t>(size);
+}
+
+void GLUniformBufferRing::CreateBufferIfNecessary () {
+  std::vector<std::unique_ptr<GLBuffer>> &buffers = m_frames[m_current_frame];
+  if (m_current_buffer < buffers.size()) {
+    return;
+  }
+  if (m_offset_alignment <= 0) {
+    GL_THROW_UPON_ERROR(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &m_offset_alignment));
+    if (m_offset_alignment <= 0) {
+      m_offset_alignment = 256; // The largest alignment required by any known implementation.
+    }
+  }
+  assert(m_current_buffer == buffers.size());
+  buffers.emplace_back(new GLBuffer());
+  GLBuffer &buffer = *buffers.back();
+  buffer.Create(GL_UNIFORM_BUFFER);
+  buffer.Bind();
+  buffer.Allocate(nullptr, m_bytes_per_frame, GL_STREAM_DRAW);
+  buffer.Unbind();
+  ++m_counters.buffers_allocated;
+}
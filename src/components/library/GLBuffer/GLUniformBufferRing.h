@@ -0,0 +1,79 @@
+#pragma once
+
+#include "GLBuffer.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// A ring of uniform buffer objects (GL 3.1 or ARB_uniform_buffer_object) into which std140
+// uniform blocks are copied and then bound to uniform block binding points via glBindBufferRange.
+// Uploading a whole block this way takes two GL calls, instead of one glUniform* call (and a
+// string-keyed location lookup) per uniform.
+//
+// Each frame writes into its own buffer, and BeginFrame advances to the next one, so that blocks
+// written in one frame don't overwrite data which earlier frames still in flight may be reading.
+// The ring should therefore be at least as long as the number of frames the driver queues.
+//
+// If a frame's buffer fills up, another buffer of the same size is added to that frame's slot
+// (rather than overwriting ranges which are already bound), so the ring grows to fit the largest
+// frame.  Users should check IsSupported (or Current() != nullptr) and fall back to plain
+// uniforms otherwise.
+class GLUniformBufferRing {
+public:
+
+  struct Counters {
+    Counters () : blocks_uploaded(0), bytes_uploaded(0), buffers_allocated(0) { }
+    uint64_t blocks_uploaded;
+    uint64_t bytes_uploaded;
+    uint64_t buffers_allocated;
+  };
+
+  static const size_t DEFAULT_FRAME_COUNT;
+  static const GLsizeiptr DEFAULT_BYTES_PER_FRAME;
+
+  // No GL calls are made until the first call to Upload.  Blocks larger than
+  // bytes_per_frame can't be uploaded.
+  GLUniformBufferRing (size_t frame_count = DEFAULT_FRAME_COUNT, GLsizeiptr bytes_per_frame = DEFAULT_BYTES_PER_FRAME);
+
+  // Returns true iff the current GL context supports uniform buffer objects.
+  static bool IsSupported ();
+
+  // Returns the ring for the current GL context, or nullptr if uniform buffers aren't in use
+  // (e.g. on a GL 2.1 context), in which case plain uniforms should be used.
+  static GLUniformBufferRing *Current ();
+  // Sets the ring for the current GL context.  The ring must outlive its use.
+  static void SetCurrent (GLUniformBufferRing *ring);
+
+  // Advances to the next buffer in the ring.  Should be called once at the beginning of each frame.
+  void BeginFrame ();
+
+  // Copies the given block into the current frame's buffer and binds that range to the given
+  // binding point.
+  void Upload (GLuint binding_point, const void *data, GLsizeiptr size);
+
+  size_t FrameCount () const { return m_frames.size(); }
+  GLsizeiptr BytesPerFrame () const { return m_bytes_per_frame; }
+
+  const Counters &GetCounters () const { return m_counters; }
+  void ResetCounters () { m_counters = Counters(); }
+
+private:
+
+  GLUniformBufferRing (const GLUniformBufferRing &) = delete;
+  GLUniformBufferRing &operator = (const GLUniformBufferRing &) = delete;
+
+  // Makes sure the current buffer of the current frame exists.
+  void CreateBufferIfNecessary ();
+
+  // The buffers for each frame in the ring.  Usually there is one per frame.
+  std::vector<std::vector<std::unique_ptr<GLBuffer>>> m_frames;
+  GLsizeiptr m_bytes_per_frame;
+  // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, queried when the first buffer is created.
+  GLint m_offset_alignment;
+  size_t m_current_frame;
+  // The index of the buffer (within the current frame) being written to, and the offset into it.
+  size_t m_current_buffer;
+  GLintptr m_offset;
+  Counters m_counters;
+};
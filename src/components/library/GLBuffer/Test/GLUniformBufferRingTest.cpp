@@ -0,0 +1,139 @@
+#include "GLUniformBufferRing.h"
+#include "GLTestFramework.h"
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+class GLUniformBufferRingTest : public GLTestFramework_Headless {
+protected:
+
+  virtual void SetUp () override {
+    GLTestFramework_Headless::SetUp();
+    m_supported = GLUniformBufferRing::IsSupported();
+    if (m_supported) {
+      glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &m_alignment);
+    }
+  }
+
+  // The buffer and the start of the range bound to a binding point.
+  static GLint BoundBuffer (GLuint binding_point) {
+    GLint buffer = 0;
+    glGetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, binding_point, &buffer);
+    return buffer;
+  }
+  static GLint BoundStart (GLuint binding_point) {
+    GLint start = -1;
+    glGetIntegeri_v(GL_UNIFORM_BUFFER_START, binding_point, &start);
+    return start;
+  }
+  static std::vector<uint8_t> BoundBytes (GLuint binding_point, size_t size) {
+    std::vector<uint8_t> bytes(size);
+    glBindBuffer(GL_UNIFORM_BUFFER, BoundBuffer(binding_point));
+    glGetBufferSubData(GL_UNIFORM_BUFFER, BoundStart(binding_point), size, bytes.data());
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    return bytes;
+  }
+  GLint AlignUp (GLint offset) const {
+    return (offset + m_alignment - 1)/m_alignment*m_alignment;
+  }
+  static std::vector<uint8_t> Block (size_t size, uint8_t value) {
+    return std::vector<uint8_t>(size, value);
+  }
+
+  bool m_supported;
+  GLint m_alignment;
+};
+
+TEST_F(GLUniformBufferRingTest, RangesStartAtTheOffsetAlignment) {
+  if (!m_supported) {
+    return;
+  }
+  GLUniformBufferRing ring;
+  // Sizes which aren't multiples of any alignment, so that packing them tightly would misalign
+  // the next block.
+  const std::vector<uint8_t> blocks[] = { Block(20, 1), Block(36, 2), Block(4, 3) };
+  for (GLuint i = 0; i < 3; i++) {
+    ring.Upload(i, blocks[i].data(), blocks[i].size());
+  }
+  EXPECT_EQ(0, BoundStart(0));
+  EXPECT_EQ(AlignUp(20), BoundStart(1));
+  EXPECT_EQ(AlignUp(AlignUp(20) + 36), BoundStart(2));
+  for (GLuint i = 0; i < 3; i++) {
+    EXPECT_EQ(BoundBuffer(0), BoundBuffer(i));
+    EXPECT_EQ(blocks[i], BoundBytes(i, blocks[i].size()));
+  }
+  EXPECT_EQ(3u, ring.GetCounters().blocks_uploaded);
+  EXPECT_EQ(60u, ring.GetCounters().bytes_uploaded);
+  EXPECT_EQ(1u, ring.GetCounters().buffers_allocated);
+}
+
+TEST_F(GLUniformBufferRingTest, FullBufferMovesOnToAnother) {
+  if (!m_supported) {
+    return;
+  }
+  GLUniformBufferRing ring(2, 2*m_alignment);
+  const std::vector<uint8_t> blocks[] = { Block(m_alignment, 1), Block(m_alignment, 2), Block(16, 3) };
+  for (GLuint i = 0; i < 3; i++) {
+    ring.Upload(i, blocks[i].data(), blocks[i].size());
+  }
+  EXPECT_EQ(BoundBuffer(0), BoundBuffer(1));
+  EXPECT_EQ(m_alignment, BoundStart(1));
+  // The third block doesn't fit, and the first two are still bound, so it goes into a new buffer.
+  EXPECT_NE(BoundBuffer(0), BoundBuffer(2));
+  EXPECT_EQ(0, BoundStart(2));
+  for (GLuint i = 0; i < 3; i++) {
+    EXPECT_EQ(blocks[i], BoundBytes(i, blocks[i].size()));
+  }
+  EXPECT_EQ(2u, ring.GetCounters().buffers_allocated);
+
+  // The frame's slot keeps both buffers, so the next time round the ring they're reused.
+  ring.BeginFrame();
+  ring.BeginFrame();
+  for (GLuint i = 0; i < 3; i++) {
+    ring.Upload(i, blocks[i].data(), blocks[i].size());
+  }
+  EXPECT_EQ(2u, ring.GetCounters().buffers_allocated);
+}
+
+TEST_F(GLUniformBufferRingTest, BeginFrameWrapsAround) {
+  if (!m_supported) {
+    return;
+  }
+  const size_t FRAMES = 3;
+  GLUniformBufferRing ring(FRAMES);
+  EXPECT_EQ(FRAMES, ring.FrameCount());
+  const std::vector<uint8_t> block(Block(64, 7));
+  std::vector<GLint> buffers;
+  for (size_t frame = 0; frame < 2*FRAMES; frame++) {
+    if (frame > 0) {
+      ring.BeginFrame();
+    }
+    ring.Upload(0, block.data(), block.size());
+    // Each frame starts at the beginning of its buffer.
+    EXPECT_EQ(0, BoundStart(0));
+    buffers.push_back(BoundBuffer(0));
+  }
+  // A buffer per frame, reused once the ring wraps around.
+  EXPECT_NE(buffers[0], buffers[1]);
+  EXPECT_NE(buffers[1], buffers[2]);
+  EXPECT_NE(buffers[0], buffers[2]);
+  for (size_t frame = FRAMES; frame < 2*FRAMES; frame++) {
+    EXPECT_EQ(buffers[frame - FRAMES], buffers[frame]);
+  }
+  EXPECT_EQ(FRAMES, ring.GetCounters().buffers_allocated);
+}
+
+TEST_F(GLUniformBufferRingTest, RejectsBadSizes) {
+  EXPECT_THROW(GLUniformBufferRing(0), std::invalid_argument);
+  EXPECT_THROW(GLUniformBufferRing(3, 0), std::invalid_argument);
+  if (!m_supported) {
+    return;
+  }
+  GLUniformBufferRing ring(1, 256);
+  const std::vector<uint8_t> block(Block(257, 0));
+  EXPECT_THROW(ring.Upload(0, block.data(), 0), std::invalid_argument);
+  EXPECT_THROW(ring.Upload(0, block.data(), block.size()), std::invalid_argument);
+  EXPECT_EQ(0u, ring.GetCounters().blocks_uploaded);
+}
@@ -15,6 +15,12 @@ void GLController::Initialize () {
   if (glewInit() != GLEW_OK) {
     throw std::runtime_error("Glew initialization failed");
   }
+  GLStateTracker::SetCurrent(&m_state_tracker);
+  // Without uniform buffers, shaders fall back to plain uniforms.
+  if (GLUniformBufferRing::IsSupported()) {
+    m_uniform_buffer_ring.reset(new GLUniformBufferRing());
+    GLUniformBufferRing::SetCurrent(m_uniform_buffer_ring.get());
+  }
   std::cerr << "GL_VERSION = \"" << GetString(GL_VERSION) << "\"\n";       // TEMP
   std::cerr << "GL_RENDERER = \"" << GetString(GL_RENDERER) << "\"\n";     // TEMP
   std::cerr << "GL_VENDOR = \"" << GetString(GL_VENDOR) << "\"\n";         // TEMP
@@ -22,12 +28,23 @@ void GLController::Initialize () {
 }
 
 void GLController::Shutdown () {
-
+  if (m_uniform_buffer_ring) {
+    if (GLUniformBufferRing::Current() == m_uniform_buffer_ring.get()) {
+      GLUniformBufferRing::SetCurrent(nullptr);
+    }
+    m_uniform_buffer_ring.reset();
+  }
+  if (&GLStateTracker::Current() == &m_state_tracker) {
+    GLStateTracker::SetCurrent(nullptr);
+  }
 }
 
 void GLController::BeginRender() const {
   glClearColor(0.0f, 0.0f, 0.0f, 0.0f); // if using transparent window, clear alpha value must be 0
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  if (m_uniform_buffer_ring) {
+    m_uniform_buffer_ring->BeginFrame();
+  }
 }
 
 void GLController::EndRender () const {
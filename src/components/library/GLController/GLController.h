@@ -1,8 +1,11 @@
 #pragma once
 
+#include <memory>
 #include <string>
 
 #include "gl_glext_glu.h" // convenience header for cross-platform GL includes
+#include "GLStateTracker.h"
+#include "GLUniformBufferRing.h"
 
 // This class bundles all the GL usage/state into a single point of control.
 // TODO: think about renaming this to GLController, because "context" means
@@ -25,7 +28,16 @@ public:
 
   static std::string GetString (GLenum name);
 
+  // The state tracker for this controller's GL context.  It is made current by Initialize.
+  const GLStateTracker &StateTracker () const { return m_state_tracker; }
+  GLStateTracker &StateTracker () { return m_state_tracker; }
+  // The uniform buffer ring for this controller's GL context, or nullptr if uniform buffers aren't
+  // supported.  It is created and made current by Initialize, and advanced by BeginRender.
+  GLUniformBufferRing *UniformBufferRing () const { return m_uniform_buffer_ring.get(); }
+
 private:
 
+  GLStateTracker m_state_tracker;
+  std::unique_ptr<GLUniformBufferRing> m_uniform_buffer_ring;
 };
 
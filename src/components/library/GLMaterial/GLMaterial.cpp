@@ -1,9 +1,41 @@
 #include "GLMaterial.h"
 
+#include <cstring>
+
 #include "GLShader.h"
 #include "GLShaderBindingScopeGuard.h"
+#include "GLUniformBufferRing.h"
+
+const std::string GLMaterial::UNIFORM_BLOCK_NAME("Material");
+const GLuint GLMaterial::UNIFORM_BLOCK_BINDING = 1;
+
+namespace {
+
+// The std140 layout of the uniform block.  The vec3 is aligned to 16 bytes, and the float
+// following it fills its last 4 bytes.  GLSL bools occupy 4 bytes.  The padding rounds the size
+// up to a multiple of 16 bytes, which some implementations report as the block's data size.
+struct UniformBlock {
+  float diffuse_light_color[4];
+  float ambient_light_color[4];
+  float light_position[3];
+  float ambient_lighting_proportion;
+  GLint use_texture;
+  GLint padding[3];
+};
+const GLint UNPADDED_UNIFORM_BLOCK_SIZE = 13*4;
+
+} // end of anonymous namespace
 
 void GLMaterial::CheckShaderForUniforms (const GLShader &shader) {
+  if (shader.HasUniformBlock(UNIFORM_BLOCK_NAME)) {
+    // Implementations may or may not round the block's data size up to a multiple of 16 bytes.
+    const GLint padded_size = static_cast<GLint>(sizeof(UniformBlock));
+    const bool is_padded = shader.UniformBlockInfo(UNIFORM_BLOCK_NAME).DataSize() == padded_size;
+    shader.CheckForUniformBlock(UNIFORM_BLOCK_NAME, is_padded ? padded_size : UNPADDED_UNIFORM_BLOCK_SIZE, VariableIs::REQUIRED);
+    shader.CheckForTypedUniform("texture", GL_SAMPLER_2D, VariableIs::OPTIONAL_BUT_WARN);
+    return;
+  }
+
   // Check for the required uniforms.  Any unmet requirement will cause an exception to be thrown.
   shader.CheckForTypedUniform("light_position", GL_FLOAT_VEC3, VariableIs::OPTIONAL_BUT_WARN);
   shader.CheckForTypedUniform("diffuse_light_color", GL_FLOAT_VEC4, VariableIs::OPTIONAL_BUT_WARN);
@@ -33,6 +65,25 @@ void GLMaterial::UploadUniforms (const GLShader &shader, float alpha_mask, BindF
   Color ambientColor = m_ambient_light_color;
   diffuseColor.A() *= alpha_mask;
   ambientColor.A() *= alpha_mask;
+
+  // If possible, upload the whole block at once.  The sampler can't be in a block, so it's still a
+  // plain uniform, but it rarely changes, so its upload is usually skipped by GLShader anyway.
+  GLUniformBufferRing *ring = GLUniformBufferRing::Current();
+  if (ring != nullptr && shader.HasUniformBlock(UNIFORM_BLOCK_NAME)) {
+    UniformBlock block;
+    std::memcpy(block.diffuse_light_color, diffuseColor.Data().data(), sizeof(block.diffuse_light_color));
+    std::memcpy(block.ambient_light_color, ambientColor.Data().data(), sizeof(block.ambient_light_color));
+    // As with the plain uniforms, the light position isn't uploaded (see the TODO in GLMaterial.h).
+    block.light_position[0] = block.light_position[1] = block.light_position[2] = 0.0f;
+    block.ambient_lighting_proportion = m_ambient_lighting_proportion;
+    block.use_texture = m_use_texture ? 1 : 0;
+    block.padding[0] = block.padding[1] = block.padding[2] = 0;
+    shader.SetUniformBlockBinding(UNIFORM_BLOCK_NAME, UNIFORM_BLOCK_BINDING);
+    ring->Upload(UNIFORM_BLOCK_BINDING, &block, std::min<GLsizeiptr>(sizeof(block), shader.UniformBlockInfo(UNIFORM_BLOCK_NAME).DataSize()));
+    shader.SetUniformi("texture", m_texture_unit_index);
+    return;
+  }
+
   shader.SetUniformf("diffuse_light_color", diffuseColor);
   shader.SetUniformf("ambient_light_color", ambientColor);
   shader.SetUniformf("ambient_lighting_proportion", m_ambient_lighting_proportion);
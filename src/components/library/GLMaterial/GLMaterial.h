@@ -5,6 +5,8 @@
 #include "gl_glext_glu.h"
 #include "ScopeGuard.h"
 
+#include <string>
+
 class GLShader;
 
 // The Material class is a container for particular uniform values which can then be
@@ -17,6 +19,16 @@ class GLShader;
 //   uniform sampler2D texture;
 // Material should only be concerned with fragment shading.  Uploading a Material's state
 // is done via the method UploadUniforms.
+//
+// Alternatively (on GL 3.1 and up), all but the sampler may be declared in a std140 uniform block,
+//   layout(std140) uniform Material {
+//     vec4 diffuse_light_color;
+//     vec4 ambient_light_color;
+//     vec3 light_position;
+//     float ambient_lighting_proportion;
+//     bool use_texture;
+//   };
+// in which case, if GLUniformBufferRing::Current() is set, the block is uploaded all at once.
 class GLMaterial {
 public:
 
@@ -24,6 +36,10 @@ public:
   // an exception will be thrown.
   static void CheckShaderForUniforms (const GLShader &shader);
 
+  // The name and binding point of the optional uniform block described above.
+  static const std::string UNIFORM_BLOCK_NAME;
+  static const GLuint UNIFORM_BLOCK_BINDING;
+
   // Constructs a Material with reasonable default values.
   GLMaterial ();
 
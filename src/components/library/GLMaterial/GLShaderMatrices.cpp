@@ -1,11 +1,31 @@
 #include "GLShaderMatrices.h"
 
 #include "GLShaderBindingScopeGuard.h"
+#include "GLUniformBufferRing.h"
 #include <stdexcept>
 
 namespace GLShaderMatrices {
 
+const std::string UNIFORM_BLOCK_NAME("ShaderMatrices");
+const GLuint UNIFORM_BLOCK_BINDING = 0;
+
+namespace {
+
+// The std140 layout of the uniform block; mat4 members are tightly packed.
+struct UniformBlock {
+  EigenTypes::Matrix4x4f projection_times_model_view_matrix;
+  EigenTypes::Matrix4x4f model_view_matrix;
+  EigenTypes::Matrix4x4f normal_matrix;
+};
+
+} // end of anonymous namespace
+
 void CheckShaderForUniforms (const GLShader &shader, BindFlags bind_flags) {
+  if (shader.HasUniformBlock(UNIFORM_BLOCK_NAME)) {
+    shader.CheckForUniformBlock(UNIFORM_BLOCK_NAME, sizeof(UniformBlock), VariableIs::REQUIRED);
+    return;
+  }
+
   GLShaderBindingScopeGuard bso(shader, bind_flags); // binds shader now if necessary, unbinds upon end of scope if necessary.
   
   shader.CheckForTypedUniform("projection_times_model_view_matrix", GL_FLOAT_MAT4, VariableIs::OPTIONAL_BUT_WARN);
@@ -25,6 +45,18 @@ void UploadUniforms (const GLShader &shader, const EigenTypes::Matrix4x4 &model_
   // the inverse transpose is itself.
   EigenTypes::Matrix4x4f normal_matrix(model_view.inverse().transpose().cast<float>());
 
+  // If possible, upload the whole block at once.  Uniform blocks don't need the shader to be bound.
+  GLUniformBufferRing *ring = GLUniformBufferRing::Current();
+  if (ring != nullptr && shader.HasUniformBlock(UNIFORM_BLOCK_NAME)) {
+    UniformBlock block;
+    block.projection_times_model_view_matrix = projection_times_model_view_matrix;
+    block.model_view_matrix = model_view_matrix;
+    block.normal_matrix = normal_matrix;
+    shader.SetUniformBlockBinding(UNIFORM_BLOCK_NAME, UNIFORM_BLOCK_BINDING);
+    ring->Upload(UNIFORM_BLOCK_BINDING, &block, sizeof(block));
+    return;
+  }
+
   GLShaderBindingScopeGuard bso(shader, bind_flags); // binds shader now if necessary, unbinds upon end of scope if necessary.
   
   // The use of COLUMN_MAJOR is because our Eigen-based Matrix4x4f typedef uses column-major data storage.
@@ -10,10 +10,23 @@
 //   uniform mat4 model_view_matrix
 //   uniform mat4 normal_matrix
 // These quantities are derived from the model view matrix and the projection matrix.
+//
+// Alternatively (on GL 3.1 and up), the shader may declare these in a std140 uniform block,
+//   layout(std140) uniform ShaderMatrices {
+//     mat4 projection_times_model_view_matrix;
+//     mat4 model_view_matrix;
+//     mat4 normal_matrix;
+//   };
+// in which case, if GLUniformBufferRing::Current() is set, the block is uploaded all at once via
+// the uniform buffer ring.
 
 namespace GLShaderMatrices {
-  
-// The shader must have the following 4x4 matrix uniforms:
+
+// The name and binding point of the optional uniform block described above.
+extern const std::string UNIFORM_BLOCK_NAME;
+extern const GLuint UNIFORM_BLOCK_BINDING;
+
+// The shader must have the following 4x4 matrix uniforms (or the uniform block containing them):
 // - projection_times_model_view_matrix
 // - model_view_matrix
 // - normal_matrix
@@ -0,0 +1,25 @@
+#version 140
+
+// This is matrix-transformed-vert.glsl, but with the matrices in a uniform block (see GLShaderMatrices.h).
+layout(std140) uniform ShaderMatrices {
+  mat4 projection_times_model_view_matrix;
+  mat4 model_view_matrix;
+  mat4 normal_matrix;
+};
+
+// attribute arrays
+in vec3 position;
+in vec3 normal;
+in vec2 tex_coord;
+
+// These are the inputs from the vertex shader to the fragment shader, and must appear identically there.
+out vec3 out_position;
+out vec3 out_normal;
+out vec2 out_tex_coord;
+
+void main() {
+  gl_Position = projection_times_model_view_matrix * vec4(position, 1.0);
+  out_position = (model_view_matrix * vec4(position, 1.0)).xyz;
+  out_normal = (normal_matrix * vec4(normal, 0.0)).xyz;
+  out_tex_coord = tex_coord;
+}
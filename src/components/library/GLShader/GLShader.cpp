@@ -1,5 +1,6 @@
 #include "GLShader.h"
 
+#include <cstring>
 #include <iostream> // TEMP
 #include <stdexcept>
 
@@ -28,16 +29,37 @@ GLShader::VarInfo::VarInfo (const std::string &name, GLint location, GLint size,
   // specifying a hardcoded list of acceptable values.
 }
 
+// ////////////////////////////////////////////////////////////////////////////////////////////////
+// GLShader::BlockInfo
+// ////////////////////////////////////////////////////////////////////////////////////////////////
+
+GLShader::BlockInfo::BlockInfo (const std::string &name, GLuint index, GLint data_size)
+  :
+  m_name(name),
+  m_index(index),
+  m_data_size(data_size)
+{
+  if (m_name.empty()) {
+    throw std::invalid_argument("shader uniform block must have nonempty name");
+  }
+  if (m_data_size <= 0) {
+    throw std::invalid_argument("shader uniform block must have positive data size");
+  }
+}
+
 // ////////////////////////////////////////////////////////////////////////////////////////////////
 // GLShader
 // ////////////////////////////////////////////////////////////////////////////////////////////////
 
-GLShader::GLShader (const std::string &vertex_shader_source, const std::string &fragment_shader_source) {
+GLShader::GLShader (const std::string &vertex_shader_source, const std::string &fragment_shader_source, const AttributeLocationMap &attribute_locations) {
   m_vertex_shader = Compile(GL_VERTEX_SHADER, vertex_shader_source);
   m_fragment_shader = Compile(GL_FRAGMENT_SHADER, fragment_shader_source);
   m_program_handle = glCreateProgram();
   glAttachShader(m_program_handle, m_vertex_shader);
   glAttachShader(m_program_handle, m_fragment_shader);
+  for (auto it = attribute_locations.begin(); it != attribute_locations.end(); ++it) {
+    glBindAttribLocation(m_program_handle, it->second, it->first.c_str());
+  }
   glLinkProgram(m_program_handle);
 
   // Populate the uniform map.
@@ -66,6 +88,26 @@ GLShader::GLShader (const std::string &vertex_shader_source, const std::string &
     }
   }
 
+  // Populate the uniform block map.
+  if (UniformBlocksAreSupported()) {
+    GLint active_uniform_blocks = 0;
+    glGetProgramiv(m_program_handle, GL_ACTIVE_UNIFORM_BLOCKS, &active_uniform_blocks);
+
+    GLint active_uniform_block_max_name_length = 0;
+    glGetProgramiv(m_program_handle, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &active_uniform_block_max_name_length);
+
+    for (GLint index = 0; index < active_uniform_blocks; ++index) {
+      std::string name(active_uniform_block_max_name_length, ' ');
+      GLsizei length;
+      GLint data_size;
+      glGetActiveUniformBlockName(m_program_handle, index, active_uniform_block_max_name_length, &length, &name[0]);
+      name.resize(length);
+      glGetActiveUniformBlockiv(m_program_handle, index, GL_UNIFORM_BLOCK_DATA_SIZE, &data_size);
+      // TODO: use emplace here, then get rid of default constructor for BlockInfo
+      m_uniform_block_info_map[name] = BlockInfo(name, static_cast<GLuint>(index), data_size);
+    }
+  }
+
   // Populate the attribute map.
   {
     GLint active_attribs = 0;
@@ -94,6 +136,8 @@ GLShader::GLShader (const std::string &vertex_shader_source, const std::string &
 }
 
 GLShader::~GLShader () {
+  // The handle may be reused by a later program, so the tracker must not think it's still bound.
+  GLStateTracker::Current().ProgramDeleted(m_program_handle);
   glDeleteProgram(m_program_handle);
   glDeleteShader(m_vertex_shader);
   glDeleteShader(m_fragment_shader);
@@ -165,6 +209,55 @@ void GLShader::CheckForTypedAttribute (const std::string &name, GLenum type, Var
   }
 }
 
+void GLShader::CheckForUniformBlock (const std::string &name, GLint data_size, VariableIs check_type) const {
+  const std::string qualifier(check_type == VariableIs::REQUIRED ? "required " : "optional ");
+  std::string message;
+  if (!HasUniformBlock(name)) {
+    message = "GLShader: " + qualifier + "uniform block \"" + name + "\" is missing";
+  } else if (UniformBlockInfo(name).DataSize() != data_size) {
+    message = "GLShader: uniform block \"" + name + "\" has data size " + std::to_string(UniformBlockInfo(name).DataSize()) +
+              " but expected " + std::to_string(data_size) + " (it should be declared with layout(std140))";
+  }
+  if (!message.empty()) {
+    switch (check_type) {
+      case VariableIs::OPTIONAL_NO_WARN: break; // Fail silently.
+      case VariableIs::OPTIONAL_BUT_WARN: std::cout << message << '\n'; break; // TODO: come up with a better way to report this.
+      case VariableIs::REQUIRED: throw std::runtime_error(message); break;
+    }
+  }
+}
+
+void GLShader::SetUniformBlockBinding (const std::string &name, GLuint binding_point) const {
+  auto it = m_uniform_block_info_map.find(name);
+  if (it == m_uniform_block_info_map.end()) {
+    return;
+  }
+  const GLuint block_index = it->second.Index();
+  auto binding = m_uniform_block_bindings.find(block_index);
+  if (binding != m_uniform_block_bindings.end() && binding->second == binding_point) {
+    return;
+  }
+  GL_THROW_UPON_ERROR(glUniformBlockBinding(m_program_handle, block_index, binding_point));
+  m_uniform_block_bindings[block_index] = binding_point;
+}
+
+bool GLShader::UniformValueChanged (GLint location, const void *value, size_t size, int tag) const {
+  if (location < 0) {
+    return false;
+  }
+  // Compared in place, so that an unchanged value costs no allocation, and a changed one of the
+  // same size reuses the cached entry's storage.
+  CachedUniformValue &cached = m_uniform_value_cache[location];
+  const bool changed = cached.bytes.empty() || cached.tag != tag || cached.bytes.size() != size || std::memcmp(cached.bytes.data(), value, size) != 0;
+  if (changed) {
+    const uint8_t *value_bytes = static_cast<const uint8_t *>(value);
+    cached.tag = tag;
+    cached.bytes.assign(value_bytes, value_bytes + size);
+  }
+  GLStateTracker::Current().CountUniformUpload(changed);
+  return changed;
+}
+
 const std::string &GLShader::VariableTypeString (GLenum type) {
   auto it = OPENGL_3_3_UNIFORM_TYPE_MAP.find(type);
   if (it == OPENGL_3_3_UNIFORM_TYPE_MAP.end()) {
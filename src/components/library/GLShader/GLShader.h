@@ -9,6 +9,7 @@
 
 #include "gl_glext_glu.h" // convenience header for cross-platform GL includes
 #include "GLError.h"
+#include "GLStateTracker.h"
 
 // helper metafunction for simplifying the uniform modifiers
 template <typename GLType_, size_t COMPONENT_COUNT_> struct UniformFunction { static const bool exists = false; };
@@ -31,6 +32,15 @@ enum class VariableIs { REQUIRED, OPTIONAL_NO_WARN, OPTIONAL_BUT_WARN };
 /// and attributes, storing the relevant info (name, location, size, type) in a map which is
 /// indexed by name.  These maps can be accessed via the UniformInfoMap and AttributeInfoMap
 /// methods.
+///
+/// On GL 3.1 (or with ARB_uniform_buffer_object), the active uniform blocks are queried as well,
+/// and stored in a map accessible via UniformBlockInfoMap.  The uniforms inside blocks don't
+/// appear in UniformInfoMap; the blocks' contents are supplied via uniform buffers bound to the
+/// blocks' binding points (see SetUniformBlockBinding and GLUniformBufferRing).
+///
+/// Binding goes through GLStateTracker::Current(), and the value last uploaded to each uniform
+/// is remembered, so that SetUniform* calls which wouldn't change anything are skipped.  Any
+/// raw glUniform* call made on this program must be followed by InvalidateUniformCache.
 class GLShader {
 public:
 
@@ -59,10 +69,39 @@ public:
 
   typedef std::map<std::string,VarInfo> VarInfoMap;
 
+  // Stores information about a named uniform block in a shader program.
+  class BlockInfo {
+  public:
+
+    BlockInfo () { } // TEMP until C++11 compatibility allows use of std::map::emplace
+    BlockInfo (const std::string &name, GLuint index, GLint data_size);
+
+    const std::string &Name () const { return m_name; }
+    // The index of the block within the program, as used by glUniformBlockBinding.
+    GLuint Index () const { return m_index; }
+    // The size of the block's buffer storage.  For std140 blocks, this is fully determined by
+    // the block's declaration.
+    GLint DataSize () const { return m_data_size; }
+
+  private:
+
+    std::string m_name;
+    GLuint m_index;
+    GLint m_data_size;
+  };
+
+  typedef std::map<std::string,BlockInfo> BlockInfoMap;
+
+  // Generic vertex attribute indices, by attribute name, which are bound before linking.
+  typedef std::map<std::string,GLuint> AttributeLocationMap;
+
   // TODO: make GLShader-specific std::exception subclass?
 
-  // Construct a shader with given vertex and fragment programs.
-  GLShader (const std::string &vertex_shader_source, const std::string &fragment_shader_source);
+  // Construct a shader with given vertex and fragment programs.  Attributes which aren't in
+  // attribute_locations are assigned locations by the linker.  In a compatibility context,
+  // anything drawn without an array enabled at location 0 isn't drawn at all, so a program whose
+  // other attributes may be given as constants should bind its vertex array's attribute to 0.
+  GLShader (const std::string &vertex_shader_source, const std::string &fragment_shader_source, const AttributeLocationMap &attribute_locations = AttributeLocationMap());
   // Automatically frees the allocated resources.
   ~GLShader ();
 
@@ -70,11 +109,11 @@ public:
   GLuint ProgramHandle () const { return m_program_handle; }
   // This method should be called to bind this shader.
   void Bind () const {
-    GL_THROW_UPON_ERROR(glUseProgram(m_program_handle));
+    GLStateTracker::Current().UseProgram(m_program_handle);
   }
   // This method should be called when no shader program should be used.
   static void Unbind () {
-    GL_THROW_UPON_ERROR(glUseProgram(0));
+    GLStateTracker::Current().UseProgram(0);
   }
   // Returns the currently bound shader program (the integer handle generated by OpenGL).
   // This should only generate a GL error if it is called between glBegin and glEnd.
@@ -106,6 +145,35 @@ public:
   // This shader does not need to be bound for this call to succeed.
   const VarInfoMap &AttributeInfoMap () const { return m_attribute_info_map; }
 
+  // Returns true iff uniform blocks (and therefore uniform buffer objects) are supported by the
+  // current GL context.  If not, UniformBlockInfoMap will always be empty.
+  static bool UniformBlocksAreSupported () { return GLEW_VERSION_3_1 || GLEW_ARB_uniform_buffer_object; }
+  // Returns a map, indexed by name, containing all the active uniform blocks in this shader program.
+  // This shader does not need to be bound for this call to succeed.
+  const BlockInfoMap &UniformBlockInfoMap () const { return m_uniform_block_info_map; }
+  // Returns true iff the shader uniform block exists.
+  // This shader does not need to be bound for this call to succeed.
+  bool HasUniformBlock (const std::string &name) const { return m_uniform_block_info_map.find(name) != m_uniform_block_info_map.end(); }
+  // Returns the BlockInfo data for the requested uniform block, or throws if that block is not found.
+  // This shader does not need to be bound for this call to succeed.
+  const BlockInfo &UniformBlockInfo (const std::string &name) const {
+    BlockInfoMap::const_iterator it = m_uniform_block_info_map.find(name);
+    if (it == m_uniform_block_info_map.end()) {
+      throw std::domain_error("no uniform block named \"" + name + "\" found in shader program");
+    }
+    return it->second;
+  }
+  // Checks for the uniform block with given name and data size (which, for a std140 block, checks
+  // its layout against the corresponding C++ struct).  If the block is not found or has the wrong
+  // size, then the behavior depends on check_type, as in CheckForTypedUniform.
+  // This shader does not need to be bound for this call to succeed.
+  void CheckForUniformBlock (const std::string &name, GLint data_size, VariableIs check_type) const;
+  // Sets the uniform buffer binding point from which the named uniform block sources its data.
+  // This is program object state, so it only needs to be done once per program; repeated calls
+  // with the same binding point are skipped.  Does nothing if the block doesn't exist.
+  // This shader does not need to be bound for this call to succeed.
+  void SetUniformBlockBinding (const std::string &name, GLuint binding_point) const;
+
   // Returns true iff the shader uniform exists.
   // This shader does not need to be bound for this call to succeed.
   bool HasUniform (const std::string &name) const { return m_uniform_info_map.find(name) != m_uniform_info_map.end(); }
@@ -147,6 +215,11 @@ public:
     return it != m_attribute_info_map.end() ? it->second.Location() : -1;
   }
 
+  // Forgets the values last uploaded to the uniforms, so that the next SetUniform* call for
+  // each uniform is issued.  This must be called after setting uniforms of this program via
+  // raw glUniform* calls.
+  void InvalidateUniformCache () const { m_uniform_value_cache.clear(); }
+
   // These SetUniform* methods require this shader to currently be bound.  They are named
   // with type annotators to avoid confusion in situations where types are implicitly coerced.
   // The uniform has a fixed type in the shader, so the call to SetUniform* should reflect that.
@@ -161,16 +234,24 @@ public:
   void SetUniformi (const std::string &name, GLint value) const {
     // TODO: type checking
     assert(CurrentlyBoundProgramHandle() == m_program_handle && "trying to set a uniform without having first called GLShader::Bind on this");
+    GLint location = LocationOfUniform(name);
+    if (!UniformValueChanged(location, &value, sizeof(value))) {
+      return;
+    }
     GL_THROW_UPON_ERROR(
-      glUniform1i(LocationOfUniform(name), value)
+      glUniform1i(location, value)
     );
   }
   // Sets the named uniform to the given GLfloat value.
   // This shader must be bound for this call to succeed.
   void SetUniformf (const std::string &name, GLfloat value) const {
     assert(CurrentlyBoundProgramHandle() == m_program_handle && "trying to set a uniform without having first called GLShader::Bind on this");
+    GLint location = LocationOfUniform(name);
+    if (!UniformValueChanged(location, &value, sizeof(value))) {
+      return;
+    }
     GL_THROW_UPON_ERROR(
-      glUniform1f(LocationOfUniform(name), value)
+      glUniform1f(location, value)
     );
   }
   // Sets the named uniform to the given value which must be a packed 
@@ -182,8 +263,12 @@ public:
     static_assert(UniformFunction<GLint,sizeof(T_)/sizeof(GLint)>::exists, "There is no known glUniform*i function for size of given T_");
     // TODO: somehow check that T_ is actually a POD containing only GLint components.
     assert(CurrentlyBoundProgramHandle() == m_program_handle && "trying to set a uniform without having first called GLShader::Bind on this");
+    GLint location = LocationOfUniform(name);
+    if (!UniformValueChanged(location, &value, sizeof(T_))) {
+      return;
+    }
     GL_THROW_UPON_ERROR((
-      UniformFunction<GLint,sizeof(T_)/sizeof(GLint)>::eval(LocationOfUniform(name), 1, reinterpret_cast<const GLint *>(&value))
+      UniformFunction<GLint,sizeof(T_)/sizeof(GLint)>::eval(location, 1, reinterpret_cast<const GLint *>(&value))
     ));
   }
   // Sets the named uniform to the given value which must be a packed 
@@ -195,8 +280,12 @@ public:
     static_assert(UniformFunction<GLfloat,sizeof(T_)/sizeof(GLfloat)>::exists, "There is no known glUniform*i function for size of given T_");
     // TODO: somehow check that T_ is actually a POD containing only GLfloat components.
     assert(CurrentlyBoundProgramHandle() == m_program_handle && "trying to set a uniform without having first called GLShader::Bind on this");
+    GLint location = LocationOfUniform(name);
+    if (!UniformValueChanged(location, &value, sizeof(T_))) {
+      return;
+    }
     GL_THROW_UPON_ERROR((
-      UniformFunction<GLfloat,sizeof(T_)/sizeof(GLfloat)>::eval(LocationOfUniform(name), 1, reinterpret_cast<const GLfloat *>(&value))
+      UniformFunction<GLfloat,sizeof(T_)/sizeof(GLfloat)>::eval(location, 1, reinterpret_cast<const GLfloat *>(&value))
     ));
   }
 
@@ -207,16 +296,24 @@ public:
   // This shader must be bound for this call to succeed.
   void SetUniformi (const std::string &name, const std::vector<GLint> &array) const {
     assert(CurrentlyBoundProgramHandle() == m_program_handle && "trying to set a uniform without having first called GLShader::Bind on this");
+    GLint location = LocationOfUniform(name);
+    if (!UniformValueChanged(location, array.data(), array.size()*sizeof(GLint))) {
+      return;
+    }
     GL_THROW_UPON_ERROR(
-      glUniform1iv(LocationOfUniform(name), static_cast<GLsizei>(array.size()), array.data())
+      glUniform1iv(location, static_cast<GLsizei>(array.size()), array.data())
     );
   }
   // Sets the named uniform to the given std::vector of GLfloat values.
   // This shader must be bound for this call to succeed.
   void SetUniformf (const std::string &name, const std::vector<GLfloat> &array) const {
     assert(CurrentlyBoundProgramHandle() == m_program_handle && "trying to set a uniform without having first called GLShader::Bind on this");
+    GLint location = LocationOfUniform(name);
+    if (!UniformValueChanged(location, array.data(), array.size()*sizeof(GLfloat))) {
+      return;
+    }
     GL_THROW_UPON_ERROR(
-      glUniform1fv(LocationOfUniform(name), static_cast<GLsizei>(array.size()), array.data())
+      glUniform1fv(location, static_cast<GLsizei>(array.size()), array.data())
     );
   }
   // Sets the named uniform to the given std::vector of values each of which must be
@@ -228,8 +325,12 @@ public:
     static_assert(UniformFunction<GLint,sizeof(T_)/sizeof(GLint)>::exists, "There is no known glUniform*iv function for size of given T_");
     // TODO: somehow check that T_ is actually a POD containing only GLint components.
     assert(CurrentlyBoundProgramHandle() == m_program_handle && "trying to set a uniform without having first called GLShader::Bind on this");
+    GLint location = LocationOfUniform(name);
+    if (!UniformValueChanged(location, array.data(), array.size()*sizeof(T_))) {
+      return;
+    }
     GL_THROW_UPON_ERROR((
-      UniformFunction<GLint,sizeof(T_)/sizeof(GLint)>::eval(LocationOfUniform(name), array.size(), reinterpret_cast<const GLint *>(array.data()))
+      UniformFunction<GLint,sizeof(T_)/sizeof(GLint)>::eval(location, static_cast<GLsizei>(array.size()), reinterpret_cast<const GLint *>(array.data()))
     ));
   }
   // Sets the named uniform to the given std::vector of values each of which must be
@@ -241,8 +342,12 @@ public:
     static_assert(UniformFunction<GLfloat,sizeof(T_)/sizeof(GLfloat)>::exists, "There is no known glUniform*i function for size of given T_");
     // TODO: somehow check that T_ is actually a POD containing only GLfloat components.
     assert(CurrentlyBoundProgramHandle() == m_program_handle && "trying to set a uniform without having first called GLShader::Bind on this");
+    GLint location = LocationOfUniform(name);
+    if (!UniformValueChanged(location, array.data(), array.size()*sizeof(T_))) {
+      return;
+    }
     GL_THROW_UPON_ERROR((
-      UniformFunction<GLfloat,sizeof(T_)/sizeof(GLfloat)>::eval(LocationOfUniform(name), array.size(), reinterpret_cast<const GLfloat *>(array.data()))
+      UniformFunction<GLfloat,sizeof(T_)/sizeof(GLfloat)>::eval(location, static_cast<GLsizei>(array.size()), reinterpret_cast<const GLfloat *>(array.data()))
     ));
   }
 
@@ -260,8 +365,12 @@ public:
     static_assert(sizeof(T_) == ROWS_*COLUMNS_*sizeof(GLfloat), "T_ must be a POD type having exactly ROWS_*COLUMNS_ components of type GLfloat");
     // TODO: somehow check that T_ is actually a POD containing only GLType_ components.
     assert(CurrentlyBoundProgramHandle() == m_program_handle && "trying to set a uniform without having first called GLShader::Bind on this");
+    GLint location = LocationOfUniform(name);
+    if (!UniformValueChanged(location, &matrix, sizeof(T_), matrix_storage_convention)) {
+      return;
+    }
     GL_THROW_UPON_ERROR((
-      UniformMatrixFunction<ROWS_,COLUMNS_>::eval(LocationOfUniform(name), 1, matrix_storage_convention == ROW_MAJOR, reinterpret_cast<const GLfloat *>(&matrix))
+      UniformMatrixFunction<ROWS_,COLUMNS_>::eval(location, 1, matrix_storage_convention == ROW_MAJOR, reinterpret_cast<const GLfloat *>(&matrix))
     ));
   }
   // Sets the named uniform to the given std::vector of values each of which must be
@@ -276,8 +385,12 @@ public:
     static_assert(sizeof(T_) == ROWS_*COLUMNS_*sizeof(GLfloat), "T_ must be a POD type having exactly ROWS_*COLUMNS_ components of type GLfloat");
     // TODO: somehow check that T_ is actually a POD containing only GLType_ components.
     assert(CurrentlyBoundProgramHandle() == m_program_handle && "trying to set a uniform without having first called GLShader::Bind on this");
+    GLint location = LocationOfUniform(name);
+    if (!UniformValueChanged(location, array.data(), array.size()*sizeof(T_), matrix_storage_convention)) {
+      return;
+    }
     GL_THROW_UPON_ERROR((
-      UniformMatrixFunction<ROWS_,COLUMNS_>::eval(LocationOfUniform(name), array.size(), matrix_storage_convention == ROW_MAJOR, reinterpret_cast<const GLfloat *>(array.data()))
+      UniformMatrixFunction<ROWS_,COLUMNS_>::eval(location, static_cast<GLsizei>(array.size()), matrix_storage_convention == ROW_MAJOR, reinterpret_cast<const GLfloat *>(array.data()))
     ));
   }
 
@@ -294,12 +407,30 @@ private:
   // in encountered, a std::logic_error is thrown.
   static GLuint Compile (GLuint type, const std::string &source);
 
+  // Returns true iff the given value differs from the one last uploaded to the uniform at the given
+  // location (or if nothing has been uploaded there yet), and records it as the uploaded value.
+  // The tag distinguishes uploads of identical bytes with different meanings (e.g. transposition).
+  // Always returns false for location -1, since glUniform* silently ignores it anyway.
+  bool UniformValueChanged (GLint location, const void *value, size_t size, int tag = 0) const;
+
   GLuint m_vertex_shader;   ///< Handle to the vertex shader in the GL apparatus.
   GLuint m_fragment_shader; ///< Handle to the fragment shader in the GL apparatus.
   GLuint m_program_handle;            ///< Handle to the shader program in the GL apparatus.
 
   VarInfoMap m_uniform_info_map;
   VarInfoMap m_attribute_info_map;
+  BlockInfoMap m_uniform_block_info_map;
+  // The binding point last set for each uniform block, indexed by block index.
+  mutable std::map<GLuint,GLuint> m_uniform_block_bindings;
+
+  // The value last uploaded to a uniform, and the tag it was uploaded with.
+  struct CachedUniformValue {
+    CachedUniformValue () : tag(0) { }
+    int tag;
+    std::vector<uint8_t> bytes;
+  };
+  // Indexed by location.
+  mutable std::map<GLint,CachedUniformValue> m_uniform_value_cache;
 };
 
 typedef std::shared_ptr<GLShader> GLShaderRef;
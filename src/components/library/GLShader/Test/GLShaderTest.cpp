@@ -94,3 +94,121 @@ TEST_F(GLShaderTest, DISABLED_SetTypedUniformCheckInVertexShader) {
   }
 }
 
+
+TEST_F(GLShaderTest, RedundantBindsAndUniformUploadsAreElided) {
+  std::string vertex_shader_source(
+    "#version 120\n"
+    "uniform vec4 color;\n"
+    "void main () {\n"
+    "    gl_Position = ftransform();\n"
+    "    gl_FrontColor = color;\n"
+    "}\n"
+  );
+  std::string fragment_shader_source(
+    "#version 120\n"
+    "void main () {\n"
+    "    gl_FragColor = gl_Color;\n"
+    "}\n"
+  );
+  std::shared_ptr<GLShader> shader;
+  ASSERT_NO_THROW_(shader = std::make_shared<GLShader>(vertex_shader_source, fragment_shader_source));
+  ASSERT_TRUE(shader->HasUniform("color"));
+
+  const GLfloat color[4] = { 1.0f, 0.5f, 0.25f, 1.0f };
+  GLStateTracker &tracker = GLStateTracker::Current();
+  tracker.ResetCounters();
+  {
+    GLStateTracker::Scope scope(tracker);
+    for (int i = 0; i < 3; ++i) {
+      shader->Bind();
+      shader->SetUniformf("color", color);
+      shader->Unbind();
+    }
+    // The pending unbind hasn't been issued yet.
+    EXPECT_EQ(shader->ProgramHandle(), GLShader::CurrentlyBoundProgramHandle());
+  }
+  EXPECT_EQ(0u, GLShader::CurrentlyBoundProgramHandle());
+
+  const GLStateTracker::Counters &counters = tracker.GetCounters();
+  // One bind, and one unbind at the end of the scope; the two rebinds and three unbinds within it are elided.
+  EXPECT_EQ(2u, counters.program_binds.issued);
+  EXPECT_EQ(5u, counters.program_binds.elided);
+  EXPECT_EQ(1u, counters.uniform_uploads.issued);
+  EXPECT_EQ(2u, counters.uniform_uploads.elided);
+
+  // After invalidating the uniform cache, the same value must be uploaded again.
+  shader->InvalidateUniformCache();
+  shader->Bind();
+  shader->SetUniformf("color", color);
+  shader->Unbind();
+  EXPECT_EQ(2u, counters.uniform_uploads.issued);
+}
+
+TEST_F(GLShaderTest, UniformBlocks) {
+  if (!GLShader::UniformBlocksAreSupported()) {
+    std::cout << "uniform blocks are not supported by this GL context; skipping\n";
+    return;
+  }
+  std::string vertex_shader_source(
+    "#version 140\n"
+    "layout(std140) uniform Transforms {\n"
+    "    mat4 projection_times_model_view_matrix;\n"
+    "    vec4 tint;\n"
+    "};\n"
+    "in vec3 position;\n"
+    "out vec4 color;\n"
+    "void main () {\n"
+    "    gl_Position = projection_times_model_view_matrix * vec4(position, 1.0);\n"
+    "    color = tint;\n"
+    "}\n"
+  );
+  std::string fragment_shader_source(
+    "#version 140\n"
+    "in vec4 color;\n"
+    "void main () {\n"
+    "    gl_FragColor = color;\n"
+    "}\n"
+  );
+  std::shared_ptr<GLShader> shader;
+  ASSERT_NO_THROW_(shader = std::make_shared<GLShader>(vertex_shader_source, fragment_shader_source));
+  ASSERT_TRUE(shader->HasUniformBlock("Transforms"));
+  // The std140 layout of a mat4 followed by a vec4.
+  EXPECT_EQ(80, shader->UniformBlockInfo("Transforms").DataSize());
+  EXPECT_NO_THROW_(shader->CheckForUniformBlock("Transforms", 80, VariableIs::REQUIRED));
+  EXPECT_ANY_THROW(shader->CheckForUniformBlock("Transforms", 64, VariableIs::REQUIRED));
+  EXPECT_ANY_THROW(shader->CheckForUniformBlock("Missing", 64, VariableIs::REQUIRED));
+  // The members of a block are not plain uniforms.
+  EXPECT_FALSE(shader->HasUniform("tint"));
+  EXPECT_NO_THROW_(shader->SetUniformBlockBinding("Transforms", 3));
+}
+
+TEST_F(GLShaderTest, AttributeLocationsAreBoundBeforeLinking) {
+  std::string vertex_shader_source(
+    "#version 120\n"
+    "attribute vec4 color;\n"
+    "attribute vec3 position;\n"
+    "void main () {\n"
+    "    gl_Position = vec4(position, 1.0);\n"
+    "    gl_FrontColor = color;\n"
+    "}\n"
+  );
+  std::string fragment_shader_source(
+    "#version 120\n"
+    "void main () {\n"
+    "    gl_FragColor = gl_Color;\n"
+    "}\n"
+  );
+  GLShader::AttributeLocationMap attribute_locations;
+  attribute_locations["position"] = 0;
+  attribute_locations["color"] = 3;
+  std::shared_ptr<GLShader> shader;
+  ASSERT_NO_THROW_(shader = std::make_shared<GLShader>(vertex_shader_source, fragment_shader_source, attribute_locations));
+  EXPECT_EQ(0, shader->LocationOfAttribute("position"));
+  EXPECT_EQ(3, shader->LocationOfAttribute("color"));
+
+  // Names which aren't attributes of the program are ignored.
+  attribute_locations["missing"] = 1;
+  ASSERT_NO_THROW_(shader = std::make_shared<GLShader>(vertex_shader_source, fragment_shader_source, attribute_locations));
+  EXPECT_EQ(0, shader->LocationOfAttribute("position"));
+  EXPECT_FALSE(shader->HasAttribute("missing"));
+}
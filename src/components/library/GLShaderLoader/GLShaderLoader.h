@@ -58,6 +58,14 @@ struct ResourceLoader<GLShaderLoadParams> {
       return std::make_shared<GLShaderLoadParams>("lighting-vert.glsl", "lighting-frag.glsl");
     } else if (name == "material") {
       return std::make_shared<GLShaderLoadParams>("matrix-transformed-vert.glsl", "material-frag.glsl");
+    } else if (name == "material_ubo") {
+      // Requires GL 3.1; see GLShaderMatrices.h and GLMaterial.h.
+      return std::make_shared<GLShaderLoadParams>("matrix-transformed-ubo-vert.glsl", "material-ubo-frag.glsl");
+    } else if (name == "material_vertex_color") {
+      // The "material" shader, with the lit color modulated by the "color" vertex attribute.
+      return std::make_shared<GLShaderLoadParams>("matrix-transformed-vertex-color-vert.glsl", "material-vertex-color-frag.glsl");
+    } else if (name == "material_vertex_color_ubo") {
+      return std::make_shared<GLShaderLoadParams>("matrix-transformed-vertex-color-ubo-vert.glsl", "material-vertex-color-ubo-frag.glsl");
     } else {
       const std::string vert = name + "-vert.glsl";
       const std::string frag = name + "-frag.glsl";
@@ -67,11 +75,36 @@ struct ResourceLoader<GLShaderLoadParams> {
   }
 };
 
+// The source code of a shader program, which is what ResourceLoader<GLShader> reads on a worker
+// thread when loading asynchronously (only compiling and linking need the GL context).
+class GLShaderSources {
+public:
+
+  GLShaderSources (const std::string &vertex_shader_source, const std::string &fragment_shader_source)
+    :
+    m_vertex_shader_source(vertex_shader_source),
+    m_fragment_shader_source(fragment_shader_source)
+  { }
+
+  const std::string &VertexShaderSource () const { return m_vertex_shader_source; }
+  const std::string &FragmentShaderSource () const { return m_fragment_shader_source; }
+
+private:
+
+  std::string m_vertex_shader_source;
+  std::string m_fragment_shader_source;
+};
+
 // Template specialization of ResourceLoader<GLShader> which defines how to load such a resource.
 template <>
 struct ResourceLoader<GLShader> {
   static const bool exists = true;
   static std::shared_ptr<GLShader> LoadResource (const std::string &name, ResourceManager<GLShader> &calling_manager) {
+    return FinishResource(DecodeResource(name, calling_manager), name, calling_manager);
+  }
+
+  typedef GLShaderSources Decoded;
+  static std::shared_ptr<GLShaderSources> DecodeResource (const std::string &name, ResourceManager<GLShader> &calling_manager) {
     if (name == "dummy") {
       std::string vertex_shader_source(
         "void main () {\n"
@@ -84,7 +117,7 @@ struct ResourceLoader<GLShader> {
         "    gl_FragColor = vec4(1.0, 0.2, 0.3, 0.5);\n"
         "}\n"
       );
-      return std::make_shared<GLShader>(vertex_shader_source, fragment_shader_source);
+      return std::make_shared<GLShaderSources>(vertex_shader_source, fragment_shader_source);
     } else {
       // Load the params for the requested shader program.
       auto params = Resource<GLShaderLoadParams>(name);
@@ -105,10 +138,13 @@ struct ResourceLoader<GLShader> {
       if (!vertex_shader_source || !fragment_shader_source) {
         // throw std::domain_error("no resource \"" + name + "\" found for type GLShader");
         std::cout << "ResourceLoader<GLShader> : failed to load \"" << name << "\", falling back to \"dummy\".\n";
-        return LoadResource("dummy", calling_manager);
+        return DecodeResource("dummy", calling_manager);
       }
-      
-      return std::make_shared<GLShader>(vertex_shader_source->Contents(), fragment_shader_source->Contents());
+
+      return std::make_shared<GLShaderSources>(vertex_shader_source->Contents(), fragment_shader_source->Contents());
     }
   }
+  static std::shared_ptr<GLShader> FinishResource (const std::shared_ptr<GLShaderSources> &decoded, const std::string &name, ResourceManager<GLShader> &calling_manager) {
+    return std::make_shared<GLShader>(decoded->VertexShaderSource(), decoded->FragmentShaderSource());
+  }
 };
@@ -0,0 +1,156 @@
+#include "GLStateTracker.h"
+
+#include <cassert>
+#include "GLError.h"
+
+namespace {
+
+GLStateTracker *s_current_tracker = nullptr;
+
+} // end of anonymous namespace
+
+GLStateTracker::GLStateTracker ()
+  :
+  m_scope_depth(0),
+  m_program_unbind_pending(false)
+{ }
+
+GLStateTracker &GLStateTracker::Current () {
+  static GLStateTracker s_default_tracker;
+  return s_current_tracker ? *s_current_tracker : s_default_tracker;
+}
+
+void GLStateTracker::SetCurrent (GLStateTracker *tracker) {
+  s_current_tracker = tracker;
+}
+
+void GLStateTracker::BeginScope () {
+  if (m_scope_depth++ == 0) {
+    Invalidate();
+    // The active texture unit is needed to key the texture bindings, so it's worth one query.
+    GLint active_texture = GL_TEXTURE0;
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &active_texture);
+    m_active_texture.Update(static_cast<GLenum>(active_texture), false);
+  }
+}
+
+void GLStateTracker::EndScope () {
+  assert(m_scope_depth > 0 && "EndScope called without a matching BeginScope");
+  if (--m_scope_depth == 0 && m_program_unbind_pending) {
+    m_program_unbind_pending = false;
+    m_bound_program.Update(0, false);
+    Count(m_counters.program_binds, true);
+    GL_THROW_UPON_ERROR(glUseProgram(0));
+  }
+}
+
+void GLStateTracker::Invalidate () {
+  // A deferred unbind can't be dropped, otherwise the program would stay bound after the scope.
+  bool program_unbind_pending = m_program_unbind_pending;
+  m_bound_program = Cached<GLuint>();
+  m_program_unbind_pending = false;
+  m_active_texture = Cached<GLenum>();
+  m_bound_textures.clear();
+  m_capabilities.clear();
+  m_blend_func = Cached<std::pair<GLenum,GLenum>>();
+  m_depth_func = Cached<GLenum>();
+  m_depth_mask = Cached<bool>();
+  if (program_unbind_pending) {
+    Count(m_counters.program_binds, true);
+    GL_THROW_UPON_ERROR(glUseProgram(0));
+  }
+}
+
+void GLStateTracker::UseProgram (GLuint program) {
+  const bool trusted = IsInsideScope();
+  if (trusted && program == 0 && m_bound_program.known) {
+    // Defer the unbind; if the same program is bound next, neither call needs to be made.
+    if (m_bound_program.value != 0) {
+      m_program_unbind_pending = true;
+    }
+    Count(m_counters.program_binds, false);
+    return;
+  }
+  m_program_unbind_pending = false;
+  bool issue = m_bound_program.Update(program, trusted);
+  Count(m_counters.program_binds, issue);
+  if (issue) {
+    GL_THROW_UPON_ERROR(glUseProgram(program));
+  }
+}
+
+void GLStateTracker::ProgramDeleted (GLuint program) {
+  if (m_bound_program.known && m_bound_program.value == program) {
+    // Issue any pending unbind now, since deletion of a bound program is postponed by GL.
+    if (m_program_unbind_pending) {
+      m_program_unbind_pending = false;
+      Count(m_counters.program_binds, true);
+      glUseProgram(0);
+    }
+    m_bound_program = Cached<GLuint>();
+  }
+}
+
+void GLStateTracker::ActiveTexture (GLenum texture_unit) {
+  bool issue = m_active_texture.Update(texture_unit, IsInsideScope());
+  Count(m_counters.active_texture_changes, issue);
+  if (issue) {
+    GL_THROW_UPON_ERROR(glActiveTexture(texture_unit));
+  }
+}
+
+void GLStateTracker::BindTexture (GLenum target, GLuint texture) {
+  bool issue = true;
+  if (m_active_texture.known) {
+    issue = m_bound_textures[std::make_pair(m_active_texture.value, target)].Update(texture, IsInsideScope());
+  }
+  Count(m_counters.texture_binds, issue);
+  if (issue) {
+    GL_THROW_UPON_ERROR(glBindTexture(target, texture));
+  }
+}
+
+void GLStateTracker::TextureDeleted (GLuint texture) {
+  for (auto it = m_bound_textures.begin(); it != m_bound_textures.end(); ++it) {
+    Cached<GLuint> &bound_texture = it->second;
+    if (bound_texture.known && bound_texture.value == texture) {
+      bound_texture.value = 0;
+    }
+  }
+}
+
+void GLStateTracker::SetCapability (GLenum capability, bool enabled) {
+  bool issue = m_capabilities[capability].Update(enabled, IsInsideScope());
+  Count(m_counters.capability_changes, issue);
+  if (issue) {
+    if (enabled) {
+      GL_THROW_UPON_ERROR(glEnable(capability));
+    } else {
+      GL_THROW_UPON_ERROR(glDisable(capability));
+    }
+  }
+}
+
+void GLStateTracker::BlendFunc (GLenum source_factor, GLenum destination_factor) {
+  bool issue = m_blend_func.Update(std::make_pair(source_factor, destination_factor), IsInsideScope());
+  Count(m_counters.blend_func_changes, issue);
+  if (issue) {
+    GL_THROW_UPON_ERROR(glBlendFunc(source_factor, destination_factor));
+  }
+}
+
+void GLStateTracker::DepthFunc (GLenum func) {
+  bool issue = m_depth_func.Update(func, IsInsideScope());
+  Count(m_counters.depth_func_changes, issue);
+  if (issue) {
+    GL_THROW_UPON_ERROR(glDepthFunc(func));
+  }
+}
+
+void GLStateTracker::DepthMask (bool enabled) {
+  bool issue = m_depth_mask.Update(enabled, IsInsideScope());
+  Count(m_counters.depth_mask_changes, issue);
+  if (issue) {
+    GL_THROW_UPON_ERROR(glDepthMask(enabled ? GL_TRUE : GL_FALSE));
+  }
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <utility>
+
+#include "gl_glext_glu.h" // convenience header for cross-platform GL includes
+
+// This class tracks a small, frequently-touched subset of the GL state of a single GL context
+// (the bound shader program, texture bindings, enabled capabilities, and the blend and depth
+// state), so that calls which would not change anything can be skipped.  Counters record how
+// many calls were issued and how many were elided.
+//
+// Because raw GL calls made elsewhere modify the GL state without the knowledge of the tracker
+// (see the design notes in GLController.cpp), the cached state is only trusted between calls to
+// BeginScope and EndScope (see also GLStateTracker::Scope).  Entering the outermost scope forgets
+// all cached state, so the first call of each kind is always issued.  Outside of a scope, every
+// call is passed through to GL (and still recorded, so that nothing goes stale).
+//
+// Within a scope, unbinding the shader program (i.e. UseProgram(0)) is deferred, so that a
+// sequence of draws which each bind and unbind the same shader (e.g. via GLShaderBindingScopeGuard)
+// only binds it once.  The pending unbind is issued when the outermost scope ends, so the GL
+// state observed after the scope is the same as if nothing had been elided.
+//
+// Uniform values are program object state, so they are cached by GLShader itself; it reports
+// its issued/elided uniform uploads here via CountUniformUpload.
+class GLStateTracker {
+public:
+
+  // The number of calls of a particular kind which were passed through to GL and which were skipped.
+  struct CallCount {
+    CallCount () : issued(0), elided(0) { }
+    uint64_t Total () const { return issued + elided; }
+    uint64_t issued;
+    uint64_t elided;
+  };
+
+  struct Counters {
+    CallCount program_binds;
+    CallCount texture_binds;
+    CallCount active_texture_changes;
+    CallCount capability_changes;
+    CallCount blend_func_changes;
+    CallCount depth_func_changes;
+    CallCount depth_mask_changes;
+    CallCount uniform_uploads;
+  };
+
+  // RAII helper for BeginScope/EndScope.
+  class Scope {
+  public:
+    Scope (GLStateTracker &tracker) : m_tracker(tracker) { m_tracker.BeginScope(); }
+    ~Scope () { m_tracker.EndScope(); }
+  private:
+    Scope (const Scope &) = delete;
+    Scope &operator = (const Scope &) = delete;
+    GLStateTracker &m_tracker;
+  };
+
+  GLStateTracker ();
+
+  // Returns the tracker for the current GL context.  If SetCurrent has not been called (or was
+  // last called with nullptr), a process-wide default tracker is returned, which is adequate for
+  // applications which use a single GL context.
+  static GLStateTracker &Current ();
+  // Sets the tracker for the current GL context.  Applications which switch between GL contexts
+  // should call this whenever the GL context is made current.  The tracker must outlive its use.
+  static void SetCurrent (GLStateTracker *tracker);
+
+  // Enters/leaves a region in which no raw GL calls touch the tracked state.  Scopes nest.
+  void BeginScope ();
+  void EndScope ();
+  bool IsInsideScope () const { return m_scope_depth > 0; }
+
+  // Forgets all cached state, so that the next call of each kind is issued.  Should be called if raw
+  // GL calls which modify the tracked state are made within a scope.
+  void Invalidate ();
+
+  // Equivalent to glUseProgram.
+  void UseProgram (GLuint program);
+  // Must be called before a program is deleted, since GL may reuse its handle for a later program.
+  void ProgramDeleted (GLuint program);
+  // Equivalent to glActiveTexture.
+  void ActiveTexture (GLenum texture_unit);
+  // Equivalent to glBindTexture on the active texture unit.
+  void BindTexture (GLenum target, GLuint texture);
+  // Must be called before a texture is deleted, since GL unbinds it from every texture unit.
+  void TextureDeleted (GLuint texture);
+  // Equivalent to glEnable/glDisable.
+  void SetCapability (GLenum capability, bool enabled);
+  void Enable (GLenum capability) { SetCapability(capability, true); }
+  void Disable (GLenum capability) { SetCapability(capability, false); }
+  // Equivalent to glBlendFunc.
+  void BlendFunc (GLenum source_factor, GLenum destination_factor);
+  // Equivalent to glDepthFunc.
+  void DepthFunc (GLenum func);
+  // Equivalent to glDepthMask.
+  void DepthMask (bool enabled);
+
+  // Called by GLShader to record whether a uniform upload was issued or elided.
+  void CountUniformUpload (bool issued) { Count(m_counters.uniform_uploads, issued); }
+
+  const Counters &GetCounters () const { return m_counters; }
+  void ResetCounters () { m_counters = Counters(); }
+
+private:
+
+  // A cached value is only meaningful if it is known, i.e. it was set since the last Invalidate.
+  template <typename T_>
+  struct Cached {
+    Cached () : known(false), value() { }
+    // Returns true iff the call setting the given value must be issued, and records the value.
+    bool Update (const T_ &new_value, bool trusted) {
+      bool must_issue = !trusted || !known || value != new_value;
+      known = true;
+      value = new_value;
+      return must_issue;
+    }
+    bool known;
+    T_ value;
+  };
+
+  static void Count (CallCount &call_count, bool issued) {
+    if (issued) {
+      ++call_count.issued;
+    } else {
+      ++call_count.elided;
+    }
+  }
+
+  unsigned int m_scope_depth;
+
+  Cached<GLuint> m_bound_program;
+  // Set while an unbind of the program (to 0) has been deferred.
+  bool m_program_unbind_pending;
+  Cached<GLenum> m_active_texture;
+  // Indexed by (texture unit, target).
+  std::map<std::pair<GLenum,GLenum>,Cached<GLuint>> m_bound_textures;
+  std::map<GLenum,Cached<bool>> m_capabilities;
+  Cached<std::pair<GLenum,GLenum>> m_blend_func;
+  Cached<GLenum> m_depth_func;
+  Cached<bool> m_depth_mask;
+
+  Counters m_counters;
+};
@@ -57,7 +57,7 @@ GLTexture2::GLTexture2 (const GLTexture2Params &params, const GLTexture2PixelDat
   GLClearError();
   glGenTextures(1, &m_texture_name);
   GLThrowUponError("in glGenTextures");
-  glBindTexture(m_params.Target(), m_texture_name);
+  Bind();
   GLThrowUponError("in glBindTexture");
 
   // Set all the GLfloat texture parameters.
@@ -97,10 +97,11 @@ GLTexture2::GLTexture2 (const GLTexture2Params &params, const GLTexture2PixelDat
   m_params.SetInternalFormat(actual_internal_format);
 
   // Unbind the texture to minimize the possibility that other GL calls may modify this texture.
-  glBindTexture(m_params.Target(), 0);
+  Unbind();
 }
 
 GLTexture2::~GLTexture2 () {
+  GLStateTracker::Current().TextureDeleted(m_texture_name);
   glDeleteTextures(1, &m_texture_name);
 }
 
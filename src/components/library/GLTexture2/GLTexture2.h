@@ -1,6 +1,7 @@
 #pragma once
 
 #include "gl_glext_glu.h" // convenience header for cross-platform GL includes
+#include "GLStateTracker.h"
 #include "GLTexture2Params.h"
 #include "GLTexture2PixelData.h"
 
@@ -29,10 +30,11 @@ public:
   // Returns the GLTexture2Params used to construct this texture.
   const GLTexture2Params &Params() const { return m_params; }
 
-  // This method should be called to bind this shader.
-  void Bind () const { glBindTexture(m_params.Target(), m_texture_name); }
-  // This method should be called when no shader program should be used.
-  void Unbind () const { glBindTexture(m_params.Target(), 0); }
+  // This method should be called to bind this texture (to the active texture unit).
+  // Redundant binds are skipped by GLStateTracker::Current().
+  void Bind () const { GLStateTracker::Current().BindTexture(m_params.Target(), m_texture_name); }
+  // This method should be called when no texture should be bound to the active texture unit.
+  void Unbind () const { GLStateTracker::Current().BindTexture(m_params.Target(), 0); }
 
   // Updates the contents of this texture from the specified pixel data.
   void UpdateTexture (const GLTexture2PixelData &pixel_data);
@@ -108,6 +108,55 @@ TEST_F(GLTexture2HeadlessTest, ExtractTexture) {
   EXPECT_EQ(pixel_data.RawPixels(), extracted_pixel_data.RawPixels());
 }
 
+// The texture bound to the 2D target of the given texture unit, queried from GL.
+static GLuint BoundTexture2D (GLenum texture_unit) {
+  GLint bound_texture = 0;
+  glActiveTexture(texture_unit);
+  glGetIntegerv(GL_TEXTURE_BINDING_2D, &bound_texture);
+  return static_cast<GLuint>(bound_texture);
+}
+
+TEST_F(GLTexture2HeadlessTest, BindingOnSeveralTextureUnits) {
+  // Three textures bound to units 0, 1 and 2, as RiggedHand does with its diffuse, normal and skin textures.
+  std::vector<std::shared_ptr<GLTexture2>> textures;
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_NO_THROW_(textures.push_back(std::make_shared<GLTexture2>(GLTexture2Params(4, 4))));
+  }
+
+  glActiveTexture(GL_TEXTURE0);
+  GLStateTracker &tracker = GLStateTracker::Current();
+  tracker.ResetCounters();
+  {
+    GLStateTracker::Scope scope(tracker);
+    for (int i = 0; i < 3; ++i) {
+      tracker.ActiveTexture(GL_TEXTURE0 + i);
+      textures[i]->Bind();
+    }
+    // Binding the same texture to another unit is not redundant.
+    tracker.ActiveTexture(GL_TEXTURE1);
+    textures[0]->Bind();
+    textures[0]->Bind();
+    // Unbind units 1 and 2, and leave unit 0 bound.
+    for (int i = 1; i < 3; ++i) {
+      tracker.ActiveTexture(GL_TEXTURE0 + i);
+      textures[i]->Unbind();
+    }
+    tracker.ActiveTexture(GL_TEXTURE0);
+  }
+
+  EXPECT_EQ(textures[0]->Id(), BoundTexture2D(GL_TEXTURE0));
+  EXPECT_EQ(0u, BoundTexture2D(GL_TEXTURE1));
+  EXPECT_EQ(0u, BoundTexture2D(GL_TEXTURE2));
+  glActiveTexture(GL_TEXTURE0);
+
+  const GLStateTracker::Counters &counters = tracker.GetCounters();
+  // Only the second bind of texture 0 to unit 1 is redundant.
+  EXPECT_EQ(6u, counters.texture_binds.issued);
+  EXPECT_EQ(1u, counters.texture_binds.elided);
+  // Unit 0 is already active when the scope begins, and unit 1 is selected twice in a row.
+  EXPECT_EQ(2u, counters.active_texture_changes.elided);
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 // Visible tests
 ///////////////////////////////////////////////////////////////////////////////////////////////////
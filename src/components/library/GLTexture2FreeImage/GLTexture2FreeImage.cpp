@@ -218,3 +218,16 @@ GLTexture2 *LoadGLTexture2UsingFreeImage (const std::string &filepath, const GLT
     throw; // rethrow the exception.
   }
 }
+
+std::shared_ptr<FIBITMAP> DecodeImageUsingFreeImage (const std::string &filepath) {
+  FIBITMAP *bitmap = LoadFreeImageBitmap(filepath);
+  if (bitmap == nullptr) {
+    // TODO: better error reporting
+    throw std::runtime_error("error while loading image \"" + filepath + "\" via FreeImage");
+  }
+  return std::shared_ptr<FIBITMAP>(bitmap, FreeImage_Unload);
+}
+
+GLTexture2 *CreateGLTexture2FromFreeImageBitmap (const std::shared_ptr<FIBITMAP> &bitmap, const GLTexture2Params &params) {
+  return AttemptToCreateGLTexture2FromFIBITMAP(bitmap.get(), params);
+}
@@ -1,9 +1,11 @@
 #pragma once
 
+#include <memory>
 #include <string>
 
 class GLTexture2;
 class GLTexture2Params;
+struct FIBITMAP;
 
 // The only value that must be set in the passed-in GLTexture2Params is "target".
 // If it is desired to specify any TexParameter values, this must be done before
@@ -15,3 +17,10 @@ class GLTexture2Params;
 // in which case it would be a hint to OpenGL for how the texture should be stored
 // internally.
 GLTexture2 *LoadGLTexture2UsingFreeImage (const std::string &filepath, const GLTexture2Params &params);
+
+// LoadGLTexture2UsingFreeImage in two steps, for loading on a worker thread: the first decodes
+// the image file (which doesn't touch GL, and so can be done on any thread), throwing if that
+// fails, and the second creates the GLTexture2 from the decoded image (which must be done on a
+// thread with the GL context).  The bitmap is freed when the last reference to it goes away.
+std::shared_ptr<FIBITMAP> DecodeImageUsingFreeImage (const std::string &filepath);
+GLTexture2 *CreateGLTexture2FromFreeImageBitmap (const std::shared_ptr<FIBITMAP> &bitmap, const GLTexture2Params &params);
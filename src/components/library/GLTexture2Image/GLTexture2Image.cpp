@@ -1,6 +1,7 @@
 #include "GLTexture2Image.h"
 
 // Components
+#include "GLStateTracker.h"
 #include "GLTexture2FreeImage.h"
 //#include "GLTexture2Loader.h"
 //#include "Resource.h"
@@ -18,7 +19,8 @@ void GLTexture2Image::Bind(int textureUnit) const
 {
   assert(m_Loaded && m_Texture);
   m_TextureUnit = textureUnit;
-  glActiveTexture(GL_TEXTURE0 + m_TextureUnit);
+  // The unit goes through the tracker too, which keys its texture bindings on it.
+  GLStateTracker::Current().ActiveTexture(GL_TEXTURE0 + m_TextureUnit);
   m_Texture->Bind();
 }
 
@@ -123,6 +125,6 @@ void GLTexture2Image::SetPath(const std::string& path)
 void GLTexture2Image::Unbind() const
 {
   assert(m_Loaded && m_Texture);
-  glActiveTexture(GL_TEXTURE0 + m_TextureUnit);
+  GLStateTracker::Current().ActiveTexture(GL_TEXTURE0 + m_TextureUnit);
   m_Texture->Unbind();
 }
@@ -6,6 +6,14 @@
 #include <cassert>
 
 std::shared_ptr<GLTexture2> ResourceLoader<GLTexture2>::LoadResource (const std::string &name, ResourceManager<GLTexture2> &calling_manager) {
+  return FinishResource(DecodeResource(name, calling_manager), name, calling_manager);
+}
+
+std::shared_ptr<FIBITMAP> ResourceLoader<GLTexture2>::DecodeResource (const std::string &name, ResourceManager<GLTexture2> &calling_manager) {
+  return DecodeImageUsingFreeImage(calling_manager.GetBasePath() + name);
+}
+
+std::shared_ptr<GLTexture2> ResourceLoader<GLTexture2>::FinishResource (const std::shared_ptr<FIBITMAP> &decoded, const std::string &name, ResourceManager<GLTexture2> &calling_manager) {
   // TODO: once the GLTexture2Params loader has been made, these values would be loaded from it.
   // for now, use reasonable fixed values.
   GLTexture2Params params;
@@ -15,5 +23,34 @@ std::shared_ptr<GLTexture2> ResourceLoader<GLTexture2>::LoadResource (const std:
   params.SetTexParameteri(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
   params.SetTexParameteri(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
   params.SetTexParameteri(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  return std::shared_ptr<GLTexture2>(LoadGLTexture2UsingFreeImage(calling_manager.GetBasePath() + name, params));
+  return std::shared_ptr<GLTexture2>(CreateGLTexture2FromFreeImageBitmap(decoded, params));
+}
+
+ResourceByteCount ResourceLoader<GLTexture2>::ByteCount (const GLTexture2 &resource) {
+  const GLTexture2Params &params = resource.Params();
+  // Drivers typically pad 3-component texels to 4 components.
+  size_t bytes_per_texel;
+  switch (params.InternalFormat()) {
+    case GL_R16UI:
+    case GL_R16I:
+      bytes_per_texel = 2;
+      break;
+    case GL_RGB16:
+    case GL_RGBA16:
+      bytes_per_texel = 8;
+      break;
+    case GL_RGB32F_ARB:
+    case GL_RGBA32F_ARB:
+      bytes_per_texel = 16;
+      break;
+    default:
+      bytes_per_texel = 4;
+      break;
+  }
+  size_t byte_count = size_t(params.Width())*size_t(params.Height())*bytes_per_texel;
+  // A full mipmap chain adds a third.
+  if (params.HasTexParameteri(GL_GENERATE_MIPMAP) && params.TexParameteri(GL_GENERATE_MIPMAP) == GL_TRUE) {
+    byte_count += byte_count/3;
+  }
+  return ResourceByteCount(0, byte_count);
 }
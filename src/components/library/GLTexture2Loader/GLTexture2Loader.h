@@ -3,6 +3,7 @@
 #include "ResourceManager.h"
 
 class GLTexture2;
+struct FIBITMAP;
 
 // TODO: maybe make a loader for GLTexture2Params, which would define "profiles" for
 // different classes of textures (e.g. non-mipmapped RGB textures, 16-bit cubemaps, etc),
@@ -13,4 +14,13 @@ template <>
 struct ResourceLoader<GLTexture2> {
   static const bool exists = true;
   static std::shared_ptr<GLTexture2> LoadResource (const std::string &name, ResourceManager<GLTexture2> &calling_manager);
+
+  // The image is decoded by FreeImage (on a worker, when loading asynchronously), and only
+  // uploading it needs the render thread.
+  typedef FIBITMAP Decoded;
+  static std::shared_ptr<FIBITMAP> DecodeResource (const std::string &name, ResourceManager<GLTexture2> &calling_manager);
+  static std::shared_ptr<GLTexture2> FinishResource (const std::shared_ptr<FIBITMAP> &decoded, const std::string &name, ResourceManager<GLTexture2> &calling_manager);
+
+  // An estimate of the texture's storage (GL doesn't report it), including any mipmaps.
+  static ResourceByteCount ByteCount (const GLTexture2 &resource);
 };
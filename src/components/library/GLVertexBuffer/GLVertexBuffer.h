@@ -117,13 +117,19 @@ public:
   // method should only be called after the intermediate attributes have changed and the
   // changes need to be propagated to the GPU.
   void UploadIntermediateAttributes () const {
-    GLsizeiptr intermediate_attributes_size(m_intermediate_attributes.size()*sizeof(Attributes));
-    const void *intermediate_attributes_data(m_intermediate_attributes.data());
-    // If the buffer is already created and is the same size as the intermediate attributes,
-    // then map it and copy the data in.
-    if (m_gl_buffer.IsCreated() && m_gl_buffer.Size() == intermediate_attributes_size) {
+    UploadAttributes(m_intermediate_attributes.data(), m_intermediate_attributes.size());
+  }
+  // As UploadIntermediateAttributes, but uploads the given array of attributes instead, e.g.
+  // one which was prebuilt and memory-mapped from a file, without copying it into the
+  // intermediate attributes first.
+  void UploadAttributes (const Attributes *attributes, size_t count) const {
+    GLsizeiptr attributes_size(count*sizeof(Attributes));
+    const void *attributes_data(attributes);
+    // If the buffer is already created and is the same size as the attributes, then map it
+    // and copy the data in.
+    if (m_gl_buffer.IsCreated() && m_gl_buffer.Size() == attributes_size) {
       void *ptr = m_gl_buffer.Map(GL_WRITE_ONLY);
-      memcpy(ptr, intermediate_attributes_data, intermediate_attributes_size);
+      memcpy(ptr, attributes_data, attributes_size);
       m_gl_buffer.Unmap();
     } else { // Otherwise ensure the buffer is created, 
       if (!m_gl_buffer.IsCreated()) {
@@ -131,10 +137,20 @@ public:
       }
       m_gl_buffer.Bind();
       // This will delete and reallocate if it's already allocated.
-      m_gl_buffer.Allocate(intermediate_attributes_data, intermediate_attributes_size, m_usage_pattern);
+      m_gl_buffer.Allocate(attributes_data, attributes_size, m_usage_pattern);
       m_gl_buffer.Unbind();
     }
   }
+  // Returns true iff the attributes have been uploaded (and so Enable may be called).
+  bool IsUploaded () const { return m_gl_buffer.IsCreated(); }
+  // Returns the offset (in bytes) of the INDEXth attribute within Attributes.  Attributes is
+  // NOT necessarily layed out in memory in the same order as the variadic template parameters,
+  // so this is needed to interpret raw attribute data.
+  template <size_t INDEX>
+  static size_t AttributeOffset () {
+    static const Attributes A; // This is not actually used for anything at runtime, just for determining the offset.
+    return static_cast<size_t>(reinterpret_cast<const uint8_t *>(&std::get<INDEX>(A)) - reinterpret_cast<const uint8_t *>(&A));
+  }
 
   // This method calls glEnableVertexAttribArray and glVertexAttribPointer on each
   // of the vertex attributes given valid locations (i.e. not equal to -1).  The
@@ -175,8 +191,7 @@ private:
     GLint location = std::get<INDEX>(locations);
     // Compute the offset of the current attribute into the Attributes tuple type.  It is NOT
     // necessarily layed out in memory in the same order as the variadic template parameters!
-    static const Attributes A; // This is not actually used for anything at runtime, just for determining the offset.
-    static const size_t OFFSET_OF_INDEXth_ATTRIBUTE = static_cast<size_t>(reinterpret_cast<const uint8_t *>(&std::get<INDEX>(A)) - reinterpret_cast<const uint8_t *>(&A));
+    static const size_t OFFSET_OF_INDEXth_ATTRIBUTE = AttributeOffset<INDEX>();
     // Call the Enable method of the INDEXth attribute type with the INDEXth location value, etc.
     AttributeType::Enable(location, static_cast<GLsizei>(stride), static_cast<GLsizei>(OFFSET_OF_INDEXth_ATTRIBUTE));
     // Increment INDEX and call this method again (this is a meta-program for loop).
@@ -5,6 +5,8 @@
 #include "GLShaderBindingScopeGuard.h"
 #include "GLShaderLoader.h"
 #include "GLShaderMatrices.h"
+#include "GLStateTracker.h"
+#include "GLUniformBufferRing.h"
 #include "RenderState.h"
 #include "Resource.h"
 #include "SceneGraphNode.h"
@@ -19,6 +21,9 @@ class Primitive : public SceneGraphNode<ParticularSceneGraphNodeProperties<Eigen
 public:
 
   static void DrawSceneGraph(const Primitive &root, RenderState &render_state) {
+    // Nothing but the nodes' draw calls touch the GL state during the traversal, so the state
+    // tracker can skip redundant binds (e.g. of a shader shared by consecutive nodes).
+    GLStateTracker::Scope state_tracker_scope(GLStateTracker::Current());
     // TODO: the existing model view matrix can be inputted as the initial state of global_properties
     // in the call to DepthFirstTraverse.
     root.template DepthFirstTraverse<Primitive>([&render_state](const Primitive &node, const Properties &global_properties) {
@@ -90,8 +95,9 @@ public:
     MakeAdditionalModelViewTransformations(model_view);
 
     if (!m_shader) {
-      m_shader = Resource<GLShader>("material");
+      m_shader = Resource<GLShader>(DefaultShaderName());
       GLMaterial::CheckShaderForUniforms(*m_shader);
+      GLShaderMatrices::CheckShaderForUniforms(*m_shader, BindFlags::BIND_AND_UNBIND);
     }
     const GLShader &shader = Shader();
     GLShaderBindingScopeGuard bso(shader, BindFlags::BIND_AND_UNBIND); // binds shader now, unbinds upon end of scope.
@@ -110,6 +116,13 @@ public:
 
 protected:
 
+  // The name of the shader resource used if none has been set via SetShader.  It must have the
+  // uniforms required by GLMaterial and GLShaderMatrices.  The uniform block variant of the
+  // material shader is used if uniform buffers are in use.
+  virtual std::string DefaultShaderName () const {
+    return GLUniformBufferRing::Current() != nullptr ? "material_ubo" : "material";
+  }
+
   // This method should be overridden in each subclass to draw the particular geometry that it represents.
   virtual void DrawContents(RenderState &render_state) const = 0;
   
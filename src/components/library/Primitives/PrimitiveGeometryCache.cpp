@@ -0,0 +1,68 @@
+#include "PrimitiveGeometryCache.h"
+
+#include <cassert>
+#include <cmath>
+
+const double PrimitiveGeometryCache::Key::DEFAULT_QUANTUM = 1.0e-4;
+const size_t PrimitiveGeometryCache::DEFAULT_CAPACITY = 256;
+
+double PrimitiveGeometryCache::Key::Add (double value, double quantum) {
+  assert(quantum > 0.0);
+  const int64_t quantized = static_cast<int64_t>(std::llround(value / quantum));
+  m_values.push_back(quantized);
+  return quantum*static_cast<double>(quantized);
+}
+
+int PrimitiveGeometryCache::Key::Add (int value) {
+  m_values.push_back(value);
+  return value;
+}
+
+PrimitiveGeometryCache &PrimitiveGeometryCache::Shared () {
+  static PrimitiveGeometryCache s_cache;
+  return s_cache;
+}
+
+std::shared_ptr<PrimitiveGeometry> PrimitiveGeometryCache::Get (const Key &key, const Generator &generator) {
+  auto found = m_index.find(key);
+  if (found != m_index.end()) {
+    ++m_stats.hits;
+    // Move the entry to the front, since it's now the most recently used.
+    m_entries.splice(m_entries.begin(), m_entries, found->second);
+    return found->second->geometry;
+  }
+
+  ++m_stats.misses;
+  std::shared_ptr<PrimitiveGeometry> geometry(std::make_shared<PrimitiveGeometry>());
+  generator(*geometry);
+  Entry entry = { key, geometry };
+  m_entries.push_front(entry);
+  m_index[key] = m_entries.begin();
+  EvictExcessEntries();
+  return geometry;
+}
+
+void PrimitiveGeometryCache::SetCapacity (size_t capacity) {
+  m_capacity = capacity;
+  EvictExcessEntries();
+}
+
+void PrimitiveGeometryCache::Clear () {
+  m_stats.evictions += m_entries.size();
+  m_index.clear();
+  m_entries.clear();
+}
+
+void PrimitiveGeometryCache::EvictExcessEntries () {
+  // Entries which are still in use elsewhere can't free anything by being evicted, so they are
+  // skipped; if all of them are in use, the cache is allowed to exceed its capacity for a while.
+  auto it = m_entries.end();
+  while (m_entries.size() > m_capacity && it != m_entries.begin()) {
+    --it;
+    if (it->geometry.use_count() == 1) {
+      m_index.erase(it->key);
+      it = m_entries.erase(it);
+      ++m_stats.evictions;
+    }
+  }
+}
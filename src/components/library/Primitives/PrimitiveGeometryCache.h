@@ -0,0 +1,95 @@
+#pragma once
+
+#include "PrimitiveGeometry.h"
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// A process-wide cache of uploaded PrimitiveGeometry, keyed on the shape and its quantized
+// generation parameters.  Primitives whose geometry depends on parameters (e.g. PartialDisk)
+// use this so that instances with the same shape share a single upload, and so that animating
+// a parameter back and forth reuses recently generated meshes instead of rebuilding them.
+//
+// Geometry is handed out as std::shared_ptr, so GPU buffers stay alive while any primitive
+// uses them, even if the cache has evicted them.  When the number of entries exceeds the
+// capacity, the least recently used entries which are not in use elsewhere are evicted.
+//
+// Like the rest of the GL code, this is not thread-safe; it must only be used on the GL thread.
+class PrimitiveGeometryCache {
+public:
+
+  // Identifies a piece of geometry.  The parameters are quantized, and Add returns the
+  // quantized value, which should be used when generating the geometry, so that the geometry
+  // for a key doesn't depend on which of the (nearly equal) requested parameters came first.
+  class Key {
+  public:
+
+    // The default quantum is well below anything visible at the scales the primitives are used.
+    static const double DEFAULT_QUANTUM;
+
+    explicit Key (const std::string &shape) : m_shape(shape) { }
+
+    double Add (double value, double quantum = DEFAULT_QUANTUM);
+    int Add (int value);
+
+    bool operator < (const Key &other) const {
+      return m_shape < other.m_shape || (m_shape == other.m_shape && m_values < other.m_values);
+    }
+
+  private:
+
+    std::string m_shape;
+    std::vector<int64_t> m_values;
+  };
+
+  // Must generate and upload (e.g. via UploadDataToBuffers) the geometry for a key.
+  typedef std::function<void(PrimitiveGeometry &geometry)> Generator;
+
+  struct Stats {
+    Stats () : hits(0), misses(0), evictions(0) { }
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+  };
+
+  static const size_t DEFAULT_CAPACITY;
+
+  PrimitiveGeometryCache (size_t capacity = DEFAULT_CAPACITY) : m_capacity(capacity) { }
+
+  // The cache used by the primitives in Primitives.h.
+  static PrimitiveGeometryCache &Shared ();
+
+  // Returns the geometry for the given key, calling generator to create it if it isn't cached.
+  std::shared_ptr<PrimitiveGeometry> Get (const Key &key, const Generator &generator);
+
+  size_t Capacity () const { return m_capacity; }
+  // Changing the capacity evicts entries as necessary.
+  void SetCapacity (size_t capacity);
+  size_t Size () const { return m_entries.size(); }
+  // Evicts every entry.  Geometry in use elsewhere stays alive until released.
+  void Clear ();
+
+  const Stats &GetStats () const { return m_stats; }
+  void ResetStats () { m_stats = Stats(); }
+
+private:
+
+  struct Entry {
+    Key key;
+    std::shared_ptr<PrimitiveGeometry> geometry;
+  };
+  // Ordered from most to least recently used.
+  typedef std::list<Entry> EntryList;
+
+  void EvictExcessEntries ();
+
+  size_t m_capacity;
+  EntryList m_entries;
+  std::map<Key,EntryList::iterator> m_index;
+  Stats m_stats;
+};
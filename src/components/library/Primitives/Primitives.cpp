@@ -2,6 +2,7 @@
 
 #include <cassert>
 #include "GLTexture2.h"
+#include "PrimitiveGeometryCache.h"
 
 void GenericShape::DrawContents(RenderState& renderState) const {
   m_geometry.Draw(Shader(), m_drawMode);
@@ -80,7 +81,7 @@ void RectanglePrim::MakeAdditionalModelViewTransformations (ModelView &model_vie
 void RectanglePrim::DrawContents(RenderState& renderState) const {
   bool useTexture = bool(m_texture); // If there is a valid texture, enable texturing.
   if (useTexture) {
-    glEnable(GL_TEXTURE_2D);
+    GLStateTracker::Current().Enable(GL_TEXTURE_2D);
     m_texture->Bind();
   }
   static PrimitiveGeometry geom;
@@ -91,7 +92,7 @@ void RectanglePrim::DrawContents(RenderState& renderState) const {
   }
   geom.Draw(Shader(), GL_TRIANGLES);
   if (useTexture) {
-    glDisable(GL_TEXTURE_2D);
+    GLStateTracker::Current().Disable(GL_TEXTURE_2D);
     m_texture->Unbind();
   }
 }
@@ -124,43 +125,49 @@ void PartialDisk::DrawContents(RenderState& renderState) const {
     RecomputeGeometry();
   }
 
-  m_Geometry.Draw(Shader(), GL_TRIANGLES);
+  m_Geometry->Draw(Shader(), GL_TRIANGLES);
 }
 
 void PartialDisk::RecomputeGeometry() const {
-  double sweepAngle = m_EndAngle - m_StartAngle;
-  if (sweepAngle > 2*M_PI) {
-    sweepAngle = 2*M_PI;
-  }
-
-  static const double DESIRED_ANGLE_PER_SEGMENT = 0.1; // radians
-  const int numSegments = static_cast<int>(sweepAngle / DESIRED_ANGLE_PER_SEGMENT) + 1;
-  const double anglePerSegment = sweepAngle / numSegments;
+  PrimitiveGeometryCache::Key key("PartialDisk");
+  const double innerRadius = key.Add(m_InnerRadius);
+  const double outerRadius = key.Add(m_OuterRadius);
+  const double startAngle = key.Add(m_StartAngle);
+  const double endAngle = key.Add(m_EndAngle);
+
+  m_Geometry = PrimitiveGeometryCache::Shared().Get(key, [=] (PrimitiveGeometry &geometry) {
+    double sweepAngle = endAngle - startAngle;
+    if (sweepAngle > 2*M_PI) {
+      sweepAngle = 2*M_PI;
+    }
 
-  m_Geometry.CleanUpBuffers();
+    static const double DESIRED_ANGLE_PER_SEGMENT = 0.1; // radians
+    const int numSegments = static_cast<int>(sweepAngle / DESIRED_ANGLE_PER_SEGMENT) + 1;
+    const double anglePerSegment = sweepAngle / numSegments;
 
-  double curAngle = m_StartAngle;
-  const double cosStart = std::cos(m_StartAngle);
-  const double sinStart = std::sin(m_StartAngle);
-  EigenTypes::Vector3f prevInner(static_cast<float>(m_InnerRadius*cosStart), static_cast<float>(m_InnerRadius*sinStart), 0.0f);
-  EigenTypes::Vector3f prevOuter(static_cast<float>(m_OuterRadius*cosStart), static_cast<float>(m_OuterRadius*sinStart), 0.0f);
-  for (int i=0; i<numSegments; i++) {
-    curAngle += anglePerSegment;
+    double curAngle = startAngle;
+    const double cosStart = std::cos(startAngle);
+    const double sinStart = std::sin(startAngle);
+    EigenTypes::Vector3f prevInner(static_cast<float>(innerRadius*cosStart), static_cast<float>(innerRadius*sinStart), 0.0f);
+    EigenTypes::Vector3f prevOuter(static_cast<float>(outerRadius*cosStart), static_cast<float>(outerRadius*sinStart), 0.0f);
+    for (int i=0; i<numSegments; i++) {
+      curAngle += anglePerSegment;
 
-    const double cosCur = std::cos(curAngle);
-    const double sinCur = std::sin(curAngle);
+      const double cosCur = std::cos(curAngle);
+      const double sinCur = std::sin(curAngle);
 
-    const EigenTypes::Vector3f curInner(static_cast<float>(m_InnerRadius*cosCur), static_cast<float>(m_InnerRadius*sinCur), 0.0f);
-    const EigenTypes::Vector3f curOuter(static_cast<float>(m_OuterRadius*cosCur), static_cast<float>(m_OuterRadius*sinCur), 0.0f);
+      const EigenTypes::Vector3f curInner(static_cast<float>(innerRadius*cosCur), static_cast<float>(innerRadius*sinCur), 0.0f);
+      const EigenTypes::Vector3f curOuter(static_cast<float>(outerRadius*cosCur), static_cast<float>(outerRadius*sinCur), 0.0f);
 
-    m_Geometry.PushTri(prevInner, prevOuter, curOuter);
-    m_Geometry.PushTri(curOuter, curInner, prevInner);
+      geometry.PushTri(prevInner, prevOuter, curOuter);
+      geometry.PushTri(curOuter, curInner, prevInner);
 
-    prevInner = curInner;
-    prevOuter = curOuter;
-  }
+      prevInner = curInner;
+      prevOuter = curOuter;
+    }
 
-  m_Geometry.UploadDataToBuffers();
+    geometry.UploadDataToBuffers();
+  });
 
   m_RecomputeGeometry = false;
 }
@@ -174,77 +181,87 @@ PartialDiskWithTriangle::PartialDiskWithTriangle()
 { }
 
 void PartialDiskWithTriangle::RecomputeGeometry() const {
-  double sweepAngle = m_EndAngle - m_StartAngle;
-  if (sweepAngle > 2*M_PI) {
-    sweepAngle = 2*M_PI;
-  }
-
-  static const double DESIRED_ANGLE_PER_SEGMENT = 0.1; // radians
-  int numSegments = static_cast<int>(sweepAngle / DESIRED_ANGLE_PER_SEGMENT) + 1;
-  const double anglePerSegment = sweepAngle / numSegments;
-
-  m_Geometry.CleanUpBuffers();
-
-  double curAngle = m_StartAngle;
-  const double cosStart = std::cos(m_StartAngle);
-  const double sinStart = std::sin(m_StartAngle);
-  EigenTypes::Vector3f prevInner(static_cast<float>(m_InnerRadius*cosStart), static_cast<float>(m_InnerRadius*sinStart), 0.0f);
-  EigenTypes::Vector3f prevOuter(static_cast<float>(m_OuterRadius*cosStart), static_cast<float>(m_OuterRadius*sinStart), 0.0f);
-
-  bool haveStarted = false;
-  bool havePassedMidpoint = false;
-  bool havePassedEnd = false;
-  bool haveTakenCareOfExtraAngle = false;
-
-  const double triangleAngle = sweepAngle * m_TriangleWidth;
-  const double triangleStart = m_TrianglePosition * sweepAngle + m_StartAngle - triangleAngle / 2.0;
-  const double triangleEnd = triangleStart + triangleAngle;
-  const double triangleMidpoint = 0.5*(triangleStart + triangleEnd);
-
-  while (curAngle < (m_EndAngle - 0.001)) {
-    curAngle += anglePerSegment;
-
-    if (!haveStarted && curAngle > triangleStart) {
-      curAngle = triangleStart;
-      haveStarted = true;
-    } else if (!havePassedMidpoint && curAngle > triangleMidpoint) {
-      curAngle = triangleMidpoint;
-      havePassedMidpoint = true;
-    } else if (!havePassedEnd && curAngle > triangleEnd) {
-      curAngle = triangleEnd;
-      havePassedEnd = true;
-    } else if (havePassedEnd && !haveTakenCareOfExtraAngle) {
-      haveTakenCareOfExtraAngle = true;
-      curAngle = m_StartAngle + anglePerSegment * (static_cast<int>((curAngle-m_StartAngle) / anglePerSegment));
+  PrimitiveGeometryCache::Key key("PartialDiskWithTriangle");
+  const double diskInnerRadius = key.Add(m_InnerRadius);
+  const double diskOuterRadius = key.Add(m_OuterRadius);
+  const double startAngle = key.Add(m_StartAngle);
+  const double endAngle = key.Add(m_EndAngle);
+  const TriangleSide triangleSide = static_cast<TriangleSide>(key.Add(static_cast<int>(m_TriangleSide)));
+  const double trianglePosition = key.Add(m_TrianglePosition);
+  const double triangleWidth = key.Add(m_TriangleWidth);
+  const double triangleOffset = key.Add(m_TriangleOffset);
+
+  m_Geometry = PrimitiveGeometryCache::Shared().Get(key, [=] (PrimitiveGeometry &geometry) {
+    double sweepAngle = endAngle - startAngle;
+    if (sweepAngle > 2*M_PI) {
+      sweepAngle = 2*M_PI;
     }
 
-    double innerRadius = m_InnerRadius;
-    double outerRadius = m_OuterRadius;
-    if (curAngle >= triangleStart && curAngle <= triangleEnd) {
-      double ratio = (curAngle - triangleStart) / (triangleAngle);
-      double mult = -2 * std::abs(ratio-0.5) + 1;
-      const double triangleHeight = m_TriangleOffset * (m_OuterRadius - m_InnerRadius);
-      if (m_TriangleSide == INSIDE) {
-        innerRadius -= mult * triangleHeight;
-      } else if (m_TriangleSide == OUTSIDE) {
-        outerRadius += mult * triangleHeight;
+    static const double DESIRED_ANGLE_PER_SEGMENT = 0.1; // radians
+    int numSegments = static_cast<int>(sweepAngle / DESIRED_ANGLE_PER_SEGMENT) + 1;
+    const double anglePerSegment = sweepAngle / numSegments;
+
+    double curAngle = startAngle;
+    const double cosStart = std::cos(startAngle);
+    const double sinStart = std::sin(startAngle);
+    EigenTypes::Vector3f prevInner(static_cast<float>(diskInnerRadius*cosStart), static_cast<float>(diskInnerRadius*sinStart), 0.0f);
+    EigenTypes::Vector3f prevOuter(static_cast<float>(diskOuterRadius*cosStart), static_cast<float>(diskOuterRadius*sinStart), 0.0f);
+
+    bool haveStarted = false;
+    bool havePassedMidpoint = false;
+    bool havePassedEnd = false;
+    bool haveTakenCareOfExtraAngle = false;
+
+    const double triangleAngle = sweepAngle * triangleWidth;
+    const double triangleStart = trianglePosition * sweepAngle + startAngle - triangleAngle / 2.0;
+    const double triangleEnd = triangleStart + triangleAngle;
+    const double triangleMidpoint = 0.5*(triangleStart + triangleEnd);
+
+    while (curAngle < (endAngle - 0.001)) {
+      curAngle += anglePerSegment;
+
+      if (!haveStarted && curAngle > triangleStart) {
+        curAngle = triangleStart;
+        haveStarted = true;
+      } else if (!havePassedMidpoint && curAngle > triangleMidpoint) {
+        curAngle = triangleMidpoint;
+        havePassedMidpoint = true;
+      } else if (!havePassedEnd && curAngle > triangleEnd) {
+        curAngle = triangleEnd;
+        havePassedEnd = true;
+      } else if (havePassedEnd && !haveTakenCareOfExtraAngle) {
+        haveTakenCareOfExtraAngle = true;
+        curAngle = startAngle + anglePerSegment * (static_cast<int>((curAngle-startAngle) / anglePerSegment));
       }
-    }
 
-    const double cosCur = std::cos(curAngle);
-    const double sinCur = std::sin(curAngle);
+      double innerRadius = diskInnerRadius;
+      double outerRadius = diskOuterRadius;
+      if (curAngle >= triangleStart && curAngle <= triangleEnd) {
+        double ratio = (curAngle - triangleStart) / (triangleAngle);
+        double mult = -2 * std::abs(ratio-0.5) + 1;
+        const double triangleHeight = triangleOffset * (diskOuterRadius - diskInnerRadius);
+        if (triangleSide == INSIDE) {
+          innerRadius -= mult * triangleHeight;
+        } else if (triangleSide == OUTSIDE) {
+          outerRadius += mult * triangleHeight;
+        }
+      }
 
-    const EigenTypes::Vector3f curInner(static_cast<float>(innerRadius*cosCur), static_cast<float>(innerRadius*sinCur), 0.0f);
-    const EigenTypes::Vector3f curOuter(static_cast<float>(outerRadius*cosCur), static_cast<float>(outerRadius*sinCur), 0.0f);
+      const double cosCur = std::cos(curAngle);
+      const double sinCur = std::sin(curAngle);
 
-    m_Geometry.PushTri(prevInner, prevOuter, curOuter);
-    m_Geometry.PushTri(curOuter, curInner, prevInner);
+      const EigenTypes::Vector3f curInner(static_cast<float>(innerRadius*cosCur), static_cast<float>(innerRadius*sinCur), 0.0f);
+      const EigenTypes::Vector3f curOuter(static_cast<float>(outerRadius*cosCur), static_cast<float>(outerRadius*sinCur), 0.0f);
 
-    prevInner = curInner;
-    prevOuter = curOuter;
-  }
+      geometry.PushTri(prevInner, prevOuter, curOuter);
+      geometry.PushTri(curOuter, curInner, prevInner);
 
-  m_Geometry.UploadDataToBuffers();
+      prevInner = curInner;
+      prevOuter = curOuter;
+    }
+
+    geometry.UploadDataToBuffers();
+  });
 
   m_RecomputeGeometry = false;
 }
@@ -265,16 +282,25 @@ void PartialSphere::DrawContents(RenderState& renderState) const {
     RecomputeGeometry();
   }
 
-  m_Geometry.Draw(Shader(), GL_TRIANGLES);
+  m_Geometry->Draw(Shader(), GL_TRIANGLES);
 }
 
 void PartialSphere::RecomputeGeometry() const {
-  static const double DESIRED_ANGLE_PER_SEGMENT = 0.1; // radians
-  const double heightSweep = std::min(M_PI, m_EndHeightAngle - m_StartHeightAngle);
-  const double widthSweep = std::min(2.0 * M_PI, m_EndWidthAngle - m_StartWidthAngle);
-  const int numWidth = static_cast<int>(widthSweep / DESIRED_ANGLE_PER_SEGMENT) + 1;
-  const int numHeight = static_cast<int>(heightSweep / DESIRED_ANGLE_PER_SEGMENT) + 1;
-  PrimitiveGeometry::CreateUnitSphere(numWidth, numHeight, m_Geometry, m_StartHeightAngle, m_EndHeightAngle, m_StartWidthAngle, m_EndWidthAngle);
+  // The radius is applied in MakeAdditionalModelViewTransformations, so it's not part of the key.
+  PrimitiveGeometryCache::Key key("PartialSphere");
+  const double startHeightAngle = key.Add(m_StartHeightAngle);
+  const double endHeightAngle = key.Add(m_EndHeightAngle);
+  const double startWidthAngle = key.Add(m_StartWidthAngle);
+  const double endWidthAngle = key.Add(m_EndWidthAngle);
+
+  m_Geometry = PrimitiveGeometryCache::Shared().Get(key, [=] (PrimitiveGeometry &geometry) {
+    static const double DESIRED_ANGLE_PER_SEGMENT = 0.1; // radians
+    const double heightSweep = std::min(M_PI, endHeightAngle - startHeightAngle);
+    const double widthSweep = std::min(2.0 * M_PI, endWidthAngle - startWidthAngle);
+    const int numWidth = static_cast<int>(widthSweep / DESIRED_ANGLE_PER_SEGMENT) + 1;
+    const int numHeight = static_cast<int>(heightSweep / DESIRED_ANGLE_PER_SEGMENT) + 1;
+    PrimitiveGeometry::CreateUnitSphere(numWidth, numHeight, geometry, startHeightAngle, endHeightAngle, startWidthAngle, endWidthAngle);
+  });
   m_RecomputeGeometry = false;
 }
 
@@ -294,11 +320,18 @@ void PartialCylinder::DrawContents(RenderState& renderState) const {
     RecomputeGeometry();
   }
 
-  m_Geometry.Draw(Shader(), GL_TRIANGLES);
+  m_Geometry->Draw(Shader(), GL_TRIANGLES);
 }
 
 void PartialCylinder::RecomputeGeometry() const {
-  PrimitiveGeometry::CreateUnitCylinder(30, 1, m_Geometry, 1.0f, 1.0f, m_StartAngle, m_EndAngle);
+  // The radius and height are applied in MakeAdditionalModelViewTransformations.
+  PrimitiveGeometryCache::Key key("PartialCylinder");
+  const double startAngle = key.Add(m_StartAngle);
+  const double endAngle = key.Add(m_EndAngle);
+
+  m_Geometry = PrimitiveGeometryCache::Shared().Get(key, [=] (PrimitiveGeometry &geometry) {
+    PrimitiveGeometry::CreateUnitCylinder(30, 1, geometry, 1.0f, 1.0f, startAngle, endAngle);
+  });
   m_RecomputeGeometry = false;
 }
 
@@ -355,7 +388,7 @@ void BiCapsulePrim::DrawContents(RenderState& renderState) const {
   modelView.Translate(EigenTypes::Vector3(0, (m_BodyOffset1+m_BodyOffset2)/2.0, 0));
   modelView.Scale(EigenTypes::Vector3(1.0, bodyHeight, 1.0));
   GLShaderMatrices::UploadUniforms(Shader(), modelView.Matrix(), renderState.GetProjection().Matrix(), BindFlags::NONE);
-  m_Body.Draw(Shader(), GL_TRIANGLES);
+  m_Body->Draw(Shader(), GL_TRIANGLES);
   modelView.Pop();
 
   // draw first end cap
@@ -363,7 +396,7 @@ void BiCapsulePrim::DrawContents(RenderState& renderState) const {
   modelView.Translate(EigenTypes::Vector3(0, -m_Height/2.0, 0));
   modelView.Scale(EigenTypes::Vector3::Constant(m_Radius1));
   GLShaderMatrices::UploadUniforms(Shader(), modelView.Matrix(), renderState.GetProjection().Matrix(), BindFlags::NONE);
-  m_Cap1.Draw(Shader(), GL_TRIANGLES);
+  m_Cap1->Draw(Shader(), GL_TRIANGLES);
   modelView.Pop();
 
   // draw second end cap
@@ -371,7 +404,7 @@ void BiCapsulePrim::DrawContents(RenderState& renderState) const {
   modelView.Translate(EigenTypes::Vector3(0, m_Height/2.0, 0));
   modelView.Scale(EigenTypes::Vector3(m_Radius2, -m_Radius2, m_Radius2));
   GLShaderMatrices::UploadUniforms(Shader(), modelView.Matrix(), renderState.GetProjection().Matrix(), BindFlags::NONE);
-  m_Cap2.Draw(Shader(), GL_TRIANGLES);
+  m_Cap2->Draw(Shader(), GL_TRIANGLES);
   modelView.Pop();
 }
 
@@ -385,9 +418,25 @@ void BiCapsulePrim::RecomputeGeometry() const {
   m_BodyRadius1 = cosSideAngle * m_Radius1;
   m_BodyRadius2 = cosSideAngle * m_Radius2;
 
-  PrimitiveGeometry::CreateUnitSphere(24, 12, m_Cap1, -M_PI/2.0, sideAngle);
-  PrimitiveGeometry::CreateUnitSphere(24, 12, m_Cap2, -M_PI/2.0, -sideAngle);
-  PrimitiveGeometry::CreateUnitCylinder(24, 1, m_Body, static_cast<float>(m_BodyRadius1), static_cast<float>(m_BodyRadius2));
+  // The caps are unit spheres (scaled by the radii when drawn), so they're keyed only on the
+  // angle, and are shared between instances whose radii have the same ratio.
+  PrimitiveGeometryCache &cache = PrimitiveGeometryCache::Shared();
+  PrimitiveGeometryCache::Key cap1Key("BiCapsulePrim/Cap");
+  const double cap1Angle = cap1Key.Add(sideAngle);
+  m_Cap1 = cache.Get(cap1Key, [cap1Angle] (PrimitiveGeometry &geometry) {
+    PrimitiveGeometry::CreateUnitSphere(24, 12, geometry, -M_PI/2.0, cap1Angle);
+  });
+  PrimitiveGeometryCache::Key cap2Key("BiCapsulePrim/Cap");
+  const double cap2Angle = cap2Key.Add(-sideAngle);
+  m_Cap2 = cache.Get(cap2Key, [cap2Angle] (PrimitiveGeometry &geometry) {
+    PrimitiveGeometry::CreateUnitSphere(24, 12, geometry, -M_PI/2.0, cap2Angle);
+  });
+  PrimitiveGeometryCache::Key bodyKey("BiCapsulePrim/Body");
+  const float bodyRadius1 = static_cast<float>(bodyKey.Add(m_BodyRadius1));
+  const float bodyRadius2 = static_cast<float>(bodyKey.Add(m_BodyRadius2));
+  m_Body = cache.Get(bodyKey, [bodyRadius1, bodyRadius2] (PrimitiveGeometry &geometry) {
+    PrimitiveGeometry::CreateUnitCylinder(24, 1, geometry, bodyRadius1, bodyRadius2);
+  });
   m_RecomputeGeometry = false;
 }
 
@@ -191,8 +191,8 @@ protected:
 
   virtual void RecomputeGeometry() const;
 
-  // cache the previously drawn geometry for speed if the primitive parameters are unchanged
-  mutable PrimitiveGeometry m_Geometry;
+  // the geometry for the current parameters, shared with other instances via PrimitiveGeometryCache
+  mutable std::shared_ptr<PrimitiveGeometry> m_Geometry;
 
   mutable bool m_RecomputeGeometry;
 
@@ -294,8 +294,8 @@ protected:
   virtual void DrawContents(RenderState& renderState) const override;
   virtual void RecomputeGeometry() const;
 
-  // cache the previously drawn geometry for speed if the primitive parameters are unchanged
-  mutable PrimitiveGeometry m_Geometry;
+  // the geometry for the current parameters, shared with other instances via PrimitiveGeometryCache
+  mutable std::shared_ptr<PrimitiveGeometry> m_Geometry;
 
   mutable bool m_RecomputeGeometry;
   double m_Radius;
@@ -362,10 +362,10 @@ protected:
 
 private:
 
-  // cache the previously drawn geometry for speed if the primitive parameters are unchanged
-  mutable PrimitiveGeometry m_Cap1;
-  mutable PrimitiveGeometry m_Cap2;
-  mutable PrimitiveGeometry m_Body;
+  // the geometry for the current parameters, shared with other instances via PrimitiveGeometryCache
+  mutable std::shared_ptr<PrimitiveGeometry> m_Cap1;
+  mutable std::shared_ptr<PrimitiveGeometry> m_Cap2;
+  mutable std::shared_ptr<PrimitiveGeometry> m_Body;
 
   mutable bool m_RecomputeGeometry;
   double m_Radius1;
@@ -412,8 +412,8 @@ protected:
   virtual void DrawContents(RenderState& renderState) const override;
   virtual void RecomputeGeometry() const;
 
-  // cache the previously drawn geometry for speed if the primitive parameters are unchanged
-  mutable PrimitiveGeometry m_Geometry;
+  // the geometry for the current parameters, shared with other instances via PrimitiveGeometryCache
+  mutable std::shared_ptr<PrimitiveGeometry> m_Geometry;
 
   mutable bool m_RecomputeGeometry;
   double m_Radius;
@@ -1,93 +1,67 @@
 #include "SVGPrimitive.h"
 
-#include <Eigen/StdVector>
-#define NANOSVG_ALL_COLOR_KEYWORDS  // Include full list of color keywords.
-#define NANOSVG_IMPLEMENTATION
-#include <nanosvg.h>
-#include <polypartition.h>
+#include "ThreadPool.h"
 
-#include <cfloat>
-#include <cassert>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 
-class Curve {
-  public:
-    struct Bezier {
-      EigenTypes::Vector2f b[4];
-    };
+namespace {
 
-    Curve(float tolerance = 1.0f);
-    ~Curve();
+SVGPrimitive::TessellationMode s_DefaultTessellationMode = SVGPrimitive::TessellationMode::SYNCHRONOUS;
+SVGPrimitive::GeometryMode s_DefaultGeometryMode = SVGPrimitive::GeometryMode::SHAPE_PER_MESH;
 
-    void Append(const Bezier& bezier);
+// The range of levels of detail, i.e. tolerances from 1/64 to 16 SVG units.
+const int MIN_LEVEL = -6;
+const int MAX_LEVEL = 4;
+// How far (in levels, i.e. powers of two) the ideal level must move away from the drawn level
+// before switching, so that an icon whose scale hovers around a boundary doesn't flip back and forth.
+const double LEVEL_HYSTERESIS = 0.75;
 
-    const std::vector<TPPLPoint>& Points() const { return m_points; }
-
-  private:
-    void Subdivide(const Bezier& bezier, Bezier& left, Bezier& right);
-    bool IsSufficientlyFlat(const Bezier& bezier);
-    float m_tolerance;
-
-    std::vector<TPPLPoint> m_points;
+// The merged geometry of each tessellation which some primitive is drawing, keyed on the
+// tessellation.  The tessellation is also held weakly, so that an entry whose tessellation has
+// been freed (and whose address might be reused) is never mistaken for a live one.  Like all GL
+// resources, it's only used on the render thread.
+struct SharedGeometry {
+  std::weak_ptr<const SVGTessellation> tessellation;
+  std::weak_ptr<const PrimitiveGeometry> geometry;
 };
+std::map<const SVGTessellation*,SharedGeometry> s_SharedGeometries;
 
-Curve::Curve(float tolerance) : m_tolerance(16.0f*tolerance*tolerance) // 16*tolerance^2
-{
-}
+} // end of anonymous namespace
 
-Curve::~Curve()
-{
+const double SVGPrimitive::DEFAULT_VIEW_TOLERANCE = 0.5;
+const size_t SVGPrimitive::MAX_CACHED_LEVELS = 3;
+
+SVGPrimitive::TessellationMode SVGPrimitive::DefaultTessellationMode() {
+  return s_DefaultTessellationMode;
 }
 
-void Curve::Append(const Bezier& bezier) {
-  if (IsSufficientlyFlat(bezier)) {
-    if (m_points.empty()) {
-      TPPLPoint point;
-      point.x = bezier.b[0].x();
-      point.y = bezier.b[0].y();
-      m_points.emplace_back(std::move(point));
-    }
-    TPPLPoint point;
-    point.x = bezier.b[3].x();
-    point.y = bezier.b[3].y();
-    const auto dx = point.x - m_points[0].x;
-    if (std::abs(dx) < FLT_EPSILON) {
-      const auto dy = point.y - m_points[0].y;
-      if (std::abs(dy) < FLT_EPSILON) {
-        return;
-      }
-    }
-    m_points.emplace_back(std::move(point));
-  } else {
-    Bezier left, right;
-    Subdivide(bezier, left, right);
-    Append(left);
-    Append(right);
-  }
+void SVGPrimitive::SetDefaultTessellationMode(TessellationMode mode) {
+  s_DefaultTessellationMode = mode;
 }
 
-void Curve::Subdivide(const Bezier& bezier, Bezier& left, Bezier& right) {
-  const EigenTypes::Vector2f middle = 0.5f*(bezier.b[1] + bezier.b[2]);
-  left.b[0] = bezier.b[0];
-  left.b[1] = 0.5f*(bezier.b[0] + bezier.b[1]);
-  left.b[2] = 0.5f*(left.b[1] + middle);
-  right.b[3] = bezier.b[3];
-  right.b[2] = 0.5f*(bezier.b[2] + bezier.b[3]);
-  right.b[1] = 0.5f*(middle + right.b[2]);
-  left.b[3] = right.b[0] = 0.5f*(left.b[2] + right.b[1]);
+SVGPrimitive::GeometryMode SVGPrimitive::DefaultGeometryMode() {
+  return s_DefaultGeometryMode;
 }
 
-bool Curve::IsSufficientlyFlat(const Bezier& bezier) {
-  EigenTypes::Vector2f u = 3.0f*bezier.b[1] - 2.0f*bezier.b[0] - bezier.b[3];
-  EigenTypes::Vector2f v = 3.0f*bezier.b[2] - 2.0f*bezier.b[3] - bezier.b[0];
-  return (u.cwiseProduct(u).cwiseMax(v.cwiseProduct(v)).sum() < m_tolerance);
+void SVGPrimitive::SetDefaultGeometryMode(GeometryMode mode) {
+  s_DefaultGeometryMode = mode;
 }
 
 SVGPrimitive::SVGPrimitive(const std::string& svg) :
-  m_Image(nullptr),
-  m_RecomputeGeometry(false)
+  m_Mode(TessellationMode::SYNCHRONOUS),
+  m_GeometryMode(s_DefaultGeometryMode),
+  m_ViewTolerance(DEFAULT_VIEW_TOLERANCE),
+  m_DrawnLevel(0),
+  m_HasDrawnLevel(false),
+  m_BoundsKnown(true),
+  m_DrawCount(0)
 {
   m_Origin << 0.0, 0.0;
   m_Size << 0.0, 0.0;
+  // In GeometryMode::MERGED the colors come from the vertices, and this material only masks them.
+  Material().SetAmbientLightingProportion(1.0f);
   if (!svg.empty()) {
     Set(svg);
   }
@@ -95,167 +69,308 @@ SVGPrimitive::SVGPrimitive(const std::string& svg) :
 
 SVGPrimitive::~SVGPrimitive()
 {
-  if (m_Image) {
-    nsvgDelete(m_Image);
+}
+
+void SVGPrimitive::Set(const std::shared_ptr<const SVGDocument>& document, TessellationMode mode)
+{
+  // Start with the level drawn for the previous document, since the scale is likely the same.
+  const int level = m_HasDrawnLevel ? m_DrawnLevel : LevelForTolerance(SVGTessellation::DEFAULT_TOLERANCE);
+  // Any tessellations still pending for the previous document are superseded.
+  m_Levels.clear();
+  m_HasDrawnLevel = false;
+  m_BoundsKnown = false;
+  if (mode == TessellationMode::SYNCHRONOUS) {
+    Children().clear();
+    m_Merged.reset();
+  } // Otherwise the previous document's shapes stay until the new ones are ready.
+  m_Document = document;
+  m_Mode = mode;
+  if (!m_Document) {
+    Children().clear();
+    m_Merged.reset();
+    m_BoundsKnown = true;
+    return;
+  }
+  EigenTypes::Vector2f canvasSize;
+  if (m_Document->CanvasSize(canvasSize)) {
+    m_Origin << 0.0, 0.0;
+    m_Size = canvasSize.cast<EigenTypes::MATH_TYPE>();
   }
+  RequestLevel(level);
+}
+
+void SVGPrimitive::SetGeometryMode(GeometryMode mode) {
+  if (mode == m_GeometryMode) {
+    return;
+  }
+  m_GeometryMode = mode;
+  for (auto& entry : m_Levels) {
+    entry.second.shapes.clear();
+    entry.second.merged.reset();
+  }
+  Children().clear();
+  m_Merged.reset();
+  m_HasDrawnLevel = false;
+  // The next draw loads the shader for the new mode.
+  SetShader(nullptr);
+}
+
+bool SVGPrimitive::IsTessellationPending() const {
+  for (const auto& entry : m_Levels) {
+    if (entry.second.pending.valid()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void SVGPrimitive::WaitForTessellation() const {
+  SVGPrimitive* self = const_cast<SVGPrimitive*>(this);
+  for (auto& entry : self->m_Levels) {
+    if (entry.second.pending.valid()) {
+      self->TakePendingTessellation(entry.second);
+    }
+  }
+}
+
+void SVGPrimitive::WaitForBounds() const {
+  SVGPrimitive* self = const_cast<SVGPrimitive*>(this);
+  for (auto it = self->m_Levels.begin(); !m_BoundsKnown && it != self->m_Levels.end(); ++it) {
+    if (it->second.pending.valid()) {
+      self->TakePendingTessellation(it->second);
+    }
+  }
+}
+
+double SVGPrimitive::DrawnTolerance() const {
+  return m_HasDrawnLevel ? ToleranceForLevel(m_DrawnLevel) : 0.0;
+}
+
+std::vector<double> SVGPrimitive::CachedTolerances() const {
+  std::vector<double> tolerances;
+  for (const auto& entry : m_Levels) {
+    tolerances.push_back(ToleranceForLevel(entry.first));
+  }
+  return tolerances;
 }
 
 void SVGPrimitive::DrawContents(RenderState& renderState) const {
-  if (m_RecomputeGeometry) {
-    const_cast<SVGPrimitive*>(this)->RecomputeChildren(); // This objects children need to be recomputed
+  if (m_Document) {
+    // This objects children may need to be recomputed
+    const_cast<SVGPrimitive*>(this)->UpdateChildren(renderState.GetModelView().Matrix());
+  }
+  if (m_Merged) {
+    m_Merged->Draw(Shader(), GL_TRIANGLES);
   }
 }
 
-void SVGPrimitive::Set(const std::string& svg)
-{
-  if (m_Image) {
-    nsvgDelete(m_Image);
-    m_Image = nullptr;
-    Children().clear();
+std::string SVGPrimitive::DefaultShaderName() const {
+  if (m_GeometryMode == GeometryMode::MERGED) {
+    return GLUniformBufferRing::Current() != nullptr ? "material_vertex_color_ubo" : "material_vertex_color";
+  }
+  return PrimitiveBase::DefaultShaderName();
+}
+
+void SVGPrimitive::UpdateChildren(const EigenTypes::Matrix4x4& modelView) {
+  ++m_DrawCount;
+  // Pick up any tessellations which have finished since the last draw.
+  for (auto& entry : m_Levels) {
+    LevelOfDetail& lod = entry.second;
+    if (lod.pending.valid() && lod.pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+      TakePendingTessellation(lod);
+    }
   }
-  std::string svgCopy{svg}; // Make a copy so that nanosvg can modify its contents (horrors)
-  m_Image = nsvgParse(const_cast<char*>(svgCopy.c_str()), "px", 96.0f);
-  if (m_Image) {
-    float bounds[4] = {0.0f, 0.0f, 0.0f, 0.0f};
-    bool isFirst = true;
-
-    for (NSVGshape* shape = m_Image->shapes; shape != NULL; shape = shape->next) {
-      if (isFirst) {
-        isFirst = false;
-        bounds[0] = shape->bounds[0];
-        bounds[1] = shape->bounds[1];
-        bounds[2] = shape->bounds[2];
-        bounds[3] = shape->bounds[3];
-      } else {
-        if (shape->bounds[0] < bounds[0]) { bounds[0] = shape->bounds[0]; }
-        if (shape->bounds[1] < bounds[1]) { bounds[1] = shape->bounds[1]; }
-        if (shape->bounds[2] > bounds[2]) { bounds[2] = shape->bounds[2]; }
-        if (shape->bounds[3] > bounds[3]) { bounds[3] = shape->bounds[3]; }
+
+  const int level = m_ViewTolerance > 0.0 ? ChooseLevel(modelView) : LevelForTolerance(SVGTessellation::DEFAULT_TOLERANCE);
+  LevelOfDetail& lod = RequestLevel(level);
+  lod.lastUsed = m_DrawCount;
+  if (!lod.pending.valid()) {
+    ShowLevel(level);
+  } else if (m_HasDrawnLevel) {
+    // Keep drawing the current level until the requested one is ready.
+    m_Levels[m_DrawnLevel].lastUsed = m_DrawCount;
+  } else {
+    // Nothing of this document has been drawn yet, so draw the closest level which is ready.
+    auto closest = m_Levels.end();
+    for (auto it = m_Levels.begin(); it != m_Levels.end(); ++it) {
+      if (!it->second.pending.valid() && (closest == m_Levels.end() || std::abs(it->first - level) < std::abs(closest->first - level))) {
+        closest = it;
       }
     }
-    m_Origin << static_cast<EigenTypes::MATH_TYPE>(bounds[0]), static_cast<EigenTypes::MATH_TYPE>(bounds[1]);
-    m_Size << static_cast<EigenTypes::MATH_TYPE>(bounds[2] - bounds[0]), static_cast<EigenTypes::MATH_TYPE>(bounds[3] - bounds[1]);
-    m_RecomputeGeometry = true;
+    if (closest != m_Levels.end()) {
+      closest->second.lastUsed = m_DrawCount;
+      ShowLevel(closest->first);
+    }
+  }
+  EvictLevels();
+}
+
+int SVGPrimitive::LevelForTolerance(double tolerance) {
+  const int level = static_cast<int>(std::floor(std::log2(tolerance) + 0.5));
+  return std::min(std::max(level, MIN_LEVEL), MAX_LEVEL);
+}
+
+float SVGPrimitive::ToleranceForLevel(int level) {
+  return std::ldexp(1.0f, level);
+}
+
+int SVGPrimitive::ChooseLevel(const EigenTypes::Matrix4x4& modelView) const {
+  // The number of view-space units per SVG unit.  The larger of the two axes is used, so that
+  // the tolerance is met in every direction.
+  const double scale = std::max(modelView.block<3,1>(0,0).norm(), modelView.block<3,1>(0,1).norm());
+  if (!(scale > 0.0) || !std::isfinite(scale)) {
+    return LevelForTolerance(SVGTessellation::DEFAULT_TOLERANCE);
+  }
+  const double idealLevel = std::log2(m_ViewTolerance/scale);
+  if (m_HasDrawnLevel && std::abs(idealLevel - static_cast<double>(m_DrawnLevel)) < LEVEL_HYSTERESIS) {
+    return m_DrawnLevel;
+  }
+  return LevelForTolerance(m_ViewTolerance/scale);
+}
+
+SVGPrimitive::LevelOfDetail& SVGPrimitive::RequestLevel(int level) {
+  auto found = m_Levels.find(level);
+  if (found != m_Levels.end()) {
+    return found->second;
+  }
+  LevelOfDetail& lod = m_Levels[level];
+  lod.lastUsed = m_DrawCount;
+  // The tessellation is shared with other primitives drawing the same document at the same level,
+  // and is loaded from the on-disk cache if this document has been seen before.
+  const std::shared_ptr<const SVGDocument> document(m_Document);
+  const float tolerance = ToleranceForLevel(level);
+  if (m_Mode == TessellationMode::ASYNCHRONOUS) {
+    lod.pending = ThreadPool::Shared().Submit([document, tolerance]() {
+      return document->Tessellation(tolerance);
+    });
+  } else {
+    AcceptTessellation(lod, document->Tessellation(tolerance));
+  }
+  return lod;
+}
+
+void SVGPrimitive::TakePendingTessellation(LevelOfDetail& lod) {
+  // get() waits for the result (if necessary) and leaves the future invalid.
+  AcceptTessellation(lod, lod.pending.get());
+}
+
+void SVGPrimitive::AcceptTessellation(LevelOfDetail& lod, const std::shared_ptr<const SVGTessellation>& tessellation) {
+  lod.tessellation = tessellation;
+  // Every level has the same bounds, so the first one to arrive provides them.  If the document
+  // couldn't be parsed, the provisional bounds are kept.
+  if (!m_BoundsKnown) {
+    m_BoundsKnown = true;
+    if (lod.tessellation) {
+      m_Origin = lod.tessellation->Origin().cast<EigenTypes::MATH_TYPE>();
+      m_Size = lod.tessellation->Size().cast<EigenTypes::MATH_TYPE>();
+    }
+    // A synchronous Set knows the bounds before it returns, so its caller needs no callback.
+    if (m_Mode == TessellationMode::ASYNCHRONOUS && m_BoundsCallback) {
+      m_BoundsCallback(*this);
+    }
   }
 }
 
-void SVGPrimitive::RecomputeChildren() {
-  m_RecomputeGeometry = false;
-  if (m_Image) {
+void SVGPrimitive::ShowLevel(int level) {
+  if (m_HasDrawnLevel && m_DrawnLevel == level) {
+    return;
+  }
+  LevelOfDetail& lod = m_Levels[level];
+  if (m_GeometryMode == GeometryMode::MERGED) {
+    if (lod.tessellation && !lod.merged) {
+      lod.merged = SharedMergedGeometry(lod.tessellation);
+    }
     Children().clear();
-    for (NSVGshape* shape = m_Image->shapes; shape != NULL; shape = shape->next) {
-      const uint32_t fillColor = shape->fill.color;
-      const uint32_t strokeColor = shape->stroke.color;
-      const float opacity = shape->opacity;
-      const float strokeWidth = shape->strokeWidth;
-      const bool doFill = (fillColor & 0xFF000000) != 0 && shape->fill.type == NSVG_PAINT_COLOR;
-      const bool doStroke = (strokeColor & 0xFF000000) != 0 && strokeWidth > FLT_EPSILON &&
-                            (shape->fill.type == NSVG_PAINT_COLOR || shape->fill.type == NSVG_PAINT_NONE);
-
-      if ((!doFill && !doStroke) || opacity <= FLT_EPSILON) {
-        continue; // Nothing to do...
-      }
-      std::list<TPPLPoly> polys;
-      std::vector<std::shared_ptr<GenericShape>> strokes;
-
-      for (NSVGpath* path = shape->paths; path != NULL; path = path->next) {
-        Curve curve(0.5f);
-        for (int i = 0; i < path->npts-1; i += 3) {
-          const float* p = &path->pts[i*2];
-          Curve::Bezier bezier;
-          bezier.b[0] << p[0], p[1];
-          bezier.b[1] << p[2], p[3];
-          bezier.b[2] << p[4], p[5];
-          bezier.b[3] << p[6], p[7];
-          curve.Append(bezier);
-        }
-        const auto& points = curve.Points();
-        if (!points.empty()) {
-          if (doFill) {
-            TPPLPoly poly;
-            size_t numPoints = points.size();
-
-            poly.Init(static_cast<long>(numPoints));
-            for (size_t i = 0; i < numPoints; i++) {
-              poly[static_cast<int>(i)] = points[i];
-            }
-            // We are assuming that ONLY the last path is not a hole
-            if (path->next) {
-              poly.SetHole(true);
-              poly.SetOrientation(TPPL_CW);
-            } else {
-              poly.SetHole(false);
-              poly.SetOrientation(TPPL_CCW);
-            }
-            polys.emplace_back(std::move(poly));
-          }
-        }
-        if (doStroke) {
-          const bool isClosed = path->closed != '\0';
-          auto genericShape = std::shared_ptr<GenericShape>(new GenericShape(isClosed ? GL_LINE_LOOP : GL_LINE_STRIP));
-          auto& geometry = genericShape->Geometry();
-
-          // We don't yet handle stroke widths. For now, simulate a stroke width less than 1 by adjusting the alpha
-          const float simulatedStrokeWidth = strokeWidth >= 1.0f ? 1.0f : strokeWidth;
-          const float alpha = static_cast<float>((strokeColor >> 24) & 0xFF)/255.0f;
-          const float blue  = static_cast<float>((strokeColor >> 16) & 0xFF)/255.0f;
-          const float green = static_cast<float>((strokeColor >>  8) & 0xFF)/255.0f;
-          const float red   = static_cast<float>( strokeColor        & 0xFF)/255.0f;
-          const Color color(red, green, blue, alpha*opacity*simulatedStrokeWidth);
-          genericShape->Material().SetDiffuseLightColor(color);
-          genericShape->Material().SetAmbientLightColor(color);
-          genericShape->Material().SetAmbientLightingProportion(1.0f);
-          std::vector<PrimitiveGeometry::VertexAttributes>& vertices = geometry.Vertices();
-          const auto& points = curve.Points();
-          EigenTypes::Vector3f normal(EigenTypes::Vector3f::UnitZ());
-          for (const auto& pt : points) {
-            const EigenTypes::Vector3f point(static_cast<float>(pt.x), static_cast<float>(pt.y), 0.0f);
-            // The arguments to PrimitiveGeometry::VertexAttributes must be actual vector
-            // types, and not Eigen expression templates (e.g. EigenTypes::Vector3f::UnitZ()).
-            vertices.emplace_back(PrimitiveGeometry::MakeVertexAttributes(point, normal));
-          }
-          geometry.UploadDataToBuffers();
-          // Gather the strokes; they will be applied after the fill
-          strokes.push_back(genericShape);
-        }
-      }
-      // Add the fill (if applicable)
-      if (!polys.empty()) {
-        TPPLPartition partition;
-        std::list<TPPLPoly> triangles;
-
-        if (!partition.Triangulate_EC(&polys, &triangles)) {
-          continue; // Failed to triangulate!
-        }
-        auto genericShape = std::shared_ptr<GenericShape>(new GenericShape());
-        auto& geometry = genericShape->Geometry();
-
-        const float alpha = static_cast<float>((fillColor >> 24) & 0xFF)/255.0f;
-        const float blue  = static_cast<float>((fillColor >> 16) & 0xFF)/255.0f;
-        const float green = static_cast<float>((fillColor >>  8) & 0xFF)/255.0f;
-        const float red   = static_cast<float>( fillColor        & 0xFF)/255.0f;
-        const Color color(red, green, blue, alpha*opacity);
-        genericShape->Material().SetDiffuseLightColor(color);
-        genericShape->Material().SetAmbientLightColor(color);
-        genericShape->Material().SetAmbientLightingProportion(1.0f);
-        for (auto& triangle : triangles) {
-          assert(triangle.GetNumPoints() == 3);
-          const EigenTypes::Vector3f point1(static_cast<float>(triangle[0].x), static_cast<float>(triangle[0].y), 0.0f);
-          const EigenTypes::Vector3f point2(static_cast<float>(triangle[1].x), static_cast<float>(triangle[1].y), 0.0f);
-          const EigenTypes::Vector3f point3(static_cast<float>(triangle[2].x), static_cast<float>(triangle[2].y), 0.0f);
-          geometry.PushTri(PrimitiveGeometry::MakeVertexAttributes(point1, EigenTypes::Vector3f::UnitZ()), 
-                           PrimitiveGeometry::MakeVertexAttributes(point2, EigenTypes::Vector3f::UnitZ()), 
-                           PrimitiveGeometry::MakeVertexAttributes(point3, EigenTypes::Vector3f::UnitZ()));
-        }
-        geometry.UploadDataToBuffers();
-        AddChild(genericShape);
+    m_Merged = lod.merged;
+    m_DrawnLevel = level;
+    m_HasDrawnLevel = true;
+    return;
+  }
+  if (lod.tessellation && lod.shapes.empty()) {
+    const EigenTypes::Vector3f normal(EigenTypes::Vector3f::UnitZ());
+    for (const SVGTessellation::Mesh& mesh : lod.tessellation->Meshes()) {
+      auto genericShape = std::shared_ptr<GenericShape>(new GenericShape(GL_TRIANGLES));
+      auto& geometry = genericShape->Geometry();
+
+      const Color color(mesh.color[0], mesh.color[1], mesh.color[2], mesh.color[3]);
+      genericShape->Material().SetDiffuseLightColor(color);
+      genericShape->Material().SetAmbientLightColor(color);
+      genericShape->Material().SetAmbientLightingProportion(1.0f);
+      std::vector<PrimitiveGeometry::VertexAttributes>& vertices = geometry.Vertices();
+      vertices.reserve(mesh.points.size());
+      for (const EigenTypes::Vector2f& pt : mesh.points) {
+        const EigenTypes::Vector3f point(pt.x(), pt.y(), 0.0f);
+        // The arguments to PrimitiveGeometry::VertexAttributes must be actual vector
+        // types, and not Eigen expression templates (e.g. EigenTypes::Vector3f::UnitZ()).
+        vertices.emplace_back(PrimitiveGeometry::MakeVertexAttributes(point, normal));
       }
-      // Add any strokes after the fill
-      if (!strokes.empty()) {
-        for (auto& stroke : strokes) {
-          AddChild(stroke);
-        }
+      geometry.UploadDataToBuffers();
+      lod.shapes.push_back(genericShape);
+    }
+  }
+  Children().clear();
+  for (const auto& shape : lod.shapes) {
+    AddChild(shape);
+  }
+  m_Merged.reset();
+  m_DrawnLevel = level;
+  m_HasDrawnLevel = true;
+}
+
+std::shared_ptr<const PrimitiveGeometry> SVGPrimitive::SharedMergedGeometry(const std::shared_ptr<const SVGTessellation>& tessellation) {
+  SharedGeometry& shared = s_SharedGeometries[tessellation.get()];
+  std::shared_ptr<const PrimitiveGeometry> geometry(shared.geometry.lock());
+  if (!geometry || shared.tessellation.lock() != tessellation) {
+    geometry = MergeMeshes(*tessellation);
+    shared.tessellation = tessellation;
+    shared.geometry = geometry;
+  }
+  // Drop the entries which nothing draws any more.
+  for (auto it = s_SharedGeometries.begin(); it != s_SharedGeometries.end(); ) {
+    if (it->second.geometry.expired() || it->second.tessellation.expired()) {
+      it = s_SharedGeometries.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  return geometry;
+}
+
+std::shared_ptr<const PrimitiveGeometry> SVGPrimitive::MergeMeshes(const SVGTessellation& tessellation) {
+  std::shared_ptr<PrimitiveGeometry> merged(std::make_shared<PrimitiveGeometry>());
+  std::vector<PrimitiveGeometry::VertexAttributes>& vertices = merged->Vertices();
+  const EigenTypes::Vector3f normal(EigenTypes::Vector3f::UnitZ());
+  const EigenTypes::Vector2f texCoord(EigenTypes::Vector2f::Zero());
+  size_t vertexCount = 0;
+  for (const SVGTessellation::Mesh& mesh : tessellation.Meshes()) {
+    vertexCount += mesh.points.size();
+  }
+  vertices.reserve(vertexCount);
+  // Every mesh is a triangle list, and they're appended in drawing order, so a single draw call
+  // paints them in the same order as separate ones would.
+  for (const SVGTessellation::Mesh& mesh : tessellation.Meshes()) {
+    const Color color(mesh.color[0], mesh.color[1], mesh.color[2], mesh.color[3]);
+    for (const EigenTypes::Vector2f& pt : mesh.points) {
+      const EigenTypes::Vector3f point(pt.x(), pt.y(), 0.0f);
+      vertices.emplace_back(PrimitiveGeometry::MakeVertexAttributes(point, normal, texCoord, color));
+    }
+  }
+  merged->UploadDataToBuffers();
+  return merged;
+}
+
+void SVGPrimitive::EvictLevels() {
+  while (m_Levels.size() > MAX_CACHED_LEVELS) {
+    // Evict the least recently used level, other than the one being drawn.
+    auto oldest = m_Levels.end();
+    for (auto it = m_Levels.begin(); it != m_Levels.end(); ++it) {
+      if ((!m_HasDrawnLevel || it->first != m_DrawnLevel) && (oldest == m_Levels.end() || it->second.lastUsed < oldest->second.lastUsed)) {
+        oldest = it;
       }
     }
+    if (oldest == m_Levels.end()) {
+      break;
+    }
+    m_Levels.erase(oldest);
   }
 }
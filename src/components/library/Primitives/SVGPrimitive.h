@@ -1,30 +1,155 @@
 #pragma once
 
 #include "Primitives.h"
+#include "SVGDocument.h"
 
-struct NSVGimage;
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <vector>
 
+// Draws an SVG document (fills and strokes of solid color only), as triangles.  The Bezier curves are flattened
+// to a tolerance given in view-space units (pixels, under the pixel-aligned orthographic
+// projection used for 2D UI), so the document is tessellated at a level of detail appropriate to
+// its on-screen size: small icons get few triangles and magnified ones don't facet.  The levels
+// are powers of two (in SVG units), and a few of the most recently used are kept per primitive,
+// so scaling an icon back and forth doesn't re-tessellate or re-upload it.
+//
+// Primitives showing the same document share it (see SVGDocument), along with its tessellations
+// and, in GeometryMode::MERGED, their uploaded buffers, so each icon is parsed and uploaded once
+// however many times it's used.
 class SVGPrimitive : public PrimitiveBase {
 public:
 
+  // How Set computes the tessellation of the document.
+  // - SYNCHRONOUS computes it within Set (which is quick if it's in SVGTessellationCache).
+  // - ASYNCHRONOUS computes it on ThreadPool::Shared(), and the first draw after it's ready
+  //   uploads it.  Until then, the previously set document (or nothing) is drawn, so a new icon
+  //   never stalls the render thread.
+  // The same applies to the tessellations of other levels of detail.
+  enum class TessellationMode { SYNCHRONOUS, ASYNCHRONOUS };
+
+  // The mode used by Set(svg).  The default is SYNCHRONOUS.
+  static TessellationMode DefaultTessellationMode();
+  static void SetDefaultTessellationMode(TessellationMode mode);
+
+  // How the tessellated fills and strokes are drawn.
+  // - SHAPE_PER_MESH makes a GenericShape child for each fill and stroke, each with its own
+  //   buffers, uniform uploads and draw call.
+  // - MERGED packs all of them into a single vertex and index buffer, with their colors in the
+  //   vertices (see the "material_vertex_color" shader), and draws it from this primitive in a
+  //   single draw call, however many paths the document has.
+  enum class GeometryMode { SHAPE_PER_MESH, MERGED };
+
+  // The mode of newly constructed primitives.  The default is SHAPE_PER_MESH.
+  static GeometryMode DefaultGeometryMode();
+  static void SetDefaultGeometryMode(GeometryMode mode);
+
+  // The default maximum distance, in view-space units, between a curve and its flattened polyline.
+  static const double DEFAULT_VIEW_TOLERANCE;
+  // The number of levels of detail kept per primitive.
+  static const size_t MAX_CACHED_LEVELS;
+
   SVGPrimitive(const std::string& svg = "");
   virtual ~SVGPrimitive();
 
-  void Set(const std::string& svg);
+  void Set(const std::string& svg) { Set(svg, DefaultTessellationMode()); }
+  void Set(const std::string& svg, TessellationMode mode) { Set(SVGDocument::Get(svg), mode); }
+  void Set(const std::shared_ptr<const SVGDocument>& document, TessellationMode mode);
+
+  // The document being drawn (null if none has been set).
+  const std::shared_ptr<const SVGDocument>& Document() const { return m_Document; }
 
+  // A nonpositive tolerance disables level-of-detail selection, and the document is always drawn
+  // at SVGTessellation::DEFAULT_TOLERANCE (in SVG units).
+  double ViewTolerance() const { return m_ViewTolerance; }
+  void SetViewTolerance(double tolerance) { m_ViewTolerance = tolerance; }
+
+  // Changing the mode discards the uploaded geometry and the shader (which must match the mode).
+  GeometryMode CurrentGeometryMode() const { return m_GeometryMode; }
+  void SetGeometryMode(GeometryMode mode);
+
+  // Returns true iff an asynchronous tessellation has been requested but not yet picked up.
+  bool IsTessellationPending() const;
+  // Blocks until every pending tessellation is complete.
+  void WaitForTessellation() const;
+
+  // The bounds of the shapes are only known once a tessellation is ready.  Until then, these are
+  // provisional: the document's canvas (see SVGDocument::CanvasSize), or the previous document's
+  // bounds if it has none.  Neither waits for a pending tessellation.
   const EigenTypes::Vector2& Origin() const { return m_Origin; }
   const EigenTypes::Vector2& Size() const { return m_Size; }
+  bool AreBoundsKnown() const { return m_BoundsKnown; }
+  // Blocks until the bounds are known.
+  void WaitForBounds() const;
+  // The callback is called when the bounds of an asynchronously set document become known (i.e.
+  // when Origin() and Size() change from the provisional bounds to the final ones), on the thread
+  // which draws this primitive.  Anything laid out around the provisional bounds should be
+  // updated from it.  A null callback removes it.
+  void SetBoundsCallback(const std::function<void(const SVGPrimitive&)>& callback) { m_BoundsCallback = callback; }
+
+  // The tolerance (in SVG units) of the level of detail currently drawn, or 0 if none is.
+  double DrawnTolerance() const;
+  // The tolerances (in SVG units) of the levels of detail currently kept, in increasing order.
+  std::vector<double> CachedTolerances() const;
 
 protected:
 
   virtual void DrawContents(RenderState& renderState) const override;
+  virtual std::string DefaultShaderName() const override;
 
 private:
 
-  void RecomputeChildren();
+  struct LevelOfDetail {
+    LevelOfDetail() : lastUsed(0) { }
+    // Null until the tessellation is ready (and if the document couldn't be parsed).
+    std::shared_ptr<const SVGTessellation> tessellation;
+    std::future<std::shared_ptr<const SVGTessellation>> pending;
+    // The uploaded geometry (for the current GeometryMode), created the first time this level is drawn.
+    std::vector<std::shared_ptr<GenericShape>> shapes;
+    // All the meshes in a single buffer (for GeometryMode::MERGED).
+    std::shared_ptr<const PrimitiveGeometry> merged;
+    uint64_t lastUsed;
+  };
+  // Keyed on the level, whose tolerance (in SVG units) is 2^level.
+  typedef std::map<int,LevelOfDetail> LevelMap;
+
+  static int LevelForTolerance(double tolerance);
+  static float ToleranceForLevel(int level);
+
+  // Returns the level of detail appropriate to the given model view transform.
+  int ChooseLevel(const EigenTypes::Matrix4x4& modelView) const;
+  // Picks up finished tessellations, chooses the level of detail, and updates the children.
+  void UpdateChildren(const EigenTypes::Matrix4x4& modelView);
+  // Starts the tessellation of the given level, unless it's already cached.
+  LevelOfDetail& RequestLevel(int level);
+  void TakePendingTessellation(LevelOfDetail& lod);
+  void AcceptTessellation(LevelOfDetail& lod, const std::shared_ptr<const SVGTessellation>& tessellation);
+  // Makes the given level's shapes the children of this node (or its merged geometry the one
+  // drawn by this node), uploading them if necessary.
+  void ShowLevel(int level);
+  // Returns the merged geometry of the given tessellation, which is shared by every primitive
+  // drawing it.
+  static std::shared_ptr<const PrimitiveGeometry> SharedMergedGeometry(const std::shared_ptr<const SVGTessellation>& tessellation);
+  static std::shared_ptr<const PrimitiveGeometry> MergeMeshes(const SVGTessellation& tessellation);
+  void EvictLevels();
 
-  NSVGimage* m_Image;
+  std::shared_ptr<const SVGDocument> m_Document;
+  TessellationMode m_Mode;
+  GeometryMode m_GeometryMode;
+  double m_ViewTolerance;
+  LevelMap m_Levels;
+  // The level whose shapes are currently the children, if m_HasDrawnLevel is true.
+  int m_DrawnLevel;
+  bool m_HasDrawnLevel;
+  bool m_BoundsKnown;
+  uint64_t m_DrawCount;
+  // The geometry drawn in GeometryMode::MERGED, which (like the children) outlives the levels
+  // of a document replaced asynchronously until the new one is ready.
+  std::shared_ptr<const PrimitiveGeometry> m_Merged;
   EigenTypes::Vector2 m_Origin;
   EigenTypes::Vector2 m_Size;
-  bool m_RecomputeGeometry;
+  std::function<void(const SVGPrimitive&)> m_BoundsCallback;
 };
@@ -0,0 +1,110 @@
+#include "PrimitiveGeometryCache.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+
+// None of these generators upload anything, so no GL context is needed.
+
+namespace {
+
+PrimitiveGeometryCache::Key DiskKey (double angle) {
+  PrimitiveGeometryCache::Key key("disk");
+  key.Add(angle);
+  return key;
+}
+
+bool AreEquivalent (const PrimitiveGeometryCache::Key &a, const PrimitiveGeometryCache::Key &b) {
+  return !(a < b) && !(b < a);
+}
+
+// A generator which counts its calls.
+PrimitiveGeometryCache::Generator CountingGenerator (int &calls) {
+  return [&calls] (PrimitiveGeometry &) { ++calls; };
+}
+
+} // end of anonymous namespace
+
+TEST(PrimitiveGeometryCacheTest, KeyQuantization) {
+  const double quantum = PrimitiveGeometryCache::Key::DEFAULT_QUANTUM;
+
+  // Add returns the quantized value, which the geometry should be generated from.
+  PrimitiveGeometryCache::Key key("disk");
+  EXPECT_NEAR(0.5, key.Add(0.5 + 0.3*quantum), 1e-12);
+  EXPECT_NEAR(1.0, key.Add(1.04, 0.1), 1e-12);
+  EXPECT_EQ(7, key.Add(7));
+
+  // Values within half a quantum give the same key, and values a quantum apart don't.
+  EXPECT_TRUE(AreEquivalent(DiskKey(0.5), DiskKey(0.5 + 0.3*quantum)));
+  EXPECT_TRUE(AreEquivalent(DiskKey(0.5), DiskKey(0.5 - 0.3*quantum)));
+  EXPECT_FALSE(AreEquivalent(DiskKey(0.5), DiskKey(0.5 + quantum)));
+
+  // The shape and every parameter are part of the key.
+  PrimitiveGeometryCache::Key other_shape("ring");
+  other_shape.Add(0.5);
+  EXPECT_FALSE(AreEquivalent(DiskKey(0.5), other_shape));
+  PrimitiveGeometryCache::Key more_parameters = DiskKey(0.5);
+  more_parameters.Add(3);
+  EXPECT_FALSE(AreEquivalent(DiskKey(0.5), more_parameters));
+}
+
+TEST(PrimitiveGeometryCacheTest, EquivalentKeysShareGeometry) {
+  PrimitiveGeometryCache cache;
+  int calls = 0;
+  const std::shared_ptr<PrimitiveGeometry> first = cache.Get(DiskKey(0.5), CountingGenerator(calls));
+  const std::shared_ptr<PrimitiveGeometry> second = cache.Get(DiskKey(0.5 + 0.3*PrimitiveGeometryCache::Key::DEFAULT_QUANTUM), CountingGenerator(calls));
+  const std::shared_ptr<PrimitiveGeometry> third = cache.Get(DiskKey(0.75), CountingGenerator(calls));
+
+  EXPECT_EQ(first, second);
+  EXPECT_NE(first, third);
+  EXPECT_EQ(2, calls);
+  EXPECT_EQ(2u, cache.Size());
+  EXPECT_EQ(1u, cache.GetStats().hits);
+  EXPECT_EQ(2u, cache.GetStats().misses);
+}
+
+TEST(PrimitiveGeometryCacheTest, EvictsTheLeastRecentlyUsed) {
+  PrimitiveGeometryCache cache(2);
+  int calls = 0;
+  cache.Get(DiskKey(1.0), CountingGenerator(calls));
+  cache.Get(DiskKey(2.0), CountingGenerator(calls));
+  // Using 1.0 again makes 2.0 the least recently used, so 3.0 evicts it.
+  cache.Get(DiskKey(1.0), CountingGenerator(calls));
+  cache.Get(DiskKey(3.0), CountingGenerator(calls));
+  EXPECT_EQ(2u, cache.Size());
+  EXPECT_EQ(1u, cache.GetStats().evictions);
+  EXPECT_EQ(3, calls);
+
+  cache.Get(DiskKey(1.0), CountingGenerator(calls));
+  cache.Get(DiskKey(3.0), CountingGenerator(calls));
+  EXPECT_EQ(3, calls);
+  cache.Get(DiskKey(2.0), CountingGenerator(calls));
+  EXPECT_EQ(4, calls);
+
+  // Shrinking the capacity evicts right away.
+  cache.SetCapacity(1);
+  EXPECT_EQ(1u, cache.Size());
+}
+
+TEST(PrimitiveGeometryCacheTest, GeometryInUseOutlivesEviction) {
+  PrimitiveGeometryCache cache(1);
+  int calls = 0;
+  std::shared_ptr<PrimitiveGeometry> held = cache.Get(DiskKey(1.0), CountingGenerator(calls));
+  held->Vertices().push_back(PrimitiveGeometry::MakeVertexAttributes(EigenTypes::Vector3f::Zero(), EigenTypes::Vector3f::UnitZ()));
+
+  // The held entry can't free anything by being evicted, so the cache goes over its capacity.
+  cache.Get(DiskKey(2.0), CountingGenerator(calls));
+  EXPECT_EQ(2u, cache.Size());
+  EXPECT_EQ(0u, cache.GetStats().evictions);
+  EXPECT_EQ(held, cache.Get(DiskKey(1.0), CountingGenerator(calls)));
+
+  // Clearing the cache leaves the held geometry intact.
+  cache.Clear();
+  EXPECT_EQ(0u, cache.Size());
+  EXPECT_EQ(1u, held->Vertices().size());
+
+  // Once released, entries are evicted as usual.
+  held = cache.Get(DiskKey(1.0), CountingGenerator(calls));
+  held.reset();
+  cache.Get(DiskKey(2.0), CountingGenerator(calls));
+  EXPECT_EQ(1u, cache.Size());
+}
@@ -0,0 +1,123 @@
+#include "SVGPrimitive.h"
+#include "SVGTessellationCache.h"
+#include "GLTestFramework.h"
+
+#include <gtest/gtest.h>
+#include <cmath>
+
+namespace {
+
+// Draws the primitive's contents directly, under a uniformly scaled model view, which is all that
+// level-of-detail selection depends on.  Drawing uploads the chosen level, hence the GL context.
+class ScaledSVGPrimitive : public SVGPrimitive {
+public:
+  ScaledSVGPrimitive() {
+    SetGeometryMode(GeometryMode::SHAPE_PER_MESH);
+    Set("<svg xmlns='http://www.w3.org/2000/svg' width='100' height='100'><circle cx='50' cy='50' r='40' fill='red'/></svg>", TessellationMode::SYNCHRONOUS);
+  }
+  void DrawAtScale(double scale) {
+    RenderState renderState;
+    renderState.GetModelView().Scale(EigenTypes::Vector3(scale, scale, scale));
+    DrawContents(renderState);
+  }
+};
+
+// The scale at which the ideal level (the base 2 log of the tolerance in SVG units) is the given
+// value, under the default view tolerance.
+double ScaleForIdealLevel(double level) {
+  return SVGPrimitive::DEFAULT_VIEW_TOLERANCE/std::exp2(level);
+}
+
+} // end of anonymous namespace
+
+class SVGPrimitiveLevelOfDetailTest : public GLTestFramework_Headless {
+protected:
+
+  // The tests use the shared cache (as SVGDocument does), but don't leave entries in it.
+  virtual void SetUp () override {
+    GLTestFramework_Headless::SetUp();
+    m_directory = SVGTessellationCache::Shared().Directory();
+    SVGTessellationCache::Shared().SetDirectory("");
+  }
+  virtual void TearDown () override {
+    SVGTessellationCache::Shared().SetDirectory(m_directory);
+    GLTestFramework_Headless::TearDown();
+  }
+
+  std::string m_directory;
+};
+
+TEST_F(SVGPrimitiveLevelOfDetailTest, LevelsSwitchAtTheExpectedScales) {
+  // A fresh primitive has no drawn level, so there's no hysteresis, and the tolerance is the power
+  // of two nearest (in log terms) to the view tolerance over the scale.
+  struct { double scale; double tolerance; } cases[] = {
+    { 1.0, 0.5 },
+    { 4.0, 0.125 },
+    { 0.25, 2.0 },
+    { 1.0/16.0, 8.0 },
+    { ScaleForIdealLevel(-0.45), 1.0 },
+    { ScaleForIdealLevel(-0.55), 0.5 },
+    { ScaleForIdealLevel(2.45), 4.0 },
+    { ScaleForIdealLevel(2.55), 8.0 },
+    // Clamped to the range of levels.
+    { 1024.0, 1.0/64.0 },
+    { 1.0/1024.0, 16.0 },
+  };
+  for (const auto& c : cases) {
+    ScaledSVGPrimitive primitive;
+    primitive.DrawAtScale(c.scale);
+    EXPECT_DOUBLE_EQ(c.tolerance, primitive.DrawnTolerance()) << "at scale " << c.scale;
+  }
+}
+
+TEST_F(SVGPrimitiveLevelOfDetailTest, DegenerateScalesAndToleranceUseTheDefault) {
+  ScaledSVGPrimitive primitive;
+  primitive.DrawAtScale(0.0);
+  EXPECT_DOUBLE_EQ(SVGTessellation::DEFAULT_TOLERANCE, primitive.DrawnTolerance());
+
+  // A nonpositive view tolerance disables level-of-detail selection.
+  ScaledSVGPrimitive fixed;
+  fixed.SetViewTolerance(0.0);
+  fixed.DrawAtScale(16.0);
+  EXPECT_DOUBLE_EQ(SVGTessellation::DEFAULT_TOLERANCE, fixed.DrawnTolerance());
+  fixed.DrawAtScale(1.0/16.0);
+  EXPECT_DOUBLE_EQ(SVGTessellation::DEFAULT_TOLERANCE, fixed.DrawnTolerance());
+}
+
+TEST_F(SVGPrimitiveLevelOfDetailTest, HysteresisAroundTheDrawnLevel) {
+  ScaledSVGPrimitive primitive;
+  primitive.DrawAtScale(ScaleForIdealLevel(-1.0));
+  EXPECT_DOUBLE_EQ(0.5, primitive.DrawnTolerance());
+
+  // Past the halfway point to the next level, but within the hysteresis of the drawn one.
+  primitive.DrawAtScale(ScaleForIdealLevel(-1.7));
+  EXPECT_DOUBLE_EQ(0.5, primitive.DrawnTolerance());
+  primitive.DrawAtScale(ScaleForIdealLevel(-0.3));
+  EXPECT_DOUBLE_EQ(0.5, primitive.DrawnTolerance());
+
+  primitive.DrawAtScale(ScaleForIdealLevel(-1.8));
+  EXPECT_DOUBLE_EQ(0.25, primitive.DrawnTolerance());
+  // Coming back, the switch happens on the other side of the boundary.
+  primitive.DrawAtScale(ScaleForIdealLevel(-1.3));
+  EXPECT_DOUBLE_EQ(0.25, primitive.DrawnTolerance());
+  primitive.DrawAtScale(ScaleForIdealLevel(-1.2));
+  EXPECT_DOUBLE_EQ(0.5, primitive.DrawnTolerance());
+}
+
+TEST_F(SVGPrimitiveLevelOfDetailTest, EvictsTheLeastRecentlyUsedLevels) {
+  ASSERT_EQ(3u, SVGPrimitive::MAX_CACHED_LEVELS);
+  ScaledSVGPrimitive primitive;
+  for (int level = -1; level <= 2; level++) {
+    primitive.DrawAtScale(ScaleForIdealLevel(level));
+    EXPECT_DOUBLE_EQ(std::exp2(level), primitive.DrawnTolerance());
+    EXPECT_LE(primitive.CachedTolerances().size(), SVGPrimitive::MAX_CACHED_LEVELS);
+  }
+  EXPECT_EQ(std::vector<double>({ 1.0, 2.0, 4.0 }), primitive.CachedTolerances());
+
+  // Using a level again makes it the most recently used, so the next one evicted is 2.
+  primitive.DrawAtScale(ScaleForIdealLevel(0));
+  EXPECT_EQ(std::vector<double>({ 1.0, 2.0, 4.0 }), primitive.CachedTolerances());
+  primitive.DrawAtScale(ScaleForIdealLevel(3));
+  EXPECT_EQ(std::vector<double>({ 1.0, 4.0, 8.0 }), primitive.CachedTolerances());
+  EXPECT_DOUBLE_EQ(8.0, primitive.DrawnTolerance());
+}
@@ -0,0 +1,100 @@
+#include "SVGPrimitive.h"
+#include "SVGTessellationCache.h"
+
+#include <gtest/gtest.h>
+
+// None of these tests draw, so they need no GL context.
+class SVGPrimitiveTest : public testing::Test {
+protected:
+
+  // The tests use the shared cache (as SVGDocument does), but don't leave entries in it.
+  virtual void SetUp () override {
+    m_directory = SVGTessellationCache::Shared().Directory();
+    SVGTessellationCache::Shared().SetDirectory("");
+  }
+  virtual void TearDown () override {
+    SVGTessellationCache::Shared().SetDirectory(m_directory);
+  }
+
+  // A 200x100 canvas with a single shape, whose bounds are (10,20) to (40,60).
+  static std::string Icon (const std::string &root_attributes = "width='200' height='100'") {
+    return "<svg xmlns='http://www.w3.org/2000/svg' " + root_attributes + "><rect x='10' y='20' width='30' height='40' fill='red'/></svg>";
+  }
+
+  static void ExpectBounds (const SVGPrimitive &primitive, double x, double y, double width, double height) {
+    EXPECT_DOUBLE_EQ(x, primitive.Origin().x());
+    EXPECT_DOUBLE_EQ(y, primitive.Origin().y());
+    EXPECT_DOUBLE_EQ(width, primitive.Size().x());
+    EXPECT_DOUBLE_EQ(height, primitive.Size().y());
+  }
+
+  std::string m_directory;
+};
+
+TEST_F(SVGPrimitiveTest, SynchronousBoundsAreKnownAtOnce) {
+  SVGPrimitive primitive;
+  int callbacks = 0;
+  primitive.SetBoundsCallback([&callbacks](const SVGPrimitive &) { ++callbacks; });
+  primitive.Set(Icon(), SVGPrimitive::TessellationMode::SYNCHRONOUS);
+  EXPECT_TRUE(primitive.AreBoundsKnown());
+  EXPECT_FALSE(primitive.IsTessellationPending());
+  ExpectBounds(primitive, 10, 20, 30, 40);
+  // The caller of a synchronous Set already has the final bounds.
+  EXPECT_EQ(0, callbacks);
+}
+
+TEST_F(SVGPrimitiveTest, AsynchronousBoundsAreProvisionalUntilReady) {
+  SVGPrimitive primitive;
+  int callbacks = 0;
+  EigenTypes::Vector2 reportedSize(EigenTypes::Vector2::Zero());
+  primitive.SetBoundsCallback([&callbacks, &reportedSize](const SVGPrimitive &p) {
+    ++callbacks;
+    reportedSize = p.Size();
+  });
+  primitive.Set(Icon(), SVGPrimitive::TessellationMode::ASYNCHRONOUS);
+
+  // Until the tessellation is picked up (even if it's already finished), the canvas stands in for
+  // the bounds, and Origin and Size don't wait for it.
+  EXPECT_FALSE(primitive.AreBoundsKnown());
+  EXPECT_TRUE(primitive.IsTessellationPending());
+  ExpectBounds(primitive, 0, 0, 200, 100);
+  EXPECT_TRUE(primitive.IsTessellationPending());
+  EXPECT_EQ(0, callbacks);
+
+  primitive.WaitForBounds();
+  EXPECT_TRUE(primitive.AreBoundsKnown());
+  EXPECT_FALSE(primitive.IsTessellationPending());
+  ExpectBounds(primitive, 10, 20, 30, 40);
+  EXPECT_EQ(1, callbacks);
+  EXPECT_DOUBLE_EQ(30, reportedSize.x());
+  EXPECT_DOUBLE_EQ(40, reportedSize.y());
+
+  // Picking up further levels doesn't call it again.
+  primitive.WaitForBounds();
+  primitive.WaitForTessellation();
+  EXPECT_EQ(1, callbacks);
+}
+
+TEST_F(SVGPrimitiveTest, ProvisionalBoundsOfADocumentWithoutACanvas) {
+  SVGPrimitive primitive;
+  primitive.Set(Icon("width='64' height='32'"), SVGPrimitive::TessellationMode::SYNCHRONOUS);
+  ExpectBounds(primitive, 10, 20, 30, 40);
+
+  // Without a canvas size, the previous document's bounds are the best guess.
+  primitive.Set(Icon("width='100%' height='100%'"), SVGPrimitive::TessellationMode::ASYNCHRONOUS);
+  EXPECT_FALSE(primitive.AreBoundsKnown());
+  ExpectBounds(primitive, 10, 20, 30, 40);
+  primitive.WaitForTessellation();
+  EXPECT_TRUE(primitive.AreBoundsKnown());
+}
+
+TEST_F(SVGPrimitiveTest, RemovedCallbackIsNotCalled) {
+  SVGPrimitive primitive;
+  int callbacks = 0;
+  primitive.SetBoundsCallback([&callbacks](const SVGPrimitive &) { ++callbacks; });
+  primitive.SetBoundsCallback(nullptr);
+  primitive.Set(Icon(), SVGPrimitive::TessellationMode::ASYNCHRONOUS);
+  primitive.WaitForBounds();
+  EXPECT_TRUE(primitive.AreBoundsKnown());
+  EXPECT_EQ(0, callbacks);
+}
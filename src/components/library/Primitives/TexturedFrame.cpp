@@ -70,11 +70,11 @@ void TexturedFrame::DrawContents(RenderState& renderState) const {
   RecomputeGeometryIfNecessary();
   // assert(!m_recompute_geometry);
 
-  glEnable(GL_TEXTURE_2D);
+  GLStateTracker::Current().Enable(GL_TEXTURE_2D);
   m_texture->Bind();
   m_geometry.Draw(Shader(), GL_TRIANGLES);
   m_texture->Unbind();
-  glDisable(GL_TEXTURE_2D);
+  GLStateTracker::Current().Disable(GL_TEXTURE_2D);
   
   // m_geometry.Draw(Shader(), GL_LINE_STRIP);
 }
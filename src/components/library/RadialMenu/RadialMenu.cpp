@@ -14,22 +14,40 @@ void RadialMenuItem::InitChildren() {
   AddChild(m_Goal);
 }
 
+RadialMenuItem::~RadialMenuItem() {
+  if (m_Icon) {
+    m_Icon->SetBoundsCallback(nullptr);
+  }
+}
+
 void RadialMenuItem::SetIcon(const std::shared_ptr<SVGPrimitive>& svgIcon) {
+  if (m_Icon) {
+    m_Icon->SetBoundsCallback(nullptr);
+  }
   m_Icon = svgIcon;
+  m_IconLinearTransformation = m_Icon->LinearTransformation();
+
+  // An icon set asynchronously is laid out around its provisional bounds until the real ones are known.
+  updateIconLayout();
+  m_Icon->SetBoundsCallback([this](const SVGPrimitive&) { updateIconLayout(); });
 
+  AddChild(m_Icon);
+}
+
+void RadialMenuItem::updateIconLayout() {
   const EigenTypes::Vector2& origin = m_Icon->Origin();
   const EigenTypes::Vector2& size = m_Icon->Size();
+  if (size.isZero()) {
+    return;
+  }
 
   static const double ICON_THICKNESS_RATIO = 0.6;
 
   m_IconScale = ICON_THICKNESS_RATIO * m_Thickness / size.norm();
-  m_Icon->LinearTransformation() = EigenTypes::Vector3(m_IconScale, -m_IconScale, m_IconScale).asDiagonal() * m_Icon->LinearTransformation();
+  m_Icon->LinearTransformation() = EigenTypes::Vector3(m_IconScale, -m_IconScale, m_IconScale).asDiagonal() * m_IconLinearTransformation;
 
   const EigenTypes::Vector2 center = origin + size/2.0;
-  const EigenTypes::Vector3 iconOffset;
   m_IconOffset = m_IconScale * EigenTypes::Vector3(-center.x(), center.y(), 0);
-
-  AddChild(m_Icon);
 }
 
 bool RadialMenuItem::Hit(const EigenTypes::Vector2& pos, double& ratio) const {
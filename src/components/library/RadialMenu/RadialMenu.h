@@ -15,6 +15,7 @@ class RadialMenuItem : public RadialItem  {
 public:
 
   RadialMenuItem();
+  virtual ~RadialMenuItem();
   void InitChildren();
   //void SetActivation(double activation) { m_Activation = activation; }
   void SetActivation(double activation) { m_Activation.SetGoal(activation); }
@@ -45,8 +46,13 @@ protected:
   Color m_ActivatedColor;
   Color m_HoverColor;
 
+  // Computes the icon's scale and offset from its bounds.
+  void updateIconLayout();
+
   double m_IconScale;
   EigenTypes::Vector3 m_IconOffset;
+  // The icon's linear transformation before it was scaled to fit.
+  EigenTypes::Matrix3x3 m_IconLinearTransformation;
   std::shared_ptr<SVGPrimitive> m_Icon;
 
   RadialMenuItemEvent* m_Callback;
@@ -15,6 +15,7 @@ class RadialSlider : public RadialItem {
 public:
 
   RadialSlider();
+  virtual ~RadialSlider();
   void InitChildren();
   void SetMinValue(double min) { m_MinValue = min; }
   void SetMaxValue(double max) { m_MaxValue = max; }
@@ -54,7 +55,12 @@ protected:
 
   RadialSliderEvent* m_Callback;
 
+  // Computes the icon's scale and offset from its bounds.
+  void updateIconLayout();
+
   double m_IconScale;
   EigenTypes::Vector3 m_IconOffset;
+  // The icon's linear transformation before it was scaled to fit.
+  EigenTypes::Matrix3x3 m_IconLinearTransformation;
   std::shared_ptr<SVGPrimitive> m_Icon;
 };
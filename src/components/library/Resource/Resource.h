@@ -4,6 +4,7 @@
 #include "Singleton.h"
 
 #include <cassert>
+#include <chrono>
 #include <iostream>
 #include <memory>
 
@@ -44,3 +45,53 @@ public:
     }
   }
 };
+
+/// @brief Convenience class for loading managed resources in the background.
+/// @details This is the asynchronous counterpart of Resource<T>: construction (or Load) starts
+/// the load via Singleton<ResourceManager<T>>::GetAsync and returns immediately.  Get can then be
+/// called each frame, and returns the manager's placeholder (by default null) until the resource
+/// has loaded.  The render thread must keep calling ResourceFinishQueue::Shared().RunFor for the
+/// load to complete.
+template <typename T>
+class AsyncResource {
+public:
+
+  /// @brief Construct an "empty" resource, for which Get returns null.
+  AsyncResource () { }
+  /// @brief Start loading the resource with the given name via Load.
+  explicit AsyncResource (const std::string &name) {
+    Load(name);
+  }
+  /// @brief Start loading the resource of the given name via Singleton<ResourceManager<T>>.
+  void Load (const std::string &name) {
+    m_name = name;
+    m_result = Singleton<ResourceManager<T>>::SafeRef().GetAsync(name);
+  }
+
+  const std::string &Name () const { return m_name; }
+  /// @brief Returns true iff loading has completed (successfully or not).
+  bool IsReady () const {
+    return m_result.valid() && m_result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+  }
+  /// @brief Returns the resource if it has loaded, otherwise the placeholder.
+  /// @details If loading failed, the exception thrown by the loader is rethrown.
+  std::shared_ptr<T> Get () const {
+    if (!m_result.valid()) {
+      return nullptr;
+    }
+    if (!IsReady()) {
+      return Singleton<ResourceManager<T>>::SafeRef().Placeholder();
+    }
+    try {
+      return m_result.get();
+    } catch (const std::exception &e) {
+      std::cerr << "exception \"" << e.what() << "\" thrown while loading resource \"" << m_name << "\"\n";
+      throw; // rethrow
+    }
+  }
+
+private:
+
+  std::string m_name;
+  typename ResourceManager<T>::FutureResource m_result;
+};
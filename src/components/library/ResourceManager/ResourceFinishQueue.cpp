@@ -0,0 +1,41 @@
+#include "ResourceFinishQueue.h"
+
+const std::chrono::microseconds ResourceFinishQueue::DEFAULT_FRAME_BUDGET(2000);
+
+ResourceFinishQueue &ResourceFinishQueue::Shared () {
+  // Like ThreadPool::Shared, this is never destroyed, since tasks may still be posted by worker
+  // threads during static destruction.
+  static ResourceFinishQueue *s_queue = new ResourceFinishQueue();
+  return *s_queue;
+}
+
+void ResourceFinishQueue::Post (std::function<void()> &&task) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_tasks.emplace_back(std::move(task));
+}
+
+size_t ResourceFinishQueue::RunFor (std::chrono::microseconds budget) {
+  typedef std::chrono::steady_clock Clock;
+  const Clock::time_point deadline = Clock::now() + budget;
+  size_t run_count = 0;
+  do {
+    std::function<void()> task;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_tasks.empty()) {
+        break;
+      }
+      task = std::move(m_tasks.front());
+      m_tasks.pop_front();
+    }
+    // The lock isn't held while the task runs, since it may post further tasks.
+    task();
+    ++run_count;
+  } while (Clock::now() < deadline);
+  return run_count;
+}
+
+size_t ResourceFinishQueue::PendingCount () const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_tasks.size();
+}
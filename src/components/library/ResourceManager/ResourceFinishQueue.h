@@ -0,0 +1,40 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+/// @brief A queue of work which has to be done on the render thread, such as creating GL
+/// objects from data which was decoded on a worker thread.
+/// @details Tasks may be posted from any thread.  The render thread calls RunFor once per frame,
+/// which runs tasks in FIFO order until a time budget is spent, so that a burst of completed
+/// loads is spread over several frames instead of causing a hitch.
+class ResourceFinishQueue {
+public:
+
+  /// @brief A reasonable per-frame budget: a small fraction of a 60 Hz frame.
+  static const std::chrono::microseconds DEFAULT_FRAME_BUDGET;
+
+  /// @brief The queue used by ResourceManager<T>::GetAsync, created upon first use.
+  static ResourceFinishQueue &Shared ();
+
+  /// @brief Queue a task to be run by a later call to RunFor.  May be called from any thread.
+  void Post (std::function<void()> &&task);
+  /// @brief Run queued tasks on the calling thread until the queue is empty or the given time
+  /// has been spent, and return the number run.
+  /// @details At least one task is run if any is queued, so that the queue makes progress
+  /// even if a single task takes longer than the budget.  Tasks posted while this runs may be
+  /// run by the same call.  An exception thrown by a task propagates out of this call, and the
+  /// remaining tasks stay queued.
+  size_t RunFor (std::chrono::microseconds budget = DEFAULT_FRAME_BUDGET);
+
+  /// @brief The number of tasks which have been posted but not yet run.
+  size_t PendingCount () const;
+
+private:
+
+  std::deque<std::function<void()>> m_tasks;
+  mutable std::mutex m_mutex;
+};
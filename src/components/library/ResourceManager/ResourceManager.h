@@ -1,9 +1,48 @@
 #pragma once
 
+#include "ResourceFinishQueue.h"
+#include "ThreadPool.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <limits>
+#include <list>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+template <typename T> class ResourceManager;
+
+/// @brief The memory used by a resource (as reported by its loader), or allowed for a type of resource.
+struct ResourceByteCount {
+  ResourceByteCount (size_t cpu_bytes_ = 0, size_t gpu_bytes_ = 0) : cpu_bytes(cpu_bytes_), gpu_bytes(gpu_bytes_) { }
+
+  size_t cpu_bytes; ///< Memory in the process, e.g. file contents or parsed data.
+  size_t gpu_bytes; ///< Memory in GL objects, e.g. texture storage.
+};
+
+/// @brief Runtime statistics for a ResourceManager<T>; see ResourceManager<T>::Statistics.
+struct ResourceCacheStatistics {
+  ResourceCacheStatistics () : hit_count(0), miss_count(0), eviction_count(0), resident_count(0) { }
+
+  /// @brief The fraction of requests which were for an already-loaded resource (or 0 if there were none).
+  double HitRate () const { return hit_count + miss_count > 0 ? double(hit_count)/double(hit_count + miss_count) : 0.0; }
+
+  size_t hit_count; ///< Get and GetAsync calls for a resource which was loaded.
+  size_t miss_count; ///< Get and GetAsync calls for a resource which was loading or had to be loaded.
+  size_t eviction_count; ///< Resources released by the manager to keep within its budget.
+  size_t resident_count; ///< Resources currently held by the manager.
+  ResourceByteCount resident_bytes; ///< The total reported size of the resources currently held by the manager.
+};
 
 /// @brief Metafunction for defining how to load particularly typed resources.
 /// @details To define how to load a paricular type U, one must template-specialize
@@ -16,11 +55,39 @@
 /// that ResourceLoader<U> is a singleton.  The manager parameter doesn't have to be used,
 /// but could be e.g. if some other resource from the same ResourceManager<U> was to be
 /// loaded.
+///
+/// A loader may additionally split loading into a decoding stage, which doesn't need the render
+/// thread (reading and parsing files, decompressing images, etc), and a finishing stage which
+/// does (creating GL objects), by defining:
+///   typedef D Decoded;
+///   static std::shared_ptr<D> DecodeResource (const std::string &name, ResourceManager<U> &calling_manager);
+///   static std::shared_ptr<U> FinishResource (const std::shared_ptr<D> &decoded, const std::string &name, ResourceManager<U> &calling_manager);
+/// ResourceManager<U>::GetAsync runs DecodeResource on a ThreadPool worker, and FinishResource
+/// on the render thread via ResourceFinishQueue.  DecodeResource may throw just as LoadResource
+/// may.  For loaders which don't define these, GetAsync runs all of LoadResource via
+/// ResourceFinishQueue.  LoadResource must be defined in either case.
+///
+/// A loader may also report how much memory a loaded resource uses, which ResourceManager<U>
+/// counts against its budget (see ResourceManager<U>::SetBudget), by defining:
+///   static ResourceByteCount ByteCount (const U &resource);
+/// Resources whose loader doesn't define it are counted as taking no memory.
 template <typename T>
 struct ResourceLoader {
   static const bool exists = false;
 };
 
+/// @brief Metafunction which is true iff ResourceLoader<T> defines a decoding stage (see ResourceLoader).
+template <typename T, typename Enable_ = void>
+struct ResourceLoaderHasDecodeStage : std::false_type { };
+template <typename T>
+struct ResourceLoaderHasDecodeStage<T, typename std::conditional<true, void, typename ResourceLoader<T>::Decoded>::type> : std::true_type { };
+
+/// @brief Metafunction which is true iff ResourceLoader<T> defines ByteCount (see ResourceLoader).
+template <typename T, typename Enable_ = void>
+struct ResourceLoaderHasByteCount : std::false_type { };
+template <typename T>
+struct ResourceLoaderHasByteCount<T, typename std::conditional<true, void, decltype(ResourceLoader<T>::ByteCount(std::declval<const T &>()))>::type> : std::true_type { };
+
 /// @brief Custom exception class specifically for Resource<T> and ResourceManager<T>.
 /// @details This is the base class for all type-specific resource-loading exceptions,
 /// and can be used to catch all resource-loading exceptions.
@@ -40,11 +107,29 @@ public:
 };
 
 /// @brief A class for tracking non-redundant loading of resources of type T.
+/// @details All the methods may be called from any thread.  A resource is loaded at most once
+/// at a time: a Get or GetAsync for a resource which is already being loaded shares that load.
+/// Get loads on the calling thread (which must therefore be the render thread for resources
+/// that make GL calls), whereas GetAsync returns immediately, and the resource becomes
+/// available once its decoding stage has run on ThreadPool::Shared() and its finishing stage has
+/// been run by the render thread's call to ResourceFinishQueue::Shared().RunFor.
+///
+/// The base path must be set before loading begins, and the manager must outlive any loads
+/// it started via GetAsync (the usual singleton managers are never destroyed while loading).
+///
+/// Loaded resources are kept in least-recently-requested order.  While the resources' total
+/// reported size exceeds the budget, the least recently requested ones which nothing but the
+/// manager refers to are released (and will be reloaded if they're requested again).  This is
+/// checked whenever a resource is added, and by Trim, which should be called periodically on the
+/// render thread if releasing resources makes GL calls.  Resources given to AddResource are
+/// never released, since they can't be reloaded.
 template <typename T>
 class ResourceManager {
 public:
   /// @brief This is the type of the named resource storage.
   typedef std::map<std::string,std::shared_ptr<T>> ResourceMap;
+  /// @brief The type through which GetAsync delivers a resource, or the exception thrown while loading it.
+  typedef std::shared_future<std::shared_ptr<T>> FutureResource;
 
   ResourceManager(const std::string &basePath = "") { SetBasePath(basePath); }
   
@@ -66,45 +151,324 @@ public:
   //Returns the utf-8 encoded base path.
   const std::string& GetBasePath() const { return m_basePath; }
 
-  /// @brief The map of loaded, named resources.
+  /// @brief A copy of the map of loaded, named resources.
   /// @details Could be used during a cleanup step to check if there are still allocated
   /// resources right before an application is about to exit.
-  const ResourceMap &Resources () const { return m_resources; }
-  // TODO: store std::weak_ptr instead of shared_ptr.
+  ResourceMap Resources () const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ResourceMap resources;
+    for (const typename EntryMap::value_type &entry : m_entries) {
+      resources[entry.first] = entry.second.resource;
+    }
+    return resources;
+  }
+  /// @brief The number of resources which have been requested but haven't finished loading.
+  size_t PendingCount () const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pending.size();
+  }
+
+  /// @brief Set the total size of the resources above which unused ones are released.  The
+  /// default is unlimited, so that nothing is released.
+  void SetBudget (const ResourceByteCount &budget) {
+    std::vector<std::shared_ptr<T>> evicted;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_budget = budget;
+    EvictOverBudget(evicted);
+  }
+  ResourceByteCount Budget () const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_budget;
+  }
+  /// @brief Release unused resources (least recently requested first) while over budget,
+  /// and return the number released.
+  /// @details Resources released here are destroyed on the calling thread.
+  size_t Trim () {
+    std::vector<std::shared_ptr<T>> evicted;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    EvictOverBudget(evicted);
+    return evicted.size();
+  }
+  ResourceCacheStatistics Statistics () const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ResourceCacheStatistics statistics(m_statistics);
+    statistics.resident_count = m_entries.size();
+    return statistics;
+  }
+
   /// @brief Return the resource with given name, loading it if necessary.
   /// @details This calls ResourceLoader<T>::LoadResource, which should throw
-  /// ResourceExceptionOfType<T> upon error.
+  /// ResourceExceptionOfType<T> upon error.  If the resource is being loaded via GetAsync, that
+  /// load is completed on the calling thread (or waited for, if another thread is finishing it).
   std::shared_ptr<T> Get (const std::string &name) {
-    //std::cout << "ResourceManager::Get(\"" << name << "\"); ... ";
-    typename ResourceMap::iterator resource_it = m_resources.find(name);
-    if (resource_it != m_resources.end()) {
-      //std::cout << "the resource was loaded already -- returning that one.\n";
-      return resource_it->second;
+    static_assert(ResourceLoader<T>::exists, "ResourceLoader<T> not defined -- template-specialize it to define");
+    std::unique_lock<std::mutex> lock(m_mutex);
+    typename EntryMap::iterator entry_it = m_entries.find(name);
+    if (entry_it != m_entries.end()) {
+      return Touch(entry_it->second);
+    }
+
+    ++m_statistics.miss_count;
+    typename PendingMap::iterator pending_it = m_pending.find(name);
+    if (pending_it == m_pending.end()) {
+      // Nothing is loading it, so load it here, while other callers wait on the result.
+      std::shared_ptr<PendingLoad> pending(NewPendingLoad(name, PendingLoad::FINISHING));
+      pending->finish = [this, name]() { return ResourceLoader<T>::LoadResource(name, *this); };
+      lock.unlock();
+      return Complete(name, *pending);
     }
 
-    //std::cout << "the resource was not already loaded -- loading it.\n";
+    std::shared_ptr<PendingLoad> pending(pending_it->second);
+    while (pending->stage == PendingLoad::DECODING) {
+      m_decoded.wait(lock);
+    }
+    if (pending->stage == PendingLoad::QUEUED) {
+      // Take over the decoding, rather than wait for a worker to get to it (which could
+      // deadlock if this is itself a worker).
+      pending->stage = PendingLoad::FINISHING;
+      lock.unlock();
+      pending->finish = Decode(name, ResourceLoaderHasDecodeStage<T>());
+      return Complete(name, *pending);
+    } else if (pending->stage == PendingLoad::DECODED) {
+      // Finish it now, rather than in ResourceFinishQueue.
+      pending->stage = PendingLoad::FINISHING;
+      lock.unlock();
+      return Complete(name, *pending);
+    } else {
+      lock.unlock();
+      return pending->result.get();
+    }
+  }
+  /// @brief Start loading the resource with the given name, if it isn't already loaded or
+  /// loading, and return immediately.
+  /// @details The result becomes ready once the resource has loaded (or failed to, in which
+  /// case it rethrows the exception).  A failed load isn't remembered, so a later call retries.
+  /// The render thread must not wait on the result, since the finishing stage runs there.
+  FutureResource GetAsync (const std::string &name) {
     static_assert(ResourceLoader<T>::exists, "ResourceLoader<T> not defined -- template-specialize it to define");
-    std::shared_ptr<T> resource;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    typename EntryMap::iterator entry_it = m_entries.find(name);
+    if (entry_it != m_entries.end()) {
+      std::promise<std::shared_ptr<T>> loaded;
+      loaded.set_value(Touch(entry_it->second));
+      return loaded.get_future().share();
+    }
+    ++m_statistics.miss_count;
+    typename PendingMap::iterator pending_it = m_pending.find(name);
+    if (pending_it != m_pending.end()) {
+      return pending_it->second->result;
+    }
 
-    resource = ResourceLoader<T>::LoadResource(name, *this);
-    //std::cout << "ResourceManager::Get(\"" << name << "\"); loaded successfully.\n";
-    AddResource(name, resource);
-    return resource;
+    std::shared_ptr<PendingLoad> pending;
+    if (ResourceLoaderHasDecodeStage<T>::value) {
+      pending = NewPendingLoad(name, PendingLoad::QUEUED);
+      lock.unlock();
+      ThreadPool::Shared().Submit([this, name, pending]() { RunDecodeStage(name, pending); });
+    } else {
+      pending = NewPendingLoad(name, PendingLoad::DECODED);
+      pending->finish = Decode(name, std::false_type());
+      lock.unlock();
+      PostFinishStage(name, pending);
+    }
+    return pending->result;
+  }
+
+  /// @brief Set the resource which AsyncResource<T> provides while loading.  May be null (the default).
+  void SetPlaceholder (const std::shared_ptr<T> &placeholder) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_placeholder = placeholder;
+  }
+  std::shared_ptr<T> Placeholder () const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_placeholder;
   }
 
   /// @brief Explicitly add a named resource to the set of managed resources.
   /// @details This could be used for e.g. pre-loading procedurally-generated "fallback"
   /// or other special resources, like a "pass-through" shader program.
-  /// A ResourceExceptionOfType<T> will be thrown if the given name is already loaded.
+  /// A ResourceExceptionOfType<T> will be thrown if the given name is already loaded (or loading).
+  /// The resource is never released to keep within the budget.
   void AddResource (const std::string &name, const std::shared_ptr<T> &resource) {
-    typename ResourceMap::iterator resource_it = m_resources.find(name);
-    if (resource_it != m_resources.end()) {
+    const ResourceByteCount byte_count(ByteCount(resource, ResourceLoaderHasByteCount<T>()));
+    std::vector<std::shared_ptr<T>> evicted;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_entries.find(name) != m_entries.end() || m_pending.find(name) != m_pending.end()) {
       throw ResourceExceptionOfType<T>("resource with name \"" + name + "\" has already been loaded for this particular resource type");
     }
-    m_resources[name] = resource;
+    Insert(name, resource, byte_count, true, evicted);
   }
 
 private:
+
+  /// @brief The state of a resource which has been requested but isn't loaded yet.
+  struct PendingLoad {
+    /// QUEUED: waiting for a worker to decode it.  DECODING: a thread is decoding it.
+    /// DECODED: waiting for the render thread to finish it.  FINISHING: a thread is finishing it.
+    enum Stage { QUEUED, DECODING, DECODED, FINISHING };
+
+    Stage stage;
+    /// Produces the resource (or throws); set once decoding is done, and called by whichever
+    /// thread moves the load to FINISHING.
+    std::function<std::shared_ptr<T>()> finish;
+    std::promise<std::shared_ptr<T>> promise;
+    FutureResource result;
+  };
+  typedef std::map<std::string,std::shared_ptr<PendingLoad>> PendingMap;
+
+  /// @brief A loaded resource, and its place in m_lru (whose front is the most recently requested).
+  struct Entry {
+    std::shared_ptr<T> resource;
+    ResourceByteCount byte_count;
+    bool pinned; ///< True for resources given to AddResource, which are never evicted.
+    std::list<std::string>::iterator lru_position;
+  };
+  typedef std::map<std::string,Entry> EntryMap;
+
+  /// @brief Must be called with m_mutex locked.
+  std::shared_ptr<T> Touch (Entry &entry) {
+    ++m_statistics.hit_count;
+    m_lru.splice(m_lru.begin(), m_lru, entry.lru_position);
+    return entry.resource;
+  }
+  /// @brief Must be called with m_mutex locked.  Evicted resources are moved to evicted, so that
+  /// the caller can release them after unlocking m_mutex (evicted should therefore be declared
+  /// before the lock).
+  void Insert (const std::string &name, const std::shared_ptr<T> &resource, const ResourceByteCount &byte_count, bool pinned, std::vector<std::shared_ptr<T>> &evicted) {
+    m_lru.push_front(name);
+    Entry &entry = m_entries[name];
+    entry.resource = resource;
+    entry.byte_count = byte_count;
+    entry.pinned = pinned;
+    entry.lru_position = m_lru.begin();
+    m_statistics.resident_bytes.cpu_bytes += byte_count.cpu_bytes;
+    m_statistics.resident_bytes.gpu_bytes += byte_count.gpu_bytes;
+    EvictOverBudget(evicted);
+  }
+  /// @brief Must be called with m_mutex locked; see Insert regarding evicted.
+  void EvictOverBudget (std::vector<std::shared_ptr<T>> &evicted) {
+    const ResourceByteCount &resident = m_statistics.resident_bytes;
+    std::list<std::string>::iterator it = m_lru.end();
+    while (it != m_lru.begin() && (resident.cpu_bytes > m_budget.cpu_bytes || resident.gpu_bytes > m_budget.gpu_bytes)) {
+      --it;
+      typename EntryMap::iterator entry_it = m_entries.find(*it);
+      Entry &entry = entry_it->second;
+      // A resource is unused if only the manager refers to it.  Since nothing else can obtain a
+      // reference to it without locking m_mutex, it can't come back into use while it's evicted.
+      if (entry.pinned || entry.resource.use_count() > 1) {
+        continue;
+      }
+      evicted.push_back(std::move(entry.resource));
+      m_statistics.resident_bytes.cpu_bytes -= entry.byte_count.cpu_bytes;
+      m_statistics.resident_bytes.gpu_bytes -= entry.byte_count.gpu_bytes;
+      ++m_statistics.eviction_count;
+      m_entries.erase(entry_it);
+      it = m_lru.erase(it);
+    }
+  }
+
+  static ResourceByteCount ByteCount (const std::shared_ptr<T> &resource, std::true_type has_byte_count) {
+    return ResourceLoader<T>::ByteCount(*resource);
+  }
+  static ResourceByteCount ByteCount (const std::shared_ptr<T> &resource, std::false_type has_byte_count) {
+    return ResourceByteCount();
+  }
+
+  /// @brief Must be called with m_mutex locked.
+  std::shared_ptr<PendingLoad> NewPendingLoad (const std::string &name, typename PendingLoad::Stage stage) {
+    std::shared_ptr<PendingLoad> pending(std::make_shared<PendingLoad>());
+    pending->stage = stage;
+    pending->result = pending->promise.get_future().share();
+    m_pending[name] = pending;
+    return pending;
+  }
+
+  /// @brief Run the decoding stage, and return the finishing stage (which rethrows any decoding exception).
+  std::function<std::shared_ptr<T>()> Decode (const std::string &name, std::true_type has_decode_stage) {
+    typedef typename ResourceLoader<T>::Decoded Decoded;
+    try {
+      std::shared_ptr<Decoded> decoded(ResourceLoader<T>::DecodeResource(name, *this));
+      return [this, name, decoded]() { return ResourceLoader<T>::FinishResource(decoded, name, *this); };
+    } catch (...) {
+      std::exception_ptr exception(std::current_exception());
+      return [exception]() -> std::shared_ptr<T> { std::rethrow_exception(exception); };
+    }
+  }
+  /// @brief Without a decoding stage, all of the loading is done by the finishing stage.
+  std::function<std::shared_ptr<T>()> Decode (const std::string &name, std::false_type has_decode_stage) {
+    return [this, name]() { return ResourceLoader<T>::LoadResource(name, *this); };
+  }
+
+  /// @brief Run on a ThreadPool worker by GetAsync.
+  void RunDecodeStage (const std::string &name, const std::shared_ptr<PendingLoad> &pending) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (pending->stage != PendingLoad::QUEUED) {
+        return; // Get took it over.
+      }
+      pending->stage = PendingLoad::DECODING;
+    }
+    std::function<std::shared_ptr<T>()> finish(Decode(name, ResourceLoaderHasDecodeStage<T>()));
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      pending->finish = std::move(finish);
+      pending->stage = PendingLoad::DECODED;
+    }
+    m_decoded.notify_all();
+    PostFinishStage(name, pending);
+  }
+  void PostFinishStage (const std::string &name, const std::shared_ptr<PendingLoad> &pending) {
+    ResourceFinishQueue::Shared().Post([this, name, pending]() {
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (pending->stage != PendingLoad::DECODED) {
+          return; // Get finished it already.
+        }
+        pending->stage = PendingLoad::FINISHING;
+      }
+      try {
+        Complete(name, *pending);
+      } catch (...) {
+        // The exception has been delivered through pending->result.
+      }
+    });
+  }
+
+  /// @brief Run the finishing stage of a load in the FINISHING stage, store the resource and
+  /// deliver it (or the exception thrown by loading, which is also rethrown).
+  std::shared_ptr<T> Complete (const std::string &name, PendingLoad &pending) {
+    std::shared_ptr<T> resource;
+    ResourceByteCount byte_count;
+    try {
+      resource = pending.finish();
+      if (!resource) {
+        throw ResourceExceptionOfType<T>("the loader for resource \"" + name + "\" returned null");
+      }
+      byte_count = ByteCount(resource, ResourceLoaderHasByteCount<T>());
+    } catch (...) {
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending.erase(name);
+      }
+      pending.promise.set_exception(std::current_exception());
+      throw;
+    }
+    std::vector<std::shared_ptr<T>> evicted;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      Insert(name, resource, byte_count, false, evicted);
+      m_pending.erase(name);
+    }
+    pending.promise.set_value(resource);
+    return resource;
+  }
+
   std::string m_basePath = "";
-  ResourceMap m_resources; ///< The map of name-indexed loaded resources.
+  EntryMap m_entries; ///< The map of name-indexed loaded resources.
+  std::list<std::string> m_lru; ///< The names of the loaded resources, most recently requested first.
+  PendingMap m_pending; ///< The resources which are being loaded, indexed by name.
+  std::shared_ptr<T> m_placeholder;
+  ResourceByteCount m_budget = ResourceByteCount(std::numeric_limits<size_t>::max(), std::numeric_limits<size_t>::max());
+  ResourceCacheStatistics m_statistics;
+  mutable std::mutex m_mutex; ///< Guards everything but the base path.
+  std::condition_variable m_decoded; ///< Notified when a load moves from DECODING to DECODED.
 };
@@ -0,0 +1,260 @@
+#include "ResourceManager.h"
+
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+// A resource whose loader has a decoding stage, and which records the thread it was finished on.
+struct DecodedAsset {
+  std::string name;
+  std::thread::id finished_on;
+};
+// A resource whose loader only defines LoadResource (and ByteCount).
+struct PlainAsset {
+  std::string name;
+  std::thread::id loaded_on;
+};
+
+static std::atomic<int> s_decode_count(0);
+static std::atomic<int> s_load_count(0);
+
+template <>
+struct ResourceLoader<DecodedAsset> {
+  static const bool exists = true;
+  static std::shared_ptr<DecodedAsset> LoadResource (const std::string &name, ResourceManager<DecodedAsset> &calling_manager) {
+    return FinishResource(DecodeResource(name, calling_manager), name, calling_manager);
+  }
+
+  typedef std::string Decoded;
+  static std::shared_ptr<std::string> DecodeResource (const std::string &name, ResourceManager<DecodedAsset> &calling_manager) {
+    ++s_decode_count;
+    // Give concurrent requests a chance to overlap with the decoding.
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    if (name.find("missing") != std::string::npos) {
+      throw ResourceExceptionOfType<DecodedAsset>("no asset named \"" + name + "\"");
+    }
+    return std::make_shared<std::string>(name);
+  }
+  static std::shared_ptr<DecodedAsset> FinishResource (const std::shared_ptr<std::string> &decoded, const std::string &name, ResourceManager<DecodedAsset> &calling_manager) {
+    std::shared_ptr<DecodedAsset> asset(std::make_shared<DecodedAsset>());
+    asset->name = *decoded;
+    asset->finished_on = std::this_thread::get_id();
+    return asset;
+  }
+};
+
+template <>
+struct ResourceLoader<PlainAsset> {
+  static const bool exists = true;
+  static std::shared_ptr<PlainAsset> LoadResource (const std::string &name, ResourceManager<PlainAsset> &calling_manager) {
+    ++s_load_count;
+    std::shared_ptr<PlainAsset> asset(std::make_shared<PlainAsset>());
+    asset->name = name;
+    asset->loaded_on = std::this_thread::get_id();
+    return asset;
+  }
+  static ResourceByteCount ByteCount (const PlainAsset &asset) {
+    return ResourceByteCount(100, 1000);
+  }
+};
+
+static_assert(ResourceLoaderHasDecodeStage<DecodedAsset>::value, "DecodedAsset's loader has a decoding stage");
+static_assert(!ResourceLoaderHasDecodeStage<PlainAsset>::value, "PlainAsset's loader has no decoding stage");
+static_assert(ResourceLoaderHasByteCount<PlainAsset>::value, "PlainAsset's loader reports byte counts");
+static_assert(!ResourceLoaderHasByteCount<DecodedAsset>::value, "DecodedAsset's loader doesn't report byte counts");
+
+class ResourceManagerTest : public testing::Test {
+protected:
+
+  virtual void SetUp () override {
+    // Drop anything left by another test.
+    ResourceFinishQueue::Shared().RunFor(std::chrono::seconds(1));
+    s_decode_count = 0;
+    s_load_count = 0;
+  }
+
+  // Runs the render thread's part of loading until the future is ready (or a timeout elapses).
+  template <typename T>
+  static bool FinishOnThisThread (const std::shared_future<std::shared_ptr<T>> &result) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+      if (std::chrono::steady_clock::now() > deadline) {
+        return false;
+      }
+      ResourceFinishQueue::Shared().RunFor();
+      std::this_thread::yield();
+    }
+    return true;
+  }
+};
+
+TEST_F(ResourceManagerTest, ConcurrentGetsLoadOnce) {
+  ResourceManager<DecodedAsset> manager;
+  std::vector<std::shared_ptr<DecodedAsset>> results(8);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < results.size(); ++i) {
+    threads.emplace_back([i, &manager, &results]() { results[i] = manager.Get("shared"); });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(1, s_decode_count.load());
+  for (const std::shared_ptr<DecodedAsset> &result : results) {
+    EXPECT_EQ(results[0], result);
+  }
+  EXPECT_EQ(1u, manager.Resources().size());
+  EXPECT_EQ(0u, manager.PendingCount());
+}
+
+TEST_F(ResourceManagerTest, GetAsyncDecodesOnAWorkerAndFinishesOnTheRenderThread) {
+  ResourceManager<DecodedAsset> manager;
+  ResourceManager<DecodedAsset>::FutureResource result(manager.GetAsync("texture"));
+  // A second request shares the load.
+  ResourceManager<DecodedAsset>::FutureResource again(manager.GetAsync("texture"));
+  ASSERT_TRUE(FinishOnThisThread(result));
+  std::shared_ptr<DecodedAsset> asset(result.get());
+  ASSERT_TRUE(asset != nullptr);
+  EXPECT_EQ("texture", asset->name);
+  EXPECT_EQ(std::this_thread::get_id(), asset->finished_on);
+  EXPECT_EQ(asset, again.get());
+  EXPECT_EQ(1, s_decode_count.load());
+  EXPECT_EQ(asset, manager.Get("texture"));
+
+  // Once loaded, the result is ready immediately.
+  ResourceManager<DecodedAsset>::FutureResource loaded(manager.GetAsync("texture"));
+  EXPECT_EQ(std::future_status::ready, loaded.wait_for(std::chrono::seconds(0)));
+  EXPECT_EQ(asset, loaded.get());
+}
+
+TEST_F(ResourceManagerTest, GetCompletesAPendingAsyncLoad) {
+  // The worker's task for the load may still be queued when Get returns, and the manager must
+  // outlive it.
+  static ResourceManager<DecodedAsset> manager;
+  ResourceManager<DecodedAsset>::FutureResource result(manager.GetAsync("urgent"));
+  // Get doesn't wait for ResourceFinishQueue (which would deadlock on the render thread).
+  std::shared_ptr<DecodedAsset> asset(manager.Get("urgent"));
+  ASSERT_EQ(std::future_status::ready, result.wait_for(std::chrono::seconds(0)));
+  EXPECT_EQ(asset, result.get());
+  EXPECT_EQ(1, s_decode_count.load());
+  // The queued finishing stage has nothing left to do.
+  ResourceFinishQueue::Shared().RunFor(std::chrono::seconds(1));
+  EXPECT_EQ(asset, manager.Get("urgent"));
+}
+
+TEST_F(ResourceManagerTest, FailedLoadsAreReportedAndRetried) {
+  ResourceManager<DecodedAsset> manager;
+  ResourceManager<DecodedAsset>::FutureResource result(manager.GetAsync("missing"));
+  ASSERT_TRUE(FinishOnThisThread(result));
+  EXPECT_THROW(result.get(), ResourceExceptionOfType<DecodedAsset>);
+  EXPECT_EQ(0u, manager.PendingCount());
+  EXPECT_TRUE(manager.Resources().empty());
+
+  EXPECT_THROW(manager.Get("missing"), ResourceExceptionOfType<DecodedAsset>);
+  EXPECT_EQ(2, s_decode_count.load());
+}
+
+TEST_F(ResourceManagerTest, LoaderWithoutDecodeStageRunsOnTheRenderThread) {
+  ResourceManager<PlainAsset> manager;
+  ResourceManager<PlainAsset>::FutureResource result(manager.GetAsync("shader"));
+  EXPECT_EQ(0, s_load_count.load());
+  EXPECT_EQ(1u, manager.PendingCount());
+  ASSERT_TRUE(FinishOnThisThread(result));
+  EXPECT_EQ(1, s_load_count.load());
+  EXPECT_EQ(std::this_thread::get_id(), result.get()->loaded_on);
+}
+
+TEST_F(ResourceManagerTest, AddResourceRejectsLoadedNames) {
+  ResourceManager<PlainAsset> manager;
+  manager.AddResource("fallback", std::make_shared<PlainAsset>());
+  EXPECT_THROW(manager.AddResource("fallback", std::make_shared<PlainAsset>()), ResourceExceptionOfType<PlainAsset>);
+  ResourceManager<PlainAsset>::FutureResource result(manager.GetAsync("loading"));
+  EXPECT_THROW(manager.AddResource("loading", std::make_shared<PlainAsset>()), ResourceExceptionOfType<PlainAsset>);
+  // The manager must outlive its loads.
+  EXPECT_TRUE(FinishOnThisThread(result));
+}
+
+TEST_F(ResourceManagerTest, FinishQueueKeepsToItsBudget) {
+  ResourceFinishQueue queue;
+  int run_count = 0;
+  for (int i = 0; i < 10; ++i) {
+    queue.Post([&run_count]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      ++run_count;
+    });
+  }
+  // Each call runs at least one task, but stops once its budget has been spent.
+  EXPECT_EQ(1u, queue.RunFor(std::chrono::microseconds(1000)));
+  EXPECT_EQ(1, run_count);
+  EXPECT_EQ(9u, queue.PendingCount());
+  EXPECT_EQ(9u, queue.RunFor(std::chrono::seconds(10)));
+  EXPECT_EQ(0u, queue.PendingCount());
+  EXPECT_EQ(0u, queue.RunFor());
+}
+
+TEST_F(ResourceManagerTest, ReportsHitRateAndResidentBytes) {
+  ResourceManager<PlainAsset> manager;
+  manager.Get("a");
+  manager.Get("a");
+  manager.Get("b");
+  manager.GetAsync("a");
+  const ResourceCacheStatistics statistics(manager.Statistics());
+  EXPECT_EQ(2u, statistics.hit_count);
+  EXPECT_EQ(2u, statistics.miss_count);
+  EXPECT_DOUBLE_EQ(0.5, statistics.HitRate());
+  EXPECT_EQ(2u, statistics.resident_count);
+  EXPECT_EQ(200u, statistics.resident_bytes.cpu_bytes);
+  EXPECT_EQ(2000u, statistics.resident_bytes.gpu_bytes);
+  EXPECT_EQ(0u, statistics.eviction_count);
+}
+
+TEST_F(ResourceManagerTest, EvictsLeastRecentlyUsedUnreferencedResources) {
+  ResourceManager<PlainAsset> manager;
+  manager.SetBudget(ResourceByteCount(300, 3000));
+  std::shared_ptr<PlainAsset> in_use(manager.Get("in use"));
+  manager.Get("old");
+  manager.Get("recent");
+  manager.Get("in use");
+  EXPECT_EQ(3u, manager.Statistics().resident_count);
+
+  // A fourth resource exceeds the budget, so the least recently requested unused one goes
+  // (even though "in use" was requested before it).
+  manager.Get("new");
+  ResourceManager<PlainAsset>::ResourceMap resources(manager.Resources());
+  EXPECT_EQ(3u, resources.size());
+  EXPECT_EQ(0u, resources.count("old"));
+  EXPECT_EQ(in_use, resources["in use"]);
+  EXPECT_EQ(1u, manager.Statistics().eviction_count);
+  EXPECT_EQ(300u, manager.Statistics().resident_bytes.cpu_bytes);
+
+  // Requesting an evicted resource reloads it.
+  s_load_count = 0;
+  std::shared_ptr<PlainAsset> old(manager.Get("old"));
+  EXPECT_EQ(1, s_load_count.load());
+  EXPECT_EQ("old", old->name);
+
+  // Shrinking the budget releases what it can; everything still referenced stays.
+  resources.clear();
+  manager.SetBudget(ResourceByteCount(0, 0));
+  resources = manager.Resources();
+  EXPECT_EQ(2u, resources.size());
+  EXPECT_EQ(1u, resources.count("in use"));
+  EXPECT_EQ(1u, resources.count("old"));
+  resources.clear();
+  in_use.reset();
+  EXPECT_EQ(1u, manager.Trim());
+  EXPECT_EQ(1u, manager.Statistics().resident_count);
+}
+
+TEST_F(ResourceManagerTest, AddedResourcesAreNeverEvicted) {
+  ResourceManager<PlainAsset> manager;
+  manager.SetBudget(ResourceByteCount(0, 0));
+  manager.AddResource("fallback", std::make_shared<PlainAsset>());
+  // A resource is in use while it's being returned, so it's only evicted by a later check.
+  manager.Get("loaded");
+  EXPECT_EQ(1u, manager.Trim());
+  ResourceManager<PlainAsset>::ResourceMap resources(manager.Resources());
+  EXPECT_EQ(1u, resources.size());
+  EXPECT_EQ(1u, resources.count("fallback"));
+}
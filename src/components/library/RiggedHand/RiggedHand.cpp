@@ -4,6 +4,7 @@
 #include "ModelIo.h"
 #include "ModelSourceAssimp.h"
 
+#include <algorithm>
 #include <cmath>
 #include <assert.h>
 
@@ -54,6 +55,7 @@ RiggedHand::RiggedHand() {
   mSkinTone = MEDIUM;
   mPrevGender = NUM_GENDERS;
   mPrevSkinTone = NUM_SKIN_TONES;
+  mSkinningMode = model::SkinnedVboMesh::GPU_SKINNING;
 
   setOffsetsForGender();
 
@@ -108,12 +110,19 @@ void RiggedHand::SetBoneLength(int fingerIdx, int boneIdx, float length) {
   mBoneLengths[fingerIdx][boneIdx] = length;
 }
 
+void RiggedHand::SetSkinningMode(model::SkinnedVboMesh::SkinningMode mode) {
+  mSkinningMode = mode;
+  if (mSkinnedVboHands) {
+    mSkinnedVboHands->setSkinningMode(mode);
+  }
+}
+
 void RiggedHand::UpdateRigAndSkin() {
   updateStyle();
   updateIntermediateData();
 
-  model::NodeRef armNode = getArmNode();
-  model::NodeRef wristNode = getWristNode();
+  const model::NodeRef& armNode = getArmNode();
+  const model::NodeRef& wristNode = getWristNode();
 
   armNode->setRelativeRotation(mArmRotation.cast<float>());
   armNode->setRelativePosition(mElbowPos);
@@ -133,16 +142,14 @@ void RiggedHand::MakeAdditionalModelViewTransformations(ModelView& model_view) c
 
 void RiggedHand::DrawContents(RenderState& renderState) const {
   if (!mHandsShader) {
-    mHandsShader = getDefaultHandsShader();
+    mHandsShader = getDefaultHandsShader(mSkinningMode);
   }
 
   std::vector<model::MeshVboSectionRef>& sections = mSkinnedVboHands->getSections();
   if (mEnableWireframe) {
     glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
   }
-  const int startIdx = mGender == MALE ? 1 : 2;
-  const int numSections = mGender == MALE ? 1 : 2;
-  for (int sectionIdx = startIdx; sectionIdx < (startIdx + numSections); sectionIdx++) {
+  for (int sectionIdx : drawnSectionIndices()) {
     model::MeshVboSectionRef section = sections[sectionIdx];
     if (section->hasDefaultTransformation()) {
       renderState.GetModelView().Push();
@@ -170,7 +177,9 @@ void RiggedHand::DrawContents(RenderState& renderState) const {
 
       GLShaderMatrices::UploadUniforms(*mHandsShader, renderState.GetModelView().Matrix(), renderState.GetProjection().Matrix(), BindFlags::NONE);
 
-      mHandsShader->SetUniformi("isAnimated", section->isAnimated());
+      // a section which was skinned on the CPU must not be skinned again by the shader
+      const bool cpuSkinned = section->isCpuSkinned();
+      mHandsShader->SetUniformi("isAnimated", section->isAnimated() && !cpuSkinned);
       mHandsShader->SetUniformi("use_texture", 1);
       mHandsShader->SetUniformi("texture", 0);
       mHandsShader->SetUniformi("useNormalMap", mUseNormalMap);
@@ -184,12 +193,18 @@ void RiggedHand::DrawContents(RenderState& renderState) const {
       mHandsShader->SetUniformf("ambient_lighting_proportion", 0.0f);
       mHandsShader->SetUniformf("shininess", mShininess);
 
-      if (section->hasSkeleton()) {
+      const bool usesBonePalette = section->hasSkeleton() && !cpuSkinned && mSkinnedVboHands->usesBonePalette();
+      if (usesBonePalette) {
+        mSkinnedVboHands->getBonePalette().bind(BONE_PALETTE_TEXTURE_UNIT);
+        mHandsShader->SetUniformi("bonePalette", BONE_PALETTE_TEXTURE_UNIT);
+      } else if (section->hasSkeleton() && !cpuSkinned) {
         const int boneMatricesAddr = mHandsShader->LocationOfUniform("boneMatrices[0]");
         const int invTransposeMatricesAddr = mHandsShader->LocationOfUniform("invTransposeMatrices[0]");
+        // the uniform arrays only have room for MAXBONES bones
+        const int numBones = std::min(static_cast<int>(section->mBoneMatricesPtr->size()), static_cast<int>(model::SkinnedVboMesh::MAXBONES));
 
-        glUniformMatrix4fv(boneMatricesAddr, model::SkinnedVboMesh::MAXBONES, false, section->mBoneMatricesPtr->data()->data());
-        glUniformMatrix4fv(invTransposeMatricesAddr, model::SkinnedVboMesh::MAXBONES, false, section->mInvTransposeMatricesPtr->data()->data());
+        glUniformMatrix4fv(boneMatricesAddr, numBones, false, section->mBoneMatricesPtr->data()->data());
+        glUniformMatrix4fv(invTransposeMatricesAddr, numBones, false, section->mInvTransposeMatricesPtr->data()->data());
       }
 
       const int positionAddr = mHandsShader->LocationOfAttribute("position");
@@ -198,15 +213,24 @@ void RiggedHand::DrawContents(RenderState& renderState) const {
       const int boneWeightsAddr = mHandsShader->LocationOfAttribute("boneWeights");
       const int boneIndicesAddr = mHandsShader->LocationOfAttribute("boneIndices");
 
-      auto locations = std::make_tuple(positionAddr, normalAddr, texcoordAddr, boneWeightsAddr, boneIndicesAddr);
+      // when skinned on the CPU, the positions and normals come from the skinned vertex buffer
+      auto locations = cpuSkinned ? std::make_tuple(-1, -1, texcoordAddr, -1, -1) :
+                                    std::make_tuple(positionAddr, normalAddr, texcoordAddr, boneWeightsAddr, boneIndicesAddr);
+      auto skinnedLocations = cpuSkinned ? std::make_tuple(positionAddr, normalAddr) : std::make_tuple(-1, -1);
       section->getVboMesh().Enable(locations);
+      if (cpuSkinned) {
+        section->getSkinnedVboMesh().Enable(skinnedLocations);
+      }
 
-      const int numIndices = static_cast<int>(section->getIndices().Size())/sizeof(uint32_t);
       section->getIndices().Bind();
-      GL_THROW_UPON_ERROR(glDrawElements(GL_TRIANGLES, numIndices, GL_UNSIGNED_INT, 0));
+      GL_THROW_UPON_ERROR(glDrawElements(GL_TRIANGLES, section->getNumIndices(), section->getIndexType(), 0));
       section->getIndices().Unbind();
 
       section->getVboMesh().Disable(locations);
+      model::SkinnedVertexBuffer::Disable(skinnedLocations);
+      if (usesBonePalette) {
+        mSkinnedVboHands->getBonePalette().unbind(BONE_PALETTE_TEXTURE_UNIT);
+      }
       mHandsShader->Unbind();
     }
 
@@ -231,6 +255,8 @@ void RiggedHand::updateStyle() {
   // load new mesh if necessary
   if (mGender != mPrevGender) {
     mSkinnedVboHands = getMeshForGender(mGender);
+    mSkinnedVboHands->setSkinningMode(mSkinningMode);
+    bindJoints();
     setOffsetsForGender();
 
     mSkinnedVboHands->update();
@@ -303,7 +329,7 @@ void RiggedHand::updateFinger(int fingerIdx) {
     const Eigen::Matrix3d& boneBasis = mBoneBases[fingerIdx][boneIdx+1];
 
     const Eigen::Quaterniond boneQuat = toQuat(boneBasis, mIsLeft) * mFingerReorientation;
-    model::NodeRef boneNode = getJointNode(fingerIdx, boneIdx);
+    const model::NodeRef& boneNode = getJointNode(fingerIdx, boneIdx);
     boneNode->setRelativeRotation((prevQuat.inverse() * boneQuat).cast<float>());
 
     const int minBoneToAdjust = fingerIdx == 0 ? 2 : 1;
@@ -321,7 +347,6 @@ void RiggedHand::updateFinger(int fingerIdx) {
 
 void RiggedHand::updateMeshMirroring(bool left) {
   std::vector<model::MeshVboSectionRef>& sections = mSkinnedVboHands->getSections();
-  assert(sections.size() > 1);
   Eigen::Matrix4f transform = Eigen::Matrix4f::Identity();
   if (left) {
     Eigen::Matrix4f translation = Eigen::Matrix4f::Identity();
@@ -331,15 +356,23 @@ void RiggedHand::updateMeshMirroring(bool left) {
     translation.col(3) << -mElbowPos.x(), -mElbowPos.y(), -mElbowPos.z(), 1.0f;
     transform = (transform * translation).eval();
   }
-  if (mGender == MALE) {
-    model::SkinnedVboMesh::MeshVboSectionRef& modelSection = sections[1];
-    modelSection->setDefaultTransformation(transform);
-  } else if (mGender == FEMALE) {
-    model::SkinnedVboMesh::MeshVboSectionRef& modelSection = sections[2];
-    model::SkinnedVboMesh::MeshVboSectionRef& nailsSection = sections[3];
-    modelSection->setDefaultTransformation(transform);
-    nailsSection->setDefaultTransformation(transform);
+  for (int sectionIdx : drawnSectionIndices()) {
+    sections[sectionIdx]->setDefaultTransformation(transform);
+  }
+}
+
+std::vector<int> RiggedHand::drawnSectionIndices() const {
+  // the male model's hand is its section 1, and the female model's hand and nails are sections 2 and 3
+  const int startIdx = mGender == MALE ? 1 : 2;
+  const int numSections = mGender == MALE ? 1 : 2;
+  std::vector<int> indices;
+  for (int sourceIdx = startIdx; sourceIdx < (startIdx + numSections); sourceIdx++) {
+    const int sectionIdx = mSkinnedVboHands->getMergedSectionIndex(sourceIdx);
+    if (std::find(indices.begin(), indices.end(), sectionIdx) == indices.end()) {
+      indices.push_back(sectionIdx);
+    }
   }
+  return indices;
 }
 
 void RiggedHand::setOffsetsForGender() {
@@ -354,16 +387,33 @@ void RiggedHand::setOffsetsForGender() {
   }
 }
 
-model::NodeRef RiggedHand::getArmNode() const {
-  const int childIdx = mGender == MALE ? 2 : 3;
-  return mSkinnedVboHands->getSkeleton()->getRootNode()->getChildren()[childIdx];
-}
-
-model::NodeRef RiggedHand::getWristNode() const {
-  return mSkinnedVboHands->getSkeleton()->getNode("Bip01 R Hand");
+void RiggedHand::bindJoints() {
+  // Every joint is posed on each update, so a model missing any of them (e.g. a stale or
+  // mismatched conversion) can't be drawn; fail here rather than dereference null nodes later.
+  const model::SkeletonRef& skeleton = mSkinnedVboHands->getSkeleton();
+  const int armChildIdx = mGender == MALE ? 2 : 3;
+  const std::vector<model::NodeRef>& rootChildren = skeleton->getRootNode()->getChildren();
+  if (armChildIdx >= static_cast<int>(rootChildren.size())) {
+    throw model::LoadErrorException("Hand model has no arm joint.");
+  }
+  mJointNodes[ARM_JOINT] = rootChildren[armChildIdx];
+  mJointNodes[WRIST_JOINT] = skeleton->getNode("Bip01 R Hand");
+  if (!mJointNodes[WRIST_JOINT]) {
+    throw model::LoadErrorException("Hand model has no wrist joint.");
+  }
+  for (int fingerIdx=0; fingerIdx<5; fingerIdx++) {
+    for (int boneIdx=0; boneIdx<3; boneIdx++) {
+      const std::string& jointName = getJointName(fingerIdx, boneIdx);
+      const int boneIndex = skeleton->getBoneIndex(jointName);
+      if (boneIndex < 0) {
+        throw model::LoadErrorException("Hand model has no bone \"" + jointName + "\".");
+      }
+      mJointNodes[FIRST_FINGER_JOINT + fingerIdx*3 + boneIdx] = skeleton->getBone(boneIndex);
+    }
+  }
 }
 
-model::NodeRef RiggedHand::getJointNode(int fingerIdx, int boneIdx) const {
+const std::string& RiggedHand::getJointName(int fingerIdx, int boneIdx) {
   static const std::string leftNames[] ={
     "Bip01 R Finger043",
     "Bip01 R Finger044",
@@ -400,33 +450,45 @@ model::NodeRef RiggedHand::getJointNode(int fingerIdx, int boneIdx) const {
   };
 
   const int boneNameIdx = fingerIdx*3 + boneIdx;
-  const std::string& boneName = rightNames[boneNameIdx];
-  return mSkinnedVboHands->getSkeleton()->getBone(boneName);
+  return rightNames[boneNameIdx];
 }
 
-GLShaderRef RiggedHand::getDefaultHandsShader() {
+GLShaderRef RiggedHand::getDefaultHandsShader(model::SkinnedVboMesh::SkinningMode mode) {
   static GLShaderRef handsShader;
-  if (handsShader == nullptr) {
+  static GLShaderRef paletteHandsShader;
+  // without texture buffers the mesh falls back to the bone matrix uniforms
+  const bool usePalette = mode == model::SkinnedVboMesh::GPU_PALETTE_SKINNING && model::BonePalette::isSupported();
+  GLShaderRef& shader = usePalette ? paletteHandsShader : handsShader;
+  if (shader == nullptr) {
     std::shared_ptr<TextFile> lightingFrag(new TextFile("shaders/lighting-frag.glsl"));
-    std::shared_ptr<TextFile> lightingVert(new TextFile("shaders/lighting-vert.glsl"));
-    handsShader = std::shared_ptr<GLShader>(new GLShader(lightingVert->Contents(), lightingFrag->Contents()));
+    std::shared_ptr<TextFile> lightingVert(new TextFile(usePalette ? "shaders/lighting-palette-vert.glsl" : "shaders/lighting-vert.glsl"));
+    shader = std::shared_ptr<GLShader>(new GLShader(lightingVert->Contents(), lightingFrag->Contents()));
   }
-  return handsShader;
+  return shader;
 }
 
 model::SkinnedVboMeshRef RiggedHand::getMeshForGender(Gender gender) {
   static model::ModelSourceRef maleMeshSource;
   static model::ModelSourceRef femaleMeshSource;
+  // merge the sections which are drawn together (the female hand and nails) when they share a
+  // material, keeping the others apart (so that they're uploaded straight from a binary model)
+  model::SkinnedVboMesh::LoadOptions options;
+  options.mMergeSections = true;
+  options.mOptimizeVertexCache = true;
+  options.mSectionGroups.push_back(0);
+  options.mSectionGroups.push_back(1);
+  options.mSectionGroups.push_back(2);
+  options.mSectionGroups.push_back(gender == FEMALE ? 2 : 3);
   if (gender == MALE) {
     if (maleMeshSource == nullptr) {
-      maleMeshSource = model::loadModel("models/Male_Rigged_Arm.FBX", "", UNIT_CONVERSION_SCALE_FACTOR);
+      maleMeshSource = model::loadCachedModel("models/Male_Rigged_Arm.FBX", "", UNIT_CONVERSION_SCALE_FACTOR);
     }
-    return model::SkinnedVboMesh::create(maleMeshSource, nullptr);
+    return model::SkinnedVboMesh::create(maleMeshSource, nullptr, options);
   } else if (gender == FEMALE) {
     if (femaleMeshSource == nullptr) {
-      femaleMeshSource = model::loadModel("models/Female_Rigged_Arm.FBX", "", UNIT_CONVERSION_SCALE_FACTOR);
+      femaleMeshSource = model::loadCachedModel("models/Female_Rigged_Arm.FBX", "", UNIT_CONVERSION_SCALE_FACTOR);
     }
-    return model::SkinnedVboMesh::create(femaleMeshSource, nullptr);
+    return model::SkinnedVboMesh::create(femaleMeshSource, nullptr, options);
   } else {
     assert(0);
     return nullptr;
@@ -8,6 +8,7 @@
 #include "PrimitiveBase.h"
 
 #include <memory>
+#include <string>
 
 class RiggedHand : public PrimitiveBase {
 public:
@@ -30,6 +31,10 @@ public:
   void SetBoneBasis(int fingerIdx, int boneIdx, const Eigen::Matrix3f& basis);
   void SetBoneLength(int fingerIdx, int boneIdx, float length);
 
+  // skinning on the CPU is faster than in the vertex shader on software GL (e.g. llvmpipe);
+  // GPU_PALETTE_SKINNING needs a hands shader which reads the bone palette (see getDefaultHandsShader)
+  void SetSkinningMode(model::SkinnedVboMesh::SkinningMode mode);
+
   // after setting data call Update to transfer data to rig/skin
   void UpdateRigAndSkin();
 
@@ -38,7 +43,8 @@ public:
   void SetHandsShader(const GLShaderRef& shader) { mHandsShader = shader; };
   GLShaderRef HandsShader() { return mHandsShader; };
 
-  static GLShaderRef getDefaultHandsShader();
+  // the shader for the given skinning mode; GPU_PALETTE_SKINNING needs a shader which reads the bone palette
+  static GLShaderRef getDefaultHandsShader(model::SkinnedVboMesh::SkinningMode mode = model::SkinnedVboMesh::GPU_SKINNING);
 
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
@@ -49,15 +55,22 @@ protected:
 private:
 
   enum TextureMap { DIFFUSE, NORMAL, SPECULAR, NUM_TEXTURE_MAPS };
+  // texture unit of the bone palette, after the texture maps
+  static const int BONE_PALETTE_TEXTURE_UNIT = NUM_TEXTURE_MAPS;
+  // slots of the joints driven by Leap data, with 3 for each finger
+  enum Joint { ARM_JOINT, WRIST_JOINT, FIRST_FINGER_JOINT, NUM_JOINTS = FIRST_FINGER_JOINT + 5*3 };
 
   void updateStyle();
   void updateIntermediateData();
   void updateFinger(int fingerIdx);
   void updateMeshMirroring(bool left);
   void setOffsetsForGender();
-  model::NodeRef getArmNode() const;
-  model::NodeRef getWristNode() const;
-  model::NodeRef getJointNode(int fingerIdx, int boneIdx) const;
+  void bindJoints();
+  std::vector<int> drawnSectionIndices() const;
+  const model::NodeRef& getArmNode() const { return mJointNodes[ARM_JOINT]; }
+  const model::NodeRef& getWristNode() const { return mJointNodes[WRIST_JOINT]; }
+  const model::NodeRef& getJointNode(int fingerIdx, int boneIdx) const { return mJointNodes[FIRST_FINGER_JOINT + fingerIdx*3 + boneIdx]; }
+  static const std::string& getJointName(int fingerIdx, int boneIdx);
 
   static model::SkinnedVboMeshRef getMeshForGender(Gender gender);
   static GLTexture2ImageRef getTexture(Gender gender, SkinTone tone, TextureMap texture);
@@ -113,6 +126,9 @@ private:
   Gender mPrevGender;
   SkinTone mPrevSkinTone;
   model::SkinnedVboMeshRef mSkinnedVboHands;
+  model::SkinnedVboMesh::SkinningMode mSkinningMode;
+  // joints of mSkinnedVboHands' skeleton, resolved by name once when the mesh is loaded
+  model::NodeRef mJointNodes[NUM_JOINTS];
 
   // textures for diffuse skin, normal map, and specular map
   GLTexture2ImageRef mSkinTex;
@@ -0,0 +1,121 @@
+#include "BonePalette.h"
+
+#include "GLError.h"
+#include "GLStateTracker.h"
+
+#include <cstring>
+
+namespace model {
+
+  // Uploading a few unchanged bones along with their neighbors is cheaper than another call.
+  static const size_t MAX_UNCHANGED_BONES_IN_RANGE = 4;
+
+  BonePalette::BonePalette()
+    : mTexture(0)
+    , mNumBones(0)
+  { }
+
+  BonePalette::~BonePalette()
+  {
+    if (mTexture != 0) {
+      GLStateTracker::Current().TextureDeleted(mTexture);
+      glDeleteTextures(1, &mTexture);
+    }
+    mBuffer.Destroy();
+  }
+
+  bool BonePalette::isSupported()
+  {
+    // The palette shaders are GLSL 1.20, which needs EXT_gpu_shader4 for samplerBuffer and
+    // texelFetchBuffer even where GL 3.1 provides texture buffers.
+    return (GLEW_VERSION_3_1 || GLEW_ARB_texture_buffer_object) && GLEW_EXT_gpu_shader4;
+  }
+
+  void BonePalette::update(const Eigen::Matrix4f* boneMatrices, const Eigen::Matrix4f* invTransposeMatrices, size_t numBones)
+  {
+    const bool resized = numBones != mNumBones;
+    if (resized) {
+      mUploaded.assign(numBones*FLOATS_PER_BONE, 0.0f);
+    }
+
+    // Write the bones into mUploaded (which becomes what's uploaded), noting runs of changed ones.
+    size_t rangeBegin = 0;
+    size_t rangeEnd = 0; // empty if equal to rangeBegin
+    for (size_t b=0; b<numBones; b++) {
+      float* bone = &mUploaded[b*FLOATS_PER_BONE];
+      // Eigen matrices are column-major, so each one is already 4 columns (texels) in a row.
+      const bool changed = resized ||
+        memcmp(bone, boneMatrices[b].data(), 16*sizeof(float)) != 0 ||
+        memcmp(bone + 16, invTransposeMatrices[b].data(), 16*sizeof(float)) != 0;
+      if (!changed) {
+        mCounters.mBonesUnchanged++;
+        continue;
+      }
+      memcpy(bone, boneMatrices[b].data(), 16*sizeof(float));
+      memcpy(bone + 16, invTransposeMatrices[b].data(), 16*sizeof(float));
+      if (resized) {
+        continue; // all of them are uploaded below
+      }
+      if (rangeEnd > rangeBegin && b - rangeEnd > MAX_UNCHANGED_BONES_IN_RANGE) {
+        upload(rangeBegin, rangeEnd - rangeBegin);
+        rangeBegin = b;
+      } else if (rangeEnd == rangeBegin) {
+        rangeBegin = b;
+      }
+      rangeEnd = b + 1;
+    }
+
+    if (resized) {
+      if (!mBuffer.IsCreated()) {
+        mBuffer.Create(GL_TEXTURE_BUFFER);
+        glGenTextures(1, &mTexture);
+      }
+      mBuffer.Bind();
+      mBuffer.Allocate(mUploaded.data(), static_cast<GLsizeiptr>(mUploaded.size()*sizeof(float)), GL_DYNAMIC_DRAW);
+      mBuffer.Unbind();
+      GLStateTracker &tracker = GLStateTracker::Current();
+      tracker.BindTexture(GL_TEXTURE_BUFFER, mTexture);
+      if (GLEW_VERSION_3_1) {
+        GL_THROW_UPON_ERROR(glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, mBuffer.Address()));
+      } else {
+        GL_THROW_UPON_ERROR(glTexBufferARB(GL_TEXTURE_BUFFER, GL_RGBA32F, mBuffer.Address()));
+      }
+      tracker.BindTexture(GL_TEXTURE_BUFFER, 0);
+      mNumBones = numBones;
+      mCounters.mUploads++;
+      mCounters.mBonesUploaded += numBones;
+      mCounters.mBytesUploaded += mUploaded.size()*sizeof(float);
+    } else if (rangeEnd > rangeBegin) {
+      upload(rangeBegin, rangeEnd - rangeBegin);
+    }
+  }
+
+  void BonePalette::upload(size_t firstBone, size_t numBones)
+  {
+    const size_t offset = firstBone*FLOATS_PER_BONE*sizeof(float);
+    const size_t size = numBones*FLOATS_PER_BONE*sizeof(float);
+    mBuffer.Bind();
+    mBuffer.Write(&mUploaded[firstBone*FLOATS_PER_BONE], static_cast<int>(size), static_cast<GLintptr>(offset));
+    mBuffer.Unbind();
+    mCounters.mUploads++;
+    mCounters.mBonesUploaded += numBones;
+    mCounters.mBytesUploaded += size;
+  }
+
+  void BonePalette::bind(int textureUnit) const
+  {
+    GLStateTracker &tracker = GLStateTracker::Current();
+    tracker.ActiveTexture(GL_TEXTURE0 + textureUnit);
+    tracker.BindTexture(GL_TEXTURE_BUFFER, mTexture);
+    tracker.ActiveTexture(GL_TEXTURE0);
+  }
+
+  void BonePalette::unbind(int textureUnit) const
+  {
+    GLStateTracker &tracker = GLStateTracker::Current();
+    tracker.ActiveTexture(GL_TEXTURE0 + textureUnit);
+    tracker.BindTexture(GL_TEXTURE_BUFFER, 0);
+    tracker.ActiveTexture(GL_TEXTURE0);
+  }
+
+} //end namespace model
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "GLBuffer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "EigenTypes.h"
+
+namespace model {
+
+  /*!
+   *  The bone matrices and inverse transposed bone matrices of a SkinnedVboMesh, in a texture
+   *  buffer (GL 3.1 or ARB_texture_buffer_object) from which the skinning vertex shader fetches
+   *  them (see RiggedHandSample's lighting-palette-vert.glsl).  Unlike the uniform arrays this
+   *  isn't limited to SkinnedVboMesh::MAXBONES, and each update only uploads the bones which
+   *  changed since the last one.
+   *
+   *  Each bone takes TEXELS_PER_BONE RGBA32F texels: the columns of its bone matrix followed by
+   *  those of its inverse transposed bone matrix.
+   */
+  class BonePalette {
+  public:
+    static const int TEXELS_PER_BONE = 8;
+
+    struct Counters {
+      Counters() : mUploads(0), mBonesUploaded(0), mBonesUnchanged(0), mBytesUploaded(0) { }
+      //! The number of glBufferSubData (or glBufferData, when resizing) calls.
+      uint64_t mUploads;
+      uint64_t mBonesUploaded;
+      uint64_t mBonesUnchanged;
+      uint64_t mBytesUploaded;
+    };
+
+    //! No GL calls are made until the first update.
+    BonePalette();
+    ~BonePalette();
+
+    //! Returns true iff the current GL context supports texture buffers, and the EXT_gpu_shader4
+    //! functions which the palette shaders read them with.
+    static bool isSupported();
+
+    /*!
+     *  Uploads the bones whose matrices differ from the previous update's.  Runs of changed bones
+     *  are each uploaded as one range, and runs separated by only a few unchanged bones are merged
+     *  (which costs less than the extra calls).  Changing the number of bones reuploads them all.
+     */
+    void update(const Eigen::Matrix4f* boneMatrices, const Eigen::Matrix4f* invTransposeMatrices, size_t numBones);
+
+    //! Binds the palette to GL_TEXTURE_BUFFER on the given texture unit, for the shader's samplerBuffer.
+    void bind(int textureUnit) const;
+    void unbind(int textureUnit) const;
+
+    size_t getNumBones() const { return mNumBones; }
+    const Counters& getCounters() const { return mCounters; }
+
+  private:
+    BonePalette(const BonePalette&); // not defined to prevent copying
+    BonePalette& operator=(const BonePalette&); // not defined to prevent copying
+
+    static const size_t FLOATS_PER_BONE = 4*TEXELS_PER_BONE;
+
+    void upload(size_t firstBone, size_t numBones);
+
+    GLBuffer mBuffer;
+    GLuint mTexture;
+    size_t mNumBones;
+    //! What was last uploaded, to find the bones which changed.
+    std::vector<float> mUploaded;
+    Counters mCounters;
+  };
+
+} //end namespace model
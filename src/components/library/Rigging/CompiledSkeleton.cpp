@@ -0,0 +1,96 @@
+#include "CompiledSkeleton.h"
+
+#include "Skeleton.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace model {
+
+  CompiledSkeleton::CompiledSkeleton(const Skeleton& skeleton)
+  {
+    std::unordered_map<const Node*, int> indices;
+    if (skeleton.getRootNode()) {
+      // Visit the hierarchy in pre-order, so that every parent precedes its children.
+      std::vector<std::pair<NodeRef, int>> stack(1, std::make_pair(skeleton.getRootNode(), -1));
+      while (!stack.empty()) {
+        const NodeRef node = stack.back().first;
+        const int parent = stack.back().second;
+        stack.pop_back();
+        const int index = static_cast<int>(mNodes.size());
+        indices[node.get()] = index;
+        mNodes.push_back(node);
+        mParents.push_back(parent);
+        const std::vector<NodeRef>& children = node->getChildren();
+        for (auto child = children.rbegin(); child != children.rend(); ++child) {
+          stack.push_back(std::make_pair(*child, index));
+        }
+      }
+    }
+
+    const std::vector<NodeRef>& bones = skeleton.getBones();
+    mBoneNodes.resize(bones.size(), -1);
+    for (size_t i=0; i<bones.size(); i++) {
+      auto entry = indices.find(bones[i].get());
+      if (entry != indices.end()) {
+        mBoneNodes[i] = entry->second;
+      }
+    }
+
+    mPositions.resize(mNodes.size());
+    mRotations.resize(mNodes.size());
+    mScales.resize(mNodes.size());
+  }
+
+  void CompiledSkeleton::evaluate(Eigen::Matrix4f* boneMatrices, Eigen::Matrix4f* invTransposeMatrices, size_t maxBones)
+  {
+    const size_t numNodes = mNodes.size();
+    for (size_t i=0; i<numNodes; i++) {
+      Node& node = *mNodes[i];
+      const int parent = mParents[i];
+      if (parent >= 0) {
+        const Eigen::Quaternionf& parentRotation = mRotations[parent];
+        const Eigen::Vector3f& parentScale = mScales[parent];
+        mRotations[i] = parentRotation * node.mRelativeRotation;
+        mScales[i] = node.mRelativeScale.cwiseProduct(parentScale);
+        mPositions[i] = parentRotation * parentScale.cwiseProduct(node.mRelativePosition) + mPositions[parent];
+      } else {
+        // As in Node::update, the root's relative position doesn't move it.
+        mRotations[i] = node.mRelativeRotation;
+        mScales[i] = node.mRelativeScale;
+        mPositions[i] = node.mAbsolutePosition;
+      }
+      node.mAbsoluteRotation = mRotations[i];
+      node.mAbsoluteScale = mScales[i];
+      node.mAbsolutePosition = mPositions[i];
+      node.mNeedsUpdate = false;
+    }
+
+    const size_t numBones = std::min(mBoneNodes.size(), maxBones);
+    for (size_t b=0; b<numBones; b++) {
+      const int i = mBoneNodes[b];
+      if (i < 0) {
+        boneMatrices[b].setIdentity();
+        invTransposeMatrices[b].setIdentity();
+        continue;
+      }
+      // Equivalent to Node::computeTransformation, without building the rotation as a 4x4 matrix.
+      Eigen::Matrix4f absolute;
+      absolute.topLeftCorner<3, 3>() = mRotations[i].toRotationMatrix() * mScales[i].asDiagonal();
+      absolute.topRightCorner<3, 1>() = mPositions[i];
+      absolute.row(3) << 0, 0, 0, 1;
+      const std::unique_ptr<Eigen::Matrix4f>& offset = mNodes[i]->mOffset;
+      Eigen::Matrix4f& boneMatrix = boneMatrices[b];
+      boneMatrix = offset ? (absolute * *offset).eval() : absolute;
+
+      // The bone matrices are affine, so their inverse transposes only need a 3x3 inverse.
+      const Eigen::Matrix3f inverse = boneMatrix.topLeftCorner<3, 3>().inverse();
+      Eigen::Matrix4f& invTranspose = invTransposeMatrices[b];
+      invTranspose.topLeftCorner<3, 3>() = inverse.transpose();
+      invTranspose.topRightCorner<3, 1>().setZero();
+      invTranspose.bottomLeftCorner<1, 3>() = -(inverse * boneMatrix.topRightCorner<3, 1>()).transpose();
+      invTranspose(3, 3) = 1.0f;
+    }
+  }
+
+} //end namespace model
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Node.h"
+
+#include <memory>
+#include <vector>
+
+#include "EigenTypes.h"
+
+namespace model {
+
+  class Skeleton;
+
+  /*!
+   *  A flattened copy of a Skeleton's node hierarchy, for evaluating its pose without walking the
+   *  hierarchy.  The nodes are stored in topological (pre-)order with the index of each one's
+   *  parent, which always precedes it, so that every absolute transformation is computed by a
+   *  single forward pass over flat arrays, and then every bone's skinning matrices by another.
+   *
+   *  The nodes stay the way poses are set (through Node::setRelativeRotation etc.), so their
+   *  relative transformations are read at the start of each evaluation.  This must be rebuilt if
+   *  the hierarchy changes, which Skeleton takes care of for its own.
+   */
+  class CompiledSkeleton {
+  public:
+    explicit CompiledSkeleton(const Skeleton& skeleton);
+
+    size_t getNumNodes() const { return mNodes.size(); }
+    const NodeRef& getNode(size_t index) const { return mNodes[index]; }
+    //! The index of the node's parent (which is less than index), or -1 for the root.
+    int getParentIndex(size_t index) const { return mParents[index]; }
+    size_t getNumBones() const { return mBoneNodes.size(); }
+
+    /*!
+     *  Evaluates the absolute transformations of all nodes, as Node::update would, and stores
+     *  them back in the nodes (so that their getAbsolute* methods needn't walk the hierarchy).
+     *  Then, for each of the first maxBones bones, it writes the bone's absolute transformation
+     *  times its offset matrix to boneMatrices, and that matrix's inverse transpose to
+     *  invTransposeMatrices, indexed by bone index as SkinnedVboMesh uploads them.
+     */
+    void evaluate(Eigen::Matrix4f* boneMatrices, Eigen::Matrix4f* invTransposeMatrices, size_t maxBones);
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  private:
+    typedef std::vector<Eigen::Quaternionf, Eigen::aligned_allocator<Eigen::Quaternionf>> Rotations;
+
+    std::vector<NodeRef> mNodes;
+    std::vector<int> mParents;
+    //! The index (in mNodes) of each bone's node, by bone index.
+    std::vector<int> mBoneNodes;
+
+    // The absolute transformations of the nodes, parallel to mNodes.
+    std::vector<Eigen::Vector3f> mPositions;
+    Rotations mRotations;
+    std::vector<Eigen::Vector3f> mScales;
+  };
+
+  typedef std::shared_ptr<CompiledSkeleton> CompiledSkeletonRef;
+
+} //end namespace model
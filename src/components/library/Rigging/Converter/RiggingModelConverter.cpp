@@ -0,0 +1,48 @@
+// Converts a rigged model (e.g. FBX or COLLADA) into the binary format which ModelSourceBinary
+// loads, so that applications don't have to parse it through Assimp at startup.  The scale
+// factor must be the one the application loads the model with (e.g.
+// RiggedHand::UNIT_CONVERSION_SCALE_FACTOR), and the output defaults to the path which
+// model::loadCachedModel looks for.  The model must be converted again whenever it (or
+// ModelBinaryFormat.h's FORMAT_VERSION) changes; until then, loadCachedModel ignores the stale
+// binary model and loads the model through Assimp.
+
+#include "ModelIo.h"
+#include "ModelSourceAssimp.h"
+#include "ModelSourceBinary.h"
+#include "ModelTargetBinary.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+int main (int argc, char **argv)
+{
+  if (argc < 3 || argc > 4) {
+    std::cerr << "usage: " << argv[0] << " <model path> <scale factor> [<output path>]" << std::endl;
+    return 1;
+  }
+  const std::string modelPath(argv[1]);
+  const float scaleFactor = static_cast<float>(std::atof(argv[2]));
+  const std::string outputPath = (argc == 4) ? std::string(argv[3]) : model::binaryModelPath(modelPath);
+  if (scaleFactor <= 0.0f) {
+    std::cerr << "invalid scale factor \"" << argv[2] << "\"" << std::endl;
+    return 1;
+  }
+
+  try {
+    model::ModelSourceAssimpRef source = model::loadModel(modelPath, "", scaleFactor);
+    model::ModelTargetBinary target(scaleFactor);
+    target.setHasAnimations(source->hasAnimations());
+    target.setSourceFile(modelPath);
+    source->load(&target);
+    target.write(outputPath);
+
+    // Read the result back, so that a file which couldn't be loaded is never shipped.
+    model::ModelSourceBinaryRef written = model::ModelSourceBinary::create(outputPath, scaleFactor, modelPath);
+    std::cout << "wrote " << outputPath << " (" << written->getNumSections() << " sections)" << std::endl;
+  } catch (const model::ModelIoException &e) {
+    std::cerr << modelPath << ": " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
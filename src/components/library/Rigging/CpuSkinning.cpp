@@ -0,0 +1,65 @@
+#include "CpuSkinning.h"
+
+#include <cstring>
+
+namespace model {
+
+  SkinningVertices makeSkinningVertices(const VertexArrayLayout& layout, const void* vertices, size_t numVertices, int numBones)
+  {
+    SkinningVertices result(numVertices);
+    const uint8_t* source = static_cast<const uint8_t*>(vertices);
+    for (size_t i=0; i<numVertices; i++) {
+      SkinningVertex& vertex = result[i];
+      float attribute[4];
+
+      memcpy(attribute, source + layout.mOffsets[VertexArrayLayout::POSITION], 3*sizeof(float));
+      vertex.mPosition << attribute[0], attribute[1], attribute[2], 1.0f;
+
+      // Attributes which aren't present are zero, so the normal can be copied regardless.
+      memcpy(attribute, source + layout.mOffsets[VertexArrayLayout::NORMAL], 3*sizeof(float));
+      vertex.mNormal << attribute[0], attribute[1], attribute[2], 0.0f;
+
+      float weights[BoneWeights::NB_WEIGHTS];
+      float indices[BoneWeights::NB_WEIGHTS];
+      memcpy(weights, source + layout.mOffsets[VertexArrayLayout::BONE_WEIGHTS], sizeof(weights));
+      memcpy(indices, source + layout.mOffsets[VertexArrayLayout::BONE_INDICES], sizeof(indices));
+      for (int b=0; b<BoneWeights::NB_WEIGHTS; b++) {
+        // The indices are stored as floats for the vertex shader.
+        const int index = static_cast<int>(indices[b]);
+        const bool valid = index >= 0 && index < numBones;
+        vertex.mWeights[b] = valid ? weights[b] : 0.0f;
+        vertex.mBoneIndices[b] = valid ? index : 0;
+      }
+      source += layout.mStride;
+    }
+    return result;
+  }
+
+  void skinVertices(const SkinningVertex* vertices, size_t numVertices,
+                    const Eigen::Matrix4f* boneMatrices, const Eigen::Matrix4f* invTransposeMatrices,
+                    float* positions, float* normals, size_t stride)
+  {
+    for (size_t i=0; i<numVertices; i++) {
+      const SkinningVertex& vertex = vertices[i];
+      Eigen::Vector4f position = Eigen::Vector4f::Zero();
+      Eigen::Vector4f normal = Eigen::Vector4f::Zero();
+      for (int b=0; b<BoneWeights::NB_WEIGHTS; b++) {
+        const float weight = vertex.mWeights[b];
+        // Most vertices are influenced by fewer than 4 bones.
+        if (weight != 0.0f) {
+          const int bone = vertex.mBoneIndices[b];
+          position.noalias() += weight * (boneMatrices[bone] * vertex.mPosition);
+          normal.noalias() += weight * (invTransposeMatrices[bone] * vertex.mNormal);
+        }
+      }
+
+      float* outPosition = positions + i*stride;
+      float* outNormal = normals + i*stride;
+      for (int c=0; c<3; c++) {
+        outPosition[c] = position[c];
+        outNormal[c] = normal[c];
+      }
+    }
+  }
+
+} //end namespace model
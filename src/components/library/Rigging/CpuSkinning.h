@@ -0,0 +1,44 @@
+#pragma once
+
+#include "ModelIo.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "EigenTypes.h"
+
+namespace model {
+
+  /*!
+   *  The bind pose of one vertex, as needed to skin it on the CPU.  Every member is 4 floats wide
+   *  (the position has w = 1 and the normal w = 0) so that skinning is done entirely in 4-wide
+   *  SIMD registers through Eigen, and a vertex fills one 64-byte cache line.
+   */
+  struct SkinningVertex
+  {
+    Eigen::Vector4f mPosition;
+    Eigen::Vector4f mNormal;
+    Eigen::Vector4f mWeights;
+    int32_t mBoneIndices[BoneWeights::NB_WEIGHTS];
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  };
+
+  typedef std::vector<SkinningVertex, Eigen::aligned_allocator<SkinningVertex>> SkinningVertices;
+
+  //! Extracts the bind pose of the given interleaved vertices.  Bone indices outside of
+  //! [0, numBones) are given zero weight, so that skinning never reads past the bone matrices.
+  SkinningVertices makeSkinningVertices(const VertexArrayLayout& layout, const void* vertices, size_t numVertices, int numBones);
+
+  /*!
+   *  Linear blend skinning of the given vertices, as done by the hands' vertex shader: each
+   *  position is blended from the bone matrices and each normal from the inverse transposed bone
+   *  matrices, by the vertex's 4 weights.  The results' xyz are written to positions and normals,
+   *  which are strided by stride floats (so that they can be interleaved).  This is safe to call
+   *  concurrently on disjoint ranges of vertices.
+   */
+  void skinVertices(const SkinningVertex* vertices, size_t numVertices,
+                    const Eigen::Matrix4f* boneMatrices, const Eigen::Matrix4f* invTransposeMatrices,
+                    float* positions, float* normals, size_t stride);
+
+} //end namespace model
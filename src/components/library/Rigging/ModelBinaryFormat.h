@@ -0,0 +1,117 @@
+#pragma once
+
+#include "ModelIo.h"
+
+#include <cstdint>
+#include <string>
+
+namespace model {
+
+  /*!
+   *  The layout of the binary models written by ModelTargetBinary and read by ModelSourceBinary.
+   *  All fields are stored in native byte order; a file written with the other byte order fails
+   *  the magic number check.  A file consists of:
+   *
+   *  - a FileHeader,
+   *  - FileHeader::mNumNodes NodeRecords, for the skeleton's node hierarchy in pre-order (so each
+   *    node's parent precedes it),
+   *  - FileHeader::mNumSections SectionRecords,
+   *  - the string table, which holds the node and section names (without terminators),
+   *  - the vertex and index arrays of each section, each starting at a multiple of ARRAY_ALIGNMENT.
+   *    Vertices are interleaved as described by FileHeader::mLayout, and indices are uint32_t.
+   */
+  namespace binary {
+
+    static const char MAGIC[4] = { 'R', 'I', 'G', 'M' };
+    //! Must be incremented whenever the file format, or the way models are converted, changes.
+    static const uint32_t FORMAT_VERSION = 2;
+    static const uint32_t ARRAY_ALIGNMENT = 16;
+
+    enum FileFlags {
+      FILE_HAS_SKELETON = 1 << 0,
+      FILE_HAS_ANIMATIONS = 1 << 1
+    };
+
+    enum SectionFlags {
+      SECTION_HAS_NORMALS = 1 << 0,
+      SECTION_HAS_SKELETON = 1 << 1,
+      SECTION_HAS_MATERIALS = 1 << 2,
+      SECTION_HAS_DEFAULT_TRANSFORMATION = 1 << 3
+    };
+
+    enum MaterialFlags {
+      MATERIAL_USE_ALPHA = 1 << 0,
+      MATERIAL_HAS_MATERIAL = 1 << 1,
+      MATERIAL_TWO_SIDED = 1 << 2
+    };
+
+    struct StringRef {
+      uint32_t mOffset;
+      uint32_t mLength;
+    };
+
+    struct FileHeader {
+      char mMagic[4];
+      uint32_t mVersion;
+      //! The size of the whole file, including this header.
+      uint64_t mFileSize;
+      //! The size and hash (see hashSourceFile) of the model file which was converted, so that a
+      //! binary model left behind by an older version of that file can be told apart.
+      uint64_t mSourceSize;
+      uint64_t mSourceHash;
+      //! The scale factor which the model was converted with.
+      float mScaleFactor;
+      uint32_t mFlags;
+      uint32_t mNumNodes;
+      uint32_t mNumSections;
+      uint64_t mStringTableOffset;
+      uint32_t mStringTableSize;
+      VertexArrayLayout mLayout;
+    };
+
+    struct NodeRecord {
+      StringRef mName;
+      //! The index of the parent's record, or -1 for the root.
+      int32_t mParent;
+      int32_t mLevel;
+      //! The node's index in the skeleton's bones, or -1 if it isn't a bone.
+      int32_t mBoneIndex;
+      uint32_t mHasOffset;
+      float mPosition[3];
+      //! w, x, y, z
+      float mRotation[4];
+      float mScale[3];
+      //! The bone offset matrix, in column-major order (if mHasOffset is nonzero).
+      float mOffset[16];
+    };
+
+    struct MaterialRecord {
+      float mTransparentColor[4];
+      float mAmbient[4];
+      float mDiffuse[4];
+      float mSpecular[4];
+      float mEmission[4];
+      float mShininess;
+      uint32_t mFlags;
+    };
+
+    struct SectionRecord {
+      StringRef mName;
+      uint32_t mFlags;
+      uint32_t mNumVertices;
+      uint32_t mNumIndices;
+      uint32_t mReserved;
+      uint64_t mVerticesOffset;
+      uint64_t mIndicesOffset;
+      MaterialRecord mMaterial;
+      //! In column-major order (if SECTION_HAS_DEFAULT_TRANSFORMATION is set).
+      float mDefaultTransformation[16];
+    };
+
+    //! Reads the size and 64-bit FNV-1a hash of the given file's contents.  Returns false if the
+    //! file can't be read.
+    bool hashSourceFile(const std::string& path, uint64_t& size, uint64_t& hash);
+
+  } //end namespace binary
+
+} //end namespace model
@@ -1,6 +1,7 @@
 #include "ModelIo.h"
 #include "Node.h"
 #include "ModelSourceAssimp.h"
+#include "ModelSourceBinary.h"
 
 namespace model {
 
@@ -46,11 +47,42 @@ namespace model {
 
   void ModelTarget::loadDefaultTransformation(const Eigen::Matrix4f& transformation) { }
 
+  bool ModelTarget::loadVertexArray(const VertexArrayLayout& layout, const void* vertices, size_t numVertices) { return false; }
+
+  const uint32_t VertexArrayLayout::NUM_COMPONENTS[VertexArrayLayout::NUM_ATTRIBUTES] = { 3, 3, 2, 4, 4 };
+
+  bool VertexArrayLayout::operator==(const VertexArrayLayout& rhs) const
+  {
+    if (mStride != rhs.mStride) {
+      return false;
+    }
+    for (int i=0; i < NUM_ATTRIBUTES; ++i) {
+      if (mOffsets[i] != rhs.mOffsets[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
   ModelSourceAssimpRef loadModel(const std::string& modelPath, const std::string& rootAssetFolderPath, float scaleFactor)
   {
     return ModelSourceAssimp::create(modelPath, rootAssetFolderPath, scaleFactor);
   }
 
+  ModelSourceRef loadCachedModel(const std::string& modelPath, const std::string& rootAssetFolderPath, float scaleFactor)
+  {
+    ModelSourceBinaryRef binarySource = ModelSourceBinary::tryCreate(binaryModelPath(modelPath), scaleFactor, modelPath);
+    if (binarySource) {
+      return binarySource;
+    }
+    return loadModel(modelPath, rootAssetFolderPath, scaleFactor);
+  }
+
+  std::string binaryModelPath(const std::string& modelPath)
+  {
+    return modelPath + ".rigbin";
+  }
+
   ModelIoException::ModelIoException(const std::string &message) throw()
     //: ModelIoException() no constructor delegation in VS2012 :(
   {
@@ -4,7 +4,9 @@
 #include "GLTexture2Image.h"
 
 #include <array>
+#include <cstdint>
 #include <memory>
+#include <string>
 
 namespace model {
 
@@ -53,6 +55,28 @@ namespace model {
     std::array<std::shared_ptr<Node>, NB_WEIGHTS> mBones;
   };
 
+  //! Describes an array of interleaved vertices, each of which holds a position (3 floats),
+  //! normal (3 floats), texture coordinate (2 floats), bone weights (4 floats) and bone indices
+  //! (4 floats), as SkinnedVboMesh stores them.  The attributes may be in any order within a vertex.
+  struct VertexArrayLayout
+  {
+    enum Attribute { POSITION, NORMAL, TEX_COORD, BONE_WEIGHTS, BONE_INDICES, NUM_ATTRIBUTES };
+    static const uint32_t NUM_COMPONENTS[NUM_ATTRIBUTES];
+
+    VertexArrayLayout() : mStride(0), mAttributeMask(0), mOffsets() { }
+    bool hasAttribute(Attribute attribute) const { return (mAttributeMask & (1u << attribute)) != 0; }
+    //! Compares the memory layout (the stride and offsets), regardless of which attributes are present.
+    bool operator==(const VertexArrayLayout& rhs) const;
+    bool operator!=(const VertexArrayLayout& rhs) const { return !(*this == rhs); }
+
+    //! The size of each vertex, in bytes.
+    uint32_t mStride;
+    //! Bit i is set iff the vertices hold meaningful values of Attribute i (the others are zero).
+    uint32_t mAttributeMask;
+    //! The offset of each attribute within a vertex, in bytes.
+    uint32_t mOffsets[NUM_ATTRIBUTES];
+  };
+
   class ModelSource {
   public:
     virtual size_t getNumSections() const = 0;
@@ -91,6 +115,12 @@ namespace model {
   };
 
   extern std::shared_ptr<class ModelSourceAssimp> loadModel(const std::string& modelPath, const std::string& rootAssetFolderPath, float scaleFactor);
+  //! Loads the binary model at binaryModelPath(modelPath) if there is one which was converted
+  //! from the current contents of modelPath with the same scale factor, and otherwise falls back
+  //! to loading modelPath through Assimp.
+  extern ModelSourceRef loadCachedModel(const std::string& modelPath, const std::string& rootAssetFolderPath, float scaleFactor);
+  //! The path of the binary model (see ModelSourceBinary) converted from the given model.
+  extern std::string binaryModelPath(const std::string& modelPath);
 
   class ModelTarget {
   public:
@@ -105,6 +135,15 @@ namespace model {
     virtual void loadSkeleton(const std::shared_ptr<Skeleton>& skeleton);
     virtual void loadBoneWeights(const std::vector<BoneWeights>& boneWeights);
     virtual void loadDefaultTransformation(const Eigen::Matrix4f& transformation);
+    /*!
+     *  Load all of the active section's vertices at once from prebuilt, interleaved data (which
+     *  may be memory-mapped, and is only valid during the call).  Returns false if the target
+     *  doesn't support this, in which case the source gives it the vertices through the
+     *  per-attribute load methods instead.  If it returns true, the source doesn't call
+     *  loadVertexPositions, loadVertexNormals or loadBoneWeights for the section, and calls
+     *  loadTex with no texture coordinates to give the section's material.
+     */
+    virtual bool loadVertexArray(const VertexArrayLayout& layout, const void* vertices, size_t numVertices);
   };
 
 } //end namespace model
@@ -0,0 +1,360 @@
+#include "ModelSourceBinary.h"
+
+#include "ModelBinaryFormat.h"
+#include "Skeleton.h"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace model {
+
+  namespace {
+
+    Color loadColor(const float* data)
+    {
+      return Color(data[0], data[1], data[2], data[3]);
+    }
+
+    Eigen::Matrix4f loadMatrix(const float* data)
+    {
+      return Eigen::Map<const Eigen::Matrix4f>(data);
+    }
+
+    MaterialInfo loadMaterial(const binary::MaterialRecord& record)
+    {
+      MaterialInfo matInfo;
+      matInfo.mTransparentColor = loadColor(record.mTransparentColor);
+      matInfo.mAmbient = loadColor(record.mAmbient);
+      matInfo.mDiffuse = loadColor(record.mDiffuse);
+      matInfo.mSpecular = loadColor(record.mSpecular);
+      matInfo.mEmission = loadColor(record.mEmission);
+      matInfo.mShininess = record.mShininess;
+      matInfo.mUseAlpha = (record.mFlags & binary::MATERIAL_USE_ALPHA) != 0;
+      matInfo.mHasMaterial = (record.mFlags & binary::MATERIAL_HAS_MATERIAL) != 0;
+      matInfo.mTwoSided = (record.mFlags & binary::MATERIAL_TWO_SIDED) != 0;
+      return matInfo;
+    }
+
+    bool inBounds(uint64_t offset, uint64_t size, uint64_t fileSize)
+    {
+      return offset <= fileSize && size <= fileSize - offset;
+    }
+
+  } //end anonymous namespace
+
+  bool binary::hashSourceFile(const std::string& path, uint64_t& size, uint64_t& hash)
+  {
+    MappedFile file;
+    if (!file.TryOpen(path)) {
+      return false;
+    }
+    size = file.Size();
+    hash = 14695981039346656037ULL;
+    for (size_t i=0; i < file.Size(); ++i) {
+      hash ^= file.Data()[i];
+      hash *= 1099511628211ULL;
+    }
+    return true;
+  }
+
+  ModelSourceBinaryRef ModelSourceBinary::create(const std::string& path, float scaleFactor, const std::string& sourcePath)
+  {
+    return ModelSourceBinaryRef(new ModelSourceBinary(path, scaleFactor, sourcePath));
+  }
+
+  ModelSourceBinaryRef ModelSourceBinary::tryCreate(const std::string& path, float scaleFactor, const std::string& sourcePath)
+  {
+    try {
+      return create(path, scaleFactor, sourcePath);
+    } catch (const LoadErrorException&) {
+      return nullptr;
+    }
+  }
+
+  ModelSourceBinary::ModelSourceBinary(const std::string& path, float scaleFactor, const std::string& sourcePath)
+  {
+    if (!mFile.TryOpen(path)) {
+      throw LoadErrorException("Couldn't open binary model \"" + path + "\".");
+    }
+    validate(scaleFactor, sourcePath);
+  }
+
+  const binary::FileHeader& ModelSourceBinary::header() const
+  {
+    return *reinterpret_cast<const binary::FileHeader*>(mFile.Data());
+  }
+
+  const binary::NodeRecord& ModelSourceBinary::node(size_t index) const
+  {
+    return reinterpret_cast<const binary::NodeRecord*>(mFile.Data() + sizeof(binary::FileHeader))[index];
+  }
+
+  const binary::SectionRecord& ModelSourceBinary::section(size_t index) const
+  {
+    const uint8_t* sections = mFile.Data() + sizeof(binary::FileHeader) + header().mNumNodes*sizeof(binary::NodeRecord);
+    return reinterpret_cast<const binary::SectionRecord*>(sections)[index];
+  }
+
+  std::string ModelSourceBinary::string(uint32_t offset, uint32_t length) const
+  {
+    return std::string(reinterpret_cast<const char*>(mFile.Data() + header().mStringTableOffset + offset), length);
+  }
+
+  void ModelSourceBinary::validate(float scaleFactor, const std::string& sourcePath) const
+  {
+    const uint64_t size = mFile.Size();
+    if (size < sizeof(binary::FileHeader)) {
+      throw LoadErrorException("Binary model is truncated.");
+    }
+    const binary::FileHeader& h = header();
+    if (std::memcmp(h.mMagic, binary::MAGIC, sizeof(binary::MAGIC)) != 0) {
+      throw LoadErrorException("Not a binary model.");
+    }
+    if (h.mVersion != binary::FORMAT_VERSION) {
+      throw LoadErrorException("Binary model has an unsupported version; it must be converted again.");
+    }
+    if (scaleFactor != 0.0f && h.mScaleFactor != scaleFactor) {
+      throw LoadErrorException("Binary model was converted with a different scale factor.");
+    }
+    if (!sourcePath.empty()) {
+      // Without the source there's nothing better to load, so only a readable one is checked.
+      uint64_t sourceSize = 0;
+      uint64_t sourceHash = 0;
+      if (binary::hashSourceFile(sourcePath, sourceSize, sourceHash) &&
+          (h.mSourceSize != sourceSize || h.mSourceHash != sourceHash)) {
+        throw LoadErrorException("Binary model was converted from another version of \"" + sourcePath + "\"; it must be converted again.");
+      }
+    }
+    if (h.mFileSize != size || h.mNumSections == 0) {
+      throw LoadErrorException("Binary model is malformed.");
+    }
+    const uint64_t recordsSize = sizeof(binary::FileHeader) + uint64_t(h.mNumNodes)*sizeof(binary::NodeRecord) + uint64_t(h.mNumSections)*sizeof(binary::SectionRecord);
+    if (h.mStringTableOffset != recordsSize || !inBounds(h.mStringTableOffset, h.mStringTableSize, size)) {
+      throw LoadErrorException("Binary model is malformed.");
+    }
+    for (int a=0; a < VertexArrayLayout::NUM_ATTRIBUTES; ++a) {
+      if (uint64_t(h.mLayout.mOffsets[a]) + VertexArrayLayout::NUM_COMPONENTS[a]*sizeof(float) > h.mLayout.mStride) {
+        throw LoadErrorException("Binary model has an invalid vertex layout.");
+      }
+    }
+
+    // The nodes must be in pre-order, and the bones' indices must be distinct and contiguous
+    // from 0, since Skeleton::addBone assigns them in that way.
+    std::vector<bool> boneIndexUsed;
+    for (uint32_t n=0; n < h.mNumNodes; ++n) {
+      const binary::NodeRecord& record = node(n);
+      const bool validParent = (n == 0) ? record.mParent == -1 : (record.mParent >= 0 && static_cast<uint32_t>(record.mParent) < n);
+      if (!validParent || !inBounds(record.mName.mOffset, record.mName.mLength, h.mStringTableSize)) {
+        throw LoadErrorException("Binary model has an invalid node hierarchy.");
+      }
+      if (record.mBoneIndex >= 0) {
+        // Contiguous indices are all less than the number of nodes, and checking that first
+        // keeps a corrupt index from sizing boneIndexUsed.
+        if (static_cast<uint32_t>(record.mBoneIndex) >= h.mNumNodes) {
+          throw LoadErrorException("Binary model has a bone index out of range.");
+        }
+        if (record.mBoneIndex >= static_cast<int32_t>(boneIndexUsed.size())) {
+          boneIndexUsed.resize(record.mBoneIndex + 1, false);
+        }
+        if (boneIndexUsed[record.mBoneIndex]) {
+          throw LoadErrorException("Binary model has duplicate bone indices.");
+        }
+        boneIndexUsed[record.mBoneIndex] = true;
+      }
+    }
+    for (bool used : boneIndexUsed) {
+      if (!used) {
+        throw LoadErrorException("Binary model has non-contiguous bone indices.");
+      }
+    }
+    if ((h.mFlags & binary::FILE_HAS_SKELETON) != 0 && h.mNumNodes == 0) {
+      throw LoadErrorException("Binary model has an empty skeleton.");
+    }
+
+    for (uint32_t s=0; s < h.mNumSections; ++s) {
+      const binary::SectionRecord& record = section(s);
+      if (!inBounds(record.mName.mOffset, record.mName.mLength, h.mStringTableSize) ||
+          record.mVerticesOffset % binary::ARRAY_ALIGNMENT != 0 ||
+          record.mIndicesOffset % binary::ARRAY_ALIGNMENT != 0 ||
+          !inBounds(record.mVerticesOffset, uint64_t(record.mNumVertices)*h.mLayout.mStride, size) ||
+          !inBounds(record.mIndicesOffset, uint64_t(record.mNumIndices)*sizeof(uint32_t), size)) {
+        throw LoadErrorException("Binary model has an invalid section.");
+      }
+      if ((record.mFlags & binary::SECTION_HAS_SKELETON) != 0 && (h.mFlags & binary::FILE_HAS_SKELETON) == 0) {
+        throw LoadErrorException("Binary model has a skinned section but no skeleton.");
+      }
+      const uint32_t* indices = reinterpret_cast<const uint32_t*>(mFile.Data() + record.mIndicesOffset);
+      for (uint32_t i=0; i < record.mNumIndices; ++i) {
+        if (indices[i] >= record.mNumVertices) {
+          throw LoadErrorException("Binary model has an index out of range.");
+        }
+      }
+    }
+  }
+
+  size_t ModelSourceBinary::getNumSections() const
+  {
+    return header().mNumSections;
+  }
+
+  size_t ModelSourceBinary::getNumVertices(int s) const
+  {
+    return section(s).mNumVertices;
+  }
+
+  size_t ModelSourceBinary::getNumIndices(int s) const
+  {
+    return section(s).mNumIndices;
+  }
+
+  bool ModelSourceBinary::hasNormals(int s) const
+  {
+    return (section(s).mFlags & binary::SECTION_HAS_NORMALS) != 0;
+  }
+
+  bool ModelSourceBinary::hasSkeleton(int s) const
+  {
+    return (section(s).mFlags & binary::SECTION_HAS_SKELETON) != 0;
+  }
+
+  bool ModelSourceBinary::hasMaterials(int s) const
+  {
+    return (section(s).mFlags & binary::SECTION_HAS_MATERIALS) != 0;
+  }
+
+  bool ModelSourceBinary::hasAnimations() const
+  {
+    return (header().mFlags & binary::FILE_HAS_ANIMATIONS) != 0;
+  }
+
+  float ModelSourceBinary::getScaleFactor() const
+  {
+    return header().mScaleFactor;
+  }
+
+  SkeletonRef ModelSourceBinary::buildSkeleton() const
+  {
+    const uint32_t numNodes = header().mNumNodes;
+    std::vector<NodeRef> nodes(numNodes);
+    std::vector<NodeRef> bones;
+    for (uint32_t n=0; n < numNodes; ++n) {
+      const binary::NodeRecord& record = node(n);
+      NodeRef parent = (record.mParent >= 0) ? nodes[record.mParent] : nullptr;
+      const Eigen::Quaternionf rotation(record.mRotation[0], record.mRotation[1], record.mRotation[2], record.mRotation[3]);
+      NodeRef created = NodeRef(new Node(Eigen::Map<const Eigen::Vector3f>(record.mPosition), rotation, Eigen::Map<const Eigen::Vector3f>(record.mScale),
+        string(record.mName.mOffset, record.mName.mLength), parent, record.mLevel));
+      if (record.mHasOffset) {
+        created->setOffsetMatrix(loadMatrix(record.mOffset));
+      }
+      if (parent) {
+        parent->addChild(created);
+      }
+      if (record.mBoneIndex >= 0) {
+        if (record.mBoneIndex >= static_cast<int32_t>(bones.size())) {
+          bones.resize(record.mBoneIndex + 1);
+        }
+        bones[record.mBoneIndex] = created;
+      }
+      nodes[n] = created;
+    }
+
+    SkeletonRef skeleton = Skeleton::create();
+    skeleton->setRootNode(nodes[0]);
+    // Adding the bones in index order gives them the same indices as when they were converted.
+    for (const NodeRef& bone : bones) {
+      skeleton->addBone(bone->getName(), bone);
+    }
+    if (skeleton->getNumBones() != static_cast<int>(bones.size())) {
+      throw LoadErrorException("Binary model has duplicate bone names.");
+    }
+    return skeleton;
+  }
+
+  void ModelSourceBinary::loadAttributes(ModelTarget* target, const binary::SectionRecord& record, const SkeletonRef& skeleton) const
+  {
+    const VertexArrayLayout& layout = header().mLayout;
+    const uint8_t* vertices = mFile.Data() + record.mVerticesOffset;
+    const size_t numVertices = record.mNumVertices;
+    auto attribute = [&](size_t v, VertexArrayLayout::Attribute a) {
+      return reinterpret_cast<const float*>(vertices + v*layout.mStride + layout.mOffsets[a]);
+    };
+
+    std::vector<Eigen::Vector3f> positions(numVertices);
+    for (size_t v=0; v < numVertices; ++v) {
+      positions[v] = Eigen::Map<const Eigen::Vector3f>(attribute(v, VertexArrayLayout::POSITION));
+    }
+    target->loadVertexPositions(positions);
+
+    if (record.mFlags & binary::SECTION_HAS_NORMALS) {
+      std::vector<Eigen::Vector3f> normals(numVertices);
+      for (size_t v=0; v < numVertices; ++v) {
+        normals[v] = Eigen::Map<const Eigen::Vector3f>(attribute(v, VertexArrayLayout::NORMAL));
+      }
+      target->loadVertexNormals(normals);
+    }
+
+    if (record.mFlags & binary::SECTION_HAS_MATERIALS) {
+      std::vector<Eigen::Vector2f> texCoords(numVertices);
+      for (size_t v=0; v < numVertices; ++v) {
+        texCoords[v] = Eigen::Map<const Eigen::Vector2f>(attribute(v, VertexArrayLayout::TEX_COORD));
+      }
+      target->loadTex(texCoords, loadMaterial(record.mMaterial));
+    }
+
+    if (skeleton) {
+      const std::vector<NodeRef>& bones = skeleton->getBones();
+      std::vector<BoneWeights> boneWeights(numVertices);
+      for (size_t v=0; v < numVertices; ++v) {
+        const float* weights = attribute(v, VertexArrayLayout::BONE_WEIGHTS);
+        const float* indices = attribute(v, VertexArrayLayout::BONE_INDICES);
+        for (int b=0; b < BoneWeights::NB_WEIGHTS; ++b) {
+          // Unused slots were stored as zero weights.
+          if (weights[b] == 0.0f) {
+            continue;
+          }
+          const size_t index = static_cast<size_t>(indices[b]);
+          if (indices[b] < 0.0f || index >= bones.size() || !bones[index]) {
+            throw LoadErrorException("Binary model has a bone index out of range.");
+          }
+          boneWeights[v].addWeight(bones[index], weights[b]);
+        }
+      }
+      target->loadSkeleton(skeleton);
+      target->loadBoneWeights(boneWeights);
+    }
+  }
+
+  void ModelSourceBinary::load(ModelTarget *target)
+  {
+    SkeletonRef skeleton = target->getSkeleton();
+    if ((header().mFlags & binary::FILE_HAS_SKELETON) && skeleton == nullptr) {
+      skeleton = buildSkeleton();
+    }
+
+    for (uint32_t i=0; i < header().mNumSections; ++i) {
+      const binary::SectionRecord& record = section(i);
+      const bool skinned = (record.mFlags & binary::SECTION_HAS_SKELETON) && skeleton;
+
+      target->setActiveSection(i);
+      target->loadName(string(record.mName.mOffset, record.mName.mLength));
+      const uint32_t* indices = reinterpret_cast<const uint32_t*>(mFile.Data() + record.mIndicesOffset);
+      target->loadIndices(std::vector<uint32_t>(indices, indices + record.mNumIndices));
+
+      if (target->loadVertexArray(header().mLayout, mFile.Data() + record.mVerticesOffset, record.mNumVertices)) {
+        if (record.mFlags & binary::SECTION_HAS_MATERIALS) {
+          target->loadTex(std::vector<Eigen::Vector2f>(), loadMaterial(record.mMaterial));
+        }
+        if (skinned) {
+          target->loadSkeleton(skeleton);
+        }
+      } else {
+        loadAttributes(target, record, skinned ? skeleton : nullptr);
+      }
+
+      if (!skinned && (record.mFlags & binary::SECTION_HAS_DEFAULT_TRANSFORMATION)) {
+        target->loadDefaultTransformation(loadMatrix(record.mDefaultTransformation));
+      }
+    }
+  }
+
+} //end namespace model
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "ModelIo.h"
+
+#include "MappedFile.h"
+
+#include <memory>
+#include <string>
+
+namespace model {
+
+  namespace binary { struct FileHeader; struct NodeRecord; struct SectionRecord; }
+
+  typedef std::shared_ptr<class ModelSourceBinary> ModelSourceBinaryRef;
+
+  /*!
+   *  A model source which reads a binary model written by ModelTargetBinary (see
+   *  ModelBinaryFormat.h), e.g. by the RiggingModelConverter tool.  The file is memory-mapped for
+   *  as long as the source exists, and loading it parses nothing: the skeleton is rebuilt from its
+   *  flattened node hierarchy, and targets which support ModelTarget::loadVertexArray (such as
+   *  SkinnedVboMesh's) are given each section's prebuilt vertices directly from the mapping.
+   */
+  class ModelSourceBinary : public ModelSource {
+  public:
+    //! Maps and validates the given file.  Throws LoadErrorException if it doesn't exist, is
+    //! malformed, was written with a different format version, (if scaleFactor is nonzero) was
+    //! converted with a different scale factor, or (if sourcePath names a readable file) was
+    //! converted from a file with other contents than sourcePath's.
+    static ModelSourceBinaryRef create(const std::string& path, float scaleFactor = 0.0f, const std::string& sourcePath = "");
+    //! As create, but returns nullptr instead of throwing.
+    static ModelSourceBinaryRef tryCreate(const std::string& path, float scaleFactor = 0.0f, const std::string& sourcePath = "");
+
+    virtual size_t getNumSections() const override;
+    virtual size_t getNumVertices(int section = 0) const override;
+    virtual size_t getNumIndices(int section = 0) const override;
+    virtual bool hasNormals(int section = 0) const override;
+    virtual bool hasSkeleton(int section = 0) const override;
+    virtual bool hasMaterials(int section = 0) const override;
+    virtual bool hasAnimations() const override;
+
+    virtual void load(ModelTarget *target) override;
+
+    float getScaleFactor() const;
+
+  protected:
+    ModelSourceBinary(const std::string& path, float scaleFactor, const std::string& sourcePath);
+  private:
+    const binary::FileHeader& header() const;
+    const binary::NodeRecord& node(size_t index) const;
+    const binary::SectionRecord& section(size_t index) const;
+    std::string string(uint32_t offset, uint32_t length) const;
+    //! Throws LoadErrorException unless the mapped file is well-formed.
+    void validate(float scaleFactor, const std::string& sourcePath) const;
+    std::shared_ptr<Skeleton> buildSkeleton() const;
+    //! Gives a target which doesn't support loadVertexArray the active section's vertices (and
+    //! skeleton, if the section is skinned), as ModelSourceAssimp would.
+    void loadAttributes(ModelTarget* target, const binary::SectionRecord& record, const std::shared_ptr<Skeleton>& skeleton) const;
+
+    MappedFile mFile;
+  };
+
+} //end namespace model
@@ -0,0 +1,311 @@
+#include "ModelTargetBinary.h"
+
+#include "ModelBinaryFormat.h"
+#include "Skeleton.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+namespace model {
+
+  namespace {
+
+    template <int DIM>
+    struct FloatVec {
+      float data[DIM];
+    };
+
+    void storeColor(const Color& color, float* out)
+    {
+      out[0] = color.R();
+      out[1] = color.G();
+      out[2] = color.B();
+      out[3] = color.A();
+    }
+
+    void storeMatrix(const Eigen::Matrix4f& matrix, float* out)
+    {
+      Eigen::Map<Eigen::Matrix4f> stored(out);
+      stored = matrix;
+    }
+
+    uint64_t align(uint64_t offset)
+    {
+      return (offset + binary::ARRAY_ALIGNMENT - 1) / binary::ARRAY_ALIGNMENT * binary::ARRAY_ALIGNMENT;
+    }
+
+    binary::StringRef appendString(std::string& table, const std::string& value)
+    {
+      binary::StringRef ref;
+      ref.mOffset = static_cast<uint32_t>(table.size());
+      ref.mLength = static_cast<uint32_t>(value.size());
+      table += value;
+      return ref;
+    }
+
+  } //end anonymous namespace
+
+  ModelTargetBinary::Section::Section()
+    : mFlags(0)
+    , mAttributeMask(0)
+    , mDefaultTransformation(Eigen::Matrix4f::Identity())
+  { }
+
+  ModelTargetBinary::ModelTargetBinary(float scaleFactor)
+    : mScaleFactor(scaleFactor)
+    , mHasAnimations(false)
+    , mSourceSize(0)
+    , mSourceHash(0)
+    , mActiveSection(-1)
+  { }
+
+  void ModelTargetBinary::setSourceFile(const std::string& modelPath)
+  {
+    if (!binary::hashSourceFile(modelPath, mSourceSize, mSourceHash)) {
+      throw ModelTargetException("Couldn't read \"" + modelPath + "\".");
+    }
+  }
+
+  void ModelTargetBinary::setActiveSection(int index)
+  {
+    if (index < 0) {
+      throw ModelTargetException("Invalid section index.");
+    }
+    if (static_cast<size_t>(index) >= mSections.size()) {
+      mSections.resize(index + 1);
+    }
+    mActiveSection = index;
+  }
+
+  ModelTargetBinary::Section& ModelTargetBinary::activeSection()
+  {
+    if (mActiveSection < 0) {
+      throw ModelTargetException("No active section.");
+    }
+    return mSections[mActiveSection];
+  }
+
+  void ModelTargetBinary::resizeVertices(size_t numVertices)
+  {
+    std::vector<VertexAttributes>& vertices = activeSection().mVertices;
+    if (vertices.size() < numVertices) {
+      // Attributes which are never loaded are stored as zeros, as SkinnedVboMesh would upload them.
+      VertexAttributes zero;
+      std::memset(&zero, 0, sizeof(zero));
+      vertices.resize(numVertices, zero);
+    }
+  }
+
+  std::shared_ptr<Skeleton> ModelTargetBinary::getSkeleton() const
+  {
+    return mSkeleton;
+  }
+
+  void ModelTargetBinary::loadName(std::string name)
+  {
+    activeSection().mName = name;
+  }
+
+  void ModelTargetBinary::loadVertexPositions(const std::vector<Eigen::Vector3f>& positions)
+  {
+    resizeVertices(positions.size());
+    std::vector<VertexAttributes>& vertices = activeSection().mVertices;
+    for (size_t i=0; i<positions.size(); i++) {
+      std::memcpy(std::get<0>(vertices[i]).As<FloatVec<3>>().data, positions[i].data(), 3*sizeof(float));
+    }
+    activeSection().mAttributeMask |= 1u << VertexArrayLayout::POSITION;
+  }
+
+  void ModelTargetBinary::loadVertexNormals(const std::vector<Eigen::Vector3f>& normals)
+  {
+    resizeVertices(normals.size());
+    std::vector<VertexAttributes>& vertices = activeSection().mVertices;
+    for (size_t i=0; i<normals.size(); i++) {
+      std::memcpy(std::get<1>(vertices[i]).As<FloatVec<3>>().data, normals[i].data(), 3*sizeof(float));
+    }
+    activeSection().mAttributeMask |= 1u << VertexArrayLayout::NORMAL;
+    activeSection().mFlags |= binary::SECTION_HAS_NORMALS;
+  }
+
+  void ModelTargetBinary::loadIndices(const std::vector<uint32_t>& indices)
+  {
+    activeSection().mIndices = indices;
+  }
+
+  void ModelTargetBinary::loadTex(const std::vector<Eigen::Vector2f>& texCoords, const MaterialInfo& matInfo)
+  {
+    resizeVertices(texCoords.size());
+    std::vector<VertexAttributes>& vertices = activeSection().mVertices;
+    for (size_t i=0; i<texCoords.size(); i++) {
+      std::memcpy(std::get<2>(vertices[i]).As<FloatVec<2>>().data, texCoords[i].data(), 2*sizeof(float));
+    }
+    activeSection().mMaterial = matInfo;
+    activeSection().mAttributeMask |= 1u << VertexArrayLayout::TEX_COORD;
+    activeSection().mFlags |= binary::SECTION_HAS_MATERIALS;
+  }
+
+  void ModelTargetBinary::loadSkeleton(const std::shared_ptr<Skeleton>& skeleton)
+  {
+    if (mSkeleton && mSkeleton != skeleton) {
+      throw ModelTargetException("All sections must share the same skeleton.");
+    }
+    mSkeleton = skeleton;
+    activeSection().mFlags |= binary::SECTION_HAS_SKELETON;
+  }
+
+  void ModelTargetBinary::loadBoneWeights(const std::vector<BoneWeights>& boneWeights)
+  {
+    resizeVertices(boneWeights.size());
+    std::vector<VertexAttributes>& vertices = activeSection().mVertices;
+    for (size_t i=0; i<boneWeights.size(); i++) {
+      const BoneWeights& boneWeight = boneWeights[i];
+      FloatVec<4>& vWeights = std::get<3>(vertices[i]).As<FloatVec<4>>();
+      FloatVec<4>& vIndices = std::get<4>(vertices[i]).As<FloatVec<4>>();
+      vWeights = FloatVec<4>();
+      vIndices = FloatVec<4>();
+      for (unsigned int b=0; b < boneWeight.mActiveNbWeights; ++b) {
+        vWeights.data[b] = boneWeight.getWeight(b);
+        vIndices.data[b] = static_cast<float>(boneWeight.getBone(b)->getBoneIndex());
+      }
+    }
+    activeSection().mAttributeMask |= (1u << VertexArrayLayout::BONE_WEIGHTS) | (1u << VertexArrayLayout::BONE_INDICES);
+  }
+
+  void ModelTargetBinary::loadDefaultTransformation(const Eigen::Matrix4f& transformation)
+  {
+    activeSection().mDefaultTransformation = transformation;
+    activeSection().mFlags |= binary::SECTION_HAS_DEFAULT_TRANSFORMATION;
+  }
+
+  void ModelTargetBinary::write(const std::string& path) const
+  {
+    std::string strings;
+
+    // Flatten the node hierarchy in pre-order, so that each node's parent precedes it.
+    std::vector<binary::NodeRecord> nodes;
+    if (mSkeleton) {
+      std::unordered_map<const Node*, int32_t> nodeIndices;
+      mSkeleton->traverseNodes(mSkeleton->getRootNode(), [&](NodeRef node) {
+        binary::NodeRecord record;
+        std::memset(&record, 0, sizeof(record));
+        NodeRef parent = node->getParent().lock();
+        record.mName = appendString(strings, node->getName());
+        record.mParent = parent ? nodeIndices.at(parent.get()) : -1;
+        record.mLevel = node->getLevel();
+        record.mBoneIndex = node->getBoneIndex();
+        Eigen::Map<Eigen::Vector3f>(record.mPosition) = node->getInitialRelativePosition();
+        const Eigen::Quaternionf& rotation = node->getInitialRelativeRotation();
+        record.mRotation[0] = rotation.w();
+        record.mRotation[1] = rotation.x();
+        record.mRotation[2] = rotation.y();
+        record.mRotation[3] = rotation.z();
+        Eigen::Map<Eigen::Vector3f>(record.mScale) = node->getInitialRelativeScale();
+        if (node->getOffset()) {
+          record.mHasOffset = 1;
+          storeMatrix(*node->getOffset(), record.mOffset);
+        }
+        nodeIndices[node.get()] = static_cast<int32_t>(nodes.size());
+        nodes.push_back(record);
+      });
+    }
+
+    std::vector<binary::SectionRecord> sections(mSections.size());
+    for (size_t i=0; i<mSections.size(); i++) {
+      const Section& section = mSections[i];
+      binary::SectionRecord& record = sections[i];
+      std::memset(&record, 0, sizeof(record));
+      record.mName = appendString(strings, section.mName);
+      record.mFlags = section.mFlags;
+      record.mNumVertices = static_cast<uint32_t>(section.mVertices.size());
+      record.mNumIndices = static_cast<uint32_t>(section.mIndices.size());
+      const MaterialInfo& material = section.mMaterial;
+      storeColor(material.mTransparentColor, record.mMaterial.mTransparentColor);
+      storeColor(material.mAmbient, record.mMaterial.mAmbient);
+      storeColor(material.mDiffuse, record.mMaterial.mDiffuse);
+      storeColor(material.mSpecular, record.mMaterial.mSpecular);
+      storeColor(material.mEmission, record.mMaterial.mEmission);
+      record.mMaterial.mShininess = material.mShininess;
+      record.mMaterial.mFlags = (material.mUseAlpha ? binary::MATERIAL_USE_ALPHA : 0) |
+        (material.mHasMaterial ? binary::MATERIAL_HAS_MATERIAL : 0) |
+        (material.mTwoSided ? binary::MATERIAL_TWO_SIDED : 0);
+      storeMatrix(section.mDefaultTransformation, record.mDefaultTransformation);
+    }
+
+    binary::FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.mMagic, binary::MAGIC, sizeof(binary::MAGIC));
+    header.mVersion = binary::FORMAT_VERSION;
+    header.mSourceSize = mSourceSize;
+    header.mSourceHash = mSourceHash;
+    header.mScaleFactor = mScaleFactor;
+    header.mFlags = (mSkeleton ? binary::FILE_HAS_SKELETON : 0) | (mHasAnimations ? binary::FILE_HAS_ANIMATIONS : 0);
+    header.mNumNodes = static_cast<uint32_t>(nodes.size());
+    header.mNumSections = static_cast<uint32_t>(sections.size());
+    header.mStringTableOffset = sizeof(header) + nodes.size()*sizeof(binary::NodeRecord) + sections.size()*sizeof(binary::SectionRecord);
+    header.mStringTableSize = static_cast<uint32_t>(strings.size());
+    header.mLayout = SkinnedVboMesh::vertexArrayLayout();
+
+    // Lay out the arrays after the string table.
+    uint64_t offset = header.mStringTableOffset + strings.size();
+    for (size_t i=0; i<mSections.size(); i++) {
+      offset = align(offset);
+      sections[i].mVerticesOffset = offset;
+      sections[i].mIndicesOffset = align(offset + mSections[i].mVertices.size()*sizeof(VertexAttributes));
+      offset = sections[i].mIndicesOffset + mSections[i].mIndices.size()*sizeof(uint32_t);
+      // Only the present attributes are meaningful, but the layout is shared by all sections.
+      header.mLayout.mAttributeMask |= mSections[i].mAttributeMask;
+    }
+    header.mFileSize = offset;
+
+    // Write to a file which no other writer is using, then rename it into place, so that readers
+    // only ever see complete files.
+    static std::atomic<unsigned int> s_tempCounter(0);
+    std::ostringstream tempPath;
+    tempPath << path << '.' << std::hash<std::thread::id>()(std::this_thread::get_id()) << '.' << s_tempCounter++ << ".tmp";
+    {
+      std::ofstream out(tempPath.str(), std::ios::binary | std::ios::trunc);
+      if (!out.is_open()) {
+        throw ModelTargetException("Couldn't open \"" + tempPath.str() + "\" for writing.");
+      }
+      uint64_t written = 0;
+      auto put = [&out, &written](const void* data, uint64_t size) {
+        out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        written += size;
+      };
+      auto pad = [&put, &written](uint64_t to) {
+        static const char ZEROS[binary::ARRAY_ALIGNMENT] = { 0 };
+        put(ZEROS, to - written);
+      };
+      put(&header, sizeof(header));
+      put(nodes.data(), nodes.size()*sizeof(binary::NodeRecord));
+      put(sections.data(), sections.size()*sizeof(binary::SectionRecord));
+      put(strings.data(), strings.size());
+      for (size_t i=0; i<mSections.size(); i++) {
+        pad(sections[i].mVerticesOffset);
+        put(mSections[i].mVertices.data(), mSections[i].mVertices.size()*sizeof(VertexAttributes));
+        pad(sections[i].mIndicesOffset);
+        put(mSections[i].mIndices.data(), mSections[i].mIndices.size()*sizeof(uint32_t));
+      }
+      if (!out.good()) {
+        out.close();
+        std::remove(tempPath.str().c_str());
+        throw ModelTargetException("Couldn't write \"" + tempPath.str() + "\".");
+      }
+    }
+    if (std::rename(tempPath.str().c_str(), path.c_str()) != 0) {
+      // On Windows, rename doesn't replace an existing file, so remove it and try again.
+      std::remove(path.c_str());
+      if (std::rename(tempPath.str().c_str(), path.c_str()) != 0) {
+        std::remove(tempPath.str().c_str());
+        throw ModelTargetException("Couldn't rename \"" + tempPath.str() + "\" to \"" + path + "\".");
+      }
+    }
+  }
+
+} //end namespace model
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "ModelIo.h"
+#include "SkinnedVboMesh.h"
+
+#include <string>
+#include <vector>
+
+#include "EigenTypes.h"
+
+namespace model {
+
+  class Skeleton;
+
+  /*!
+   *  Collects a model from a ModelSource (usually ModelSourceAssimp) and writes it as a binary
+   *  model (see ModelBinaryFormat.h), which ModelSourceBinary loads without Assimp.  The vertices
+   *  are stored as the same interleaved attributes which SkinnedVboMesh uploads, so that they can
+   *  be uploaded straight from the file.
+   */
+  class ModelTargetBinary : public ModelTarget {
+  public:
+    //! The scale factor is only recorded, so that the binary model can be checked against the
+    //! scale factor it's loaded with; the source must already have applied it.
+    ModelTargetBinary(float scaleFactor);
+
+    virtual void setActiveSection(int index) override;
+    virtual std::shared_ptr<Skeleton> getSkeleton() const override;
+
+    virtual void loadName(std::string name) override;
+    virtual void loadVertexPositions(const std::vector<Eigen::Vector3f>& positions) override;
+    virtual void loadVertexNormals(const std::vector<Eigen::Vector3f>& normals) override;
+    virtual void loadIndices(const std::vector<uint32_t>& indices) override;
+    virtual void loadTex(const std::vector<Eigen::Vector2f>& texCoords, const MaterialInfo& matInfo) override;
+    virtual void loadSkeleton(const std::shared_ptr<Skeleton>& skeleton) override;
+    virtual void loadBoneWeights(const std::vector<BoneWeights>& boneWeights) override;
+    virtual void loadDefaultTransformation(const Eigen::Matrix4f& transformation) override;
+
+    //! Records whether the source has animations (which isn't passed to targets).
+    void setHasAnimations(bool hasAnimations) { mHasAnimations = hasAnimations; }
+    //! Records the size and hash of the model file being converted, which ModelSourceBinary checks
+    //! the file against when it's given its path.  Throws ModelTargetException if it can't be read.
+    void setSourceFile(const std::string& modelPath);
+
+    //! Writes the collected model to the given path, through a temporary file which is renamed
+    //! into place.  Throws ModelTargetException upon failure.
+    void write(const std::string& path) const;
+
+  private:
+    struct Section {
+      Section();
+      std::string mName;
+      uint32_t mFlags;
+      uint32_t mAttributeMask;
+      std::vector<VertexAttributes> mVertices;
+      std::vector<uint32_t> mIndices;
+      MaterialInfo mMaterial;
+      Eigen::Matrix4f mDefaultTransformation;
+      EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    };
+
+    Section& activeSection();
+    void resizeVertices(size_t numVertices);
+
+    float mScaleFactor;
+    bool mHasAnimations;
+    uint64_t mSourceSize;
+    uint64_t mSourceHash;
+    std::shared_ptr<Skeleton> mSkeleton;
+    std::vector<Section, Eigen::aligned_allocator<Section>> mSections;
+    int mActiveSection;
+  };
+
+} //end namespace model
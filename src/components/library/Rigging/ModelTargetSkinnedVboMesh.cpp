@@ -3,10 +3,13 @@
 #include "Skeleton.h"
 #include "SkinnedVboMesh.h"
 
+#include <cstring>
+
 namespace model {
 
   ModelTargetSkinnedVboMesh::ModelTargetSkinnedVboMesh(SkinnedVboMesh * mesh)
     : mSkinnedVboMesh(mesh)
+    , mActiveSectionIndex(0)
   {
 
   }
@@ -14,6 +17,7 @@ namespace model {
   void ModelTargetSkinnedVboMesh::setActiveSection(int index)
   {
     mSkinnedVboMesh->setActiveSection(index);
+    mActiveSectionIndex = index;
   }
 
   std::shared_ptr<Skeleton> ModelTargetSkinnedVboMesh::getSkeleton() const
@@ -23,11 +27,7 @@ namespace model {
 
   void ModelTargetSkinnedVboMesh::loadIndices(const std::vector<uint32_t>& indices)
   {
-    const int numBytes = static_cast<int>(indices.size() * sizeof(uint32_t));
-    GLBuffer& indexBuffer = mSkinnedVboMesh->getActiveSection()->getIndices();
-    indexBuffer.Bind();
-    indexBuffer.Allocate(indices.data(), numBytes, GL_STATIC_DRAW);
-    indexBuffer.Unbind();
+    mSkinnedVboMesh->getActiveSection()->setIndices(indices.data(), indices.size());
   }
 
   template <int DIM>
@@ -72,10 +72,15 @@ namespace model {
 
   void ModelTargetSkinnedVboMesh::loadSkeleton(const SkeletonRef& skeleton)
   {
-    if (skeleton->getNumBones() > SkinnedVboMesh::MAXBONES)
-      throw ModelTargetException("Skeleton has more bones than maximal the number allowed.");
-
     mSkinnedVboMesh->setSkeleton(skeleton);
+    // The bone matrices are shared by all sections, so they fit the largest skeleton.
+    const size_t numBones = static_cast<size_t>(skeleton->getNumBones());
+    if (mSkinnedVboMesh->mBoneMatrices.size() < numBones) {
+      mSkinnedVboMesh->mBoneMatrices.resize(numBones, Eigen::Matrix4f::Identity());
+      mSkinnedVboMesh->mInvTransposeMatrices.resize(numBones, Eigen::Matrix4f::Identity());
+    }
+    mSkinnedVboMesh->getActiveSection()->mBoneMatricesPtr = &mSkinnedVboMesh->mBoneMatrices;
+    mSkinnedVboMesh->getActiveSection()->mInvTransposeMatricesPtr = &mSkinnedVboMesh->mInvTransposeMatrices;
   }
 
   void ModelTargetSkinnedVboMesh::loadBoneWeights(const std::vector<BoneWeights>& boneWeights)
@@ -97,9 +102,7 @@ namespace model {
         vIndices.data[b] = static_cast<float>(bone->getBoneIndex());
       }
     }
-
-    mSkinnedVboMesh->getActiveSection()->mBoneMatricesPtr = &mSkinnedVboMesh->mBoneMatrices;
-    mSkinnedVboMesh->getActiveSection()->mInvTransposeMatricesPtr = &mSkinnedVboMesh->mInvTransposeMatrices;
+    mSkinnedVboMesh->getActiveSection()->setSkinningVertices(SkinnedVboMesh::vertexArrayLayout(), attributes.data(), attributes.size());
   }
 
   void ModelTargetSkinnedVboMesh::loadDefaultTransformation(const Eigen::Matrix4f& transformation)
@@ -107,4 +110,34 @@ namespace model {
     mSkinnedVboMesh->setDefaultTransformation(transformation);
   }
 
+  bool ModelTargetSkinnedVboMesh::loadVertexArray(const VertexArrayLayout& layout, const void* vertices, size_t numVertices)
+  {
+    mSkinnedVboMesh->getActiveSection()->setHasNormals(layout.hasAttribute(VertexArrayLayout::NORMAL));
+    if (layout.hasAttribute(VertexArrayLayout::BONE_WEIGHTS)) {
+      mSkinnedVboMesh->getActiveSection()->setSkinningVertices(layout, vertices, numVertices);
+    }
+    VertexBuffer& buffer = mSkinnedVboMesh->getActiveSection()->getVboMesh();
+    if (layout == SkinnedVboMesh::vertexArrayLayout() && !mSkinnedVboMesh->mayMergeSection(mActiveSectionIndex)) {
+      // The vertices are already laid out as VertexAttributes, so upload them as they are
+      // (unless another section in the same merge group may have to be appended to them).
+      std::vector<VertexBuffer::Attributes>().swap(buffer.IntermediateAttributes());
+      buffer.UploadAttributes(static_cast<const VertexBuffer::Attributes*>(vertices), numVertices);
+      return true;
+    }
+
+    // Otherwise (e.g. if the array was written by a different compiler) rearrange each vertex.
+    const VertexArrayLayout native = SkinnedVboMesh::vertexArrayLayout();
+    std::vector<VertexBuffer::Attributes>& attributes = buffer.IntermediateAttributes();
+    attributes.resize(numVertices);
+    const uint8_t* source = static_cast<const uint8_t*>(vertices);
+    for (size_t i=0; i<numVertices; i++) {
+      uint8_t* destination = reinterpret_cast<uint8_t*>(&attributes[i]);
+      for (int a=0; a<VertexArrayLayout::NUM_ATTRIBUTES; a++) {
+        memcpy(destination + native.mOffsets[a], source + layout.mOffsets[a], VertexArrayLayout::NUM_COMPONENTS[a]*sizeof(float));
+      }
+      source += layout.mStride;
+    }
+    return true;
+  }
+
 } //end namespace model
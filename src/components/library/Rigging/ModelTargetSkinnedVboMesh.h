@@ -24,8 +24,10 @@ namespace model {
     virtual void loadSkeleton(const std::shared_ptr<Skeleton>& skeleton) override;
     virtual void loadBoneWeights(const std::vector<BoneWeights>& boneWeights) override;
     virtual void loadDefaultTransformation(const Eigen::Matrix4f& transformation) override;
+    virtual bool loadVertexArray(const VertexArrayLayout& layout, const void* vertices, size_t numVertices) override;
   private:
     SkinnedVboMesh*	mSkinnedVboMesh;
+    int mActiveSectionIndex;
   };
 
 } //end namespace model
\ No newline at end of file
@@ -132,6 +132,8 @@ namespace model {
     int mBoneIndex;
 
   private:
+    friend class CompiledSkeleton;
+
     Node(const Node &rhs); // private to prevent copying; use clone() method instead
     Node& operator=(const Node &rhs); // not defined to prevent copying
   };
@@ -24,9 +24,12 @@ namespace model {
     mRootNode = rhs.getRootNode()->clone();
     cloneTraversal(rhs.getRootNode(), mRootNode);
 
+    mBones.resize(rhs.mBones.size());
     for (auto& entry : rhs.getBoneNames()) {
       std::string name = entry.first;
-      mBoneNames[name] = getNode(name);
+      NodeRef bone = getNode(name);
+      mBoneNames[name] = bone;
+      mBones[bone->getBoneIndex()] = bone;
     }
   }
 
@@ -49,6 +52,12 @@ namespace model {
     }
   }
 
+  int Skeleton::getBoneIndex(const std::string& name) const
+  {
+    auto entry = mBoneNames.find(name);
+    return (entry != mBoneNames.end()) ? entry->second->getBoneIndex() : -1;
+  }
+
   NodeRef Skeleton::getNode(const std::string& name) const
   {
     return findNode(name, mRootNode);
@@ -57,9 +66,19 @@ namespace model {
   void Skeleton::addBone(const std::string &name, const NodeRef &bone)
   {
     if (mBoneNames.count(name) == 0) {
-      bone->setBoneIndex(static_cast<int>(mBoneNames.size()));
+      bone->setBoneIndex(static_cast<int>(mBones.size()));
       mBoneNames[name] = bone;
+      mBones.push_back(bone);
+      mCompiled = nullptr;
+    }
+  }
+
+  CompiledSkeleton& Skeleton::getCompiledSkeleton()
+  {
+    if (!mCompiled) {
+      mCompiled = std::make_shared<CompiledSkeleton>(*this);
     }
+    return *mCompiled;
   }
 
   NodeRef Skeleton::findNode(const std::string& name, const NodeRef& node) const
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "CompiledSkeleton.h"
 #include "Node.h"
 #include <vector>
 #include <unordered_map>
@@ -33,15 +34,28 @@ namespace model {
 
     const NodeRef& getRootNode() const { return mRootNode; }
 
-    void setRootNode(const NodeRef& root) { mRootNode = root; }
+    void setRootNode(const NodeRef& root) { mRootNode = root; mCompiled = nullptr; }
 
     bool hasBone(const std::string& name) const;
     NodeRef getBone(const std::string& name) const;
-    int getNumBones() { return static_cast<int>(mBoneNames.size()); }
+    int getNumBones() const { return static_cast<int>(mBones.size()); }
 
-    //! Adds bone node to name -> NodeRef map.
+    //! Adds bone node to name -> NodeRef map, and gives it the next bone index.
     void addBone(const std::string& name, const NodeRef& bone);
 
+    //! The bones, indexed by their bone indices.  Resolve bones by name once (e.g. with
+    //! getBoneIndex) and then use this, rather than looking them up by name every frame.
+    const std::vector<NodeRef>& getBones() const { return mBones; }
+    const NodeRef& getBone(int index) const { return mBones[index]; }
+    //! Returns the index of the named bone, or -1 if there is no such bone.
+    int getBoneIndex(const std::string& name) const;
+
+    //! The flattened hierarchy, for evaluating the pose in one pass.  It's built upon first use
+    //! and rebuilt after setRootNode or addBone; changing the hierarchy otherwise (e.g. through
+    //! Node::addChild) requires calling invalidateCompiledSkeleton.
+    CompiledSkeleton& getCompiledSkeleton();
+    void invalidateCompiledSkeleton() { mCompiled = nullptr; }
+
     const std::unordered_map<std::string, NodeRef>& getBoneNames() const { return mBoneNames; }
     std::unordered_map<std::string, NodeRef>& getBoneNames() { return mBoneNames; }
 
@@ -62,6 +76,8 @@ namespace model {
 
     NodeRef mRootNode;
     std::unordered_map<std::string, NodeRef> mBoneNames;
+    std::vector<NodeRef> mBones;
+    CompiledSkeletonRef mCompiled;
   };
 
   extern std::ostream& operator<<(std::ostream& lhs, const Skeleton& rhs);
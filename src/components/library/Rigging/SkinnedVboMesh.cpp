@@ -2,11 +2,39 @@
 #include "ModelTargetSkinnedVboMesh.h"
 
 #include "Skeleton.h"
+#include "ThreadPool.h"
+#include "VertexCacheOptimization.h"
+
+#include <algorithm>
+#include <future>
+#include <limits>
 
 namespace model {
 
+  static bool sameMaterial(const MaterialInfo& a, const MaterialInfo& b)
+  {
+    return a.mTexture.IsLoaded() == b.mTexture.IsLoaded() && a.mTexture.GetPath() == b.mTexture.GetPath() &&
+      a.mTransparentColor.Data() == b.mTransparentColor.Data() &&
+      a.mAmbient.Data() == b.mAmbient.Data() &&
+      a.mDiffuse.Data() == b.mDiffuse.Data() &&
+      a.mSpecular.Data() == b.mSpecular.Data() &&
+      a.mShininess == b.mShininess &&
+      a.mEmission.Data() == b.mEmission.Data() &&
+      a.mUseAlpha == b.mUseAlpha &&
+      a.mHasMaterial == b.mHasMaterial &&
+      a.mTwoSided == b.mTwoSided;
+  }
+
   SkinnedVboMesh::MeshSection::MeshSection()
-    : AMeshSection(), mVboMesh(GL_STATIC_DRAW)
+    : AMeshSection()
+    , mBoneMatricesPtr(nullptr)
+    , mInvTransposeMatricesPtr(nullptr)
+    , mVboMesh(GL_STATIC_DRAW)
+    , mIndexType(GL_UNSIGNED_INT)
+    , mNumIndices(0)
+    , mNumBonesUsed(0)
+    , mSkinnedVboMesh(GL_STREAM_DRAW)
+    , mIsCpuSkinned(false)
   { }
 
   void SkinnedVboMesh::MeshSection::setVboMesh(size_t numVertices, size_t numIndices, GLenum primitiveType)
@@ -20,30 +48,105 @@ namespace model {
 
   void SkinnedVboMesh::MeshSection::updateMesh(bool enableSkinning)
   {
-    if (enableSkinning) {
-      int i = 0;
-      for (const auto& entry : mSkeleton->getBoneNames()) {
-        if (i >= MAXBONES) {
-          break;
+    // The bone matrices are computed by SkinnedVboMesh::update, which they're shared by.
+    mIsAnimated = enableSkinning;
+  }
+
+  void SkinnedVboMesh::MeshSection::setSkinningVertices(const VertexArrayLayout& layout, const void* vertices, size_t numVertices)
+  {
+    // The skeleton may not be loaded yet, so the indices are checked against the bone matrices
+    // (in canSkinOnCpu) instead.
+    mSkinningVertices = makeSkinningVertices(layout, vertices, numVertices, std::numeric_limits<int>::max());
+    mNumBonesUsed = 0;
+    for (const SkinningVertex& vertex : mSkinningVertices) {
+      for (int b=0; b<BoneWeights::NB_WEIGHTS; b++) {
+        if (vertex.mWeights[b] != 0.0f) {
+          mNumBonesUsed = std::max(mNumBonesUsed, static_cast<size_t>(vertex.mBoneIndices[b]) + 1);
         }
-        NodeRef bone = entry.second;
-        (*mBoneMatricesPtr)[bone->getBoneIndex()] = bone->getAbsoluteTransformation() * *bone->getOffset();
-        (*mInvTransposeMatricesPtr)[bone->getBoneIndex()] = (*mBoneMatricesPtr)[bone->getBoneIndex()].inverse().transpose();
-        ++i;
       }
-      mIsAnimated = true;
-    } else if (mIsAnimated) {
-      mIsAnimated = false;
     }
+    mSkinnedVboMesh.IntermediateAttributes().resize(numVertices);
   }
 
-  SkinnedVboMeshRef SkinnedVboMesh::create(ModelSourceRef modelSource, SkeletonRef skeleton)
+  bool SkinnedVboMesh::MeshSection::canSkinOnCpu() const
   {
-    return SkinnedVboMeshRef(new SkinnedVboMesh(modelSource, skeleton));
+    return hasSkeleton() && !mSkinningVertices.empty() && mBoneMatricesPtr != nullptr && mNumBonesUsed <= mBoneMatricesPtr->size();
   }
 
-  SkinnedVboMesh::SkinnedVboMesh(ModelSourceRef modelSource, SkeletonRef skeleton)
+  void SkinnedVboMesh::MeshSection::skinOnCpu(size_t begin, size_t end)
+  {
+    const size_t stride = sizeof(SkinnedVertexBuffer::Attributes)/sizeof(float);
+    uint8_t* output = reinterpret_cast<uint8_t*>(&mSkinnedVboMesh.IntermediateAttributes()[begin]);
+    skinVertices(&mSkinningVertices[begin], end - begin,
+                 mBoneMatricesPtr->data(), mInvTransposeMatricesPtr->data(),
+                 reinterpret_cast<float*>(output + SkinnedVertexBuffer::AttributeOffset<0>()),
+                 reinterpret_cast<float*>(output + SkinnedVertexBuffer::AttributeOffset<1>()),
+                 stride);
+  }
+
+  bool SkinnedVboMesh::MeshSection::canMerge(const MeshSection& section) const
+  {
+    return mSkeleton == section.mSkeleton &&
+      mBoneMatricesPtr == section.mBoneMatricesPtr &&
+      mHasNormals == section.mHasNormals &&
+      mHasDefaultTransformation == section.mHasDefaultTransformation &&
+      (!mHasDefaultTransformation || mDefaultTransformation == section.mDefaultTransformation) &&
+      mSkinningVertices.empty() == section.mSkinningVertices.empty() &&
+      sameMaterial(mMatInfo, section.mMatInfo);
+  }
+
+  void SkinnedVboMesh::MeshSection::merge(const MeshSection& section)
+  {
+    std::vector<VertexAttributes>& attributes = mVboMesh.IntermediateAttributes();
+    const std::vector<VertexAttributes>& otherAttributes = section.mVboMesh.IntermediateAttributes();
+    const uint32_t firstVertex = static_cast<uint32_t>(attributes.size());
+    attributes.insert(attributes.end(), otherAttributes.begin(), otherAttributes.end());
+    for (uint32_t index : section.mStagedIndices) {
+      mStagedIndices.push_back(firstVertex + index);
+    }
+    mBoneWeights.insert(mBoneWeights.end(), section.mBoneWeights.begin(), section.mBoneWeights.end());
+    if (!section.mSkinningVertices.empty()) {
+      mSkinningVertices.insert(mSkinningVertices.end(), section.mSkinningVertices.begin(), section.mSkinningVertices.end());
+      mNumBonesUsed = std::max(mNumBonesUsed, section.mNumBonesUsed);
+      mSkinnedVboMesh.IntermediateAttributes().resize(mSkinningVertices.size());
+    }
+  }
+
+  void SkinnedVboMesh::MeshSection::uploadIndices(bool reorderForVertexCache)
+  {
+    size_t numVertices = 0;
+    for (uint32_t index : mStagedIndices) {
+      numVertices = std::max(numVertices, static_cast<size_t>(index) + 1);
+    }
+    if (reorderForVertexCache) {
+      optimizeVertexCache(mStagedIndices.data(), mStagedIndices.size(), numVertices);
+    }
+    mNumIndices = static_cast<int>(mStagedIndices.size());
+
+    // Halve the index data when the indices fit in 16 bits.
+    mIndices.Bind();
+    if (numVertices <= std::numeric_limits<uint16_t>::max() + size_t(1)) {
+      const std::vector<uint16_t> shortIndices(mStagedIndices.begin(), mStagedIndices.end());
+      mIndices.Allocate(shortIndices.data(), static_cast<int>(shortIndices.size()*sizeof(uint16_t)), GL_STATIC_DRAW);
+      mIndexType = GL_UNSIGNED_SHORT;
+    } else {
+      mIndices.Allocate(mStagedIndices.data(), static_cast<int>(mStagedIndices.size()*sizeof(uint32_t)), GL_STATIC_DRAW);
+      mIndexType = GL_UNSIGNED_INT;
+    }
+    mIndices.Unbind();
+    std::vector<uint32_t>().swap(mStagedIndices);
+  }
+
+  SkinnedVboMeshRef SkinnedVboMesh::create(ModelSourceRef modelSource, SkeletonRef skeleton, const LoadOptions& options)
+  {
+    return SkinnedVboMeshRef(new SkinnedVboMesh(modelSource, skeleton, options));
+  }
+
+  SkinnedVboMesh::SkinnedVboMesh(ModelSourceRef modelSource, SkeletonRef skeleton, const LoadOptions& options)
     : mEnableSkinning(true)
+    , mSkinningMode(GPU_SKINNING)
+    , mUsesBonePalette(false)
+    , mLoadOptions(options)
   {
     assert(modelSource->getNumSections() > 0);
 
@@ -52,16 +155,74 @@ namespace model {
       section->setVboMesh(modelSource->getNumVertices(i), modelSource->getNumIndices(i), GL_TRIANGLES);
       section->setSkeleton(skeleton);
       mMeshSections.push_back(section);
+      mMergedSectionIndices.push_back(static_cast<int>(i));
     }
     mActiveSection = mMeshSections[0];
 
     ModelTargetSkinnedVboMesh target(this);
     modelSource->load(&target);
 
+    if (mLoadOptions.mMergeSections) {
+      mergeSections();
+    }
     for (size_t i=0; i<mMeshSections.size(); i++) {
-      mMeshSections[i]->getVboMesh().UploadIntermediateAttributes();
+      // Sections loaded from a prebuilt vertex array have already been uploaded.
+      if (!mMeshSections[i]->getVboMesh().IsUploaded()) {
+        mMeshSections[i]->getVboMesh().UploadIntermediateAttributes();
+      }
       mMeshSections[i]->getVboMesh().ClearIntermediateAttributes();
+      mMeshSections[i]->uploadIndices(mLoadOptions.mOptimizeVertexCache);
+    }
+  }
+
+  bool SkinnedVboMesh::mayMergeSection(int sourceSectionIndex) const
+  {
+    if (!mLoadOptions.mMergeSections) {
+      return false;
     }
+    const std::vector<int>& groups = mLoadOptions.mSectionGroups;
+    auto groupOf = [&groups](size_t i) { return i < groups.size() ? groups[i] : 0; };
+    for (size_t i=0; i<mMergedSectionIndices.size(); i++) {
+      if (i != static_cast<size_t>(sourceSectionIndex) && groupOf(i) == groupOf(sourceSectionIndex)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void SkinnedVboMesh::mergeSections()
+  {
+    std::vector<MeshVboSectionRef> merged;
+    std::vector<int> mergedGroups;
+    const std::vector<int>& groups = mLoadOptions.mSectionGroups;
+    for (size_t i=0; i<mMeshSections.size(); i++) {
+      const int group = i < groups.size() ? groups[i] : 0;
+      size_t m = 0;
+      while (m < merged.size() && !(mergedGroups[m] == group && merged[m]->canMerge(*mMeshSections[i]))) {
+        m++;
+      }
+      if (m == merged.size()) {
+        merged.push_back(mMeshSections[i]);
+        mergedGroups.push_back(group);
+      } else {
+        merged[m]->merge(*mMeshSections[i]);
+      }
+      mMergedSectionIndices[i] = static_cast<int>(m);
+    }
+    mMeshSections.swap(merged);
+    mActiveSection = mMeshSections[0];
+  }
+
+  VertexArrayLayout SkinnedVboMesh::vertexArrayLayout()
+  {
+    VertexArrayLayout layout;
+    layout.mStride = static_cast<uint32_t>(sizeof(VertexAttributes));
+    layout.mOffsets[VertexArrayLayout::POSITION] = static_cast<uint32_t>(VertexBuffer::AttributeOffset<0>());
+    layout.mOffsets[VertexArrayLayout::NORMAL] = static_cast<uint32_t>(VertexBuffer::AttributeOffset<1>());
+    layout.mOffsets[VertexArrayLayout::TEX_COORD] = static_cast<uint32_t>(VertexBuffer::AttributeOffset<2>());
+    layout.mOffsets[VertexArrayLayout::BONE_WEIGHTS] = static_cast<uint32_t>(VertexBuffer::AttributeOffset<3>());
+    layout.mOffsets[VertexArrayLayout::BONE_INDICES] = static_cast<uint32_t>(VertexBuffer::AttributeOffset<4>());
+    return layout;
   }
 
   MeshVboSectionRef& SkinnedVboMesh::setActiveSection(int index)
@@ -73,8 +234,74 @@ namespace model {
 
   void SkinnedVboMesh::update()
   {
+    if (mEnableSkinning) {
+      // The sections all write to mBoneMatrices, so a skeleton shared by several (as usual) only
+      // needs to be evaluated once.
+      const Skeleton* evaluated = nullptr;
+      for (const MeshVboSectionRef& section : mMeshSections) {
+        Skeleton* skeleton = section->getSkeleton().get();
+        if (skeleton && skeleton != evaluated) {
+          skeleton->getCompiledSkeleton().evaluate(mBoneMatrices.data(), mInvTransposeMatrices.data(), mBoneMatrices.size());
+          evaluated = skeleton;
+        }
+      }
+    }
     for (MeshVboSectionRef section : mMeshSections) {
       section->updateMesh(mEnableSkinning);
+      section->mIsCpuSkinned = false;
+    }
+    if (mEnableSkinning && mSkinningMode == CPU_SKINNING) {
+      skinOnCpu();
+    }
+    mUsesBonePalette = mEnableSkinning && mSkinningMode == GPU_PALETTE_SKINNING && BonePalette::isSupported();
+    if (mUsesBonePalette) {
+      mBonePalette.update(mBoneMatrices.data(), mInvTransposeMatrices.data(), mBoneMatrices.size());
+    }
+  }
+
+  void SkinnedVboMesh::skinOnCpu()
+  {
+    // Large sections are split up so that a single section still keeps every worker busy.
+    static const size_t VERTICES_PER_TASK = 4096;
+    struct Task {
+      MeshSection* mSection;
+      size_t mBegin;
+      size_t mEnd;
+    };
+    std::vector<Task> tasks;
+    for (const MeshVboSectionRef& section : mMeshSections) {
+      if (!section->canSkinOnCpu()) {
+        continue;
+      }
+      const size_t numVertices = section->mSkinningVertices.size();
+      for (size_t begin = 0; begin < numVertices; begin += VERTICES_PER_TASK) {
+        Task task = { section.get(), begin, std::min(begin + VERTICES_PER_TASK, numVertices) };
+        tasks.push_back(task);
+      }
+    }
+    if (tasks.empty()) {
+      return;
+    }
+
+    // The bone matrices were all computed above, so the tasks only read shared data.  The first
+    // task is run on this thread, which would otherwise just wait.
+    std::vector<std::future<void>> results;
+    results.reserve(tasks.size() - 1);
+    for (size_t i = 1; i < tasks.size(); ++i) {
+      const Task task = tasks[i];
+      results.push_back(ThreadPool::Shared().Submit([task] { task.mSection->skinOnCpu(task.mBegin, task.mEnd); }));
+    }
+    tasks[0].mSection->skinOnCpu(tasks[0].mBegin, tasks[0].mEnd);
+    for (std::future<void>& result : results) {
+      result.get();
+    }
+
+    // Uploading has to happen on this (the GL) thread.
+    for (const MeshVboSectionRef& section : mMeshSections) {
+      if (section->canSkinOnCpu()) {
+        section->mSkinnedVboMesh.UploadIntermediateAttributes();
+        section->mIsCpuSkinned = true;
+      }
     }
   }
 
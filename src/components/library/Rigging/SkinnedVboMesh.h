@@ -1,6 +1,8 @@
 #pragma once
 
 #include "AMeshSection.h"
+#include "BonePalette.h"
+#include "CpuSkinning.h"
 
 #include "GLShader.h"
 #include "GLVertexBuffer.h"
@@ -21,11 +23,52 @@ namespace model {
 
   typedef VertexBuffer::Attributes VertexAttributes;
 
+  //! The positions and normals of a section skinned on the CPU, which are streamed to the GPU each update.
+  typedef GLVertexBuffer<GLVertexAttribute<GL_FLOAT_VEC3>, // position
+    GLVertexAttribute<GL_FLOAT_VEC3>> // normal
+    SkinnedVertexBuffer;
+
+  //! Bone matrices, indexed by bone index.
+  typedef std::vector<Eigen::Matrix4f, Eigen::aligned_allocator<Eigen::Matrix4f>> BoneMatrices;
+
   class SkinnedVboMesh
   {
   public:
+    //! The number of bone matrices which fit in the uniform arrays of the GPU_SKINNING shader.
+    //! The other skinning modes take any number of bones.
     static const int MAXBONES = 92;
 
+    /*!
+     *  Where the vertices are skinned.  GPU_SKINNING leaves it to the vertex shader, which gets
+     *  the bone matrices as uniform arrays (so only the first MAXBONES bones can be used).
+     *  GPU_PALETTE_SKINNING also skins in the vertex shader, but one which fetches the matrices
+     *  from getBonePalette(), which update() keeps up to date; if texture buffers aren't
+     *  supported, it falls back to GPU_SKINNING (see usesBonePalette()).  CPU_SKINNING skins the
+     *  sections on the CPU (see CpuSkinning.h) across a thread pool in update(), and streams the
+     *  skinned positions and normals into each section's getSkinnedVboMesh(), which is cheaper
+     *  than vertex shader skinning on software GL.
+     */
+    enum SkinningMode { GPU_SKINNING, GPU_PALETTE_SKINNING, CPU_SKINNING };
+
+    //! How the sections of a model source are turned into the mesh's sections.
+    struct LoadOptions
+    {
+      LoadOptions() : mMergeSections(false), mOptimizeVertexCache(false) { }
+      /*!
+       *  Merges the sections which share a material, skeleton and default transformation (and
+       *  merge group) into one, so that they are drawn with a single draw call.  Use
+       *  getMergedSectionIndex to find where a section of the model source ended up.
+       */
+      bool mMergeSections;
+      //! The merge group of each section of the model source, by index (missing ones are in
+      //! group 0).  Only sections in the same group are merged, so sections which aren't always
+      //! drawn together must be put in different groups.  A section alone in its group is
+      //! uploaded without copying if its source supports ModelTarget::loadVertexArray.
+      std::vector<int> mSectionGroups;
+      //! Reorders the triangles of each section for the vertex cache (see VertexCacheOptimization.h).
+      bool mOptimizeVertexCache;
+    };
+
     struct MeshSection : public AMeshSection
     {
       MeshSection();
@@ -37,17 +80,46 @@ namespace model {
 
       GLBuffer& getIndices() { return mIndices; }
       const GLBuffer& getIndices() const { return mIndices; }
-
-      std::array<Eigen::Matrix4f, MAXBONES>* mBoneMatricesPtr;
-      std::array<Eigen::Matrix4f, MAXBONES>* mInvTransposeMatricesPtr;
+      //! GL_UNSIGNED_SHORT if the section has few enough vertices, otherwise GL_UNSIGNED_INT.
+      GLenum getIndexType() const { return mIndexType; }
+      int getNumIndices() const { return mNumIndices; }
+      //! Keeps the indices until they're uploaded, once the whole model has been loaded.
+      void setIndices(const uint32_t* indices, size_t numIndices) { mStagedIndices.assign(indices, indices + numIndices); }
+
+      //! Keeps the bind pose of the given vertices, so that the section can be skinned on the CPU.
+      void setSkinningVertices(const VertexArrayLayout& layout, const void* vertices, size_t numVertices);
+      bool canSkinOnCpu() const;
+      //! Whether the last update skinned the section on the CPU, in which case its positions and
+      //! normals are to be taken from getSkinnedVboMesh() and the vertex shader must not skin it.
+      bool isCpuSkinned() const { return mIsCpuSkinned; }
+      const SkinnedVertexBuffer& getSkinnedVboMesh() const { return mSkinnedVboMesh; }
+
+      BoneMatrices* mBoneMatricesPtr;
+      BoneMatrices* mInvTransposeMatricesPtr;
       EIGEN_MAKE_ALIGNED_OPERATOR_NEW
     private:
+      friend class SkinnedVboMesh;
+      void skinOnCpu(size_t begin, size_t end);
+      bool canMerge(const MeshSection& section) const;
+      void merge(const MeshSection& section);
+      void uploadIndices(bool optimizeVertexCache);
+
       VertexBuffer mVboMesh;
       GLBuffer mIndices;
+      std::vector<uint32_t> mStagedIndices;
+      GLenum mIndexType;
+      int mNumIndices;
+      SkinningVertices mSkinningVertices;
+      //! One more than the largest bone index which mSkinningVertices use.
+      size_t mNumBonesUsed;
+      SkinnedVertexBuffer mSkinnedVboMesh;
+      bool mIsCpuSkinned;
     };
     typedef std::shared_ptr<SkinnedVboMesh::MeshSection> MeshVboSectionRef;
 
-    static SkinnedVboMeshRef create(ModelSourceRef modelSource, std::shared_ptr<Skeleton> skeleton = nullptr);
+    static SkinnedVboMeshRef create(ModelSourceRef modelSource, std::shared_ptr<Skeleton> skeleton = nullptr, const LoadOptions& options = LoadOptions());
+    //! The layout of VertexAttributes, in which vertex arrays can be uploaded without copying.
+    static VertexArrayLayout vertexArrayLayout();
 
     void update();
 
@@ -56,6 +128,9 @@ namespace model {
     MeshVboSectionRef& setActiveSection(int index);
     std::vector<MeshVboSectionRef>& getSections() { return mMeshSections; }
     const std::vector<MeshVboSectionRef>& getSections() const { return mMeshSections; }
+    //! The index of the section which the given section of the model source was loaded into,
+    //! which is the same index unless sections were merged.
+    int getMergedSectionIndex(int sourceSectionIndex) const { return mMergedSectionIndices[sourceSectionIndex]; }
 
     std::shared_ptr<Skeleton>& getSkeleton() { return mActiveSection->getSkeleton(); }
     const std::shared_ptr<Skeleton>& getSkeleton() const { return mActiveSection->getSkeleton(); }
@@ -67,18 +142,40 @@ namespace model {
 
     void setEnableSkinning(bool enabled) { mEnableSkinning = enabled; }
 
+    //! Selects where the vertices are skinned, from the next update() on.
+    void setSkinningMode(SkinningMode mode) { mSkinningMode = mode; }
+    SkinningMode getSkinningMode() const { return mSkinningMode; }
+    //! Whether the last update() uploaded the bone matrices to getBonePalette(), which is the
+    //! case in GPU_PALETTE_SKINNING mode if texture buffers are supported.
+    bool usesBonePalette() const { return mUsesBonePalette; }
+    const BonePalette& getBonePalette() const { return mBonePalette; }
+
     friend struct SkinnedVboMesh::MeshSection;
+    friend class ModelTargetSkinnedVboMesh;
 
-    std::array<Eigen::Matrix4f, MAXBONES> mBoneMatrices;
-    std::array<Eigen::Matrix4f, MAXBONES> mInvTransposeMatrices;
+    //! Sized to the largest skeleton loaded.
+    BoneMatrices mBoneMatrices;
+    BoneMatrices mInvTransposeMatrices;
 
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
   protected:
     bool mEnableSkinning;
-    SkinnedVboMesh(ModelSourceRef modelSource, std::shared_ptr<Skeleton> skeleton = nullptr);
+    SkinningMode mSkinningMode;
+    bool mUsesBonePalette;
+    BonePalette mBonePalette;
+    SkinnedVboMesh(ModelSourceRef modelSource, std::shared_ptr<Skeleton> skeleton, const LoadOptions& options);
     MeshVboSectionRef mActiveSection;
     std::vector< MeshVboSectionRef > mMeshSections;
+    std::vector<int> mMergedSectionIndices;
+    LoadOptions mLoadOptions;
+
+  private:
+    void skinOnCpu();
+    //! Whether the given section of the model source shares its merge group with another, in
+    //! which case its vertices must be kept until the sections have been merged.
+    bool mayMergeSection(int sourceSectionIndex) const;
+    void mergeSections();
   };
 
 
@@ -0,0 +1,344 @@
+#include "ModelBinaryFormat.h"
+#include "ModelSourceBinary.h"
+#include "ModelTargetBinary.h"
+#include "Skeleton.h"
+#include "SkinnedVboMesh.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <iterator>
+
+using namespace model;
+
+namespace {
+
+// Records everything a source loads, through the per-attribute load methods unless it accepts
+// vertex arrays.
+class RecordingTarget : public ModelTarget {
+public:
+  struct Section {
+    Section() : mHasDefaultTransformation(false), mNumPackedVertices(0) { }
+    std::string mName;
+    std::vector<uint32_t> mIndices;
+    std::vector<Eigen::Vector3f> mPositions;
+    std::vector<Eigen::Vector3f> mNormals;
+    std::vector<Eigen::Vector2f> mTexCoords;
+    std::vector<MaterialInfo> mMaterials;
+    SkeletonRef mSkeleton;
+    std::vector<BoneWeights> mBoneWeights;
+    bool mHasDefaultTransformation;
+    Eigen::Matrix4f mDefaultTransformation;
+    VertexArrayLayout mLayout;
+    std::vector<uint8_t> mPackedVertices;
+    size_t mNumPackedVertices;
+  };
+
+  RecordingTarget(bool acceptVertexArrays = false) : mAcceptVertexArrays(acceptVertexArrays), mActive(nullptr) { }
+
+  virtual void setActiveSection(int index) override {
+    if (static_cast<size_t>(index) >= mSections.size()) {
+      mSections.resize(index + 1);
+    }
+    mActive = &mSections[index];
+  }
+  virtual SkeletonRef getSkeleton() const override { return nullptr; }
+  virtual void loadName(std::string name) override { mActive->mName = name; }
+  virtual void loadVertexPositions(const std::vector<Eigen::Vector3f>& positions) override { mActive->mPositions = positions; }
+  virtual void loadIndices(const std::vector<uint32_t>& indices) override { mActive->mIndices = indices; }
+  virtual void loadTex(const std::vector<Eigen::Vector2f>& texCoords, const MaterialInfo& matInfo) override {
+    mActive->mTexCoords = texCoords;
+    mActive->mMaterials.push_back(matInfo);
+  }
+  virtual void loadVertexNormals(const std::vector<Eigen::Vector3f>& normals) override { mActive->mNormals = normals; }
+  virtual void loadSkeleton(const SkeletonRef& skeleton) override { mActive->mSkeleton = skeleton; }
+  virtual void loadBoneWeights(const std::vector<BoneWeights>& boneWeights) override { mActive->mBoneWeights = boneWeights; }
+  virtual void loadDefaultTransformation(const Eigen::Matrix4f& transformation) override {
+    mActive->mHasDefaultTransformation = true;
+    mActive->mDefaultTransformation = transformation;
+  }
+  virtual bool loadVertexArray(const VertexArrayLayout& layout, const void* vertices, size_t numVertices) override {
+    if (!mAcceptVertexArrays) {
+      return false;
+    }
+    mActive->mLayout = layout;
+    mActive->mPackedVertices.assign(static_cast<const uint8_t*>(vertices), static_cast<const uint8_t*>(vertices) + numVertices*layout.mStride);
+    mActive->mNumPackedVertices = numVertices;
+    return true;
+  }
+
+  std::vector<Section> mSections;
+
+private:
+  bool mAcceptVertexArrays;
+  Section* mActive;
+};
+
+} // end of anonymous namespace
+
+class ModelBinaryTest : public testing::Test {
+protected:
+
+  virtual void SetUp () override {
+    const char *directory = std::getenv("TMPDIR");
+    m_path = std::string((directory != nullptr && *directory != '\0') ? directory : "/tmp") + "/ModelBinaryTest.rigbin";
+    WriteModel(m_path, 10.0f);
+  }
+  virtual void TearDown () override {
+    std::remove(m_path.c_str());
+  }
+
+  // A skinned section, whose vertices are weighted between two bones under a non-bone root,
+  // followed by an unskinned section, as ModelSourceAssimp would load them.  If sourcePath isn't
+  // empty, the model is recorded as converted from that file.
+  static void WriteModel (const std::string &path, float scaleFactor, const std::string &sourcePath = "") {
+    SkeletonRef skeleton = Skeleton::create();
+    NodeRef root(new Node(Eigen::Vector3f(1, 2, 3), Eigen::Quaternionf::Identity(), Eigen::Vector3f::Ones(), "Root"));
+    NodeRef arm(new Node(Eigen::Vector3f(0, 5, 0), Eigen::Quaternionf(Eigen::AngleAxisf(0.5f, Eigen::Vector3f::UnitZ())), Eigen::Vector3f::Ones(), "Arm", root, 1));
+    NodeRef hand(new Node(Eigen::Vector3f(0, 3, 0), Eigen::Quaternionf::Identity(), Eigen::Vector3f(2, 2, 2), "Hand", arm, 2));
+    root->addChild(arm);
+    arm->addChild(hand);
+    skeleton->setRootNode(root);
+    skeleton->addBone("Arm", arm);
+    skeleton->addBone("Hand", hand);
+    arm->setOffsetMatrix(Eigen::Matrix4f::Identity() * 2.0f);
+    hand->setOffsetMatrix(Eigen::Matrix4f::Identity() * 3.0f);
+
+    ModelTargetBinary target(scaleFactor);
+    target.setActiveSection(0);
+    target.loadName("Skin");
+    target.loadIndices({ 0, 1, 2, 2, 1, 0 });
+    target.loadVertexPositions({ Eigen::Vector3f(0, 0, 0), Eigen::Vector3f(1, 0, 0), Eigen::Vector3f(0, 1, 0) });
+    target.loadVertexNormals({ Eigen::Vector3f(0, 0, 1), Eigen::Vector3f(0, 1, 0), Eigen::Vector3f(1, 0, 0) });
+    MaterialInfo material;
+    material.mDiffuse = Color(0.25f, 0.5f, 0.75f, 1.0f);
+    material.mShininess = 8.0f;
+    material.mTwoSided = true;
+    target.loadTex({ Eigen::Vector2f(0, 0), Eigen::Vector2f(1, 0), Eigen::Vector2f(0, 1) }, material);
+    target.loadSkeleton(skeleton);
+    std::vector<BoneWeights> boneWeights(3);
+    boneWeights[0].addWeight(arm, 1.0f);
+    boneWeights[1].addWeight(arm, 0.25f);
+    boneWeights[1].addWeight(hand, 0.75f);
+    boneWeights[2].addWeight(hand, 1.0f);
+    target.loadBoneWeights(boneWeights);
+
+    target.setActiveSection(1);
+    target.loadName("Strap");
+    target.loadIndices({ 0, 1, 2 });
+    target.loadVertexPositions({ Eigen::Vector3f(4, 0, 0), Eigen::Vector3f(5, 0, 0), Eigen::Vector3f(4, 1, 0) });
+    Eigen::Matrix4f transformation(Eigen::Matrix4f::Identity());
+    transformation.block<3, 1>(0, 3) = Eigen::Vector3f(7, 8, 9);
+    target.loadDefaultTransformation(transformation);
+
+    target.setHasAnimations(true);
+    if (!sourcePath.empty()) {
+      target.setSourceFile(sourcePath);
+    }
+    target.write(path);
+  }
+
+  static std::vector<char> ReadFile (const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  }
+  static void WriteFile (const std::string &path, const std::vector<char> &contents) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(contents.data(), contents.size());
+  }
+
+  std::string m_path;
+};
+
+TEST_F(ModelBinaryTest, DescribesTheModel) {
+  ModelSourceBinaryRef source = ModelSourceBinary::create(m_path, 10.0f);
+  ASSERT_EQ(2u, source->getNumSections());
+  EXPECT_EQ(3u, source->getNumVertices(0));
+  EXPECT_EQ(6u, source->getNumIndices(0));
+  EXPECT_TRUE(source->hasNormals(0));
+  EXPECT_TRUE(source->hasSkeleton(0));
+  EXPECT_TRUE(source->hasMaterials(0));
+  EXPECT_FALSE(source->hasNormals(1));
+  EXPECT_FALSE(source->hasSkeleton(1));
+  EXPECT_FALSE(source->hasMaterials(1));
+  EXPECT_TRUE(source->hasAnimations());
+  EXPECT_EQ(10.0f, source->getScaleFactor());
+}
+
+TEST_F(ModelBinaryTest, LoadsThroughThePerAttributeMethods) {
+  RecordingTarget target;
+  ModelSourceBinary::create(m_path)->load(&target);
+  ASSERT_EQ(2u, target.mSections.size());
+
+  const RecordingTarget::Section& skin = target.mSections[0];
+  EXPECT_EQ("Skin", skin.mName);
+  EXPECT_EQ(std::vector<uint32_t>({ 0, 1, 2, 2, 1, 0 }), skin.mIndices);
+  ASSERT_EQ(3u, skin.mPositions.size());
+  EXPECT_EQ(Eigen::Vector3f(1, 0, 0), skin.mPositions[1]);
+  ASSERT_EQ(3u, skin.mNormals.size());
+  EXPECT_EQ(Eigen::Vector3f(0, 1, 0), skin.mNormals[1]);
+  ASSERT_EQ(3u, skin.mTexCoords.size());
+  EXPECT_EQ(Eigen::Vector2f(0, 1), skin.mTexCoords[2]);
+  ASSERT_EQ(1u, skin.mMaterials.size());
+  EXPECT_EQ(0.5f, skin.mMaterials[0].mDiffuse.G());
+  EXPECT_EQ(8.0f, skin.mMaterials[0].mShininess);
+  EXPECT_TRUE(skin.mMaterials[0].mTwoSided);
+  EXPECT_FALSE(skin.mMaterials[0].mUseAlpha);
+  ASSERT_TRUE(skin.mSkeleton != nullptr);
+  ASSERT_EQ(3u, skin.mBoneWeights.size());
+  ASSERT_EQ(2u, skin.mBoneWeights[1].mActiveNbWeights);
+  EXPECT_EQ("Arm", skin.mBoneWeights[1].getBone(0)->getName());
+  EXPECT_EQ(0.25f, skin.mBoneWeights[1].getWeight(0));
+  EXPECT_EQ(skin.mSkeleton->getBone("Hand"), skin.mBoneWeights[1].getBone(1));
+  EXPECT_EQ(0.75f, skin.mBoneWeights[1].getWeight(1));
+  EXPECT_FALSE(skin.mHasDefaultTransformation);
+
+  const RecordingTarget::Section& strap = target.mSections[1];
+  EXPECT_EQ("Strap", strap.mName);
+  EXPECT_EQ(Eigen::Vector3f(5, 0, 0), strap.mPositions[1]);
+  EXPECT_TRUE(strap.mNormals.empty());
+  EXPECT_TRUE(strap.mMaterials.empty());
+  EXPECT_TRUE(strap.mSkeleton == nullptr);
+  EXPECT_TRUE(strap.mHasDefaultTransformation);
+  const Eigen::Vector3f translation = strap.mDefaultTransformation.topRightCorner<3, 1>();
+  EXPECT_EQ(Eigen::Vector3f(7, 8, 9), translation);
+}
+
+TEST_F(ModelBinaryTest, RebuildsTheSkeleton) {
+  ModelSourceBinaryRef source = ModelSourceBinary::create(m_path);
+  RecordingTarget first, second;
+  source->load(&first);
+  source->load(&second);
+  const SkeletonRef& skeleton = first.mSections[0].mSkeleton;
+  ASSERT_TRUE(skeleton != nullptr);
+  // Each load gets a skeleton of its own, so that meshes can be posed independently.
+  EXPECT_NE(skeleton, second.mSections[0].mSkeleton);
+
+  ASSERT_EQ(2, skeleton->getNumBones());
+  const NodeRef& root = skeleton->getRootNode();
+  EXPECT_EQ("Root", root->getName());
+  EXPECT_EQ(-1, root->getBoneIndex());
+  EXPECT_TRUE(root->getOffset() == nullptr);
+  ASSERT_EQ(1, root->getNumChildren());
+  NodeRef arm = skeleton->getBone("Arm");
+  NodeRef hand = skeleton->getBone("Hand");
+  EXPECT_EQ(root->getChildren()[0], arm);
+  EXPECT_EQ(root, arm->getParent().lock());
+  EXPECT_EQ(arm, hand->getParent().lock());
+  EXPECT_EQ(0, arm->getBoneIndex());
+  EXPECT_EQ(1, hand->getBoneIndex());
+  EXPECT_EQ(2, hand->getLevel());
+  EXPECT_TRUE(arm->getRelativeRotation().isApprox(Eigen::Quaternionf(Eigen::AngleAxisf(0.5f, Eigen::Vector3f::UnitZ()))));
+  EXPECT_EQ(Eigen::Vector3f(2, 2, 2), hand->getRelativeScale());
+  ASSERT_TRUE(hand->getOffset() != nullptr);
+  EXPECT_EQ(Eigen::Matrix4f(Eigen::Matrix4f::Identity() * 3.0f), *hand->getOffset());
+  EXPECT_EQ(Eigen::Vector3f(1, 2, 3), root->getRelativePosition());
+  EXPECT_EQ(Eigen::Vector3f(0, 3, 0), hand->getInitialRelativePosition());
+}
+
+TEST_F(ModelBinaryTest, GivesPrebuiltVertexArrays) {
+  RecordingTarget target(true);
+  ModelSourceBinary::create(m_path)->load(&target);
+  const RecordingTarget::Section& skin = target.mSections[0];
+
+  // The vertices are stored as SkinnedVboMesh's attributes, so it can upload them as they are.
+  EXPECT_TRUE(skin.mLayout == SkinnedVboMesh::vertexArrayLayout());
+  EXPECT_TRUE(skin.mLayout.hasAttribute(VertexArrayLayout::NORMAL));
+  ASSERT_EQ(3u, skin.mNumPackedVertices);
+  const VertexAttributes* vertices = reinterpret_cast<const VertexAttributes*>(skin.mPackedVertices.data());
+  const float* position = reinterpret_cast<const float*>(&std::get<0>(vertices[1]));
+  EXPECT_EQ(1.0f, position[0]);
+  const float* weights = reinterpret_cast<const float*>(&std::get<3>(vertices[1]));
+  const float* boneIndices = reinterpret_cast<const float*>(&std::get<4>(vertices[1]));
+  EXPECT_EQ(0.25f, weights[0]);
+  EXPECT_EQ(0.75f, weights[1]);
+  EXPECT_EQ(0.0f, weights[2]);
+  EXPECT_EQ(0.0f, boneIndices[0]);
+  EXPECT_EQ(1.0f, boneIndices[1]);
+
+  // The per-vertex methods aren't used, but the material and skeleton still are.
+  EXPECT_TRUE(skin.mPositions.empty());
+  EXPECT_TRUE(skin.mBoneWeights.empty());
+  EXPECT_TRUE(skin.mTexCoords.empty());
+  ASSERT_EQ(1u, skin.mMaterials.size());
+  EXPECT_EQ(8.0f, skin.mMaterials[0].mShininess);
+  EXPECT_TRUE(skin.mSkeleton != nullptr);
+  EXPECT_TRUE(target.mSections[1].mHasDefaultTransformation);
+}
+
+TEST_F(ModelBinaryTest, RejectsMismatchedFiles) {
+  EXPECT_TRUE(ModelSourceBinary::tryCreate(m_path + ".missing") == nullptr);
+  EXPECT_TRUE(ModelSourceBinary::tryCreate(m_path, 1.0f) == nullptr);
+  EXPECT_TRUE(ModelSourceBinary::tryCreate(m_path, 10.0f) != nullptr);
+
+  const std::vector<char> contents = ReadFile(m_path);
+  ASSERT_GT(contents.size(), sizeof(binary::FileHeader));
+
+  std::vector<char> otherVersion(contents);
+  binary::FileHeader header;
+  std::memcpy(&header, otherVersion.data(), sizeof(header));
+  header.mVersion += 1;
+  std::memcpy(otherVersion.data(), &header, sizeof(header));
+  WriteFile(m_path, otherVersion);
+  EXPECT_THROW(ModelSourceBinary::create(m_path), LoadErrorException);
+
+  std::vector<char> truncated(contents.begin(), contents.end() - 4);
+  WriteFile(m_path, truncated);
+  EXPECT_THROW(ModelSourceBinary::create(m_path), LoadErrorException);
+
+  // An index past the end of its section's vertices.
+  std::vector<char> badIndex(contents);
+  binary::SectionRecord section;
+  std::memcpy(&section, badIndex.data() + header.mStringTableOffset - 2*sizeof(binary::SectionRecord), sizeof(section));
+  const uint32_t outOfRange = 3;
+  std::memcpy(badIndex.data() + section.mIndicesOffset, &outOfRange, sizeof(outOfRange));
+  WriteFile(m_path, badIndex);
+  EXPECT_THROW(ModelSourceBinary::create(m_path), LoadErrorException);
+}
+
+TEST_F(ModelBinaryTest, RejectsAStaleSource) {
+  const std::string sourcePath = m_path + ".fbx";
+  const std::vector<char> source = { 'm', 'o', 'd', 'e', 'l' };
+  WriteFile(sourcePath, source);
+  WriteModel(m_path, 10.0f, sourcePath);
+  EXPECT_TRUE(ModelSourceBinary::tryCreate(m_path, 10.0f, sourcePath) != nullptr);
+
+  // Changed contents, of the same size and then of another.
+  std::vector<char> changed(source);
+  changed[0] = 'M';
+  WriteFile(sourcePath, changed);
+  EXPECT_THROW(ModelSourceBinary::create(m_path, 10.0f, sourcePath), LoadErrorException);
+  changed.push_back('!');
+  WriteFile(sourcePath, changed);
+  EXPECT_THROW(ModelSourceBinary::create(m_path, 10.0f, sourcePath), LoadErrorException);
+
+  // Without the source (or its path), the binary model is all there is to load.
+  std::remove(sourcePath.c_str());
+  EXPECT_TRUE(ModelSourceBinary::tryCreate(m_path, 10.0f, sourcePath) != nullptr);
+  EXPECT_TRUE(ModelSourceBinary::tryCreate(m_path, 10.0f) != nullptr);
+
+  // A binary model which wasn't recorded as converted from the source doesn't match it either.
+  WriteFile(sourcePath, source);
+  WriteModel(m_path, 10.0f);
+  EXPECT_TRUE(ModelSourceBinary::tryCreate(m_path, 10.0f, sourcePath) == nullptr);
+  std::remove(sourcePath.c_str());
+}
+
+TEST_F(ModelBinaryTest, RejectsABoneIndexPastTheNodes) {
+  std::vector<char> contents = ReadFile(m_path);
+  binary::FileHeader header;
+  std::memcpy(&header, contents.data(), sizeof(header));
+  ASSERT_EQ(3u, header.mNumNodes);
+
+  // Which would otherwise have sized the check for contiguous indices.
+  binary::NodeRecord node;
+  char* const hand = contents.data() + sizeof(header) + 2*sizeof(binary::NodeRecord);
+  std::memcpy(&node, hand, sizeof(node));
+  ASSERT_EQ(1, node.mBoneIndex);
+  node.mBoneIndex = 0x7fffffff;
+  std::memcpy(hand, &node, sizeof(node));
+  WriteFile(m_path, contents);
+  EXPECT_THROW(ModelSourceBinary::create(m_path), LoadErrorException);
+}
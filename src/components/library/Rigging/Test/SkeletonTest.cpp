@@ -0,0 +1,103 @@
+#include "Skeleton.h"
+
+#include <gtest/gtest.h>
+
+using namespace model;
+
+class SkeletonTest : public testing::Test {
+protected:
+
+  // Root -> Arm -> Hand -> Finger, where all but the root are bones.
+  static SkeletonRef CreateSkeleton () {
+    SkeletonRef skeleton = Skeleton::create();
+    NodeRef parent(new Node(Eigen::Vector3f::Zero(), Eigen::Quaternionf::Identity(), Eigen::Vector3f::Ones(), "Root"));
+    skeleton->setRootNode(parent);
+    const char *boneNames[] = { "Arm", "Hand", "Finger" };
+    for (int i = 0; i < 3; ++i) {
+      NodeRef bone(new Node(Eigen::Vector3f(0, 1, 0), Eigen::Quaternionf::Identity(), Eigen::Vector3f::Ones(), boneNames[i], parent, i + 1));
+      bone->setOffsetMatrix(Eigen::Matrix4f::Identity());
+      parent->addChild(bone);
+      skeleton->addBone(boneNames[i], bone);
+      parent = bone;
+    }
+    return skeleton;
+  }
+};
+
+TEST_F(SkeletonTest, BonesAreIndexedInTheOrderTheyWereAdded) {
+  SkeletonRef skeleton = CreateSkeleton();
+  ASSERT_EQ(3, skeleton->getNumBones());
+  ASSERT_EQ(3u, skeleton->getBones().size());
+  EXPECT_EQ(1, skeleton->getBoneIndex("Hand"));
+  EXPECT_EQ(-1, skeleton->getBoneIndex("Root"));
+  EXPECT_EQ(-1, skeleton->getBoneIndex("Missing"));
+  for (int i = 0; i < skeleton->getNumBones(); ++i) {
+    const NodeRef &bone = skeleton->getBone(i);
+    EXPECT_EQ(i, bone->getBoneIndex());
+    EXPECT_EQ(bone, skeleton->getBone(bone->getName()));
+  }
+
+  // Adding a bone under a name which is already used does nothing.
+  skeleton->addBone("Hand", skeleton->getRootNode());
+  EXPECT_EQ(3, skeleton->getNumBones());
+  EXPECT_EQ(-1, skeleton->getRootNode()->getBoneIndex());
+}
+
+TEST_F(SkeletonTest, ClonesHaveTheirOwnBoneTable) {
+  SkeletonRef skeleton = CreateSkeleton();
+  SkeletonRef clone = skeleton->clone();
+  ASSERT_EQ(skeleton->getNumBones(), clone->getNumBones());
+  for (int i = 0; i < clone->getNumBones(); ++i) {
+    const NodeRef &bone = clone->getBone(i);
+    EXPECT_NE(skeleton->getBone(i), bone);
+    EXPECT_EQ(skeleton->getBone(i)->getName(), bone->getName());
+    EXPECT_EQ(i, bone->getBoneIndex());
+    EXPECT_EQ(clone->getNode(bone->getName()), bone);
+  }
+}
+
+TEST_F(SkeletonTest, CompiledSkeletonMatchesTheNodeHierarchy) {
+  SkeletonRef skeleton = CreateSkeleton();
+  // Branch off a second finger, so that the hierarchy isn't just a chain.
+  NodeRef hand = skeleton->getBone("Hand");
+  NodeRef thumb(new Node(Eigen::Vector3f(1, 0.5f, 0), Eigen::Quaternionf::Identity(), Eigen::Vector3f::Ones(), "Thumb", hand, 3));
+  hand->addChild(thumb);
+  skeleton->addBone("Thumb", thumb);
+
+  for (int i = 0; i < skeleton->getNumBones(); ++i) {
+    const NodeRef &bone = skeleton->getBone(i);
+    Eigen::Matrix4f offset = Eigen::Matrix4f::Identity();
+    offset.topLeftCorner<3, 3>() = Eigen::AngleAxisf(0.3f*i, Eigen::Vector3f::UnitX()).toRotationMatrix()*(1.0f + 0.1f*i);
+    offset.topRightCorner<3, 1>() = Eigen::Vector3f(0.0f, -1.0f*i, 0.5f);
+    bone->setOffsetMatrix(offset);
+    bone->setRelativeRotation(Eigen::Quaternionf(Eigen::AngleAxisf(0.2f + 0.1f*i, Eigen::Vector3f(1, 2, 3).normalized())));
+    bone->setRelativeScale(Eigen::Vector3f(1.0f, 1.0f + 0.05f*i, 1.0f - 0.05f*i));
+  }
+
+  // The clone is evaluated by walking its nodes, and the original through its compiled skeleton.
+  SkeletonRef reference = skeleton->clone();
+  CompiledSkeleton &compiled = skeleton->getCompiledSkeleton();
+  ASSERT_EQ(5u, compiled.getNumNodes());
+  ASSERT_EQ(4u, compiled.getNumBones());
+  for (size_t i = 0; i < compiled.getNumNodes(); ++i) {
+    EXPECT_LT(compiled.getParentIndex(i), static_cast<int>(i));
+  }
+
+  std::vector<Eigen::Matrix4f, Eigen::aligned_allocator<Eigen::Matrix4f>> boneMatrices(4), invTransposeMatrices(4);
+  compiled.evaluate(boneMatrices.data(), invTransposeMatrices.data(), boneMatrices.size());
+  for (int i = 0; i < reference->getNumBones(); ++i) {
+    const NodeRef &bone = reference->getBone(i);
+    const Eigen::Matrix4f expected = bone->getAbsoluteTransformation() * *bone->getOffset();
+    EXPECT_TRUE(boneMatrices[i].isApprox(expected, 1e-5f)) << bone->getName();
+    EXPECT_TRUE(invTransposeMatrices[i].isApprox(expected.inverse().transpose(), 1e-5f)) << bone->getName();
+    // The absolute transformations are stored back in the nodes.
+    const Eigen::Vector3f position = skeleton->getBone(i)->getAbsolutePosition();
+    EXPECT_TRUE(position.isApprox(bone->getAbsolutePosition(), 1e-5f)) << bone->getName();
+  }
+
+  // Adding a bone rebuilds the compiled skeleton.
+  NodeRef nail(new Node(Eigen::Vector3f(0, 0.5f, 0), Eigen::Quaternionf::Identity(), Eigen::Vector3f::Ones(), "Nail", thumb, 4));
+  thumb->addChild(nail);
+  skeleton->addBone("Nail", nail);
+  EXPECT_EQ(6u, skeleton->getCompiledSkeleton().getNumNodes());
+}
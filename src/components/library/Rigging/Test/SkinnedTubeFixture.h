@@ -0,0 +1,300 @@
+#pragma once
+
+#include "BonePalette.h"
+#include "GLShader.h"
+#include "GLTestFramework.h"
+#include "ModelIo.h"
+#include "Skeleton.h"
+#include "SkinnedVboMesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+// A synthetic skinned tube, and the means to draw it as RiggedHand does, shared by the skinning
+// tests and benchmarks.
+
+namespace model {
+
+  const int NUM_BONES = 16;
+  const float BONE_LENGTH = 10.0f;
+  const float RADIUS = 8.0f;
+
+  // Gives the weights of the 4 bones from first on, for a vertex at height y (some may be zero).
+  inline void TubeWeights (float y, int numBones, int &first, float weights[4]) {
+    const float boneCoordinate = y/BONE_LENGTH;
+    const int nearest = std::min(numBones - 1, static_cast<int>(boneCoordinate));
+    first = std::max(0, std::min(numBones - 4, nearest - 1));
+    float total = 0.0f;
+    for (int b = 0; b < 4; ++b) {
+      weights[b] = std::max(0.0f, 2.0f - std::abs(boneCoordinate - (first + b + 0.5f)));
+      total += weights[b];
+    }
+    for (int b = 0; b < 4; ++b) {
+      weights[b] /= total;
+    }
+  }
+
+  // A tube along the y axis, skinned to a chain of bones which each cover BONE_LENGTH of it.
+  // Each vertex is weighted over the (up to 4) nearest bones, so that every weight is exercised.
+  // The tube can be cut into sections of consecutive rings, which share a material.
+  class TubeModelSource : public ModelSource {
+  public:
+    TubeModelSource (int rings, int segments, int numBones = NUM_BONES, int numSections = 1)
+      : mRings(rings), mSegments(segments), mNumBones(numBones), mNumSections(numSections) { }
+
+    virtual size_t getNumSections() const override { return mNumSections; }
+    virtual size_t getNumVertices(int section) const override { return (LastRing(section) - FirstRing(section) + 1)*mSegments; }
+    virtual size_t getNumIndices(int section) const override { return 6*(LastRing(section) - FirstRing(section))*mSegments; }
+    virtual bool hasNormals(int) const override { return true; }
+    virtual bool hasSkeleton(int) const override { return true; }
+    virtual bool hasMaterials(int) const override { return false; }
+    virtual bool hasAnimations() const override { return false; }
+
+    virtual void load(ModelTarget *target) override {
+      SkeletonRef skeleton = Skeleton::create();
+      NodeRef parent(new Node(Eigen::Vector3f::Zero(), Eigen::Quaternionf::Identity(), Eigen::Vector3f::Ones(), "Root"));
+      skeleton->setRootNode(parent);
+      for (int i = 0; i < mNumBones; ++i) {
+        const std::string name = "Bone" + std::to_string(i);
+        const Eigen::Vector3f relativePosition(0, i == 0 ? 0.0f : BONE_LENGTH, 0);
+        NodeRef bone(new Node(relativePosition, Eigen::Quaternionf::Identity(), Eigen::Vector3f::Ones(), name, parent, i + 1));
+        Eigen::Matrix4f offset = Eigen::Matrix4f::Identity();
+        offset(1, 3) = -i*BONE_LENGTH;
+        bone->setOffsetMatrix(offset);
+        parent->addChild(bone);
+        skeleton->addBone(name, bone);
+        parent = bone;
+      }
+      for (int section = 0; section < mNumSections; ++section) {
+        loadSection(target, section, skeleton);
+      }
+    }
+
+  private:
+    // The sections' rings overlap by one, so that the tube stays closed.
+    int FirstRing (int section) const { return section*(mRings - 1)/mNumSections; }
+    int LastRing (int section) const { return (section + 1)*(mRings - 1)/mNumSections; }
+
+    void loadSection (ModelTarget *target, int section, const SkeletonRef &skeleton) {
+      const int rings = LastRing(section) - FirstRing(section) + 1;
+      std::vector<Eigen::Vector3f> positions;
+      std::vector<Eigen::Vector3f> normals;
+      std::vector<Eigen::Vector2f> texCoords;
+      for (int r = FirstRing(section); r <= LastRing(section); ++r) {
+        const float y = mNumBones*BONE_LENGTH*r/(mRings - 1);
+        for (int s = 0; s < mSegments; ++s) {
+          const float angle = static_cast<float>(2*M_PI*s/mSegments);
+          normals.push_back(Eigen::Vector3f(std::cos(angle), 0, std::sin(angle)));
+          positions.push_back(Eigen::Vector3f(RADIUS*normals.back().x(), y, RADIUS*normals.back().z()));
+          texCoords.push_back(Eigen::Vector2f(float(s)/mSegments, float(r)/(mRings - 1)));
+        }
+      }
+      std::vector<uint32_t> indices;
+      for (int r = 0; r + 1 < rings; ++r) {
+        for (int s = 0; s < mSegments; ++s) {
+          const uint32_t a = r*mSegments + s;
+          const uint32_t b = r*mSegments + (s + 1) % mSegments;
+          const uint32_t indicesOfQuad[] = { a, b, a + mSegments, b, b + mSegments, a + mSegments };
+          indices.insert(indices.end(), indicesOfQuad, indicesOfQuad + 6);
+        }
+      }
+
+      std::vector<BoneWeights> boneWeights(positions.size());
+      for (size_t v = 0; v < positions.size(); ++v) {
+        int first;
+        float weights[4];
+        TubeWeights(positions[v].y(), mNumBones, first, weights);
+        for (int b = 0; b < 4; ++b) {
+          if (weights[b] > 0.0f) {
+            boneWeights[v].addWeight(skeleton->getBone(first + b), weights[b]);
+          }
+        }
+      }
+
+      target->setActiveSection(section);
+      target->loadVertexPositions(positions);
+      target->loadVertexNormals(normals);
+      target->loadIndices(indices);
+      target->loadTex(texCoords, MaterialInfo());
+      target->loadSkeleton(skeleton);
+      target->loadBoneWeights(boneWeights);
+    }
+
+    int mRings;
+    int mSegments;
+    int mNumBones;
+    int mNumSections;
+  };
+
+  class SkinnedTubeFixture : public GLTestFramework_Headless {
+  protected:
+
+    // The skinning of RiggedHandSample's lighting-vert.glsl, shading by the skinned normal.
+    static GLShaderRef CreateShader () {
+      return CreateShader(
+        "#version 120\n"
+        "const int MAXBONES = 92;\n"
+        "uniform mat4 boneMatrices[MAXBONES];\n"
+        "uniform mat4 invTransposeMatrices[MAXBONES];\n"
+        "mat4 boneMatrix(float boneIndex) { return boneMatrices[int(boneIndex)]; }\n"
+        "mat4 invTransposeMatrix(float boneIndex) { return invTransposeMatrices[int(boneIndex)]; }\n"
+      );
+    }
+
+    // The skinning of RiggedHandSample's lighting-palette-vert.glsl.
+    static GLShaderRef CreatePaletteShader () {
+      return CreateShader(
+        "#version 120\n"
+        "#extension GL_EXT_gpu_shader4 : require\n"
+        "uniform samplerBuffer bonePalette;\n"
+        "mat4 paletteMatrix(int texel) {\n"
+        "  return mat4(texelFetchBuffer(bonePalette, texel), texelFetchBuffer(bonePalette, texel + 1),\n"
+        "              texelFetchBuffer(bonePalette, texel + 2), texelFetchBuffer(bonePalette, texel + 3));\n"
+        "}\n"
+        "mat4 boneMatrix(float boneIndex) { return paletteMatrix(8*int(boneIndex)); }\n"
+        "mat4 invTransposeMatrix(float boneIndex) { return paletteMatrix(8*int(boneIndex) + 4); }\n"
+      );
+    }
+
+    // boneMatrices declares the boneMatrix and invTransposeMatrix functions.
+    static GLShaderRef CreateShader (const std::string &boneMatrices) {
+      const std::string vertexShaderSource(boneMatrices +
+        "uniform mat4 projection_times_model_view_matrix;\n"
+        "attribute vec3 position;\n"
+        "attribute vec3 normal;\n"
+        "attribute vec4 boneWeights;\n"
+        "attribute vec4 boneIndices;\n"
+        "uniform bool isAnimated;\n"
+        "varying vec3 outNormal;\n"
+        "void main() {\n"
+        "  vec4 pos = vec4(position, 1.0);\n"
+        "  vec4 norm = vec4(normal, 0.0);\n"
+        "  if (isAnimated) {\n"
+        "    pos = boneMatrix(boneIndices.x) * pos * boneWeights.x +\n"
+        "          boneMatrix(boneIndices.y) * pos * boneWeights.y +\n"
+        "          boneMatrix(boneIndices.z) * pos * boneWeights.z +\n"
+        "          boneMatrix(boneIndices.w) * pos * boneWeights.w;\n"
+        "    norm = invTransposeMatrix(boneIndices.x) * norm * boneWeights.x +\n"
+        "           invTransposeMatrix(boneIndices.y) * norm * boneWeights.y +\n"
+        "           invTransposeMatrix(boneIndices.z) * norm * boneWeights.z +\n"
+        "           invTransposeMatrix(boneIndices.w) * norm * boneWeights.w;\n"
+        "    pos.w = 1.0;\n"
+        "  }\n"
+        "  outNormal = norm.xyz;\n"
+        "  gl_Position = projection_times_model_view_matrix * pos;\n"
+        "}\n"
+      );
+      const std::string fragmentShaderSource(
+        "#version 120\n"
+        "varying vec3 outNormal;\n"
+        "void main() {\n"
+        "  gl_FragColor = vec4(0.5*normalize(outNormal) + 0.5, 1.0);\n"
+        "}\n"
+      );
+      return std::make_shared<GLShader>(vertexShaderSource, fragmentShaderSource);
+    }
+
+    // Curls the tube by rotating every bone about z, by an amount which varies with the frame.
+    static void Animate (SkinnedVboMesh &mesh, int frame) {
+      const std::vector<NodeRef> &bones = mesh.getSkeleton()->getBones();
+      for (size_t i = 0; i < bones.size(); ++i) {
+        const float angle = 0.15f*std::sin(0.1f*frame + 0.5f*i);
+        bones[i]->setRelativeRotation(Eigen::Quaternionf(Eigen::AngleAxisf(angle, Eigen::Vector3f::UnitZ())));
+      }
+      mesh.update();
+    }
+
+    // Draws the mesh as RiggedHand does, taking the positions and normals from the skinned vertex
+    // buffer if the mesh was skinned on the CPU, and the bone matrices from the bone palette if the
+    // mesh uses one (for which the shader must be a palette shader).
+    static void Draw (const SkinnedVboMesh &mesh, const GLShader &shader) {
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      for (const MeshVboSectionRef &section : mesh.getSections()) {
+        DrawSection(mesh, *section, shader);
+      }
+    }
+
+    static void DrawSection (const SkinnedVboMesh &mesh, const SkinnedVboMesh::MeshSection &section, const GLShader &shader) {
+      const bool cpuSkinned = section.isCpuSkinned();
+      const bool usesBonePalette = !cpuSkinned && mesh.usesBonePalette();
+      shader.Bind();
+
+      // Fit the tube (which spans y in [0, numBones*BONE_LENGTH]) into clip space.
+      const float height = mesh.getSkeleton()->getNumBones()*BONE_LENGTH;
+      Eigen::Matrix4f projection = Eigen::Matrix4f::Identity();
+      projection.topLeftCorner<3, 3>() *= 1.0f/height;
+      projection(1, 3) = -0.5f;
+      glUniformMatrix4fv(shader.LocationOfUniform("projection_times_model_view_matrix"), 1, false, projection.data());
+      shader.SetUniformi("isAnimated", !cpuSkinned);
+      if (usesBonePalette) {
+        mesh.getBonePalette().bind(0);
+        shader.SetUniformi("bonePalette", 0);
+      } else if (!cpuSkinned) {
+        const int numBones = std::min(static_cast<int>(section.mBoneMatricesPtr->size()), static_cast<int>(SkinnedVboMesh::MAXBONES));
+        glUniformMatrix4fv(shader.LocationOfUniform("boneMatrices[0]"), numBones, false, section.mBoneMatricesPtr->data()->data());
+        glUniformMatrix4fv(shader.LocationOfUniform("invTransposeMatrices[0]"), numBones, false, section.mInvTransposeMatricesPtr->data()->data());
+      }
+
+      const int positionAddr = shader.LocationOfAttribute("position");
+      const int normalAddr = shader.LocationOfAttribute("normal");
+      const int boneWeightsAddr = shader.LocationOfAttribute("boneWeights");
+      const int boneIndicesAddr = shader.LocationOfAttribute("boneIndices");
+      auto locations = cpuSkinned ? std::make_tuple(-1, -1, -1, -1, -1) :
+                                    std::make_tuple(positionAddr, normalAddr, -1, boneWeightsAddr, boneIndicesAddr);
+      auto skinnedLocations = cpuSkinned ? std::make_tuple(positionAddr, normalAddr) : std::make_tuple(-1, -1);
+      section.getVboMesh().Enable(locations);
+      if (cpuSkinned) {
+        section.getSkinnedVboMesh().Enable(skinnedLocations);
+      }
+
+      section.getIndices().Bind();
+      GL_THROW_UPON_ERROR(glDrawElements(GL_TRIANGLES, section.getNumIndices(), section.getIndexType(), 0));
+      section.getIndices().Unbind();
+
+      VertexBuffer::Disable(locations);
+      SkinnedVertexBuffer::Disable(skinnedLocations);
+      if (usesBonePalette) {
+        mesh.getBonePalette().unbind(0);
+      }
+      shader.Unbind();
+    }
+
+    static std::vector<uint8_t> ReadPixels (int width, int height) {
+      std::vector<uint8_t> pixels(4*width*height);
+      glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+      return pixels;
+    }
+
+    // Animates and draws the given number of frames in the given mode, finishing each one.
+    static void DrawFrames (SkinnedVboMesh &mesh, const GLShader &shader, SkinnedVboMesh::SkinningMode mode, int frames) {
+      mesh.setSkinningMode(mode);
+      for (int frame = 0; frame < frames; ++frame) {
+        Animate(mesh, frame);
+        Draw(mesh, shader);
+        glFinish();
+      }
+    }
+
+    // Checks that two renderings of the same frame only differ by rounding.  The background is
+    // black, and the tube's normals never have a zero blue channel.
+    static void ExpectSamePixels (const std::vector<uint8_t> &expected, const std::vector<uint8_t> &actual, const std::string &what) {
+      size_t coveredPixels = 0;
+      size_t differingPixels = 0;
+      for (size_t i = 0; i < expected.size(); i += 4) {
+        coveredPixels += expected[i + 2] != 0 ? 1 : 0;
+        for (int c = 0; c < 3; ++c) {
+          if (std::abs(int(expected[i + c]) - int(actual[i + c])) > 4) {
+            ++differingPixels;
+            break;
+          }
+        }
+      }
+      EXPECT_GT(coveredPixels, 0u) << what;
+      EXPECT_LE(differingPixels, coveredPixels/100) << what;
+    }
+  };
+
+} // end namespace model
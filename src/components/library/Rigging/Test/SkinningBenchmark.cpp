@@ -0,0 +1,80 @@
+#include "SkinnedTubeFixture.h"
+
+#include <chrono>
+#include <iostream>
+
+using namespace model;
+
+// These benchmarks report timings for skinning a synthetic tube of 16 bones in the vertex shader
+// (as RiggedHand does by default, and from a bone palette) and on the CPU, drawing each frame and
+// waiting for it to finish.
+// Skinning in the vertex shader is expensive on software GL, so run them with
+// LIBGL_ALWAYS_SOFTWARE=1 (which selects llvmpipe) to compare the two there.  They only fail if
+// the two kinds of skinning disagree; SkinningTest checks them in more detail.
+
+class SkinningBenchmark : public SkinnedTubeFixture {
+protected:
+
+  typedef std::chrono::high_resolution_clock Clock;
+
+  // Draws the given number of frames in the given mode, and returns the milliseconds per frame.
+  static double TimeFrames (SkinnedVboMesh &mesh, const GLShader &shader, SkinnedVboMesh::SkinningMode mode, int frames) {
+    Clock::time_point start = Clock::now();
+    DrawFrames(mesh, shader, mode, frames);
+    return std::chrono::duration<double,std::milli>(Clock::now() - start).count()/frames;
+  }
+};
+
+TEST_F(SkinningBenchmark, CompareGpuAndCpuSkinning) {
+  const int FRAMES = 100;
+  const char *renderer = reinterpret_cast<const char *>(glGetString(GL_RENDERER));
+  std::cout << "GL renderer: " << (renderer ? renderer : "unknown") << '\n';
+
+  GLShaderRef shader = CreateShader();
+  GLShaderRef paletteShader = BonePalette::isSupported() ? CreatePaletteShader() : GLShaderRef();
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  glEnable(GL_DEPTH_TEST);
+
+  const int sizes[][2] = { { 64, 32 }, { 256, 64 }, { 512, 128 } };
+  for (const int *size : sizes) {
+    SkinnedVboMeshRef mesh = SkinnedVboMesh::create(std::make_shared<TubeModelSource>(size[0], size[1]));
+    const std::string vertices = std::to_string(size[0]*size[1]) + " vertices";
+    const double gpuMs = TimeFrames(*mesh, *shader, SkinnedVboMesh::GPU_SKINNING, FRAMES);
+    const std::vector<uint8_t> gpuPixels = ReadPixels(viewport[2], viewport[3]);
+    const double cpuMs = TimeFrames(*mesh, *shader, SkinnedVboMesh::CPU_SKINNING, FRAMES);
+    const std::vector<uint8_t> cpuPixels = ReadPixels(viewport[2], viewport[3]);
+    std::cout << vertices << ": GPU skinning " << gpuMs << " ms/frame, CPU skinning "
+              << cpuMs << " ms/frame (" << gpuMs/cpuMs << "x)";
+    // Both drew the same (last) frame.
+    ExpectSamePixels(gpuPixels, cpuPixels, vertices);
+
+    if (paletteShader) {
+      const double paletteMs = TimeFrames(*mesh, *paletteShader, SkinnedVboMesh::GPU_PALETTE_SKINNING, FRAMES);
+      ASSERT_TRUE(mesh->usesBonePalette());
+      std::cout << ", GPU palette skinning " << paletteMs << " ms/frame";
+      ExpectSamePixels(gpuPixels, ReadPixels(viewport[2], viewport[3]), vertices + " from the bone palette");
+    }
+    std::cout << '\n';
+  }
+  glDisable(GL_DEPTH_TEST);
+}
+
+TEST_F(SkinningBenchmark, CompareSeparateAndMergedSections) {
+  const int FRAMES = 100;
+  const int NUM_SECTIONS = 8;
+  GLShaderRef shader = CreateShader();
+  glEnable(GL_DEPTH_TEST);
+
+  ModelSourceRef source = std::make_shared<TubeModelSource>(256, 64, NUM_BONES, NUM_SECTIONS);
+  SkinnedVboMeshRef separate = SkinnedVboMesh::create(source);
+  SkinnedVboMesh::LoadOptions options;
+  options.mMergeSections = true;
+  options.mOptimizeVertexCache = true;
+  SkinnedVboMeshRef merged = SkinnedVboMesh::create(source, nullptr, options);
+
+  const double separateMs = TimeFrames(*separate, *shader, SkinnedVboMesh::GPU_SKINNING, FRAMES);
+  const double mergedMs = TimeFrames(*merged, *shader, SkinnedVboMesh::GPU_SKINNING, FRAMES);
+  std::cout << NUM_SECTIONS << " sections " << separateMs << " ms/frame, merged and reordered " << mergedMs << " ms/frame\n";
+  glDisable(GL_DEPTH_TEST);
+}
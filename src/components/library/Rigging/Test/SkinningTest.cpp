@@ -0,0 +1,210 @@
+#include "SkinnedTubeFixture.h"
+
+#include "GLStateTracker.h"
+#include "ModelSourceBinary.h"
+#include "ModelTargetBinary.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+using namespace model;
+
+// Checks skinning on the CPU against a reference, and that a bone palette and merged sections
+// draw the same tube as uniform bone matrices and separate sections.  The timings are in
+// SkinningBenchmark.
+
+class SkinningTest : public SkinnedTubeFixture { };
+
+TEST_F(SkinningTest, CpuSkinningMatchesTheReference) {
+  const int rings = 256;
+  const int segments = 64;
+  SkinnedVboMeshRef mesh = SkinnedVboMesh::create(std::make_shared<TubeModelSource>(rings, segments));
+  const SkinnedVboMesh::MeshSection &section = *mesh->getSections()[0];
+  ASSERT_TRUE(section.canSkinOnCpu());
+
+  mesh->setSkinningMode(SkinnedVboMesh::CPU_SKINNING);
+  Animate(*mesh, 7);
+  ASSERT_TRUE(section.isCpuSkinned());
+
+  // Skin the bind pose again in double precision, straight from the mesh's bone matrices.
+  const std::vector<SkinnedVertexBuffer::Attributes> &skinned = section.getSkinnedVboMesh().IntermediateAttributes();
+  ASSERT_EQ(static_cast<size_t>(rings*segments), skinned.size());
+  float maxError = 0.0f;
+  for (int r = 0; r < rings; ++r) {
+    const float y = NUM_BONES*BONE_LENGTH*r/(rings - 1);
+    int first;
+    float weights[4];
+    TubeWeights(y, NUM_BONES, first, weights);
+    for (int s = 0; s < segments; ++s) {
+      const double angle = 2*M_PI*s/segments;
+      const Eigen::Vector4d normal(std::cos(float(angle)), 0, std::sin(float(angle)), 0);
+      const Eigen::Vector4d position(RADIUS*normal.x(), y, RADIUS*normal.z(), 1);
+      Eigen::Vector4d expectedPosition = Eigen::Vector4d::Zero();
+      Eigen::Vector4d expectedNormal = Eigen::Vector4d::Zero();
+      for (int b = 0; b < 4; ++b) {
+        const double weight = weights[b];
+        expectedPosition += weight*(mesh->mBoneMatrices[first + b].cast<double>()*position);
+        expectedNormal += weight*(mesh->mInvTransposeMatrices[first + b].cast<double>()*normal);
+      }
+      const uint8_t *vertex = reinterpret_cast<const uint8_t *>(&skinned[r*segments + s]);
+      const float *skinnedPosition = reinterpret_cast<const float *>(vertex + SkinnedVertexBuffer::AttributeOffset<0>());
+      const float *skinnedNormal = reinterpret_cast<const float *>(vertex + SkinnedVertexBuffer::AttributeOffset<1>());
+      for (int c = 0; c < 3; ++c) {
+        maxError = std::max(maxError, static_cast<float>(std::abs(skinnedPosition[c] - expectedPosition[c])));
+        maxError = std::max(maxError, static_cast<float>(std::abs(skinnedNormal[c] - expectedNormal[c])));
+      }
+    }
+  }
+  EXPECT_LT(maxError, 1e-3f);
+}
+
+TEST_F(SkinningTest, BonePaletteHoldsMoreThanMaxBones) {
+  if (!BonePalette::isSupported()) {
+    std::cout << "Texture buffers aren't supported; skipping\n";
+    return;
+  }
+  const int numBones = 2*SkinnedVboMesh::MAXBONES;
+  GLShaderRef paletteShader = CreatePaletteShader();
+  GLShaderRef shader = CreateShader();
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  glEnable(GL_DEPTH_TEST);
+
+  SkinnedVboMeshRef mesh = SkinnedVboMesh::create(std::make_shared<TubeModelSource>(4*numBones, 32, numBones));
+  ASSERT_EQ(static_cast<size_t>(numBones), mesh->mBoneMatrices.size());
+  DrawFrames(*mesh, *paletteShader, SkinnedVboMesh::GPU_PALETTE_SKINNING, 3);
+  ASSERT_TRUE(mesh->usesBonePalette());
+  EXPECT_EQ(static_cast<size_t>(numBones), mesh->getBonePalette().getNumBones());
+  const std::vector<uint8_t> palettePixels = ReadPixels(viewport[2], viewport[3]);
+  DrawFrames(*mesh, *shader, SkinnedVboMesh::CPU_SKINNING, 3);
+  ExpectSamePixels(ReadPixels(viewport[2], viewport[3]), palettePixels, "bone palette");
+
+  // Only bending the chain near its end changes the matrices of the few bones from there on, so
+  // only those are uploaded.
+  mesh->setSkinningMode(SkinnedVboMesh::GPU_PALETTE_SKINNING);
+  const int firstChangedBone = numBones - 8;
+  const BonePalette::Counters before = mesh->getBonePalette().getCounters();
+  mesh->getSkeleton()->getBone(firstChangedBone)->setRelativeRotation(Eigen::Quaternionf(Eigen::AngleAxisf(0.3f, Eigen::Vector3f::UnitZ())));
+  mesh->update();
+  const BonePalette::Counters &after = mesh->getBonePalette().getCounters();
+  EXPECT_EQ(before.mUploads + 1, after.mUploads);
+  EXPECT_EQ(before.mBonesUploaded + (numBones - firstChangedBone), after.mBonesUploaded);
+  EXPECT_EQ(before.mBonesUnchanged + firstChangedBone, after.mBonesUnchanged);
+  EXPECT_EQ(before.mBytesUploaded + (numBones - firstChangedBone)*BonePalette::TEXELS_PER_BONE*4*sizeof(float), after.mBytesUploaded);
+
+  // Updating again without changes uploads nothing.
+  mesh->update();
+  EXPECT_EQ(before.mUploads + 1, mesh->getBonePalette().getCounters().mUploads);
+  glDisable(GL_DEPTH_TEST);
+}
+
+TEST_F(SkinningTest, BonePaletteBindsThroughTheStateTracker) {
+  if (!BonePalette::isSupported()) {
+    std::cout << "Texture buffers aren't supported; skipping\n";
+    return;
+  }
+  SkinnedVboMeshRef mesh = SkinnedVboMesh::create(std::make_shared<TubeModelSource>(16, 8));
+  mesh->setSkinningMode(SkinnedVboMesh::GPU_PALETTE_SKINNING);
+  Animate(*mesh, 0);
+  ASSERT_TRUE(mesh->usesBonePalette());
+
+  // Within a scope, binding the palette again to the same unit is elided.  Each call switches to
+  // its unit and back to unit 0.
+  GLStateTracker tracker;
+  GLStateTracker::SetCurrent(&tracker);
+  {
+    GLStateTracker::Scope scope(tracker);
+    mesh->getBonePalette().bind(1);
+    mesh->getBonePalette().bind(1);
+    mesh->getBonePalette().unbind(1);
+  }
+  GLStateTracker::SetCurrent(nullptr);
+  EXPECT_EQ(2u, tracker.GetCounters().texture_binds.issued);
+  EXPECT_EQ(1u, tracker.GetCounters().texture_binds.elided);
+  EXPECT_EQ(6u, tracker.GetCounters().active_texture_changes.Total());
+
+  GLint binding = -1;
+  glActiveTexture(GL_TEXTURE1);
+  glGetIntegerv(GL_TEXTURE_BINDING_BUFFER, &binding);
+  glActiveTexture(GL_TEXTURE0);
+  EXPECT_EQ(0, binding);
+}
+
+TEST_F(SkinningTest, MergedSectionsDrawTheSameTube) {
+  const int FRAMES = 3;
+  const int NUM_SECTIONS = 8;
+  GLShaderRef shader = CreateShader();
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  glEnable(GL_DEPTH_TEST);
+
+  ModelSourceRef source = std::make_shared<TubeModelSource>(256, 64, NUM_BONES, NUM_SECTIONS);
+  SkinnedVboMeshRef separate = SkinnedVboMesh::create(source);
+  SkinnedVboMesh::LoadOptions options;
+  options.mMergeSections = true;
+  options.mOptimizeVertexCache = true;
+  SkinnedVboMeshRef merged = SkinnedVboMesh::create(source, nullptr, options);
+  ASSERT_EQ(static_cast<size_t>(NUM_SECTIONS), separate->getSections().size());
+  ASSERT_EQ(1u, merged->getSections().size());
+  for (int i = 0; i < NUM_SECTIONS; ++i) {
+    EXPECT_EQ(i, separate->getMergedSectionIndex(i));
+    EXPECT_EQ(0, merged->getMergedSectionIndex(i));
+  }
+  // The rings shared by neighboring sections are duplicated, but add no triangles.
+  const SkinnedVboMesh::MeshSection &section = *merged->getSections()[0];
+  EXPECT_EQ(GL_UNSIGNED_SHORT, static_cast<int>(section.getIndexType()));
+  EXPECT_EQ(6*255*64, section.getNumIndices());
+  EXPECT_EQ(static_cast<GLsizeiptr>(sizeof(uint16_t)*section.getNumIndices()), section.getIndices().Size());
+  ASSERT_TRUE(section.canSkinOnCpu());
+
+  DrawFrames(*separate, *shader, SkinnedVboMesh::GPU_SKINNING, FRAMES);
+  const std::vector<uint8_t> separatePixels = ReadPixels(viewport[2], viewport[3]);
+  DrawFrames(*merged, *shader, SkinnedVboMesh::GPU_SKINNING, FRAMES);
+  ExpectSamePixels(separatePixels, ReadPixels(viewport[2], viewport[3]), "merged sections");
+
+  // Skinning the merged section on the CPU covers the vertices of all of the sections.
+  DrawFrames(*merged, *shader, SkinnedVboMesh::CPU_SKINNING, FRAMES);
+  ExpectSamePixels(separatePixels, ReadPixels(viewport[2], viewport[3]), "merged sections skinned on the CPU");
+  glDisable(GL_DEPTH_TEST);
+}
+
+TEST_F(SkinningTest, MergesSectionsLoadedFromABinaryModel) {
+  // The first two sections are alone in their groups, so they're uploaded straight from the
+  // binary model, while the last two are merged.
+  const int NUM_SECTIONS = 4;
+  const char *directory = std::getenv("TMPDIR");
+  const std::string path = std::string((directory != nullptr && *directory != '\0') ? directory : "/tmp") + "/SkinningTest.rigbin";
+  ModelSourceRef tube = std::make_shared<TubeModelSource>(64, 32, NUM_BONES, NUM_SECTIONS);
+  ModelTargetBinary target(1.0f);
+  tube->load(&target);
+  target.write(path);
+  ModelSourceRef binary = ModelSourceBinary::create(path);
+
+  SkinnedVboMesh::LoadOptions options;
+  options.mMergeSections = true;
+  options.mSectionGroups = { 0, 1, 2, 2 };
+  SkinnedVboMeshRef merged = SkinnedVboMesh::create(binary, nullptr, options);
+  SkinnedVboMeshRef separate = SkinnedVboMesh::create(tube);
+  std::remove(path.c_str());
+  ASSERT_EQ(3u, merged->getSections().size());
+  EXPECT_EQ(0, merged->getMergedSectionIndex(0));
+  EXPECT_EQ(1, merged->getMergedSectionIndex(1));
+  EXPECT_EQ(2, merged->getMergedSectionIndex(2));
+  EXPECT_EQ(2, merged->getMergedSectionIndex(3));
+  for (int i = 0; i < NUM_SECTIONS; ++i) {
+    EXPECT_TRUE(merged->getSections()[merged->getMergedSectionIndex(i)]->canSkinOnCpu());
+  }
+
+  GLShaderRef shader = CreateShader();
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  glEnable(GL_DEPTH_TEST);
+  DrawFrames(*separate, *shader, SkinnedVboMesh::GPU_SKINNING, 3);
+  const std::vector<uint8_t> separatePixels = ReadPixels(viewport[2], viewport[3]);
+  DrawFrames(*merged, *shader, SkinnedVboMesh::GPU_SKINNING, 3);
+  ExpectSamePixels(separatePixels, ReadPixels(viewport[2], viewport[3]), "binary model");
+  DrawFrames(*merged, *shader, SkinnedVboMesh::CPU_SKINNING, 3);
+  ExpectSamePixels(separatePixels, ReadPixels(viewport[2], viewport[3]), "binary model skinned on the CPU");
+  glDisable(GL_DEPTH_TEST);
+}
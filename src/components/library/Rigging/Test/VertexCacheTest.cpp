@@ -0,0 +1,87 @@
+#include "VertexCacheOptimization.h"
+
+#include <algorithm>
+#include <array>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace model;
+
+namespace {
+
+  // A grid of size x size quads, each split into two triangles, in row order.
+  std::vector<uint32_t> GridIndices (uint32_t size) {
+    std::vector<uint32_t> indices;
+    for (uint32_t y = 0; y < size; ++y) {
+      for (uint32_t x = 0; x < size; ++x) {
+        const uint32_t a = y*(size + 1) + x;
+        const uint32_t c = a + size + 1;
+        const uint32_t quad[] = { a, a + 1, c, a + 1, c + 1, c };
+        indices.insert(indices.end(), quad, quad + 6);
+      }
+    }
+    return indices;
+  }
+
+  // The triangles of an index list, each rotated to start with its smallest index (which keeps its
+  // winding), in sorted order.
+  std::vector<std::array<uint32_t, 3>> SortedTriangles (const std::vector<uint32_t> &indices) {
+    std::vector<std::array<uint32_t, 3>> triangles;
+    for (size_t i = 0; i < indices.size(); i += 3) {
+      std::array<uint32_t, 3> triangle = {{ indices[i], indices[i + 1], indices[i + 2] }};
+      std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+      triangles.push_back(triangle);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+  }
+
+  void ShuffleTriangles (std::vector<uint32_t> &indices) {
+    std::vector<std::array<uint32_t, 3>> triangles;
+    for (size_t i = 0; i < indices.size(); i += 3) {
+      const std::array<uint32_t, 3> triangle = {{ indices[i], indices[i + 1], indices[i + 2] }};
+      triangles.push_back(triangle);
+    }
+    std::mt19937 random(42);
+    std::shuffle(triangles.begin(), triangles.end(), random);
+    for (size_t t = 0; t < triangles.size(); ++t) {
+      std::copy(triangles[t].begin(), triangles[t].end(), indices.begin() + 3*t);
+    }
+  }
+
+} // end of anonymous namespace
+
+TEST(VertexCacheTest, ReorderingKeepsTheTriangles) {
+  std::vector<uint32_t> indices = GridIndices(16);
+  // A degenerate triangle, and one which shares no vertices with the rest.
+  const uint32_t extra[] = { 3, 3, 20, 289, 290, 291 };
+  indices.insert(indices.end(), extra, extra + 6);
+  ShuffleTriangles(indices);
+  const std::vector<std::array<uint32_t, 3>> expected = SortedTriangles(indices);
+
+  optimizeVertexCache(indices.data(), indices.size(), 292);
+  EXPECT_EQ(expected, SortedTriangles(indices));
+}
+
+TEST(VertexCacheTest, ReorderingLowersTheCacheMissRatio) {
+  std::vector<uint32_t> indices = GridIndices(64);
+  const float rowOrder = averageCacheMissRatio(indices.data(), indices.size());
+  ShuffleTriangles(indices);
+  const float shuffled = averageCacheMissRatio(indices.data(), indices.size());
+
+  optimizeVertexCache(indices.data(), indices.size(), 65*65);
+  const float optimized = averageCacheMissRatio(indices.data(), indices.size());
+  std::cout << "ACMR in row order " << rowOrder << ", shuffled " << shuffled << ", optimized " << optimized << '\n';
+  EXPECT_LT(optimized, rowOrder);
+  EXPECT_LT(optimized, 0.75f);
+  // Also for a smaller cache than the one it was optimized for.
+  EXPECT_LT(averageCacheMissRatio(indices.data(), indices.size(), 16), averageCacheMissRatio(GridIndices(64).data(), indices.size(), 16));
+}
+
+TEST(VertexCacheTest, MissRatioOfUnsharedTriangles) {
+  const uint32_t indices[] = { 0, 1, 2, 3, 4, 5 };
+  EXPECT_EQ(3.0f, averageCacheMissRatio(indices, 6));
+  EXPECT_EQ(0.0f, averageCacheMissRatio(indices, 0));
+}
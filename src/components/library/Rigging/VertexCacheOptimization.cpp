@@ -0,0 +1,165 @@
+#include "VertexCacheOptimization.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <vector>
+
+namespace model {
+
+  namespace {
+
+    // The tuning of Forsyth's article.
+    const float CACHE_DECAY_POWER = 1.5f;
+    const float LAST_TRIANGLE_SCORE = 0.75f;
+    const float VALENCE_BOOST_SCALE = 2.0f;
+    const float VALENCE_BOOST_POWER = 0.5f;
+
+    // cachePosition is -1 for a vertex which isn't in the cache.
+    float vertexScore(int cachePosition, uint32_t remainingTriangles)
+    {
+      if (remainingTriangles == 0) {
+        return -1.0f; // the vertex is done with
+      }
+      float score = 0.0f;
+      if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+          // The vertices of the last triangle get a fixed score, so that the next triangle
+          // doesn't simply reuse the same edge over and over.
+          score = LAST_TRIANGLE_SCORE;
+        } else {
+          const float scale = 1.0f/(VERTEX_CACHE_SIZE - 3);
+          score = std::pow(1.0f - (cachePosition - 3)*scale, CACHE_DECAY_POWER);
+        }
+      }
+      // Favor vertices with few triangles left, so that lone triangles aren't left behind.
+      return score + VALENCE_BOOST_SCALE*std::pow(static_cast<float>(remainingTriangles), -VALENCE_BOOST_POWER);
+    }
+
+  } // end of anonymous namespace
+
+  void optimizeVertexCache(uint32_t* indices, size_t numIndices, size_t numVertices)
+  {
+    const size_t numTriangles = numIndices/3;
+    if (numTriangles < 2) {
+      return;
+    }
+
+    // The triangles of each vertex, of which the first mRemaining[v] aren't emitted yet.
+    std::vector<uint32_t> triangleOffsets(numVertices + 1, 0);
+    for (size_t i=0; i<3*numTriangles; i++) {
+      triangleOffsets[indices[i] + 1]++;
+    }
+    for (size_t v=0; v<numVertices; v++) {
+      triangleOffsets[v + 1] += triangleOffsets[v];
+    }
+    std::vector<uint32_t> vertexTriangles(3*numTriangles);
+    std::vector<uint32_t> remaining(numVertices, 0);
+    for (size_t t=0; t<numTriangles; t++) {
+      for (int c=0; c<3; c++) {
+        const uint32_t v = indices[3*t + c];
+        vertexTriangles[triangleOffsets[v] + remaining[v]++] = static_cast<uint32_t>(t);
+      }
+    }
+
+    std::vector<int> cachePositions(numVertices, -1);
+    std::vector<float> vertexScores(numVertices);
+    for (size_t v=0; v<numVertices; v++) {
+      vertexScores[v] = vertexScore(-1, remaining[v]);
+    }
+    std::vector<float> triangleScores(numTriangles);
+    std::vector<bool> emitted(numTriangles, false);
+    size_t best = 0;
+    for (size_t t=0; t<numTriangles; t++) {
+      triangleScores[t] = vertexScores[indices[3*t]] + vertexScores[indices[3*t + 1]] + vertexScores[indices[3*t + 2]];
+      if (triangleScores[t] > triangleScores[best]) {
+        best = t;
+      }
+    }
+
+    // The cache is kept in LRU order, with room for the vertices it's about to evict.
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> newCache;
+    cache.reserve(VERTEX_CACHE_SIZE + 3);
+    newCache.reserve(VERTEX_CACHE_SIZE + 3);
+    std::vector<uint32_t> output;
+    output.reserve(3*numTriangles);
+    size_t nextUnemitted = 0;
+    for (size_t n=0; n<numTriangles; n++) {
+      emitted[best] = true;
+      const uint32_t* triangle = &indices[3*best];
+      newCache.clear();
+      for (int c=0; c<3; c++) {
+        const uint32_t v = triangle[c];
+        output.push_back(v);
+        uint32_t* begin = &vertexTriangles[triangleOffsets[v]];
+        uint32_t* end = begin + remaining[v];
+        std::swap(*std::find(begin, end, static_cast<uint32_t>(best)), *(end - 1));
+        remaining[v]--;
+        if (std::find(newCache.begin(), newCache.end(), v) == newCache.end()) {
+          newCache.push_back(v);
+        }
+      }
+      for (uint32_t v : cache) {
+        if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+          newCache.push_back(v);
+        }
+      }
+
+      // Only the scores of the vertices which moved in (or out of) the cache changed, so only
+      // their triangles are rescored, and the next triangle is the best of those.
+      for (size_t i=0; i<newCache.size(); i++) {
+        const uint32_t v = newCache[i];
+        cachePositions[v] = i < VERTEX_CACHE_SIZE ? static_cast<int>(i) : -1;
+        vertexScores[v] = vertexScore(cachePositions[v], remaining[v]);
+      }
+      float bestScore = -1.0f;
+      for (uint32_t v : newCache) {
+        for (uint32_t i=0; i<remaining[v]; i++) {
+          const uint32_t t = vertexTriangles[triangleOffsets[v] + i];
+          const float score = vertexScores[indices[3*t]] + vertexScores[indices[3*t + 1]] + vertexScores[indices[3*t + 2]];
+          triangleScores[t] = score;
+          if (score > bestScore) {
+            bestScore = score;
+            best = t;
+          }
+        }
+      }
+      if (newCache.size() > VERTEX_CACHE_SIZE) {
+        newCache.resize(VERTEX_CACHE_SIZE);
+      }
+      cache.swap(newCache);
+
+      if (bestScore < 0.0f) {
+        // None of the cached vertices have triangles left, so start again elsewhere.
+        while (nextUnemitted < numTriangles && emitted[nextUnemitted]) {
+          nextUnemitted++;
+        }
+        best = nextUnemitted;
+      }
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+  }
+
+  float averageCacheMissRatio(const uint32_t* indices, size_t numIndices, size_t cacheSize)
+  {
+    const size_t numTriangles = numIndices/3;
+    if (numTriangles == 0) {
+      return 0.0f;
+    }
+    std::deque<uint32_t> cache;
+    size_t misses = 0;
+    for (size_t i=0; i<3*numTriangles; i++) {
+      if (std::find(cache.begin(), cache.end(), indices[i]) == cache.end()) {
+        misses++;
+        cache.push_back(indices[i]);
+        if (cache.size() > cacheSize) {
+          cache.pop_front();
+        }
+      }
+    }
+    return static_cast<float>(misses)/numTriangles;
+  }
+
+} //end namespace model
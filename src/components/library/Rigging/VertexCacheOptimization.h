@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace model {
+
+  //! The number of entries of the vertex cache which optimizeVertexCache orders triangles for.
+  //! Reordering for a larger cache than the hardware's still does well, unlike the other way around.
+  static const size_t VERTEX_CACHE_SIZE = 32;
+
+  /*!
+   *  Reorders the triangles of an indexed triangle list (in place) so that consecutive triangles
+   *  share vertices, which then stay in the GPU's post-transform vertex cache instead of being
+   *  skinned and transformed again.  This is Tom Forsyth's "Linear-Speed Vertex Cache
+   *  Optimisation": it greedily emits the triangle whose vertices score highest, where a vertex
+   *  scores higher the more recently it was used and the fewer of its triangles remain.  The
+   *  winding of every triangle is kept, and all indices must be less than numVertices.
+   */
+  void optimizeVertexCache(uint32_t* indices, size_t numIndices, size_t numVertices);
+
+  /*!
+   *  Returns the average number of vertices transformed per triangle (the ACMR) when drawing the
+   *  given triangle list through a FIFO vertex cache of cacheSize entries, which is between 0.5
+   *  (for a large regular grid) and 3 (for no reuse at all).
+   */
+  float averageCacheMissRatio(const uint32_t* indices, size_t numIndices, size_t cacheSize = VERTEX_CACHE_SIZE);
+
+} //end namespace model
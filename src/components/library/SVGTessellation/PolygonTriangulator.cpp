@@ -0,0 +1,595 @@
+#include "PolygonTriangulator.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iterator>
+
+namespace {
+
+// True iff p comes after q in the sweep, which runs from top (greatest y) to bottom, and from
+// right to left among points of equal y.
+bool Below (const EigenTypes::Vector2f &p, const EigenTypes::Vector2f &q) {
+  return p.y() < q.y() || (p.y() == q.y() && p.x() < q.x());
+}
+
+// Twice the signed area of the triangle (o, a, b), which is positive iff it's counterclockwise.
+// If a is below o, it's negative iff b is left of the edge from o down to a.
+double Cross (const EigenTypes::Vector2f &o, const EigenTypes::Vector2f &a, const EigenTypes::Vector2f &b) {
+  return (static_cast<double>(a.x()) - o.x())*(static_cast<double>(b.y()) - o.y()) -
+         (static_cast<double>(a.y()) - o.y())*(static_cast<double>(b.x()) - o.x());
+}
+
+// True iff the points are equal to within a few units in the last place, which is as close as the
+// points of a flattened curve usually come to its (exact) endpoint.
+bool AreCoincident (const EigenTypes::Vector2f &a, const EigenTypes::Vector2f &b) {
+  const float tolerance = 16.0f*FLT_EPSILON*std::max(1.0f, std::max(a.cwiseAbs().maxCoeff(), b.cwiseAbs().maxCoeff()));
+  return std::abs(a.x() - b.x()) <= tolerance && std::abs(a.y() - b.y()) <= tolerance;
+}
+
+// True iff the path from a through b to c doubles back on itself at b, so that b is the tip of a
+// spike of zero width (as at the end of a zero-length curve, whose points differ by rounding).
+bool IsSpike (const EigenTypes::Vector2f &a, const EigenTypes::Vector2f &b, const EigenTypes::Vector2f &c) {
+  return Cross(a, b, c) == 0.0 && (b - a).dot(c - b) <= 0.0f;
+}
+
+// True iff p, which is collinear with the segment from a to b, lies on it.
+bool IsWithin (const EigenTypes::Vector2f &a, const EigenTypes::Vector2f &b, const EigenTypes::Vector2f &p) {
+  return std::min(a.x(), b.x()) <= p.x() && p.x() <= std::max(a.x(), b.x()) &&
+         std::min(a.y(), b.y()) <= p.y() && p.y() <= std::max(a.y(), b.y());
+}
+
+// True iff the closed segments (a1, a2) and (b1, b2) have a point in common.
+bool SegmentsMeet (const EigenTypes::Vector2f &a1, const EigenTypes::Vector2f &a2, const EigenTypes::Vector2f &b1, const EigenTypes::Vector2f &b2) {
+  const double d1 = Cross(a1, a2, b1);
+  const double d2 = Cross(a1, a2, b2);
+  const double d3 = Cross(b1, b2, a1);
+  const double d4 = Cross(b1, b2, a2);
+  if (((d1 > 0.0 && d2 < 0.0) || (d1 < 0.0 && d2 > 0.0)) && ((d3 > 0.0 && d4 < 0.0) || (d3 < 0.0 && d4 > 0.0))) {
+    return true;
+  }
+  return (d1 == 0.0 && IsWithin(a1, a2, b1)) || (d2 == 0.0 && IsWithin(a1, a2, b2)) ||
+         (d3 == 0.0 && IsWithin(b1, b2, a1)) || (d4 == 0.0 && IsWithin(b1, b2, a2));
+}
+
+bool IsFilled (int winding, PolygonTriangulator::FillRule fill_rule) {
+  return fill_rule == PolygonTriangulator::FillRule::NONZERO ? winding != 0 : winding % 2 != 0;
+}
+
+} // end of anonymous namespace
+
+bool PolygonTriangulator::SweepEdgeOrder::operator () (const SweepEdge &a, const SweepEdge &b) const {
+  // The edges are compared where the one which entered the sweep later starts, since the other one
+  // spans the sweep line there.  Edges which start at the same point are compared by their other
+  // endpoints.
+  if (a.rank >= b.rank) {
+    double side = Cross(b.upper, b.lower, a.upper);
+    if (side == 0.0) {
+      side = Cross(b.upper, b.lower, a.lower);
+    }
+    return side < 0.0;
+  }
+  double side = Cross(a.upper, a.lower, b.upper);
+  if (side == 0.0) {
+    side = Cross(a.upper, a.lower, b.lower);
+  }
+  return side > 0.0;
+}
+
+PolygonTriangulator::PolygonTriangulator () { }
+
+void PolygonTriangulator::AddContour (const EigenTypes::Vector2f *points, size_t count) {
+  const size_t start = m_points.size();
+  for (size_t i = 0; i < count; ++i) {
+    if (m_points.size() > start && AreCoincident(points[i], m_points.back())) {
+      continue;
+    }
+    m_points.push_back(points[i]);
+    while (m_points.size() >= start + 3 && IsSpike(m_points.end()[-3], m_points.end()[-2], m_points.back())) {
+      m_points.end()[-2] = m_points.back();
+      m_points.pop_back();
+      if (m_points.size() >= start + 2 && AreCoincident(m_points.end()[-2], m_points.back())) {
+        m_points.pop_back();
+      }
+    }
+  }
+  // The contour is closed, so the same goes for the points around its start.
+  while (m_points.size() >= start + 3) {
+    const size_t last = m_points.size() - 1;
+    if (AreCoincident(m_points[last], m_points[start]) || IsSpike(m_points[last - 1], m_points[last], m_points[start])) {
+      m_points.pop_back();
+    } else if (IsSpike(m_points[last], m_points[start], m_points[start + 1])) {
+      m_points.erase(m_points.begin() + start);
+    } else {
+      break;
+    }
+  }
+  if (m_points.size() < start + 3) {
+    m_points.resize(start);
+    return;
+  }
+  m_contour_starts.push_back(static_cast<uint32_t>(start));
+}
+
+void PolygonTriangulator::Clear () {
+  m_points.clear();
+  m_contour_starts.clear();
+}
+
+bool PolygonTriangulator::Triangulate (FillRule fill_rule, std::vector<uint32_t> &indices) {
+  const size_t initial_size = indices.size();
+  const uint32_t point_count = static_cast<uint32_t>(m_points.size());
+
+  m_contours.clear();
+  m_vertices.clear();
+  m_vertices.reserve(3*point_count); // Each diagonal adds two vertices, and there are fewer than n.
+  for (size_t c = 0; c < m_contour_starts.size(); ++c) {
+    Contour contour;
+    contour.first = m_contour_starts[c];
+    contour.count = (c + 1 < m_contour_starts.size() ? m_contour_starts[c + 1] : point_count) - contour.first;
+    double area = 0.0;
+    for (uint32_t i = 0; i < contour.count; ++i) {
+      Vertex vertex;
+      vertex.point = contour.first + i;
+      vertex.contour = static_cast<uint32_t>(c);
+      vertex.next = contour.first + (i + 1)%contour.count;
+      vertex.previous = contour.first + (i + contour.count - 1)%contour.count;
+      m_vertices.push_back(vertex);
+      area += Cross(EigenTypes::Vector2f::Zero(), m_points[vertex.point], m_points[vertex.next]);
+    }
+    contour.orientation = area > 0.0 ? 1 : (area < 0.0 ? -1 : 0);
+    contour.inside_winding = contour.outside_winding = 0;
+    m_contours.push_back(contour);
+  }
+
+  // The order of the sweep, which both passes use.
+  m_order.resize(point_count);
+  for (uint32_t i = 0; i < point_count; ++i) {
+    m_order[i] = i;
+  }
+  std::sort(m_order.begin(), m_order.end(), [this](uint32_t a, uint32_t b) { return Below(m_points[b], m_points[a]); });
+
+  bool succeeded = ComputeWindings();
+  if (succeeded) {
+    OrientContours(fill_rule);
+    succeeded = PartitionIntoMonotonePieces() && TriangulateMonotonePieces(indices);
+  }
+  m_sweep_line.clear();
+  if (!succeeded) {
+    indices.resize(initial_size);
+  }
+  return succeeded;
+}
+
+bool PolygonTriangulator::EdgesMeet (const SweepEdge &a, const SweepEdge &b) const {
+  const Vertex &va = m_vertices[a.vertex];
+  const Vertex &vb = m_vertices[b.vertex];
+  if (va.next == b.vertex || vb.next == a.vertex) {
+    return false; // Consecutive edges of a contour meet at their common vertex, and nowhere else.
+  }
+  return SegmentsMeet(a.upper, a.lower, b.upper, b.lower);
+}
+
+bool PolygonTriangulator::MeetsNeighbors (SweepLine::iterator edge) const {
+  if (edge != m_sweep_line.begin() && EdgesMeet(*std::prev(edge), *edge)) {
+    return true;
+  }
+  const SweepLine::iterator next = std::next(edge);
+  return next != m_sweep_line.end() && EdgesMeet(*edge, *next);
+}
+
+bool PolygonTriangulator::Erase (SweepLine::iterator edge) {
+  const SweepLine::iterator next = m_sweep_line.erase(edge);
+  return next == m_sweep_line.begin() || next == m_sweep_line.end() || !EdgesMeet(*std::prev(next), *next);
+}
+
+bool PolygonTriangulator::EdgeGoesDown (uint32_t vertex) const {
+  return Below(Position(m_vertices[vertex].next), Position(vertex));
+}
+
+PolygonTriangulator::SweepEdge PolygonTriangulator::MakeEdge (uint32_t vertex, uint32_t rank) const {
+  SweepEdge edge;
+  const bool goes_down = EdgeGoesDown(vertex);
+  edge.upper = goes_down ? Position(vertex) : Position(m_vertices[vertex].next);
+  edge.lower = goes_down ? Position(m_vertices[vertex].next) : Position(vertex);
+  edge.rank = rank;
+  edge.vertex = vertex;
+  return edge;
+}
+
+PolygonTriangulator::SweepLine::iterator PolygonTriangulator::EdgeLeftOf (const EigenTypes::Vector2f &point, uint32_t rank) {
+  SweepEdge key;
+  key.upper = key.lower = point;
+  key.rank = rank;
+  key.vertex = 0;
+  // This finds the first edge which the point isn't strictly right of.
+  SweepLine::iterator it = m_sweep_line.lower_bound(key);
+  if (it == m_sweep_line.begin()) {
+    return m_sweep_line.end();
+  }
+  return --it;
+}
+
+// The first pass sweeps every edge.  When it reaches the top vertex of a contour, the edge directly
+// left of it gives the winding number outside the contour (that on the edge's right side), and the
+// contour's orientation gives the winding number inside.  As in the Shamos-Hoey algorithm, each
+// pair of edges which become neighbors on the sweep line is checked for an intersection (or a
+// contact), since the first one the sweep reaches must be between neighbors.
+bool PolygonTriangulator::ComputeWindings () {
+  const uint32_t vertex_count = static_cast<uint32_t>(m_vertices.size());
+  m_sweep_line.clear();
+  m_edges.assign(vertex_count, m_sweep_line.end());
+  m_contour_kept.assign(m_contours.size(), false); // Here, it means the contour has been reached.
+
+  for (uint32_t rank = 0; rank < vertex_count; ++rank) {
+    const uint32_t v = m_order[rank];
+    const uint32_t previous = m_vertices[v].previous;
+    const EigenTypes::Vector2f &p = Position(v);
+
+    // Remove the edges which end here (the edge from previous ends at v iff it goes down).
+    if (EdgeGoesDown(previous)) {
+      if (m_edges[previous] == m_sweep_line.end()) {
+        return false;
+      }
+      if (!Erase(m_edges[previous])) {
+        return false;
+      }
+      m_edges[previous] = m_sweep_line.end();
+    }
+    if (!EdgeGoesDown(v)) {
+      if (m_edges[v] == m_sweep_line.end()) {
+        return false;
+      }
+      if (!Erase(m_edges[v])) {
+        return false;
+      }
+      m_edges[v] = m_sweep_line.end();
+    }
+
+    const uint32_t c = m_vertices[v].contour;
+    if (!m_contour_kept[c]) {
+      m_contour_kept[c] = true;
+      Contour &contour = m_contours[c];
+      const SweepLine::iterator left = EdgeLeftOf(p, rank);
+      if (left != m_sweep_line.end()) {
+        const Contour &left_contour = m_contours[m_vertices[left->vertex].contour];
+        // A counterclockwise contour's interior is right of its edges which go down.
+        const bool inside_is_right = EdgeGoesDown(left->vertex) == (left_contour.orientation > 0);
+        contour.outside_winding = inside_is_right ? left_contour.inside_winding : left_contour.outside_winding;
+      }
+      contour.inside_winding = contour.outside_winding + contour.orientation;
+    }
+
+    // Insert the edges which start here.
+    if (!EdgeGoesDown(previous)) {
+      const auto inserted = m_sweep_line.insert(MakeEdge(previous, rank));
+      if (!inserted.second || MeetsNeighbors(inserted.first)) {
+        return false; // It overlaps or crosses another edge.
+      }
+      m_edges[previous] = inserted.first;
+    }
+    if (EdgeGoesDown(v)) {
+      const auto inserted = m_sweep_line.insert(MakeEdge(v, rank));
+      if (!inserted.second || MeetsNeighbors(inserted.first)) {
+        return false;
+      }
+      m_edges[v] = inserted.first;
+    }
+  }
+  return m_sweep_line.empty();
+}
+
+// Discards the contours which don't separate a filled region from an unfilled one, and reverses
+// the others as necessary so that the filled region is on their left.
+void PolygonTriangulator::OrientContours (FillRule fill_rule) {
+  for (size_t c = 0; c < m_contours.size(); ++c) {
+    const Contour &contour = m_contours[c];
+    const bool inside_filled = IsFilled(contour.inside_winding, fill_rule);
+    const bool outside_filled = IsFilled(contour.outside_winding, fill_rule);
+    m_contour_kept[c] = contour.orientation != 0 && inside_filled != outside_filled;
+    if (m_contour_kept[c] && (inside_filled ? contour.orientation < 0 : contour.orientation > 0)) {
+      for (uint32_t v = contour.first; v < contour.first + contour.count; ++v) {
+        std::swap(m_vertices[v].next, m_vertices[v].previous);
+      }
+    }
+  }
+}
+
+// The second pass is the sweep which adds diagonals to split the filled region into monotone
+// pieces.  Its comments are those of "Computational Geometry: Algorithms and Applications".
+bool PolygonTriangulator::PartitionIntoMonotonePieces () {
+  const uint32_t vertex_count = static_cast<uint32_t>(m_vertices.size());
+  m_types.resize(vertex_count);
+  for (uint32_t v = 0; v < vertex_count; ++v) {
+    const EigenTypes::Vector2f &p = Position(v);
+    const EigenTypes::Vector2f &previous = Position(m_vertices[v].previous);
+    const EigenTypes::Vector2f &next = Position(m_vertices[v].next);
+    const bool is_convex = Cross(previous, p, next) > 0.0;
+    if (Below(previous, p) && Below(next, p)) {
+      m_types[v] = is_convex ? VertexType::START : VertexType::SPLIT;
+    } else if (Below(p, previous) && Below(p, next)) {
+      m_types[v] = is_convex ? VertexType::END : VertexType::MERGE;
+    } else {
+      m_types[v] = VertexType::REGULAR;
+    }
+  }
+  m_helpers.assign(vertex_count, 0);
+  m_sweep_line.clear();
+  m_edges.assign(vertex_count, m_sweep_line.end());
+
+  for (uint32_t rank = 0; rank < vertex_count; ++rank) {
+    const uint32_t v = m_order[rank];
+    if (!m_contour_kept[m_vertices[v].contour]) {
+      continue;
+    }
+    const uint32_t previous = m_vertices[v].previous;
+    const EigenTypes::Vector2f &p = Position(v);
+    // The vertex whose outgoing edge is v's, which is a copy of v if a diagonal was added at v.
+    uint32_t v2 = v;
+    SweepLine::iterator left;
+
+    switch (m_types[v]) {
+    case VertexType::START:
+      // Insert e_i in T and set helper(e_i) to v_i.
+      m_edges[v] = m_sweep_line.insert(MakeEdge(v, rank)).first;
+      m_helpers[v] = v;
+      break;
+
+    case VertexType::END:
+      // If helper(e_i-1) is a merge vertex, insert the diagonal connecting v_i to helper(e_i-1).
+      if (m_types[m_helpers[previous]] == VertexType::MERGE) {
+        AddDiagonal(v, m_helpers[previous]);
+      }
+      // Delete e_i-1 from T.
+      if (m_edges[previous] == m_sweep_line.end()) {
+        return false;
+      }
+      m_sweep_line.erase(m_edges[previous]);
+      break;
+
+    case VertexType::SPLIT:
+      // Search in T to find the edge e_j directly left of v_i.
+      left = EdgeLeftOf(p, rank);
+      if (left == m_sweep_line.end()) {
+        return false;
+      }
+      // Insert the diagonal connecting v_i to helper(e_j), and set helper(e_j) to v_i.
+      AddDiagonal(v, m_helpers[left->vertex]);
+      v2 = static_cast<uint32_t>(m_vertices.size()) - 2;
+      m_helpers[left->vertex] = v;
+      // Insert e_i in T and set helper(e_i) to v_i.
+      m_edges[v2] = m_sweep_line.insert(MakeEdge(v2, rank)).first;
+      m_helpers[v2] = v2;
+      break;
+
+    case VertexType::MERGE:
+      // If helper(e_i-1) is a merge vertex, insert the diagonal connecting v_i to helper(e_i-1).
+      if (m_types[m_helpers[previous]] == VertexType::MERGE) {
+        AddDiagonal(v, m_helpers[previous]);
+        v2 = static_cast<uint32_t>(m_vertices.size()) - 2;
+      }
+      // Delete e_i-1 from T.
+      if (m_edges[previous] == m_sweep_line.end()) {
+        return false;
+      }
+      m_sweep_line.erase(m_edges[previous]);
+      // Search in T to find the edge e_j directly left of v_i.
+      left = EdgeLeftOf(p, rank);
+      if (left == m_sweep_line.end()) {
+        return false;
+      }
+      // If helper(e_j) is a merge vertex, insert the diagonal connecting v_i to helper(e_j).
+      if (m_types[m_helpers[left->vertex]] == VertexType::MERGE) {
+        AddDiagonal(v2, m_helpers[left->vertex]);
+      }
+      // Set helper(e_j) to v_i.
+      m_helpers[left->vertex] = v2;
+      break;
+
+    case VertexType::REGULAR:
+      if (Below(p, Position(previous))) {
+        // The interior is right of v_i.  If helper(e_i-1) is a merge vertex, insert the diagonal
+        // connecting v_i to helper(e_i-1).
+        if (m_types[m_helpers[previous]] == VertexType::MERGE) {
+          AddDiagonal(v, m_helpers[previous]);
+          v2 = static_cast<uint32_t>(m_vertices.size()) - 2;
+        }
+        // Delete e_i-1 from T.
+        if (m_edges[previous] == m_sweep_line.end()) {
+          return false;
+        }
+        m_sweep_line.erase(m_edges[previous]);
+        // Insert e_i in T and set helper(e_i) to v_i.
+        m_edges[v2] = m_sweep_line.insert(MakeEdge(v2, rank)).first;
+        m_helpers[v2] = v2;
+      } else {
+        // Search in T to find the edge e_j directly left of v_i.
+        left = EdgeLeftOf(p, rank);
+        if (left == m_sweep_line.end()) {
+          return false;
+        }
+        // If helper(e_j) is a merge vertex, insert the diagonal connecting v_i to helper(e_j).
+        if (m_types[m_helpers[left->vertex]] == VertexType::MERGE) {
+          AddDiagonal(v, m_helpers[left->vertex]);
+        }
+        // Set helper(e_j) to v_i.
+        m_helpers[left->vertex] = v;
+      }
+      break;
+    }
+  }
+  return true;
+}
+
+// Adds the diagonal between the given vertices by duplicating them, so that the diagonal appears
+// (once in each direction) in the cycles of the pieces on either side.  The copies, which are the
+// last two vertices, take over the edges leaving the originals.
+void PolygonTriangulator::AddDiagonal (uint32_t index1, uint32_t index2) {
+  const uint32_t new_index1 = static_cast<uint32_t>(m_vertices.size());
+  const uint32_t new_index2 = new_index1 + 1;
+  // index1 -> new_index2 and index2 -> new_index1 are the diagonal.
+  Vertex copy1 = m_vertices[index1];
+  Vertex copy2 = m_vertices[index2];
+  copy1.previous = index2;
+  copy2.previous = index1;
+  m_vertices.push_back(copy1);
+  m_vertices.push_back(copy2);
+  m_vertices[copy1.next].previous = new_index1;
+  m_vertices[copy2.next].previous = new_index2;
+  m_vertices[index1].next = new_index2;
+  m_vertices[index2].next = new_index1;
+
+  m_types.push_back(m_types[index1]);
+  m_types.push_back(m_types[index2]);
+  m_helpers.push_back(m_helpers[index1]);
+  m_helpers.push_back(m_helpers[index2]);
+  m_edges.push_back(m_edges[index1]);
+  m_edges.push_back(m_edges[index2]);
+  if (m_edges[new_index1] != m_sweep_line.end()) {
+    m_edges[new_index1]->vertex = new_index1;
+  }
+  if (m_edges[new_index2] != m_sweep_line.end()) {
+    m_edges[new_index2]->vertex = new_index2;
+  }
+  // The originals' outgoing edges are now diagonals, which are never in the sweep line.
+  m_edges[index1] = m_edges[index2] = m_sweep_line.end();
+}
+
+bool PolygonTriangulator::TriangulateMonotonePieces (std::vector<uint32_t> &indices) {
+  const uint32_t vertex_count = static_cast<uint32_t>(m_vertices.size());
+  m_used.assign(vertex_count, false);
+  for (uint32_t start = 0; start < vertex_count; ++start) {
+    if (m_used[start] || !m_contour_kept[m_vertices[start].contour]) {
+      continue;
+    }
+    m_piece.clear();
+    uint32_t v = start;
+    do {
+      if (m_used[v] || m_piece.size() >= vertex_count) {
+        return false; // The cycle is broken.
+      }
+      m_used[v] = true;
+      m_piece.push_back(v);
+      v = m_vertices[v].next;
+    } while (v != start);
+    if (!TriangulateMonotonePiece(indices)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Triangulates the monotone piece whose (counterclockwise) cycle of vertices is in m_piece, by
+// merging its left and right chains from top to bottom and cutting off every triangle which lies
+// inside the piece.
+bool PolygonTriangulator::TriangulateMonotonePiece (std::vector<uint32_t> &indices) {
+  const uint32_t count = static_cast<uint32_t>(m_piece.size());
+  if (count < 3) {
+    return false;
+  }
+  auto point = [this](uint32_t i) -> const EigenTypes::Vector2f & { return Position(m_piece[i]); };
+  auto emit = [this, &indices](uint32_t a, uint32_t b, uint32_t c) {
+    indices.push_back(m_vertices[m_piece[a]].point);
+    indices.push_back(m_vertices[m_piece[b]].point);
+    indices.push_back(m_vertices[m_piece[c]].point);
+  };
+  if (count == 3) {
+    emit(0, 1, 2);
+    return true;
+  }
+
+  uint32_t top = 0;
+  uint32_t bottom = 0;
+  for (uint32_t i = 1; i < count; ++i) {
+    if (Below(point(i), point(bottom))) {
+      bottom = i;
+    }
+    if (Below(point(top), point(i))) {
+      top = i;
+    }
+  }
+  // Check that the piece really is monotone: going counterclockwise, the left chain runs down
+  // from the top to the bottom, and the right chain back up.
+  for (uint32_t i = top; i != bottom; i = (i + 1)%count) {
+    if (!Below(point((i + 1)%count), point(i))) {
+      return false;
+    }
+  }
+  for (uint32_t i = bottom; i != top; i = (i + 1)%count) {
+    if (!Below(point(i), point((i + 1)%count))) {
+      return false;
+    }
+  }
+
+  // Merge the chains into the sweep order.  The chain of each vertex is 1 for left, -1 for right,
+  // and 0 for the top and bottom.
+  m_piece_order.resize(count);
+  m_piece_chain.resize(count);
+  m_piece_order[0] = top;
+  m_piece_chain[top] = 0;
+  uint32_t left = (top + 1)%count;
+  uint32_t right = (top + count - 1)%count;
+  uint32_t i = 1;
+  for (; i + 1 < count; ++i) {
+    if (left == bottom || (right != bottom && Below(point(left), point(right)))) {
+      m_piece_order[i] = right;
+      m_piece_chain[right] = -1;
+      right = (right + count - 1)%count;
+    } else {
+      m_piece_order[i] = left;
+      m_piece_chain[left] = 1;
+      left = (left + 1)%count;
+    }
+  }
+  m_piece_order[i] = bottom;
+  m_piece_chain[bottom] = 0;
+
+  m_stack.resize(count);
+  m_stack[0] = m_piece_order[0];
+  m_stack[1] = m_piece_order[1];
+  uint32_t stack_size = 2;
+  for (i = 2; i + 1 < count; ++i) {
+    const uint32_t v = m_piece_order[i];
+    if (m_piece_chain[v] != m_piece_chain[m_stack[stack_size - 1]]) {
+      // v is on the other chain from the stack, so it sees all of the stack's vertices.
+      for (uint32_t j = 0; j + 1 < stack_size; ++j) {
+        if (m_piece_chain[v] == 1) {
+          emit(m_stack[j + 1], m_stack[j], v);
+        } else {
+          emit(m_stack[j], m_stack[j + 1], v);
+        }
+      }
+      m_stack[0] = m_piece_order[i - 1];
+      m_stack[1] = v;
+      stack_size = 2;
+    } else {
+      // v is on the same chain as the stack's top, so cut off triangles while they're inside.
+      --stack_size;
+      while (stack_size > 0) {
+        const uint32_t a = m_stack[stack_size - 1];
+        const uint32_t b = m_stack[stack_size];
+        if (m_piece_chain[v] == 1 ? Cross(point(v), point(a), point(b)) > 0.0 : Cross(point(v), point(b), point(a)) > 0.0) {
+          if (m_piece_chain[v] == 1) {
+            emit(v, a, b);
+          } else {
+            emit(v, b, a);
+          }
+          --stack_size;
+        } else {
+          break;
+        }
+      }
+      ++stack_size;
+      m_stack[stack_size++] = v;
+    }
+  }
+  const uint32_t v = m_piece_order[i];
+  for (uint32_t j = 0; j + 1 < stack_size; ++j) {
+    if (m_piece_chain[m_stack[j + 1]] == 1) {
+      emit(m_stack[j], m_stack[j + 1], v);
+    } else {
+      emit(m_stack[j + 1], m_stack[j], v);
+    }
+  }
+  return true;
+}
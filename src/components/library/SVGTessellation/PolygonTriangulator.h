@@ -0,0 +1,119 @@
+#pragma once
+
+#include "EigenTypes.h"
+
+#include <cstdint>
+#include <set>
+#include <vector>
+
+// Triangulates polygons with holes -- any number of closed, non-intersecting contours, nested to
+// any depth -- in O(n log n) time, by partitioning the filled region into y-monotone pieces with a
+// sweep line and triangulating each piece in linear time (see chapter 3 of "Computational
+// Geometry: Algorithms and Applications").  A preliminary sweep computes the winding number on
+// either side of each contour, so the contours may be given in any order and orientation, and the
+// fill rule decides which regions are filled: with EVEN_ODD, an island inside a hole inside an
+// outline is filled, and with NONZERO, so is a hole which winds the same way as its outline.
+//
+// The contours and all the working data are kept in contiguous arrays which are reused, so once a
+// triangulator's buffers have grown large enough, triangulating allocates little beyond the nodes
+// of the sweep line's search tree.
+class PolygonTriangulator {
+public:
+
+  enum class FillRule { NONZERO, EVEN_ODD };
+
+  PolygonTriangulator ();
+
+  // Adds a closed contour, whose last point connects to its first.  Repeated consecutive points,
+  // and the tips of spikes where the contour doubles back on itself, are dropped, and a contour of
+  // fewer than three remaining points is ignored.
+  void AddContour (const EigenTypes::Vector2f *points, size_t count);
+  // Removes all the contours (but keeps the buffers).
+  void Clear ();
+
+  // The points of all the contours, in the order they were added (less any repeated points).
+  const std::vector<EigenTypes::Vector2f> &Points () const { return m_points; }
+  size_t ContourCount () const { return m_contour_starts.size(); }
+  // The range of Points() belonging to the given contour.
+  size_t ContourBegin (size_t contour) const { return m_contour_starts[contour]; }
+  size_t ContourEnd (size_t contour) const { return contour + 1 < m_contour_starts.size() ? m_contour_starts[contour + 1] : m_points.size(); }
+
+  // Appends the triangles which cover the filled region to the given list, as triples of indices
+  // into Points(), wound counterclockwise.  Contours which touch or intersect (each other or
+  // themselves) aren't supported: the first sweep detects them, and this returns false and
+  // appends nothing.
+  bool Triangulate (FillRule fill_rule, std::vector<uint32_t> &indices);
+
+private:
+
+  enum class VertexType : uint8_t { START, SPLIT, END, MERGE, REGULAR };
+
+  // A vertex of the working polygons.  Adding a diagonal duplicates its endpoints, so that each
+  // monotone piece can be walked as a cycle of its own.
+  struct Vertex {
+    uint32_t point;
+    uint32_t contour;
+    uint32_t next;
+    uint32_t previous;
+  };
+
+  // An edge crossing the sweep line, from its upper to its lower endpoint.  The edge starts at
+  // vertex, which changes if a diagonal duplicates that vertex.
+  struct SweepEdge {
+    EigenTypes::Vector2f upper;
+    EigenTypes::Vector2f lower;
+    uint32_t rank;
+    mutable uint32_t vertex;
+  };
+  // Orders the edges crossing the sweep line from left to right.
+  struct SweepEdgeOrder {
+    bool operator () (const SweepEdge &a, const SweepEdge &b) const;
+  };
+  typedef std::set<SweepEdge,SweepEdgeOrder> SweepLine;
+
+  struct Contour {
+    uint32_t first;
+    uint32_t count;
+    int orientation;
+    int inside_winding;
+    int outside_winding;
+  };
+
+  const EigenTypes::Vector2f &Position (uint32_t vertex) const { return m_points[m_vertices[vertex].point]; }
+  bool EdgeGoesDown (uint32_t vertex) const;
+  SweepEdge MakeEdge (uint32_t vertex, uint32_t rank) const;
+  // Returns the edge directly left of the given point, or end() if there is none.
+  SweepLine::iterator EdgeLeftOf (const EigenTypes::Vector2f &point, uint32_t rank);
+  // True iff the edges have a point in common, other than the vertex joining consecutive edges.
+  bool EdgesMeet (const SweepEdge &a, const SweepEdge &b) const;
+  // True iff the edge meets either of its neighbors on the sweep line.
+  bool MeetsNeighbors (SweepLine::iterator edge) const;
+  // Removes the edge from the sweep line, and returns false iff its neighbors, which become
+  // neighbors of each other, meet.
+  bool Erase (SweepLine::iterator edge);
+
+  bool ComputeWindings ();
+  void OrientContours (FillRule fill_rule);
+  bool PartitionIntoMonotonePieces ();
+  void AddDiagonal (uint32_t index1, uint32_t index2);
+  bool TriangulateMonotonePieces (std::vector<uint32_t> &indices);
+  bool TriangulateMonotonePiece (std::vector<uint32_t> &indices);
+
+  std::vector<EigenTypes::Vector2f> m_points;
+  std::vector<uint32_t> m_contour_starts;
+
+  // Working data, kept between calls to Triangulate so that its capacity is reused.
+  std::vector<Contour> m_contours;
+  std::vector<bool> m_contour_kept;
+  std::vector<Vertex> m_vertices;
+  std::vector<uint32_t> m_order;
+  std::vector<VertexType> m_types;
+  std::vector<uint32_t> m_helpers;
+  std::vector<SweepLine::iterator> m_edges;
+  std::vector<bool> m_used;
+  std::vector<uint32_t> m_piece;
+  std::vector<uint32_t> m_piece_order;
+  std::vector<int8_t> m_piece_chain;
+  std::vector<uint32_t> m_stack;
+  SweepLine m_sweep_line;
+};
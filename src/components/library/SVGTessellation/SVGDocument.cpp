@@ -0,0 +1,200 @@
+#include "SVGDocument.h"
+
+#include "SVGTessellationCache.h"
+
+#include <nanosvg.h>
+
+#include <cctype>
+#include <cstdlib>
+
+namespace {
+
+// The documents returned by SVGDocument::Get, which are removed when they're released.
+struct Registry {
+  std::mutex mutex;
+  std::map<uint64_t,std::weak_ptr<const SVGDocument>> documents;
+};
+
+Registry &SharedRegistry () {
+  static Registry registry;
+  return registry;
+}
+
+// Returns the value of the given attribute of the root <svg> element, or an empty string.
+std::string RootAttribute (const std::string &svg, const std::string &name) {
+  size_t start = svg.find("<svg");
+  while (start != std::string::npos && start + 4 < svg.size() && !std::isspace(static_cast<unsigned char>(svg[start + 4]))) {
+    start = svg.find("<svg", start + 4);
+  }
+  if (start == std::string::npos) {
+    return std::string();
+  }
+  const size_t end = svg.find('>', start);
+  for (size_t i = svg.find(name, start); i < end; i = svg.find(name, i + 1)) {
+    size_t j = i + name.size();
+    while (j < end && std::isspace(static_cast<unsigned char>(svg[j]))) { ++j; }
+    if (!std::isspace(static_cast<unsigned char>(svg[i - 1])) || j >= end || svg[j] != '=') {
+      continue; // Part of another attribute's name or value.
+    }
+    do { ++j; } while (j < end && std::isspace(static_cast<unsigned char>(svg[j])));
+    const size_t close = j < end ? svg.find(svg[j], j + 1) : std::string::npos;
+    if ((svg[j] != '"' && svg[j] != '\'') || close == std::string::npos || close > end) {
+      return std::string();
+    }
+    return svg.substr(j + 1, close - j - 1);
+  }
+  return std::string();
+}
+
+// Parses a length in pixels (i.e. with no unit, or "px"), returning 0 if it isn't one.
+float PixelLength (const std::string &value) {
+  char *rest = nullptr;
+  const float length = std::strtof(value.c_str(), &rest);
+  while (*rest != '\0' && std::isspace(static_cast<unsigned char>(*rest))) { ++rest; }
+  const std::string unit(rest);
+  return (unit.empty() || unit.compare(0, 2, "px") == 0) && length > 0.0f ? length : 0.0f;
+}
+
+} // end of anonymous namespace
+
+std::shared_ptr<const SVGDocument> SVGDocument::Get (const std::string &svg) {
+  const uint64_t hash = SVGTessellationCache::HashContents(svg);
+  Registry &registry = SharedRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  std::weak_ptr<const SVGDocument> &entry = registry.documents[hash];
+  std::shared_ptr<const SVGDocument> document(entry.lock());
+  if (document) {
+    if (document->Contents() == svg) {
+      return document;
+    }
+    // A hash collision, which is vanishingly unlikely, just isn't shared.
+    return std::shared_ptr<const SVGDocument>(new SVGDocument(svg, hash));
+  }
+  document.reset(new SVGDocument(svg, hash), Release);
+  entry = document;
+  return document;
+}
+
+size_t SVGDocument::LiveCount () {
+  Registry &registry = SharedRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  size_t count = 0;
+  for (const auto &entry : registry.documents) {
+    if (!entry.second.expired()) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+void SVGDocument::Release (const SVGDocument *document) {
+  {
+    Registry &registry = SharedRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    // Get may already have replaced the entry with a new document of the same contents.
+    auto found = registry.documents.find(document->Hash());
+    if (found != registry.documents.end() && found->second.expired()) {
+      registry.documents.erase(found);
+    }
+  }
+  delete document;
+}
+
+SVGDocument::SVGDocument (const std::string &svg, uint64_t hash)
+  :
+  m_contents(svg),
+  m_hash(hash),
+  m_has_canvas_size(false),
+  m_image(nullptr),
+  m_parsed(false)
+{
+  // As in nanosvg, a missing width or height is taken from the viewBox.
+  float view_box[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+  const std::string view_box_value(RootAttribute(svg, "viewBox"));
+  const char *next = view_box_value.c_str();
+  for (int i = 0; i < 4 && *next != '\0'; i++) {
+    char *rest = nullptr;
+    view_box[i] = std::strtof(next, &rest);
+    for (next = rest; *next == ',' || std::isspace(static_cast<unsigned char>(*next)); ++next) { }
+  }
+  float width = PixelLength(RootAttribute(svg, "width"));
+  float height = PixelLength(RootAttribute(svg, "height"));
+  width = width > 0.0f ? width : view_box[2];
+  height = height > 0.0f ? height : view_box[3];
+  if (width > 0.0f && height > 0.0f) {
+    m_has_canvas_size = true;
+    m_canvas_size << width, height;
+  }
+}
+
+SVGDocument::~SVGDocument () {
+  if (m_image) {
+    nsvgDelete(m_image);
+  }
+}
+
+bool SVGDocument::CanvasSize (EigenTypes::Vector2f &size) const {
+  if (m_has_canvas_size) {
+    size = m_canvas_size;
+  }
+  return m_has_canvas_size;
+}
+
+const NSVGimage *SVGDocument::Image () const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (!m_parsed) {
+    m_parsed = true;
+    std::string copy(m_contents); // nanosvg modifies the text it parses.
+    m_image = nsvgParse(const_cast<char *>(copy.c_str()), "px", 96.0f);
+  }
+  return m_image;
+}
+
+bool SVGDocument::IsParsed () const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_parsed;
+}
+
+std::shared_ptr<const SVGTessellation> SVGDocument::Tessellation (float tolerance) const {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto found = m_tessellations.find(tolerance);
+    if (found != m_tessellations.end()) {
+      std::shared_ptr<const SVGTessellation> tessellation(found->second.lock());
+      if (tessellation) {
+        return tessellation;
+      }
+    }
+  }
+  // Loading or tessellating happens outside the lock, so that different tolerances can be
+  // computed concurrently.
+  std::shared_ptr<const SVGTessellation> tessellation(SVGTessellationCache::Shared().Get(*this, tolerance));
+  if (!tessellation) {
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::weak_ptr<const SVGTessellation> &entry = m_tessellations[tolerance];
+  std::shared_ptr<const SVGTessellation> existing(entry.lock());
+  if (existing) {
+    return existing; // Another thread computed the same tessellation first.
+  }
+  entry = tessellation;
+  for (auto it = m_tessellations.begin(); it != m_tessellations.end(); ) {
+    if (it->second.expired()) {
+      it = m_tessellations.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  return tessellation;
+}
+
+bool SVGDocument::Tessellate (float tolerance, SVGTessellation &tessellation) const {
+  const NSVGimage *image = Image();
+  if (!image) {
+    tessellation.Clear();
+    return false;
+  }
+  tessellation.Tessellate(*image, tolerance);
+  return true;
+}
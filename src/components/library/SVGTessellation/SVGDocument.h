@@ -0,0 +1,76 @@
+#pragma once
+
+#include "SVGTessellation.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+struct NSVGimage;
+
+// An SVG document, shared by everything which uses the same source.  Get returns the same
+// instance for the same contents for as long as anyone holds a reference to it, so however many
+// primitives show an icon, its source is stored once, parsed at most once, and each of its
+// tessellations is loaded (or computed) once and shared.
+//
+// The document is only parsed if a tessellation isn't in SVGTessellationCache, and the parse is
+// then kept until the document is released.  The tessellations are only held by their users, so
+// a level of detail which nobody draws any more is freed (and reloaded from the on-disk cache if
+// it's needed again).
+//
+// All the methods may be called from any thread.
+class SVGDocument {
+public:
+
+  // Returns the document with the given contents, creating it if no other reference to one
+  // exists.  Documents are identified by SVGTessellationCache::HashContents, and contents which
+  // collide with a live document's hash get a document of their own (which isn't shared).
+  static std::shared_ptr<const SVGDocument> Get (const std::string &svg);
+  // The number of documents currently alive (and so shared by Get).
+  static size_t LiveCount ();
+
+  ~SVGDocument ();
+
+  const std::string &Contents () const { return m_contents; }
+  uint64_t Hash () const { return m_hash; }
+
+  // The size of the document's canvas, from the root element's width and height (or its viewBox)
+  // in pixels, which is read without parsing the document.  The shapes are placed on this canvas,
+  // so it stands in for their bounds until a tessellation is available.  Returns false (leaving
+  // size alone) if the root element specifies neither.
+  bool CanvasSize (EigenTypes::Vector2f &size) const;
+
+  // Returns the parsed document, parsing it if this is the first call, or nullptr if it couldn't
+  // be parsed.
+  const NSVGimage *Image () const;
+  // True iff the document has been parsed (which happens at most once).
+  bool IsParsed () const;
+
+  // Returns the tessellation at the given tolerance, from SVGTessellationCache::Shared() (which
+  // tessellates the parsed document if it has no entry), or nullptr if the document couldn't be
+  // parsed.  While any caller holds the result, the same tessellation is returned for the same
+  // tolerance.
+  std::shared_ptr<const SVGTessellation> Tessellation (float tolerance = SVGTessellation::DEFAULT_TOLERANCE) const;
+  // Tessellates the parsed document, without any caching.  Returns false if it couldn't be parsed.
+  bool Tessellate (float tolerance, SVGTessellation &tessellation) const;
+
+private:
+
+  SVGDocument (const std::string &svg, uint64_t hash);
+  SVGDocument (const SVGDocument &) = delete;
+  SVGDocument &operator = (const SVGDocument &) = delete;
+  // The deleter of shared documents, which also removes them from the registry used by Get.
+  static void Release (const SVGDocument *document);
+
+  const std::string m_contents;
+  const uint64_t m_hash;
+  bool m_has_canvas_size;
+  EigenTypes::Vector2f m_canvas_size;
+
+  mutable std::mutex m_mutex;
+  mutable NSVGimage *m_image;
+  mutable bool m_parsed;
+  mutable std::map<float,std::weak_ptr<const SVGTessellation>> m_tessellations;
+};
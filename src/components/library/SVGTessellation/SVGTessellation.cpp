@@ -0,0 +1,491 @@
+#include "SVGTessellation.h"
+
+#include "PolygonTriangulator.h"
+
+#define NANOSVG_ALL_COLOR_KEYWORDS  // Include full list of color keywords.
+#define NANOSVG_IMPLEMENTATION
+#include <nanosvg.h>
+#include <polypartition.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <list>
+
+const float SVGTessellation::DEFAULT_TOLERANCE = 0.5f;
+
+namespace {
+
+// Flattens a path made of cubic Bezier curves into a polyline.  Rather than subdividing until
+// each piece is flat enough, each curve is evaluated at evenly spaced parameter values, using the
+// number of segments which Wang's formula guarantees keeps every segment within the tolerance of
+// the curve:
+//   n = ceil(sqrt(3/4 * max(|b0 - 2 b1 + b2|, |b1 - 2 b2 + b3|) / tolerance))
+// This costs a few operations per curve, and bounds the number of points up front.
+class Curve {
+  public:
+    struct Bezier {
+      EigenTypes::Vector2f b[4];
+    };
+
+    // An upper bound on the number of segments per curve, in case of a degenerate tolerance.
+    static const int MAX_SEGMENTS = 256;
+
+    Curve(float tolerance = 1.0f);
+
+    void Append(const Bezier& bezier);
+
+    const std::vector<EigenTypes::Vector2f>& Points() const { return m_points; }
+
+    static int SegmentCount(const Bezier& bezier, float tolerance);
+
+  private:
+    void AppendPoint(const EigenTypes::Vector2f& p);
+    float m_tolerance;
+
+    std::vector<EigenTypes::Vector2f> m_points;
+};
+
+Curve::Curve(float tolerance) : m_tolerance(tolerance)
+{
+}
+
+int Curve::SegmentCount(const Bezier& bezier, float tolerance) {
+  const float d0 = (bezier.b[0] - 2.0f*bezier.b[1] + bezier.b[2]).norm();
+  const float d1 = (bezier.b[1] - 2.0f*bezier.b[2] + bezier.b[3]).norm();
+  const float segments = std::ceil(std::sqrt(0.75f*std::max(d0, d1)/tolerance));
+  // Also catches NaN from a nonpositive tolerance.
+  if (!(segments < static_cast<float>(MAX_SEGMENTS))) {
+    return MAX_SEGMENTS;
+  }
+  return std::max(1, static_cast<int>(segments));
+}
+
+void Curve::Append(const Bezier& bezier) {
+  if (m_points.empty()) {
+    m_points.push_back(bezier.b[0]);
+  }
+  const int segments = SegmentCount(bezier, m_tolerance);
+  const float dt = 1.0f/static_cast<float>(segments);
+  for (int i = 1; i < segments; ++i) {
+    const float t = dt*static_cast<float>(i);
+    const float s = 1.0f - t;
+    AppendPoint((s*s*s)*bezier.b[0] + (3.0f*s*s*t)*bezier.b[1] + (3.0f*s*t*t)*bezier.b[2] + (t*t*t)*bezier.b[3]);
+  }
+  // The endpoint is exact, so that consecutive curves meet.
+  AppendPoint(bezier.b[3]);
+}
+
+void Curve::AppendPoint(const EigenTypes::Vector2f& p) {
+  // A point which returns to the start of the path (or repeats the previous point, e.g. at the
+  // end of a zero-length curve) would make a degenerate polygon.
+  const EigenTypes::Vector2f& first = m_points.front();
+  const EigenTypes::Vector2f& last = m_points.back();
+  if ((std::abs(p.x() - first.x()) < FLT_EPSILON && std::abs(p.y() - first.y()) < FLT_EPSILON) ||
+      (std::abs(p.x() - last.x()) < FLT_EPSILON && std::abs(p.y() - last.y()) < FLT_EPSILON)) {
+    return;
+  }
+  m_points.push_back(p);
+}
+
+// Appends a triangle to a triangle list, wound counterclockwise like the triangulated fills.
+void AppendTriangle(const EigenTypes::Vector2f& a, const EigenTypes::Vector2f& b, const EigenTypes::Vector2f& c, std::vector<EigenTypes::Vector2f>& triangles) {
+  const float doubleArea = (b.x() - a.x())*(c.y() - a.y()) - (b.y() - a.y())*(c.x() - a.x());
+  if (doubleArea == 0.0f) {
+    return; // Degenerate triangles cover nothing.
+  }
+  triangles.push_back(a);
+  triangles.push_back(doubleArea > 0.0f ? b : c);
+  triangles.push_back(doubleArea > 0.0f ? c : b);
+}
+
+// The unit vector perpendicular to (90 degrees counterclockwise from) the given direction.
+EigenTypes::Vector2f Perpendicular(const EigenTypes::Vector2f& direction) {
+  return EigenTypes::Vector2f(-direction.y(), direction.x());
+}
+
+// Tessellates the area covered by stroking polylines into triangles: a quad per segment, plus the
+// joins and caps given by the shape's stroke-linejoin, stroke-linecap and stroke-miterlimit.  The
+// pieces overlap at the joins, which is only visible if the stroke is translucent.  Round joins
+// and caps are flattened to the same tolerance as the curves.
+class Stroker {
+  public:
+    Stroker(float width, char lineJoin, char lineCap, float miterLimit, float tolerance);
+
+    void Append(const std::vector<EigenTypes::Vector2f>& points, bool isClosed, std::vector<EigenTypes::Vector2f>& triangles) const;
+
+  private:
+    // The join at the given point between segments with the given (unit) directions.
+    void AppendJoin(const EigenTypes::Vector2f& point, const EigenTypes::Vector2f& dirIn, const EigenTypes::Vector2f& dirOut, std::vector<EigenTypes::Vector2f>& triangles) const;
+    // The cap at the given end point, where the given (unit) direction points away from the path.
+    void AppendCap(const EigenTypes::Vector2f& point, const EigenTypes::Vector2f& dirOut, std::vector<EigenTypes::Vector2f>& triangles) const;
+    // A fan of triangles covering the sector of the stroke-width circle about the given center,
+    // starting at the given unit vector and sweeping through the given (signed) angle.
+    void AppendArc(const EigenTypes::Vector2f& center, const EigenTypes::Vector2f& from, float angle, std::vector<EigenTypes::Vector2f>& triangles) const;
+
+    float m_halfWidth;
+    char m_lineJoin;
+    char m_lineCap;
+    float m_miterLimit;
+    // The largest angle subtended by one segment of a round join or cap.
+    float m_maxArcStep;
+};
+
+Stroker::Stroker(float width, char lineJoin, char lineCap, float miterLimit, float tolerance) :
+  m_halfWidth(0.5f*width),
+  m_lineJoin(lineJoin),
+  m_lineCap(lineCap),
+  m_miterLimit(miterLimit)
+{
+  // A chord subtending the angle a lies within h (1 - cos(a/2)) of a circle of radius h.
+  const float ratio = tolerance/m_halfWidth;
+  m_maxArcStep = ratio > 0.0f && ratio < 1.0f ? 2.0f*std::acos(1.0f - ratio) : static_cast<float>(M_PI_2);
+}
+
+void Stroker::Append(const std::vector<EigenTypes::Vector2f>& points, bool isClosed, std::vector<EigenTypes::Vector2f>& triangles) const {
+  const size_t count = points.size();
+  if (count == 0) {
+    return;
+  }
+  if (count == 1) {
+    // A zero-length path is only visible through its caps.
+    const EigenTypes::Vector2f direction(EigenTypes::Vector2f::UnitX());
+    AppendCap(points[0], direction, triangles);
+    AppendCap(points[0], -direction, triangles);
+    return;
+  }
+
+  const size_t segmentCount = isClosed ? count : count - 1;
+  std::vector<EigenTypes::Vector2f> directions;
+  directions.reserve(segmentCount);
+  for (size_t i = 0; i < segmentCount; ++i) {
+    const EigenTypes::Vector2f& a = points[i];
+    const EigenTypes::Vector2f& b = points[(i + 1) % count];
+    directions.push_back((b - a).normalized());
+    const EigenTypes::Vector2f offset = m_halfWidth*Perpendicular(directions.back());
+    AppendTriangle(a + offset, a - offset, b - offset, triangles);
+    AppendTriangle(a + offset, b - offset, b + offset, triangles);
+  }
+
+  if (isClosed) {
+    for (size_t i = 0; i < count; ++i) {
+      AppendJoin(points[i], directions[(i + segmentCount - 1) % segmentCount], directions[i], triangles);
+    }
+  } else {
+    for (size_t i = 1; i + 1 < count; ++i) {
+      AppendJoin(points[i], directions[i - 1], directions[i], triangles);
+    }
+    AppendCap(points.front(), -directions.front(), triangles);
+    AppendCap(points.back(), directions.back(), triangles);
+  }
+}
+
+void Stroker::AppendJoin(const EigenTypes::Vector2f& point, const EigenTypes::Vector2f& dirIn, const EigenTypes::Vector2f& dirOut, std::vector<EigenTypes::Vector2f>& triangles) const {
+  const float cross = dirIn.x()*dirOut.y() - dirIn.y()*dirOut.x();
+  const float dot = dirIn.dot(dirOut);
+  if (std::abs(cross) < 1e-6f && dot > 0.0f) {
+    return; // The segments are collinear, so their quads already meet.
+  }
+  // The segments' quads overlap on the inside of the turn and leave a gap on the outside, which
+  // is on the right of a left (counterclockwise) turn.
+  const float side = cross > 0.0f ? -1.0f : 1.0f;
+  const EigenTypes::Vector2f normalIn = side*Perpendicular(dirIn);
+  const EigenTypes::Vector2f normalOut = side*Perpendicular(dirOut);
+  const EigenTypes::Vector2f outerIn = point + m_halfWidth*normalIn;
+  const EigenTypes::Vector2f outerOut = point + m_halfWidth*normalOut;
+
+  if (m_lineJoin == NSVG_JOIN_ROUND) {
+    const float angle = std::atan2(normalIn.x()*normalOut.y() - normalIn.y()*normalOut.x(), normalIn.dot(normalOut));
+    AppendArc(point, normalIn, angle, triangles);
+    return;
+  }
+  if (m_lineJoin == NSVG_JOIN_MITER) {
+    // The ratio of the miter length to the stroke width is 1/sin(t/2), where t is the angle
+    // between the segments, i.e. 1/cos(u/2), where u is the angle between their normals.
+    const EigenTypes::Vector2f bisector = normalIn + normalOut;
+    const float bisectorNorm = bisector.norm();
+    if (bisectorNorm > 1e-6f) {
+      const EigenTypes::Vector2f miterDirection = bisector/bisectorNorm;
+      const float miterRatio = 1.0f/miterDirection.dot(normalIn);
+      if (miterRatio <= m_miterLimit) {
+        const EigenTypes::Vector2f tip = point + (m_halfWidth*miterRatio)*miterDirection;
+        AppendTriangle(point, outerIn, tip, triangles);
+        AppendTriangle(point, tip, outerOut, triangles);
+        return;
+      }
+    }
+  }
+  // A bevel join, which is also the fallback for a miter exceeding the miter limit.
+  AppendTriangle(point, outerIn, outerOut, triangles);
+}
+
+void Stroker::AppendCap(const EigenTypes::Vector2f& point, const EigenTypes::Vector2f& dirOut, std::vector<EigenTypes::Vector2f>& triangles) const {
+  const EigenTypes::Vector2f normal = Perpendicular(dirOut);
+  if (m_lineCap == NSVG_CAP_SQUARE) {
+    const EigenTypes::Vector2f side = m_halfWidth*normal;
+    const EigenTypes::Vector2f extension = m_halfWidth*dirOut;
+    AppendTriangle(point + side, point - side, point - side + extension, triangles);
+    AppendTriangle(point + side, point - side + extension, point + side + extension, triangles);
+  } else if (m_lineCap == NSVG_CAP_ROUND) {
+    // Sweep clockwise from the normal, through the outward direction, to the opposite side.
+    AppendArc(point, normal, -static_cast<float>(M_PI), triangles);
+  } // A butt cap adds nothing.
+}
+
+void Stroker::AppendArc(const EigenTypes::Vector2f& center, const EigenTypes::Vector2f& from, float angle, std::vector<EigenTypes::Vector2f>& triangles) const {
+  const float steps = std::ceil(std::abs(angle)/m_maxArcStep);
+  const int segments = steps < static_cast<float>(Curve::MAX_SEGMENTS) ? std::max(1, static_cast<int>(steps)) : Curve::MAX_SEGMENTS;
+  const float step = angle/static_cast<float>(segments);
+  EigenTypes::Vector2f previous = center + m_halfWidth*from;
+  for (int i = 1; i <= segments; ++i) {
+    const float a = step*static_cast<float>(i);
+    const float c = std::cos(a);
+    const float s = std::sin(a);
+    const EigenTypes::Vector2f current = center + m_halfWidth*EigenTypes::Vector2f(c*from.x() - s*from.y(), s*from.x() + c*from.y());
+    AppendTriangle(center, previous, current, triangles);
+    previous = current;
+  }
+}
+
+// True iff the point is inside the closed polygon (by the even-odd rule).
+bool ContainsPoint(const EigenTypes::Vector2f* polygon, size_t count, const EigenTypes::Vector2f& p) {
+  bool inside = false;
+  for (size_t i = 0, j = count - 1; i < count; j = i++) {
+    const EigenTypes::Vector2f& a = polygon[i];
+    const EigenTypes::Vector2f& b = polygon[j];
+    if ((a.y() > p.y()) != (b.y() > p.y()) && p.x() < a.x() + (b.x() - a.x())*(p.y() - a.y())/(b.y() - a.y())) {
+      inside = !inside;
+    }
+  }
+  return inside;
+}
+
+float SignedArea(const EigenTypes::Vector2f* polygon, size_t count) {
+  float doubleArea = 0.0f;
+  for (size_t i = 0, j = count - 1; i < count; j = i++) {
+    doubleArea += polygon[j].x()*polygon[i].y() - polygon[i].x()*polygon[j].y();
+  }
+  return 0.5f*doubleArea;
+}
+
+// Fills the triangulator's contours by ear clipping (with polypartition), for the contours which
+// PolygonTriangulator rejects because they touch or intersect.  A contour lying entirely inside
+// another is a hole or an island (as the fill rule says), and every contour which isn't a hole is
+// triangulated along with the holes directly inside it.  Contours which only partly overlap are
+// triangulated separately, so their fill is the union of their interiors (under either rule).
+// Returns false if some contour (e.g. one which intersects itself) couldn't be triangulated, in
+// which case the rest are still filled.
+bool TriangulateByEarClipping(const PolygonTriangulator& triangulator, PolygonTriangulator::FillRule fillRule, std::vector<EigenTypes::Vector2f>& triangles) {
+  const size_t count = triangulator.ContourCount();
+  const EigenTypes::Vector2f* points = triangulator.Points().data();
+  std::vector<float> areas(count);
+  for (size_t i = 0; i < count; ++i) {
+    areas[i] = SignedArea(points + triangulator.ContourBegin(i), triangulator.ContourEnd(i) - triangulator.ContourBegin(i));
+  }
+  // The smallest contour containing each contour, if any.
+  std::vector<size_t> parents(count, count);
+  for (size_t i = 0; i < count; ++i) {
+    for (size_t j = 0; j < count; ++j) {
+      if (j == i || std::abs(areas[j]) <= std::abs(areas[i]) || (parents[i] < count && std::abs(areas[j]) >= std::abs(areas[parents[i]]))) {
+        continue;
+      }
+      const EigenTypes::Vector2f* contour = points + triangulator.ContourBegin(j);
+      const size_t size = triangulator.ContourEnd(j) - triangulator.ContourBegin(j);
+      bool isInside = true;
+      for (size_t k = triangulator.ContourBegin(i); isInside && k < triangulator.ContourEnd(i); ++k) {
+        isInside = ContainsPoint(contour, size, points[k]);
+      }
+      if (isInside) {
+        parents[i] = j;
+      }
+    }
+  }
+  // The winding number (or the nesting depth, for EVEN_ODD) just inside each contour.  Parents
+  // are larger than their children, so they come first in order of decreasing area.
+  std::vector<size_t> order(count);
+  for (size_t i = 0; i < count; ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [&areas](size_t a, size_t b) { return std::abs(areas[a]) > std::abs(areas[b]); });
+  std::vector<int> windings(count, 0);
+  for (const size_t i : order) {
+    const int parentWinding = parents[i] < count ? windings[parents[i]] : 0;
+    windings[i] = parentWinding + (fillRule == PolygonTriangulator::FillRule::EVEN_ODD || areas[i] > 0.0f ? 1 : -1);
+  }
+  const auto isHole = [fillRule, &windings](size_t i) {
+    return fillRule == PolygonTriangulator::FillRule::EVEN_ODD ? windings[i] % 2 == 0 : windings[i] == 0;
+  };
+
+  const auto makePoly = [&triangulator, points](size_t i, bool hole) {
+    TPPLPoly poly;
+    const size_t begin = triangulator.ContourBegin(i);
+    poly.Init(static_cast<long>(triangulator.ContourEnd(i) - begin));
+    for (long k = 0; k < poly.GetNumPoints(); ++k) {
+      poly[k].x = points[begin + k].x();
+      poly[k].y = points[begin + k].y();
+    }
+    poly.SetHole(hole);
+    poly.SetOrientation(hole ? TPPL_CW : TPPL_CCW);
+    return poly;
+  };
+  bool succeeded = true;
+  TPPLPartition partition;
+  for (size_t i = 0; i < count; ++i) {
+    if (isHole(i)) {
+      continue;
+    }
+    std::list<TPPLPoly> polys;
+    polys.push_back(makePoly(i, false));
+    for (size_t j = 0; j < count; ++j) {
+      if (parents[j] == i && isHole(j)) {
+        polys.push_back(makePoly(j, true));
+      }
+    }
+    std::list<TPPLPoly> pieces;
+    if (!partition.Triangulate_EC(&polys, &pieces)) {
+      succeeded = false;
+      continue;
+    }
+    for (TPPLPoly& piece : pieces) {
+      AppendTriangle(EigenTypes::Vector2f(static_cast<float>(piece[0].x), static_cast<float>(piece[0].y)),
+                     EigenTypes::Vector2f(static_cast<float>(piece[1].x), static_cast<float>(piece[1].y)),
+                     EigenTypes::Vector2f(static_cast<float>(piece[2].x), static_cast<float>(piece[2].y)), triangles);
+    }
+  }
+  return succeeded;
+}
+
+// nanosvg packs colors as 0xAABBGGRR.
+void UnpackColor(uint32_t packedColor, float alphaScale, float (&color)[4]) {
+  color[0] = static_cast<float>( packedColor        & 0xFF)/255.0f;
+  color[1] = static_cast<float>((packedColor >>  8) & 0xFF)/255.0f;
+  color[2] = static_cast<float>((packedColor >> 16) & 0xFF)/255.0f;
+  color[3] = static_cast<float>((packedColor >> 24) & 0xFF)/255.0f*alphaScale;
+}
+
+void AppendShape(const NSVGshape* shape, float tolerance, PolygonTriangulator& triangulator, std::vector<SVGTessellation::Mesh>& meshes) {
+  const uint32_t fillColor = shape->fill.color;
+  const uint32_t strokeColor = shape->stroke.color;
+  const float opacity = shape->opacity;
+  const float strokeWidth = shape->strokeWidth;
+  const bool doFill = (fillColor & 0xFF000000) != 0 && shape->fill.type == NSVG_PAINT_COLOR;
+  const bool doStroke = (strokeColor & 0xFF000000) != 0 && strokeWidth > FLT_EPSILON &&
+                        (shape->fill.type == NSVG_PAINT_COLOR || shape->fill.type == NSVG_PAINT_NONE);
+
+  if ((!doFill && !doStroke) || opacity <= FLT_EPSILON) {
+    return; // Nothing to do...
+  }
+  // Every path of the shape is a contour of its fill, and the fill rule decides which are holes.
+  triangulator.Clear();
+  // The strokes of all the paths are gathered into one mesh, since they have the same color.
+  SVGTessellation::Mesh stroke;
+  stroke.type = SVGTessellation::MeshType::STROKE;
+  UnpackColor(strokeColor, opacity, stroke.color);
+  const Stroker stroker(strokeWidth, shape->strokeLineJoin, shape->strokeLineCap, shape->miterLimit, tolerance);
+
+  for (NSVGpath* path = shape->paths; path != NULL; path = path->next) {
+    Curve curve(tolerance);
+    for (int i = 0; i < path->npts-1; i += 3) {
+      const float* p = &path->pts[i*2];
+      Curve::Bezier bezier;
+      bezier.b[0] << p[0], p[1];
+      bezier.b[1] << p[2], p[3];
+      bezier.b[2] << p[4], p[5];
+      bezier.b[3] << p[6], p[7];
+      curve.Append(bezier);
+    }
+    const auto& points = curve.Points();
+    if (points.empty()) {
+      continue;
+    }
+    if (doFill) {
+      triangulator.AddContour(points.data(), points.size());
+    }
+    if (doStroke) {
+      std::vector<EigenTypes::Vector2f> polyline(points);
+      // Curve drops a point which returns to the start, but an open path's final segment is still
+      // stroked (with caps rather than a join).
+      const bool isClosed = path->closed != '\0';
+      const float* end = &path->pts[(path->npts - 1)*2];
+      if (!isClosed && polyline.size() > 1 && end[0] == path->pts[0] && end[1] == path->pts[1]) {
+        polyline.push_back(polyline.front());
+      }
+      stroker.Append(polyline, isClosed, stroke.points);
+    }
+  }
+  // Add the fill (if applicable)
+  if (triangulator.ContourCount() > 0) {
+    const PolygonTriangulator::FillRule fillRule = shape->fillRule == NSVG_FILLRULE_EVENODD ? PolygonTriangulator::FillRule::EVEN_ODD : PolygonTriangulator::FillRule::NONZERO;
+    std::vector<uint32_t> indices;
+    SVGTessellation::Mesh fill;
+    fill.type = SVGTessellation::MeshType::FILL;
+    UnpackColor(fillColor, opacity, fill.color);
+    if (triangulator.Triangulate(fillRule, indices)) {
+      fill.points.reserve(indices.size());
+      for (const uint32_t index : indices) {
+        fill.points.push_back(triangulator.Points()[index]);
+      }
+    } else {
+      // The contours touch or intersect, which the sweep doesn't handle, so fall back to the
+      // slower ear clipping.  Whatever it can't triangulate is left out.
+      TriangulateByEarClipping(triangulator, fillRule, fill.points);
+    }
+    if (!fill.points.empty()) {
+      meshes.emplace_back(std::move(fill));
+    }
+  }
+  // Add the stroke after the fill
+  if (!stroke.points.empty()) {
+    meshes.emplace_back(std::move(stroke));
+  }
+}
+
+} // end of anonymous namespace
+
+SVGTessellation::SVGTessellation() {
+  Clear();
+}
+
+void SVGTessellation::Clear() {
+  m_Origin.setZero();
+  m_Size.setZero();
+  m_Meshes.clear();
+}
+
+bool SVGTessellation::Tessellate(const std::string& svg, float tolerance) {
+  Clear();
+  std::string svgCopy{svg}; // Make a copy so that nanosvg can modify its contents (horrors)
+  NSVGimage* image = nsvgParse(const_cast<char*>(svgCopy.c_str()), "px", 96.0f);
+  if (!image) {
+    return false;
+  }
+  Tessellate(*image, tolerance);
+  nsvgDelete(image);
+  return true;
+}
+
+void SVGTessellation::Tessellate(const NSVGimage& image, float tolerance) {
+  Clear();
+  float bounds[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+  bool isFirst = true;
+  // Shared by the shapes, so that its buffers are reused.
+  PolygonTriangulator triangulator;
+
+  for (const NSVGshape* shape = image.shapes; shape != NULL; shape = shape->next) {
+    if (isFirst) {
+      isFirst = false;
+      bounds[0] = shape->bounds[0];
+      bounds[1] = shape->bounds[1];
+      bounds[2] = shape->bounds[2];
+      bounds[3] = shape->bounds[3];
+    } else {
+      if (shape->bounds[0] < bounds[0]) { bounds[0] = shape->bounds[0]; }
+      if (shape->bounds[1] < bounds[1]) { bounds[1] = shape->bounds[1]; }
+      if (shape->bounds[2] > bounds[2]) { bounds[2] = shape->bounds[2]; }
+      if (shape->bounds[3] > bounds[3]) { bounds[3] = shape->bounds[3]; }
+    }
+    AppendShape(shape, tolerance, triangulator, m_Meshes);
+  }
+  m_Origin << bounds[0], bounds[1];
+  m_Size << bounds[2] - bounds[0], bounds[3] - bounds[1];
+}
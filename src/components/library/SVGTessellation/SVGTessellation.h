@@ -0,0 +1,59 @@
+#pragma once
+
+#include "EigenTypes.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct NSVGimage;
+
+// The flattened and triangulated geometry of an SVG document -- everything SVGPrimitive needs in
+// order to build its GL geometry.  Computing it (parsing, Bezier flattening, and triangulating the
+// fills and strokes) is the expensive part of loading an SVG, and involves no GL calls, so the
+// result is kept in this plain form, which SVGTessellationCache can store and reload.
+class SVGTessellation {
+public:
+
+  // The values are stored in SVGTessellationCache files, so they must not be changed.  Either
+  // way, every three points form a triangle, so all meshes can be drawn (and batched) alike.
+  enum class MeshType : uint32_t {
+    FILL = 0,   // The interior of a shape.
+    STROKE = 1  // The outline of a shape's stroked paths, at the stroke width, with joins and caps.
+  };
+
+  struct Mesh {
+    MeshType type;
+    // RGBA, with the opacity of the shape already applied.
+    float color[4];
+    std::vector<EigenTypes::Vector2f> points;
+  };
+
+  // The maximum distance (in SVG units) between a Bezier curve and its flattened polyline.
+  static const float DEFAULT_TOLERANCE;
+
+  SVGTessellation ();
+
+  // Parses, flattens, and triangulates the given SVG document, replacing the current contents.
+  // Returns false (leaving this empty) if the document couldn't be parsed.
+  bool Tessellate (const std::string &svg, float tolerance = DEFAULT_TOLERANCE);
+  // Flattens and triangulates an already parsed document (see SVGDocument), which isn't modified,
+  // so the same image may be tessellated on several threads at once.
+  void Tessellate (const NSVGimage &image, float tolerance = DEFAULT_TOLERANCE);
+  void Clear ();
+
+  // The bounding box of all the shapes in the document.
+  const EigenTypes::Vector2f &Origin () const { return m_Origin; }
+  const EigenTypes::Vector2f &Size () const { return m_Size; }
+  void SetBounds (const EigenTypes::Vector2f &origin, const EigenTypes::Vector2f &size) { m_Origin = origin; m_Size = size; }
+
+  // In drawing order; the fill of each shape comes before its strokes.
+  const std::vector<Mesh> &Meshes () const { return m_Meshes; }
+  std::vector<Mesh> &Meshes () { return m_Meshes; }
+
+private:
+
+  EigenTypes::Vector2f m_Origin;
+  EigenTypes::Vector2f m_Size;
+  std::vector<Mesh> m_Meshes;
+};
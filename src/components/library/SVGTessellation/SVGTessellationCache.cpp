@@ -0,0 +1,381 @@
+#include "SVGTessellationCache.h"
+
+#include "MappedFile.h"
+#include "SVGDocument.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+
+#if _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <atomic>
+#include <fcntl.h>
+#include <io.h>
+#include <share.h>
+#include <sstream>
+#include <sys/stat.h>
+#include <thread>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char ENTRY_MAGIC[4] = { 'S', 'V', 'G', 'T' };
+
+// All fields are stored in native byte order; an entry written with the other byte order fails
+// the magic number check and is regenerated.  Followed by the contents_size bytes of the document.
+struct EntryHeader {
+  char magic[4];
+  uint32_t version;
+  uint64_t contents_hash;
+  uint64_t contents_size;
+  // The size of the whole entry, including this header.
+  uint64_t entry_size;
+  float tolerance;
+  uint32_t mesh_count;
+  float origin[2];
+  float size[2];
+};
+
+// Followed by point_count pairs of floats.
+struct MeshHeader {
+  uint32_t type;
+  uint32_t point_count;
+  float color[4];
+};
+
+uint32_t FloatBits(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+#if _WIN32
+
+bool MakeDirectory(const std::string &path) {
+  return CreateDirectoryA(path.c_str(), nullptr) || GetLastError() == ERROR_ALREADY_EXISTS;
+}
+
+// Writes the bytes to a new file next to path, which is then renamed into place.
+bool WriteEntry(const std::string &path, const std::string &bytes) {
+  // The temporary file is created exclusively, so that nothing which already exists under its
+  // name (such as another writer's file) is opened and overwritten; another name is tried instead.
+  static std::atomic<unsigned int> s_temp_counter(0);
+  std::string temp_path;
+  int fd = -1;
+  for (int attempt = 0; attempt < 100 && fd < 0; attempt++) {
+    std::ostringstream name;
+    name << path << '.' << std::hash<std::thread::id>()(std::this_thread::get_id()) << '.' << s_temp_counter++ << ".tmp";
+    temp_path = name.str();
+    const errno_t error = _sopen_s(&fd, temp_path.c_str(), _O_CREAT | _O_EXCL | _O_WRONLY | _O_BINARY, _SH_DENYRW, _S_IREAD | _S_IWRITE);
+    if (error != 0 && error != EEXIST) {
+      return false;
+    }
+  }
+  if (fd < 0) {
+    return false;
+  }
+  const bool written = _write(fd, bytes.data(), static_cast<unsigned int>(bytes.size())) == static_cast<int>(bytes.size());
+  if (_close(fd) != 0 || !written) {
+    std::remove(temp_path.c_str());
+    return false;
+  }
+  if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+    // Rename doesn't replace an existing (stale) entry, so remove it and try again.
+    std::remove(path.c_str());
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+      std::remove(temp_path.c_str());
+      return false;
+    }
+  }
+  return true;
+}
+
+#else
+
+// Creates the directory, accessible only by the user, unless it exists already.
+bool MakeDirectory(const std::string &path) {
+  return mkdir(path.c_str(), S_IRWXU) == 0 || errno == EEXIST;
+}
+
+// Writes the bytes to a new file next to path, which is then renamed into place.
+bool WriteEntry(const std::string &path, const std::string &bytes) {
+  // mkstemp picks an unpredictable name and creates the file exclusively (so it never follows a
+  // symlink, or opens a file, which is already there), readable only by the user.
+  std::string temp_path = path + ".XXXXXX";
+  const int fd = mkstemp(&temp_path[0]);
+  if (fd < 0) {
+    return false;
+  }
+  size_t written = 0;
+  while (written < bytes.size()) {
+    const ssize_t count = write(fd, bytes.data() + written, bytes.size() - written);
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count <= 0) {
+      break;
+    }
+    written += static_cast<size_t>(count);
+  }
+  if (close(fd) != 0 || written != bytes.size() || std::rename(temp_path.c_str(), path.c_str()) != 0) {
+    unlink(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+#endif
+
+template <typename T>
+void Append(std::string &bytes, const T &value) {
+  bytes.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+} // end of anonymous namespace
+
+const uint32_t SVGTessellationCache::FORMAT_VERSION = 5;
+
+SVGTessellationCache::SVGTessellationCache () : m_directory(DefaultDirectory()) { }
+
+SVGTessellationCache::SVGTessellationCache (const std::string &directory) {
+  SetDirectory(directory);
+}
+
+SVGTessellationCache &SVGTessellationCache::Shared () {
+  static SVGTessellationCache s_cache;
+  return s_cache;
+}
+
+std::string SVGTessellationCache::DefaultDirectory () {
+#if _WIN32
+  const char *local_app_data = std::getenv("LOCALAPPDATA");
+  if (local_app_data == nullptr || *local_app_data == '\0') {
+    return std::string();
+  }
+  // The user's profile is already accessible only by the user.
+  const std::string directory = std::string(local_app_data) + "\\SVGTessellation";
+  return MakeDirectory(directory) ? directory : std::string();
+#else
+  // Relative paths in XDG_CACHE_HOME are invalid, and ignored.
+  std::string cache_home;
+  const char *xdg_cache_home = std::getenv("XDG_CACHE_HOME");
+  const char *home = std::getenv("HOME");
+  if (xdg_cache_home != nullptr && xdg_cache_home[0] == '/') {
+    cache_home = xdg_cache_home;
+  } else if (home != nullptr && *home != '\0') {
+    cache_home = std::string(home) + "/.cache";
+  } else {
+    return std::string();
+  }
+  const std::string directory = cache_home + "/SVGTessellation";
+  if (!MakeDirectory(cache_home) || !MakeDirectory(directory)) {
+    return std::string();
+  }
+  // The directory may have existed already, so make sure it's really the user's own.
+  struct stat status;
+  if (lstat(directory.c_str(), &status) != 0 || !S_ISDIR(status.st_mode) || status.st_uid != geteuid()) {
+    return std::string();
+  }
+  if ((status.st_mode & (S_IRWXG | S_IRWXO)) != 0 && chmod(directory.c_str(), S_IRWXU) != 0) {
+    return std::string();
+  }
+  return directory;
+#endif
+}
+
+void SVGTessellationCache::SetDirectory (const std::string &directory) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_directory = directory;
+  // Strip any trailing separator, since EntryPath adds one.
+  while (m_directory.size() > 1 && (m_directory.back() == '/' || m_directory.back() == '\\')) {
+    m_directory.pop_back();
+  }
+}
+
+std::string SVGTessellationCache::Directory () const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_directory;
+}
+
+uint64_t SVGTessellationCache::HashContents (const std::string &contents) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (const char c : contents) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+SVGTessellationCache::Stats SVGTessellationCache::GetStats () const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stats;
+}
+
+void SVGTessellationCache::ResetStats () {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_stats = Stats();
+}
+
+std::shared_ptr<const SVGTessellation> SVGTessellationCache::Get (const std::string &svg, float tolerance) {
+  return Get(HashContents(svg), svg, tolerance, [&svg, tolerance](SVGTessellation &tessellation) {
+    return tessellation.Tessellate(svg, tolerance);
+  });
+}
+
+std::shared_ptr<const SVGTessellation> SVGTessellationCache::Get (const SVGDocument &document, float tolerance) {
+  return Get(document.Hash(), document.Contents(), tolerance, [&document, tolerance](SVGTessellation &tessellation) {
+    return document.Tessellate(tolerance, tessellation);
+  });
+}
+
+std::shared_ptr<const SVGTessellation> SVGTessellationCache::Get (uint64_t hash, const std::string &contents, float tolerance, const std::function<bool(SVGTessellation &)> &tessellate) {
+  const std::string directory = Directory();
+  const std::string path = directory.empty() ? std::string() : EntryPath(directory, hash, tolerance);
+
+  std::shared_ptr<SVGTessellation> tessellation(std::make_shared<SVGTessellation>());
+  bool rejected = false;
+  if (!path.empty() && Load(path, hash, contents, tolerance, *tessellation, rejected)) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_stats.hits;
+    return tessellation;
+  }
+
+  tessellation->Clear();
+  const bool parsed = tessellate(*tessellation);
+  const bool stored = !parsed || path.empty() || Store(path, hash, contents, tolerance, *tessellation);
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_stats.misses;
+    if (rejected) {
+      ++m_stats.rejected;
+    }
+    if (!stored) {
+      ++m_stats.write_failures;
+    }
+  }
+  return parsed ? tessellation : nullptr;
+}
+
+std::string SVGTessellationCache::EntryPath (const std::string &svg, float tolerance) const {
+  const std::string directory = Directory();
+  return directory.empty() ? std::string() : EntryPath(directory, HashContents(svg), tolerance);
+}
+
+std::string SVGTessellationCache::EntryPath (const std::string &directory, uint64_t hash, float tolerance) const {
+  char name[64];
+  std::snprintf(name, sizeof(name), "svgtess-%016llx-%08x.bin", static_cast<unsigned long long>(hash), static_cast<unsigned int>(FloatBits(tolerance)));
+#if _WIN32
+  return directory + '\\' + name;
+#else
+  return directory + '/' + name;
+#endif
+}
+
+bool SVGTessellationCache::Load (const std::string &path, uint64_t hash, const std::string &contents, float tolerance, SVGTessellation &tessellation, bool &rejected) const {
+  MappedFile file;
+  if (!file.TryOpen(path)) {
+    return false; // There is no entry yet.
+  }
+  // From here on, the entry exists, so any mismatch means it is stale or corrupt.
+  rejected = true;
+  const uint8_t *data = file.Data();
+  const size_t size = file.Size();
+
+  EntryHeader header;
+  if (size < sizeof(header)) {
+    return false;
+  }
+  std::memcpy(&header, data, sizeof(header));
+  if (std::memcmp(header.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC)) != 0 ||
+      header.version != FORMAT_VERSION ||
+      header.contents_hash != hash ||
+      header.contents_size != static_cast<uint64_t>(contents.size()) ||
+      FloatBits(header.tolerance) != FloatBits(tolerance) ||
+      header.entry_size != static_cast<uint64_t>(size) ||
+      size - sizeof(header) < contents.size()) {
+    return false;
+  }
+  // The hash only names the entry; it's the contents which identify the document.
+  if (!contents.empty() && std::memcmp(data + sizeof(header), contents.data(), contents.size()) != 0) {
+    return false;
+  }
+
+  tessellation.SetBounds(EigenTypes::Vector2f(header.origin[0], header.origin[1]), EigenTypes::Vector2f(header.size[0], header.size[1]));
+  std::vector<SVGTessellation::Mesh> &meshes = tessellation.Meshes();
+  meshes.resize(header.mesh_count);
+  size_t offset = sizeof(header) + contents.size();
+  for (SVGTessellation::Mesh &mesh : meshes) {
+    MeshHeader mesh_header;
+    if (size - offset < sizeof(mesh_header)) {
+      return false;
+    }
+    std::memcpy(&mesh_header, data + offset, sizeof(mesh_header));
+    offset += sizeof(mesh_header);
+    const size_t points_size = static_cast<size_t>(mesh_header.point_count)*2*sizeof(float);
+    if (mesh_header.type > static_cast<uint32_t>(SVGTessellation::MeshType::STROKE) || mesh_header.point_count % 3 != 0 || size - offset < points_size) {
+      return false;
+    }
+    mesh.type = static_cast<SVGTessellation::MeshType>(mesh_header.type);
+    std::memcpy(mesh.color, mesh_header.color, sizeof(mesh.color));
+    mesh.points.resize(mesh_header.point_count);
+    // Vector2f is a pair of tightly packed floats, so the points can be copied in one go, as the
+    // columns of a 2xN matrix.
+    static_assert(sizeof(EigenTypes::Vector2f) == 2*sizeof(float), "Vector2f must be two packed floats");
+    if (points_size > 0) {
+      typedef Eigen::Matrix<float,2,Eigen::Dynamic> Points;
+      Eigen::Map<Points> points(mesh.points.front().data(), 2, mesh_header.point_count);
+      points = Eigen::Map<const Points>(reinterpret_cast<const float *>(data + offset), 2, mesh_header.point_count);
+    }
+    offset += points_size;
+  }
+  if (offset != size) {
+    return false;
+  }
+  rejected = false;
+  return true;
+}
+
+bool SVGTessellationCache::Store (const std::string &path, uint64_t hash, const std::string &contents, float tolerance, const SVGTessellation &tessellation) const {
+  const std::vector<SVGTessellation::Mesh> &meshes = tessellation.Meshes();
+  EntryHeader header;
+  std::memcpy(header.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC));
+  header.version = FORMAT_VERSION;
+  header.contents_hash = hash;
+  header.contents_size = static_cast<uint64_t>(contents.size());
+  header.entry_size = sizeof(header) + contents.size();
+  for (const SVGTessellation::Mesh &mesh : meshes) {
+    header.entry_size += sizeof(MeshHeader) + mesh.points.size()*2*sizeof(float);
+  }
+  header.tolerance = tolerance;
+  header.mesh_count = static_cast<uint32_t>(meshes.size());
+  header.origin[0] = tessellation.Origin().x();
+  header.origin[1] = tessellation.Origin().y();
+  header.size[0] = tessellation.Size().x();
+  header.size[1] = tessellation.Size().y();
+
+  std::string bytes;
+  bytes.reserve(static_cast<size_t>(header.entry_size));
+  Append(bytes, header);
+  bytes += contents;
+  for (const SVGTessellation::Mesh &mesh : meshes) {
+    MeshHeader mesh_header;
+    mesh_header.type = static_cast<uint32_t>(mesh.type);
+    mesh_header.point_count = static_cast<uint32_t>(mesh.points.size());
+    std::memcpy(mesh_header.color, mesh.color, sizeof(mesh_header.color));
+    Append(bytes, mesh_header);
+    if (!mesh.points.empty()) {
+      bytes.append(reinterpret_cast<const char *>(mesh.points.data()), mesh.points.size()*sizeof(EigenTypes::Vector2f));
+    }
+  }
+  // Readers only ever see complete entries.
+  return WriteEntry(path, bytes);
+}
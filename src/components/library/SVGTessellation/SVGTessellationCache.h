@@ -0,0 +1,87 @@
+#pragma once
+
+#include "SVGTessellation.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+class SVGDocument;
+
+// A persistent, on-disk cache of SVGTessellations, so that SVG documents which were tessellated
+// during an earlier run (e.g. the cursor and menu icons) are loaded without parsing, flattening,
+// or triangulating anything.
+//
+// Each entry is a binary file named after a 64-bit hash of the SVG document's contents and the
+// flattening tolerance.  Its header records the format version, the hash, the length of the
+// contents and the tolerance, and is followed by the contents themselves, so an entry is only
+// used for exactly the document it was made from.  Entries which don't match all of them (or
+// whose size doesn't match their header) are rejected as stale and regenerated.  Entries are
+// memory-mapped and read directly into the tessellation, and are written to a newly created
+// temporary file which is then renamed into place, so that a partially written entry is never
+// read.
+//
+// Get may be called from any thread.
+class SVGTessellationCache {
+public:
+
+  // Must be incremented whenever the file format, or the way tessellations are computed, changes.
+  static const uint32_t FORMAT_VERSION;
+
+  struct Stats {
+    Stats () : hits(0), misses(0), rejected(0), write_failures(0) { }
+    uint64_t hits;
+    uint64_t misses;
+    // Entries which existed but were stale or malformed (these are also counted as misses).
+    uint64_t rejected;
+    uint64_t write_failures;
+  };
+
+  // Uses DefaultDirectory().
+  SVGTessellationCache ();
+  explicit SVGTessellationCache (const std::string &directory);
+
+  // The cache used by SVGDocument (and so by SVGPrimitive).
+  static SVGTessellationCache &Shared ();
+
+  // The user's own cache directory: SVGTessellation in XDG_CACHE_HOME (or ~/.cache), or in
+  // LOCALAPPDATA on Windows.  It is created if necessary, accessible only by the user, and
+  // returned only if it's a directory which the user owns (rather than, say, a symlink which
+  // someone else planted).  Otherwise it is an empty string, which disables the cache.
+  static std::string DefaultDirectory ();
+
+  // Entries are read from and written to this directory, which must already exist.  If it is
+  // empty, the cache is disabled and Get always tessellates.
+  void SetDirectory (const std::string &directory);
+  std::string Directory () const;
+
+  // Returns the tessellation of the given SVG document, loading it from the cache if a valid
+  // entry exists, and otherwise tessellating it and storing the result.  Returns nullptr if the
+  // document couldn't be parsed.
+  std::shared_ptr<const SVGTessellation> Get (const std::string &svg, float tolerance = SVGTessellation::DEFAULT_TOLERANCE);
+  // The same, except that a document which must be tessellated uses the document's (shared) parse.
+  std::shared_ptr<const SVGTessellation> Get (const SVGDocument &document, float tolerance = SVGTessellation::DEFAULT_TOLERANCE);
+
+  // The 64-bit FNV-1a hash of the given bytes, which identifies cache entries.
+  static uint64_t HashContents (const std::string &contents);
+  // The path of the entry for the given SVG document and tolerance, whether or not it exists, or
+  // an empty string if the cache is disabled.
+  std::string EntryPath (const std::string &svg, float tolerance = SVGTessellation::DEFAULT_TOLERANCE) const;
+
+  Stats GetStats () const;
+  void ResetStats ();
+
+private:
+
+  std::shared_ptr<const SVGTessellation> Get (uint64_t hash, const std::string &contents, float tolerance, const std::function<bool(SVGTessellation &)> &tessellate);
+  std::string EntryPath (const std::string &directory, uint64_t hash, float tolerance) const;
+  // Returns false if the entry doesn't exist or doesn't match the given parameters.
+  bool Load (const std::string &path, uint64_t hash, const std::string &contents, float tolerance, SVGTessellation &tessellation, bool &rejected) const;
+  bool Store (const std::string &path, uint64_t hash, const std::string &contents, float tolerance, const SVGTessellation &tessellation) const;
+
+  mutable std::mutex m_mutex;
+  std::string m_directory;
+  Stats m_stats;
+};
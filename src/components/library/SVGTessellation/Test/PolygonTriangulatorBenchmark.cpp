@@ -0,0 +1,254 @@
+#include "PolygonTriangulator.h"
+
+// The implementation is compiled into SVGTessellation.cpp.
+#include <nanosvg.h>
+#include <polypartition.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <list>
+#include <string>
+#include <vector>
+
+// These tests report timings for triangulating the fills of the shipped icons and of large
+// synthetic polygons, comparing PolygonTriangulator against polypartition's ear clipping (which
+// SVGTessellation used to use, treating every path of a shape but the last as a hole, and which
+// is reported if it covers the wrong area).  They only fail if PolygonTriangulator's triangles
+// don't cover the area enclosed by the contours.
+
+class PolygonTriangulatorBenchmark : public testing::Test {
+protected:
+
+  typedef std::vector<EigenTypes::Vector2f> Contour;
+  // The last contour is the outline and the others are holes, as the ear clipping expects.
+  typedef std::vector<Contour> Polygon;
+
+  typedef std::chrono::high_resolution_clock Clock;
+  static double MillisecondsSince (const Clock::time_point &start) {
+    return std::chrono::duration<double,std::milli>(Clock::now() - start).count();
+  }
+
+  static double ContourArea (const Contour &contour) {
+    double area = 0.0;
+    for (size_t i = 0; i < contour.size(); ++i) {
+      const EigenTypes::Vector2f &a = contour[i];
+      const EigenTypes::Vector2f &b = contour[(i + 1) % contour.size()];
+      area += 0.5*(double(a.x())*b.y() - double(b.x())*a.y());
+    }
+    return std::abs(area);
+  }
+  static bool ContourContains (const Contour &contour, const EigenTypes::Vector2f &point) {
+    bool inside = false;
+    for (size_t i = 0, j = contour.size() - 1; i < contour.size(); j = i++) {
+      const EigenTypes::Vector2f &a = contour[i];
+      const EigenTypes::Vector2f &b = contour[j];
+      if ((a.y() > point.y()) != (b.y() > point.y()) &&
+          point.x() < (b.x() - a.x())*(point.y() - a.y())/(b.y() - a.y()) + a.x()) {
+        inside = !inside;
+      }
+    }
+    return inside;
+  }
+  // The area filled under the even-odd rule, given that the contours don't intersect: each
+  // contour adds its area if it's nested in an even number of others, and subtracts it otherwise.
+  static double EvenOddArea (const Polygon &polygon) {
+    double area = 0.0;
+    for (size_t c = 0; c < polygon.size(); ++c) {
+      size_t depth = 0;
+      for (size_t other = 0; other < polygon.size(); ++other) {
+        if (other != c && ContourContains(polygon[other], polygon[c][0])) {
+          ++depth;
+        }
+      }
+      area += (depth % 2 == 0 ? 1.0 : -1.0)*ContourArea(polygon[c]);
+    }
+    return area;
+  }
+  static double TriangleArea (const EigenTypes::Vector2f &a, const EigenTypes::Vector2f &b, const EigenTypes::Vector2f &c) {
+    return 0.5*std::abs((double(b.x()) - a.x())*(double(c.y()) - a.y()) - (double(b.y()) - a.y())*(double(c.x()) - a.x()));
+  }
+
+  // Returns the triangulated area, or -1 if the triangulation failed.
+  static double TriangulateWithSweep (const Polygon &polygon, size_t repetitions, double &milliseconds) {
+    PolygonTriangulator triangulator;
+    std::vector<uint32_t> indices;
+    bool succeeded = true;
+    Clock::time_point start = Clock::now();
+    for (size_t r = 0; r < repetitions; ++r) {
+      triangulator.Clear();
+      indices.clear();
+      for (const Contour &contour : polygon) {
+        triangulator.AddContour(contour.data(), contour.size());
+      }
+      succeeded = triangulator.Triangulate(PolygonTriangulator::FillRule::EVEN_ODD, indices) && succeeded;
+    }
+    milliseconds = MillisecondsSince(start);
+    double area = 0.0;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+      area += TriangleArea(triangulator.Points()[indices[i]], triangulator.Points()[indices[i + 1]], triangulator.Points()[indices[i + 2]]);
+    }
+    return succeeded ? area : -1.0;
+  }
+  static double TriangulateWithEarClipping (const Polygon &polygon, size_t repetitions, double &milliseconds) {
+    std::list<TPPLPoly> triangles;
+    bool succeeded = true;
+    Clock::time_point start = Clock::now();
+    for (size_t r = 0; r < repetitions; ++r) {
+      std::list<TPPLPoly> polys;
+      for (size_t c = 0; c < polygon.size(); ++c) {
+        TPPLPoly poly;
+        poly.Init(static_cast<long>(polygon[c].size()));
+        for (size_t i = 0; i < polygon[c].size(); ++i) {
+          poly[static_cast<int>(i)].x = polygon[c][i].x();
+          poly[static_cast<int>(i)].y = polygon[c][i].y();
+        }
+        const bool is_hole = c + 1 < polygon.size();
+        poly.SetHole(is_hole);
+        poly.SetOrientation(is_hole ? TPPL_CW : TPPL_CCW);
+        polys.push_back(poly);
+      }
+      triangles.clear();
+      TPPLPartition partition;
+      succeeded = partition.Triangulate_EC(&polys, &triangles) != 0 && succeeded;
+    }
+    milliseconds = MillisecondsSince(start);
+    double area = 0.0;
+    for (TPPLPoly &triangle : triangles) {
+      area += TriangleArea(EigenTypes::Vector2f(float(triangle[0].x), float(triangle[0].y)),
+                           EigenTypes::Vector2f(float(triangle[1].x), float(triangle[1].y)),
+                           EigenTypes::Vector2f(float(triangle[2].x), float(triangle[2].y)));
+    }
+    return succeeded ? area : -1.0;
+  }
+
+  // Flattens each path of an icon's filled shapes into a contour, with a fixed number of
+  // segments per Bezier curve.
+  static std::vector<Polygon> LoadIconFills (const std::string &path) {
+    std::vector<Polygon> fills;
+    NSVGimage *image = nsvgParseFromFile(path.c_str(), "px", 96.0f);
+    if (!image) {
+      return fills;
+    }
+    const int segments_per_curve = 8;
+    for (NSVGshape *shape = image->shapes; shape; shape = shape->next) {
+      if (shape->fill.type != NSVG_PAINT_COLOR) {
+        continue;
+      }
+      Polygon polygon;
+      for (NSVGpath *svg_path = shape->paths; svg_path; svg_path = svg_path->next) {
+        Contour contour;
+        for (int i = 0; i + 3 < svg_path->npts; i += 3) {
+          const float *p = &svg_path->pts[2*i];
+          for (int s = 0; s < segments_per_curve; ++s) {
+            const float t = float(s)/segments_per_curve;
+            const float u = 1.0f - t;
+            const float w[] = { u*u*u, 3*u*u*t, 3*u*t*t, t*t*t };
+            const EigenTypes::Vector2f point(w[0]*p[0] + w[1]*p[2] + w[2]*p[4] + w[3]*p[6],
+                                             w[0]*p[1] + w[1]*p[3] + w[2]*p[5] + w[3]*p[7]);
+            // Like SVGTessellation, skip the points of zero-length curves (which differ by rounding).
+            if (contour.empty() || (point - contour.back()).cwiseAbs().maxCoeff() >= FLT_EPSILON) {
+              contour.push_back(point);
+            }
+          }
+        }
+        if (contour.size() >= 3) {
+          polygon.push_back(contour);
+        }
+      }
+      if (!polygon.empty()) {
+        fills.push_back(polygon);
+      }
+    }
+    nsvgDelete(image);
+    return fills;
+  }
+
+  // A star with the given number of points, whose vertices alternate between two radii.
+  static Contour Star (size_t points, float inner_radius, float outer_radius, float x = 0, float y = 0) {
+    Contour star;
+    for (size_t i = 0; i < 2*points; ++i) {
+      const double angle = M_PI*i/points;
+      const float radius = i % 2 == 0 ? outer_radius : inner_radius;
+      star.emplace_back(x + radius*float(std::cos(angle)), y + radius*float(std::sin(angle)));
+    }
+    return star;
+  }
+
+  static void Compare (const std::string &description, const Polygon &polygon, size_t repetitions) {
+    // Ear clipping takes quadratic time, so it's left out for the largest polygons.
+    const size_t MAX_EAR_CLIPPING_VERTICES = 5000;
+    size_t vertex_count = 0;
+    for (const Contour &contour : polygon) {
+      vertex_count += contour.size();
+    }
+    const double expected_area = EvenOddArea(polygon);
+    double sweep_ms = 0.0;
+    const double sweep_area = TriangulateWithSweep(polygon, repetitions, sweep_ms);
+    // A fill of no area (such as a line traced there and back) may fail to triangulate, which loses nothing.
+    if (sweep_area >= 0.0 || expected_area > 1e-3) {
+      EXPECT_NEAR(expected_area, sweep_area, 1e-4*expected_area) << description;
+    }
+    std::cout << description << " (" << vertex_count << " vertices, " << polygon.size() << " contours, "
+              << repetitions << " repetitions): sweep " << sweep_ms << " ms";
+    if (sweep_area < 0.0) {
+      std::cout << " (failed)";
+    }
+    if (vertex_count <= MAX_EAR_CLIPPING_VERTICES) {
+      double ear_clipping_ms = 0.0;
+      const double ear_clipping_area = TriangulateWithEarClipping(polygon, repetitions, ear_clipping_ms);
+      std::cout << ", ear clipping " << ear_clipping_ms << " ms";
+      if (ear_clipping_area < 0.0) {
+        std::cout << " (failed)";
+      } else if (std::abs(ear_clipping_area - expected_area) > 1e-4*expected_area) {
+        std::cout << " (covered " << ear_clipping_area << " of " << expected_area << ")";
+      }
+    }
+    std::cout << '\n';
+  }
+};
+
+TEST_F(PolygonTriangulatorBenchmark, Icons) {
+  const char *icons[] = {
+    "disabled-cursor.svg", "expose-icon-01.svg", "minus-icon.svg", "next-track-icon-extended-01.svg",
+    "play_pause-icon-extended-01.svg", "plus-icon.svg", "prev-track-icon-extended-01.svg", "scroll-cursor-body.svg",
+    "scroll-cursor-finger_left.svg", "scroll-cursor-finger_right.svg", "scroll-cursor-ghost.svg",
+    "scroll-cursor-line.svg", "volume-icon-01.svg", "volume-notch-active.svg", "volume-notch-inactive.svg"
+  };
+  for (const char *icon : icons) {
+    const std::vector<Polygon> fills(LoadIconFills(std::string(SVG_ICON_DIRECTORY) + "/" + icon));
+    for (size_t i = 0; i < fills.size(); ++i) {
+      Compare(std::string(icon) + " fill " + std::to_string(i), fills[i], 100);
+    }
+  }
+}
+
+TEST_F(PolygonTriangulatorBenchmark, LargeStars) {
+  for (size_t points : { 100, 1000, 2500, 50000 }) {
+    Compare("star", Polygon(1, Star(points, 50.0f, 100.0f)), 1);
+  }
+}
+
+TEST_F(PolygonTriangulatorBenchmark, GridOfHoles) {
+  for (size_t cells : { 4, 16, 64 }) {
+    Polygon polygon;
+    for (size_t row = 0; row < cells; ++row) {
+      for (size_t column = 0; column < cells; ++column) {
+        Contour hole(Star(8, 0.2f, 0.4f, column + 0.5f, row + 0.5f));
+        std::reverse(hole.begin(), hole.end());
+        polygon.push_back(hole);
+      }
+    }
+    const float size = static_cast<float>(cells);
+    Contour outline;
+    outline.emplace_back(0.0f, 0.0f);
+    outline.emplace_back(size, 0.0f);
+    outline.emplace_back(size, size);
+    outline.emplace_back(0.0f, size);
+    polygon.push_back(outline);
+    Compare("grid of holes", polygon, 1);
+  }
+}
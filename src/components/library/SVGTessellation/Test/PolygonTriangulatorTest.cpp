@@ -0,0 +1,188 @@
+#include "PolygonTriangulator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <vector>
+
+class PolygonTriangulatorTest : public testing::Test {
+protected:
+
+  typedef PolygonTriangulator::FillRule FillRule;
+
+  // An axis-aligned square contour, counterclockwise unless clockwise is true.
+  static std::vector<EigenTypes::Vector2f> Square (float x, float y, float size, bool clockwise = false) {
+    std::vector<EigenTypes::Vector2f> points;
+    points.emplace_back(x, y);
+    points.emplace_back(x + size, y);
+    points.emplace_back(x + size, y + size);
+    points.emplace_back(x, y + size);
+    if (clockwise) {
+      std::reverse(points.begin(), points.end());
+    }
+    return points;
+  }
+  static void AddContour (PolygonTriangulator &triangulator, const std::vector<EigenTypes::Vector2f> &points) {
+    triangulator.AddContour(points.data(), points.size());
+  }
+  static double SignedArea (const EigenTypes::Vector2f &a, const EigenTypes::Vector2f &b, const EigenTypes::Vector2f &c) {
+    return 0.5*((double(b.x()) - a.x())*(double(c.y()) - a.y()) - (double(b.y()) - a.y())*(double(c.x()) - a.x()));
+  }
+  // Triangulates, checks that every triangle is counterclockwise, and returns the total area.
+  static double TriangulatedArea (PolygonTriangulator &triangulator, FillRule fill_rule) {
+    std::vector<uint32_t> indices;
+    EXPECT_TRUE(triangulator.Triangulate(fill_rule, indices));
+    EXPECT_EQ(0u, indices.size() % 3);
+    double area = 0.0;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+      EXPECT_LT(indices[i + 2], triangulator.Points().size());
+      const double triangle_area = SignedArea(triangulator.Points()[indices[i]],
+                                              triangulator.Points()[indices[i + 1]],
+                                              triangulator.Points()[indices[i + 2]]);
+      EXPECT_GE(triangle_area, 0.0);
+      area += triangle_area;
+    }
+    return area;
+  }
+};
+
+TEST_F(PolygonTriangulatorTest, Square) {
+  for (bool clockwise : { false, true }) {
+    PolygonTriangulator triangulator;
+    AddContour(triangulator, Square(0, 0, 1, clockwise));
+    std::vector<uint32_t> indices;
+    EXPECT_TRUE(triangulator.Triangulate(FillRule::NONZERO, indices));
+    EXPECT_EQ(6u, indices.size());
+    EXPECT_NEAR(1.0, TriangulatedArea(triangulator, FillRule::NONZERO), 1e-6);
+    EXPECT_NEAR(1.0, TriangulatedArea(triangulator, FillRule::EVEN_ODD), 1e-6);
+  }
+}
+
+TEST_F(PolygonTriangulatorTest, DegenerateContoursAreIgnored) {
+  PolygonTriangulator triangulator;
+  const EigenTypes::Vector2f segment[] = { EigenTypes::Vector2f(0, 0), EigenTypes::Vector2f(1, 0), EigenTypes::Vector2f(1, 0) };
+  triangulator.AddContour(segment, 3);
+  EXPECT_EQ(0u, triangulator.ContourCount());
+
+  // A closing point which repeats the first is dropped too.
+  std::vector<EigenTypes::Vector2f> square(Square(0, 0, 2));
+  square.push_back(square.front());
+  AddContour(triangulator, square);
+  EXPECT_EQ(1u, triangulator.ContourCount());
+  EXPECT_EQ(4u, triangulator.Points().size());
+  EXPECT_NEAR(4.0, TriangulatedArea(triangulator, FillRule::NONZERO), 1e-6);
+}
+
+TEST_F(PolygonTriangulatorTest, HoleWoundOppositeToOutline) {
+  PolygonTriangulator triangulator;
+  AddContour(triangulator, Square(1, 1, 2, true));
+  AddContour(triangulator, Square(0, 0, 4));
+  EXPECT_NEAR(12.0, TriangulatedArea(triangulator, FillRule::NONZERO), 1e-6);
+  EXPECT_NEAR(12.0, TriangulatedArea(triangulator, FillRule::EVEN_ODD), 1e-6);
+}
+
+TEST_F(PolygonTriangulatorTest, HoleWoundLikeOutline) {
+  // The inner square has a winding number of 2, so it's only a hole under the even-odd rule.
+  PolygonTriangulator triangulator;
+  AddContour(triangulator, Square(0, 0, 4, true));
+  AddContour(triangulator, Square(1, 1, 2, true));
+  EXPECT_NEAR(16.0, TriangulatedArea(triangulator, FillRule::NONZERO), 1e-6);
+  EXPECT_NEAR(12.0, TriangulatedArea(triangulator, FillRule::EVEN_ODD), 1e-6);
+}
+
+TEST_F(PolygonTriangulatorTest, NestedIsland) {
+  PolygonTriangulator triangulator;
+  AddContour(triangulator, Square(2, 2, 2));
+  AddContour(triangulator, Square(1, 1, 4, true));
+  AddContour(triangulator, Square(0, 0, 6));
+  EXPECT_NEAR(36.0 - 16.0 + 4.0, TriangulatedArea(triangulator, FillRule::NONZERO), 1e-6);
+  EXPECT_NEAR(36.0 - 16.0 + 4.0, TriangulatedArea(triangulator, FillRule::EVEN_ODD), 1e-6);
+}
+
+TEST_F(PolygonTriangulatorTest, SeparateOutlinesAndHoles) {
+  // A row of squares, each with a hole, all in one fill.
+  PolygonTriangulator triangulator;
+  for (int i = 0; i < 10; ++i) {
+    AddContour(triangulator, Square(4.0f*i, 0, 3, i % 2 == 0));
+    AddContour(triangulator, Square(4.0f*i + 1, 1, 1, i % 2 != 0));
+  }
+  EXPECT_NEAR(10*8.0, TriangulatedArea(triangulator, FillRule::NONZERO), 1e-6);
+  EXPECT_NEAR(10*8.0, TriangulatedArea(triangulator, FillRule::EVEN_ODD), 1e-6);
+}
+
+TEST_F(PolygonTriangulatorTest, ConcavePolygon) {
+  // A comb, whose teeth point up and down alternately, has many split and merge vertices.
+  std::vector<EigenTypes::Vector2f> comb;
+  const int teeth = 50;
+  for (int i = 0; i < teeth; ++i) {
+    comb.emplace_back(2.0f*i, 0.0f);
+    comb.emplace_back(2.0f*i + 1, i % 2 == 0 ? -10.0f : 0.5f);
+  }
+  comb.emplace_back(2.0f*teeth, 0.0f);
+  comb.emplace_back(2.0f*teeth, 2.0f);
+  for (int i = teeth; i > 0; --i) {
+    comb.emplace_back(2.0f*i, 2.0f);
+    comb.emplace_back(2.0f*i - 1, i % 2 == 0 ? 12.0f : 1.5f);
+  }
+  comb.emplace_back(0.0f, 2.0f);
+
+  double expected_area = 0.0;
+  for (size_t i = 0; i < comb.size(); ++i) {
+    const EigenTypes::Vector2f &a = comb[i];
+    const EigenTypes::Vector2f &b = comb[(i + 1) % comb.size()];
+    expected_area += 0.5*(double(a.x())*b.y() - double(b.x())*a.y());
+  }
+  PolygonTriangulator triangulator;
+  AddContour(triangulator, comb);
+  EXPECT_NEAR(std::abs(expected_area), TriangulatedArea(triangulator, FillRule::NONZERO), 1e-6*std::abs(expected_area));
+}
+
+TEST_F(PolygonTriangulatorTest, IsReusable) {
+  PolygonTriangulator triangulator;
+  AddContour(triangulator, Square(0, 0, 4));
+  AddContour(triangulator, Square(1, 1, 2, true));
+  EXPECT_NEAR(12.0, TriangulatedArea(triangulator, FillRule::NONZERO), 1e-6);
+  triangulator.Clear();
+  EXPECT_EQ(0u, triangulator.ContourCount());
+  EXPECT_TRUE(triangulator.Points().empty());
+  AddContour(triangulator, Square(0, 0, 3));
+  EXPECT_NEAR(9.0, TriangulatedArea(triangulator, FillRule::NONZERO), 1e-6);
+}
+
+TEST_F(PolygonTriangulatorTest, FailureAppendsNothing) {
+  // A bow tie intersects itself, which isn't supported; whatever happens, the indices already in
+  // the list must be kept, and on failure nothing may be appended.
+  PolygonTriangulator triangulator;
+  const EigenTypes::Vector2f bow_tie[] = {
+    EigenTypes::Vector2f(0, 0), EigenTypes::Vector2f(2, 2), EigenTypes::Vector2f(2, 0), EigenTypes::Vector2f(0, 2)
+  };
+  triangulator.AddContour(bow_tie, 4);
+  std::vector<uint32_t> indices(1, 7);
+  if (!triangulator.Triangulate(FillRule::NONZERO, indices)) {
+    EXPECT_EQ(1u, indices.size());
+  }
+  EXPECT_EQ(7u, indices[0]);
+  EXPECT_EQ(1u, indices.size() % 3);
+}
+
+TEST_F(PolygonTriangulatorTest, IntersectingContoursAreRejected) {
+  // Overlapping, crossing and touching contours, which the sweep can't triangulate; it reports
+  // them rather than producing a wrong fill.
+  const std::vector<std::vector<EigenTypes::Vector2f>> cases[] = {
+    { Square(0, 0, 6), Square(3, 3, 6) },
+    { Square(0, 0, 6), Square(3, 3, 6, true) },
+    { { { 4, 1 }, { 6, 1 }, { 6, 9 }, { 4, 9 } }, { { 1, 4 }, { 9, 4 }, { 9, 6 }, { 1, 6 } } },
+    { Square(0, 0, 6), Square(6, 2, 2) },
+  };
+  for (const auto& contours : cases) {
+    for (FillRule fill_rule : { FillRule::NONZERO, FillRule::EVEN_ODD }) {
+      PolygonTriangulator triangulator;
+      for (const auto& contour : contours) {
+        AddContour(triangulator, contour);
+      }
+      std::vector<uint32_t> indices;
+      EXPECT_FALSE(triangulator.Triangulate(fill_rule, indices));
+      EXPECT_TRUE(indices.empty());
+    }
+  }
+}
@@ -0,0 +1,121 @@
+#include "SVGDocument.h"
+#include "SVGTessellationCache.h"
+
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+class SVGDocumentTest : public testing::Test {
+protected:
+
+  // The tests use the shared cache (as SVGDocument does), but don't leave entries in it.
+  virtual void SetUp () override {
+    m_directory = SVGTessellationCache::Shared().Directory();
+    SVGTessellationCache::Shared().SetDirectory("");
+  }
+  virtual void TearDown () override {
+    SVGTessellationCache::Shared().SetDirectory(m_directory);
+  }
+
+  static std::string Square (int size) {
+    return "<svg xmlns='http://www.w3.org/2000/svg' width='100' height='100'><rect x='0' y='0' width='" +
+           std::to_string(size) + "' height='" + std::to_string(size) + "' fill='red'/></svg>";
+  }
+
+  std::string m_directory;
+};
+
+TEST_F(SVGDocumentTest, SameContentsShareADocument) {
+  const size_t initial_count = SVGDocument::LiveCount();
+  std::shared_ptr<const SVGDocument> a(SVGDocument::Get(Square(10)));
+  std::shared_ptr<const SVGDocument> b(SVGDocument::Get(Square(10)));
+  std::shared_ptr<const SVGDocument> c(SVGDocument::Get(Square(20)));
+  EXPECT_EQ(a, b);
+  EXPECT_NE(a, c);
+  EXPECT_EQ(Square(10), a->Contents());
+  EXPECT_EQ(SVGTessellationCache::HashContents(Square(10)), a->Hash());
+  EXPECT_EQ(initial_count + 2, SVGDocument::LiveCount());
+
+  // Once every reference is gone, the document is freed.
+  a.reset();
+  b.reset();
+  EXPECT_EQ(initial_count + 1, SVGDocument::LiveCount());
+  c.reset();
+  EXPECT_EQ(initial_count, SVGDocument::LiveCount());
+}
+
+TEST_F(SVGDocumentTest, ParsesOnce) {
+  std::shared_ptr<const SVGDocument> document(SVGDocument::Get(Square(30)));
+  EXPECT_FALSE(document->IsParsed());
+  const NSVGimage *image = document->Image();
+  ASSERT_NE(nullptr, image);
+  EXPECT_TRUE(document->IsParsed());
+  EXPECT_EQ(image, SVGDocument::Get(Square(30))->Image());
+}
+
+TEST_F(SVGDocumentTest, SharesTessellations) {
+  std::shared_ptr<const SVGDocument> document(SVGDocument::Get(Square(40)));
+  std::shared_ptr<const SVGTessellation> coarse(document->Tessellation(1.0f));
+  ASSERT_TRUE(coarse != nullptr);
+  EXPECT_EQ(coarse, SVGDocument::Get(Square(40))->Tessellation(1.0f));
+  EXPECT_NE(coarse, document->Tessellation(0.25f));
+
+  // The tessellation matches one computed from the source.
+  SVGTessellation expected;
+  ASSERT_TRUE(expected.Tessellate(Square(40), 1.0f));
+  ASSERT_EQ(expected.Meshes().size(), coarse->Meshes().size());
+  for (size_t i = 0; i < expected.Meshes().size(); ++i) {
+    EXPECT_EQ(expected.Meshes()[i].points, coarse->Meshes()[i].points);
+  }
+  EXPECT_EQ(expected.Size(), coarse->Size());
+}
+
+TEST_F(SVGDocumentTest, ConcurrentUsersShareTessellations) {
+  std::shared_ptr<const SVGDocument> document(SVGDocument::Get(Square(50)));
+  const int thread_count = 8;
+  std::vector<std::shared_ptr<const SVGTessellation>> results(thread_count);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < thread_count; ++i) {
+    threads.emplace_back([i, &results]() {
+      results[i] = SVGDocument::Get(Square(50))->Tessellation(0.5f);
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  ASSERT_TRUE(results[0] != nullptr);
+  for (int i = 1; i < thread_count; ++i) {
+    EXPECT_EQ(results[0], results[i]);
+  }
+  EXPECT_TRUE(document->IsParsed());
+}
+
+TEST_F(SVGDocumentTest, DocumentWithoutShapes) {
+  std::shared_ptr<const SVGDocument> document(SVGDocument::Get("<svg xmlns='http://www.w3.org/2000/svg' width='10' height='10'></svg>"));
+  std::shared_ptr<const SVGTessellation> tessellation(document->Tessellation(1.0f));
+  ASSERT_TRUE(tessellation != nullptr);
+  EXPECT_TRUE(tessellation->Meshes().empty());
+}
+
+TEST_F(SVGDocumentTest, CanvasSizeWithoutParsing) {
+  const std::string prefix("<?xml version='1.0'?><!-- <svgs> --><svg xmlns='http://www.w3.org/2000/svg' ");
+  const std::string suffix("><rect stroke-width='3' x='0' y='0' width='5' height='5'/></svg>");
+  EigenTypes::Vector2f size(EigenTypes::Vector2f::Zero());
+
+  std::shared_ptr<const SVGDocument> document(SVGDocument::Get(prefix + "width='64px' height = \"32\"" + suffix));
+  ASSERT_TRUE(document->CanvasSize(size));
+  EXPECT_EQ(EigenTypes::Vector2f(64.0f, 32.0f), size);
+  EXPECT_FALSE(document->IsParsed());
+
+  // A missing width or height comes from the viewBox, as it does when the document is parsed.
+  document = SVGDocument::Get(prefix + "viewBox='-5 -5,48 24' height='12'" + suffix);
+  ASSERT_TRUE(document->CanvasSize(size));
+  EXPECT_EQ(EigenTypes::Vector2f(48.0f, 12.0f), size);
+
+  // Other units aren't converted.
+  document = SVGDocument::Get(prefix + "width='100%' height='10mm'" + suffix);
+  size.setZero();
+  EXPECT_FALSE(document->CanvasSize(size));
+  EXPECT_EQ(EigenTypes::Vector2f::Zero(), size);
+  EXPECT_FALSE(SVGDocument::Get("not an svg document")->CanvasSize(size));
+}
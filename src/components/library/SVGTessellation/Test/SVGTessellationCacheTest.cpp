@@ -0,0 +1,223 @@
+#include "SVGTessellationCache.h"
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#if !_WIN32
+#include <cstdlib>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+class SVGTessellationCacheTest : public testing::Test {
+protected:
+
+  // Each test uses a document of its own, so entries left behind by an earlier run (or by another
+  // test) can't be hit by accident.
+  virtual void SetUp () override {
+    m_svg = "<svg xmlns='http://www.w3.org/2000/svg' width='100' height='100'><!-- " +
+            std::string(testing::UnitTest::GetInstance()->current_test_info()->name()) +
+            " --><rect x='10' y='20' width='30' height='40' fill='red'/><circle cx='70' cy='70' r='20' fill='blue'/></svg>";
+    m_paths.push_back(m_cache.EntryPath(m_svg));
+    std::remove(m_paths.back().c_str());
+  }
+  virtual void TearDown () override {
+    for (const std::string &path : m_paths) {
+      std::remove(path.c_str());
+    }
+  }
+
+  static std::string ReadFile (const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+  static void WriteFile (const std::string &path, const std::string &contents) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(contents.data(), contents.size());
+  }
+
+  static void ExpectSameTessellation (const SVGTessellation &expected, const SVGTessellation &actual) {
+    EXPECT_EQ(expected.Origin(), actual.Origin());
+    EXPECT_EQ(expected.Size(), actual.Size());
+    ASSERT_EQ(expected.Meshes().size(), actual.Meshes().size());
+    for (size_t i = 0; i < expected.Meshes().size(); i++) {
+      const SVGTessellation::Mesh &a = expected.Meshes()[i];
+      const SVGTessellation::Mesh &b = actual.Meshes()[i];
+      EXPECT_EQ(a.type, b.type);
+      for (int j = 0; j < 4; j++) {
+        EXPECT_EQ(a.color[j], b.color[j]);
+      }
+      EXPECT_EQ(a.points, b.points);
+    }
+  }
+
+  // Stores an entry for m_svg, and returns its path.
+  std::string StoreEntry () {
+    m_expected = m_cache.Get(m_svg);
+    EXPECT_TRUE(m_expected != nullptr);
+    EXPECT_EQ(1u, m_cache.GetStats().misses);
+    const std::string path = m_cache.EntryPath(m_svg);
+    EXPECT_FALSE(ReadFile(path).empty());
+    return path;
+  }
+
+  // Expects the entry for m_svg to be rejected and then regenerated by a new cache.
+  void ExpectRejectedAndRegenerated () {
+    SVGTessellationCache cache;
+    std::shared_ptr<const SVGTessellation> rejected(cache.Get(m_svg));
+    ASSERT_TRUE(rejected != nullptr);
+    ExpectSameTessellation(*m_expected, *rejected);
+    EXPECT_EQ(0u, cache.GetStats().hits);
+    EXPECT_EQ(1u, cache.GetStats().misses);
+    EXPECT_EQ(1u, cache.GetStats().rejected);
+    EXPECT_EQ(0u, cache.GetStats().write_failures);
+
+    std::shared_ptr<const SVGTessellation> regenerated(cache.Get(m_svg));
+    ASSERT_TRUE(regenerated != nullptr);
+    ExpectSameTessellation(*m_expected, *regenerated);
+    EXPECT_EQ(1u, cache.GetStats().hits);
+  }
+
+  SVGTessellationCache m_cache;
+  std::string m_svg;
+  std::vector<std::string> m_paths;
+  std::shared_ptr<const SVGTessellation> m_expected;
+};
+
+TEST_F(SVGTessellationCacheTest, RoundTrip) {
+  StoreEntry();
+  ASSERT_FALSE(m_expected->Meshes().empty());
+
+  // A different cache (as in a later run) loads the entry instead of tessellating.
+  SVGTessellationCache cache;
+  std::shared_ptr<const SVGTessellation> loaded(cache.Get(m_svg));
+  ASSERT_TRUE(loaded != nullptr);
+  EXPECT_NE(m_expected, loaded);
+  ExpectSameTessellation(*m_expected, *loaded);
+  EXPECT_EQ(1u, cache.GetStats().hits);
+  EXPECT_EQ(0u, cache.GetStats().misses);
+  EXPECT_EQ(0u, cache.GetStats().rejected);
+}
+
+TEST_F(SVGTessellationCacheTest, RejectsAnotherVersion) {
+  const std::string path = StoreEntry();
+  std::string entry = ReadFile(path);
+  // The version follows the four byte magic number.
+  ASSERT_GE(entry.size(), 8u);
+  const uint32_t version = SVGTessellationCache::FORMAT_VERSION + 1;
+  entry.replace(4, sizeof(version), reinterpret_cast<const char *>(&version), sizeof(version));
+  WriteFile(path, entry);
+
+  ExpectRejectedAndRegenerated();
+}
+
+TEST_F(SVGTessellationCacheTest, RejectsAnotherTolerance) {
+  const std::string path = StoreEntry();
+  // An entry for this document at the default tolerance, renamed as if it were for another.
+  const float tolerance = 2*SVGTessellation::DEFAULT_TOLERANCE;
+  m_paths.push_back(m_cache.EntryPath(m_svg, tolerance));
+  ASSERT_NE(path, m_paths.back());
+  WriteFile(m_paths.back(), ReadFile(path));
+
+  SVGTessellationCache cache;
+  std::shared_ptr<const SVGTessellation> tessellation(cache.Get(m_svg, tolerance));
+  ASSERT_TRUE(tessellation != nullptr);
+  EXPECT_EQ(0u, cache.GetStats().hits);
+  EXPECT_EQ(1u, cache.GetStats().rejected);
+  EXPECT_TRUE(cache.Get(m_svg, tolerance) != nullptr);
+  EXPECT_EQ(1u, cache.GetStats().hits);
+
+  // The default tolerance's entry is untouched.
+  EXPECT_TRUE(cache.Get(m_svg) != nullptr);
+  EXPECT_EQ(2u, cache.GetStats().hits);
+}
+
+TEST_F(SVGTessellationCacheTest, RejectsAnEntryForAnotherDocument) {
+  const std::string path = StoreEntry();
+  // Another document of the same length, whose entry is this one's, but with the other document's
+  // hash, as if the hashes collided or the entry had been planted.
+  std::string other(m_svg);
+  other.replace(other.find("fill='red'"), 10, "fill='tan'");
+  m_paths.push_back(m_cache.EntryPath(other));
+  std::string entry = ReadFile(path);
+  // The hash follows the version.
+  ASSERT_GE(entry.size(), 16u);
+  const uint64_t hash = SVGTessellationCache::HashContents(other);
+  entry.replace(8, sizeof(hash), reinterpret_cast<const char *>(&hash), sizeof(hash));
+  WriteFile(m_paths.back(), entry);
+
+  SVGTessellationCache cache;
+  std::shared_ptr<const SVGTessellation> tessellation(cache.Get(other));
+  ASSERT_TRUE(tessellation != nullptr);
+  EXPECT_EQ(0u, cache.GetStats().hits);
+  EXPECT_EQ(1u, cache.GetStats().rejected);
+  // The rectangle is tan, not the stored document's red.
+  ASSERT_FALSE(tessellation->Meshes().empty());
+  EXPECT_NE(m_expected->Meshes()[0].color[1], tessellation->Meshes()[0].color[1]);
+}
+
+TEST_F(SVGTessellationCacheTest, RejectsATruncatedEntry) {
+  const std::string path = StoreEntry();
+  const std::string entry = ReadFile(path);
+  WriteFile(path, entry.substr(0, entry.size()/2));
+  ExpectRejectedAndRegenerated();
+
+  // Shorter than the header.
+  WriteFile(path, entry.substr(0, 8));
+  ExpectRejectedAndRegenerated();
+
+  // And empty.
+  WriteFile(path, std::string());
+  ExpectRejectedAndRegenerated();
+}
+
+TEST_F(SVGTessellationCacheTest, DisabledCacheHasNoEntries) {
+  SVGTessellationCache cache("");
+  EXPECT_TRUE(cache.EntryPath(m_svg).empty());
+  EXPECT_TRUE(cache.Get(m_svg) != nullptr);
+  EXPECT_EQ(1u, cache.GetStats().misses);
+  EXPECT_EQ(0u, cache.GetStats().write_failures);
+}
+
+#if !_WIN32
+
+TEST_F(SVGTessellationCacheTest, DefaultDirectoryIsPrivate) {
+  const char *previous = std::getenv("XDG_CACHE_HOME");
+  const std::string previous_value(previous != nullptr ? previous : "");
+  char cache_home[] = "/tmp/SVGTessellationCacheTest.XXXXXX";
+  ASSERT_TRUE(mkdtemp(cache_home) != nullptr);
+  setenv("XDG_CACHE_HOME", cache_home, 1);
+  const std::string expected = std::string(cache_home) + "/SVGTessellation";
+
+  // Created accessible only by the user.
+  EXPECT_EQ(expected, SVGTessellationCache::DefaultDirectory());
+  struct stat status;
+  ASSERT_EQ(0, stat(expected.c_str(), &status));
+  EXPECT_EQ(static_cast<mode_t>(S_IRWXU), status.st_mode & 0777);
+
+  // An existing directory which others can use is made private.
+  ASSERT_EQ(0, chmod(expected.c_str(), 0777));
+  EXPECT_EQ(expected, SVGTessellationCache::DefaultDirectory());
+  ASSERT_EQ(0, stat(expected.c_str(), &status));
+  EXPECT_EQ(static_cast<mode_t>(S_IRWXU), status.st_mode & 0777);
+
+  // A symlink in its place isn't followed, which disables the cache.
+  ASSERT_EQ(0, rmdir(expected.c_str()));
+  ASSERT_EQ(0, symlink(cache_home, expected.c_str()));
+  EXPECT_EQ(std::string(), SVGTessellationCache::DefaultDirectory());
+
+  unlink(expected.c_str());
+  rmdir(cache_home);
+  if (previous != nullptr) {
+    setenv("XDG_CACHE_HOME", previous_value.c_str(), 1);
+  } else {
+    unsetenv("XDG_CACHE_HOME");
+  }
+}
+
+#endif
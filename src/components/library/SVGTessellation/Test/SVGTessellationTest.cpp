@@ -0,0 +1,354 @@
+#include "SVGTessellation.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace {
+
+typedef EigenTypes::Vector2f Point;
+
+Point EvaluateCubic(const Point b[4], float t) {
+  const float s = 1.0f - t;
+  return (s*s*s)*b[0] + (3.0f*s*s*t)*b[1] + (3.0f*s*t*t)*b[2] + (t*t*t)*b[3];
+}
+
+float DistanceToSegment(const Point& p, const Point& a, const Point& b) {
+  const Point ab = b - a;
+  const float t = std::min(1.0f, std::max(0.0f, (p - a).dot(ab)/ab.squaredNorm()));
+  return (p - (a + t*ab)).norm();
+}
+
+// The distinct points of a mesh, ordered by x.
+std::vector<Point> DistinctPointsByX(const SVGTessellation::Mesh& mesh) {
+  std::vector<Point> points(mesh.points);
+  std::sort(points.begin(), points.end(), [](const Point& a, const Point& b) {
+    return a.x() < b.x() || (a.x() == b.x() && a.y() < b.y());
+  });
+  points.erase(std::unique(points.begin(), points.end()), points.end());
+  return points;
+}
+
+} // end of anonymous namespace
+
+// A filled arch, whose boundary is a single cubic Bezier curve (along which x increases) closed by
+// a line along the x axis.  The fill's triangles have the flattened curve's points as vertices.
+class SVGTessellationFlatteningTest : public testing::TestWithParam<float> {
+protected:
+  SVGTessellationFlatteningTest() {
+    m_bezier[0] << 0.0f, 0.0f;
+    m_bezier[1] << 30.0f, 100.0f;
+    m_bezier[2] << 70.0f, 100.0f;
+    m_bezier[3] << 100.0f, 0.0f;
+  }
+
+  std::string Arch() const {
+    return "<svg xmlns='http://www.w3.org/2000/svg' width='100' height='100'><path d='M0 0 C30 100 70 100 100 0 Z' fill='red'/></svg>";
+  }
+
+  // The number of segments given by Wang's formula.
+  int WangSegmentCount(float tolerance) const {
+    const float d0 = (m_bezier[0] - 2.0f*m_bezier[1] + m_bezier[2]).norm();
+    const float d1 = (m_bezier[1] - 2.0f*m_bezier[2] + m_bezier[3]).norm();
+    return static_cast<int>(std::ceil(std::sqrt(0.75f*std::max(d0, d1)/tolerance)));
+  }
+
+  Point m_bezier[4];
+};
+
+TEST_P(SVGTessellationFlatteningTest, SegmentCountFollowsWangsFormula) {
+  const float tolerance = GetParam();
+  SVGTessellation tessellation;
+  ASSERT_TRUE(tessellation.Tessellate(Arch(), tolerance));
+  ASSERT_EQ(1u, tessellation.Meshes().size());
+  const std::vector<Point> points(DistinctPointsByX(tessellation.Meshes()[0]));
+  // The curve's n segments have n + 1 points (and the closing line adds none).
+  EXPECT_EQ(WangSegmentCount(tolerance) + 1, static_cast<int>(points.size()));
+}
+
+TEST_P(SVGTessellationFlatteningTest, FlattenedCurveStaysWithinTolerance) {
+  const float tolerance = GetParam();
+  SVGTessellation tessellation;
+  ASSERT_TRUE(tessellation.Tessellate(Arch(), tolerance));
+  ASSERT_EQ(1u, tessellation.Meshes().size());
+  const std::vector<Point> points(DistinctPointsByX(tessellation.Meshes()[0]));
+  ASSERT_GE(points.size(), 2u);
+
+  // Every point of the curve is within the tolerance of the polyline segment spanning its x, and
+  // every point of the polyline is on the curve (to rounding).
+  const int samples = 10000;
+  float maxDistance = 0.0f;
+  for (int i = 0; i <= samples; i++) {
+    const Point p(EvaluateCubic(m_bezier, static_cast<float>(i)/samples));
+    auto upper = std::upper_bound(points.begin(), points.end(), p.x(), [](float x, const Point& q) { return x < q.x(); });
+    upper = std::min(std::max(upper, points.begin() + 1), points.end() - 1);
+    maxDistance = std::max(maxDistance, DistanceToSegment(p, *(upper - 1), *upper));
+  }
+  EXPECT_LE(maxDistance, tolerance);
+  // Wang's formula is conservative, but not wildly so.
+  EXPECT_GT(maxDistance, tolerance/8.0f);
+
+  for (const Point& q : points) {
+    float closest = std::numeric_limits<float>::max();
+    for (int i = 0; i <= samples; i++) {
+      closest = std::min(closest, (EvaluateCubic(m_bezier, static_cast<float>(i)/samples) - q).norm());
+    }
+    EXPECT_LT(closest, 0.05f);
+  }
+}
+
+TEST_P(SVGTessellationFlatteningTest, FinerTolerancesUseMoreSegments) {
+  const float tolerance = GetParam();
+  SVGTessellation coarse, fine;
+  ASSERT_TRUE(coarse.Tessellate(Arch(), tolerance));
+  ASSERT_TRUE(fine.Tessellate(Arch(), tolerance/4.0f));
+  // Wang's formula goes as the inverse square root of the tolerance.
+  const size_t coarseCount = DistinctPointsByX(coarse.Meshes()[0]).size();
+  const size_t fineCount = DistinctPointsByX(fine.Meshes()[0]).size();
+  EXPECT_GE(fineCount, 2*coarseCount - 3);
+  EXPECT_LE(fineCount, 2*coarseCount + 1);
+}
+
+INSTANTIATE_TEST_CASE_P(Tolerances, SVGTessellationFlatteningTest, testing::Values(2.0f, 0.5f, 0.125f, 1.0f/32.0f));
+
+// Strokes 4 units wide, of paths made of straight lines (which are flattened to single segments),
+// so that the area and number of triangles of each join and cap can be worked out exactly.
+class SVGTessellationStrokeTest : public testing::Test {
+protected:
+  static constexpr float HALF_WIDTH = 2.0f;
+  static constexpr float TOLERANCE = 0.05f;
+
+  // Tessellates the stroke of the given path, accumulating the area and number of its triangles.
+  // The triangles overlap at the joins, and the overlaps are counted twice.
+  void Stroke(const std::string& path, const std::string& attributes = "") {
+    m_area = 0.0f;
+    m_vertexCount = 0;
+    SVGTessellation tessellation;
+    ASSERT_TRUE(tessellation.Tessellate("<svg xmlns='http://www.w3.org/2000/svg' width='100' height='100'><path d='" + path +
+                                        "' fill='none' stroke='black' stroke-width='4' " + attributes + "/></svg>", TOLERANCE));
+    for (const SVGTessellation::Mesh& mesh : tessellation.Meshes()) {
+      ASSERT_EQ(SVGTessellation::MeshType::STROKE, mesh.type);
+      ASSERT_EQ(0u, mesh.points.size() % 3);
+      for (size_t i = 0; i < mesh.points.size(); i += 3) {
+        const Point ab = mesh.points[i + 1] - mesh.points[i];
+        const Point ac = mesh.points[i + 2] - mesh.points[i];
+        const float doubleArea = ab.x()*ac.y() - ab.y()*ac.x();
+        // Every triangle is wound counterclockwise, and none is degenerate.
+        EXPECT_GT(doubleArea, 0.0f);
+        m_area += 0.5f*doubleArea;
+      }
+      m_vertexCount += mesh.points.size();
+    }
+  }
+
+  // The number of segments in a round join or cap sweeping through the given angle: the fewest
+  // whose chords stay within the tolerance of the arc.
+  static int ArcSegmentCount(float angle) {
+    return static_cast<int>(std::ceil(angle/(2.0f*std::acos(1.0f - TOLERANCE/HALF_WIDTH))));
+  }
+  // The area of the fan approximating such an arc.
+  static float ArcArea(float angle) {
+    const int segments = ArcSegmentCount(angle);
+    return segments*0.5f*HALF_WIDTH*HALF_WIDTH*std::sin(angle/segments);
+  }
+
+  float m_area;
+  size_t m_vertexCount;
+};
+
+constexpr float SVGTessellationStrokeTest::HALF_WIDTH;
+constexpr float SVGTessellationStrokeTest::TOLERANCE;
+
+namespace {
+
+// Two 40 unit segments with a right angle turn.
+const char* const RIGHT_ANGLE = "M10 10 L50 10 L50 50";
+const float RIGHT_ANGLE_QUADS_AREA = 2*40*4;
+const size_t QUAD_VERTEX_COUNT = 6;
+
+} // end of anonymous namespace
+
+TEST_F(SVGTessellationStrokeTest, Joins) {
+  // The miter fills in the square outside the corner.
+  Stroke(RIGHT_ANGLE, "stroke-linejoin='miter'");
+  EXPECT_NEAR(RIGHT_ANGLE_QUADS_AREA + HALF_WIDTH*HALF_WIDTH, m_area, 1e-3f);
+  EXPECT_EQ(2*QUAD_VERTEX_COUNT + 2*3, m_vertexCount);
+
+  // The bevel fills half of it.
+  Stroke(RIGHT_ANGLE, "stroke-linejoin='bevel'");
+  EXPECT_NEAR(RIGHT_ANGLE_QUADS_AREA + 0.5f*HALF_WIDTH*HALF_WIDTH, m_area, 1e-3f);
+  EXPECT_EQ(2*QUAD_VERTEX_COUNT + 3, m_vertexCount);
+
+  // The round join fills a quarter circle, to within the tolerance.
+  Stroke(RIGHT_ANGLE, "stroke-linejoin='round'");
+  const float quarter = static_cast<float>(M_PI_2);
+  EXPECT_NEAR(RIGHT_ANGLE_QUADS_AREA + ArcArea(quarter), m_area, 1e-3f);
+  EXPECT_LE(m_area - RIGHT_ANGLE_QUADS_AREA, 0.25f*static_cast<float>(M_PI)*HALF_WIDTH*HALF_WIDTH);
+  EXPECT_GE(m_area - RIGHT_ANGLE_QUADS_AREA, 0.25f*static_cast<float>(M_PI)*HALF_WIDTH*HALF_WIDTH - TOLERANCE*HALF_WIDTH*quarter);
+  EXPECT_GT(ArcSegmentCount(quarter), 1);
+  EXPECT_EQ(2*QUAD_VERTEX_COUNT + 3*ArcSegmentCount(quarter), m_vertexCount);
+}
+
+TEST_F(SVGTessellationStrokeTest, MiterLimit) {
+  // A sharp turn, where the angle between the segments is t = atan(4/40), so the miter is
+  // 1/sin(t/2) (about 20) times the stroke width.
+  const char* const sharp = "M10 10 L50 10 L10 14";
+  const float quadsArea = 40*4 + std::sqrt(40.0f*40.0f + 4.0f*4.0f)*4;
+  const float t = std::atan2(4.0f, 40.0f);
+  ASSERT_GT(1.0f/std::sin(0.5f*t), 16.0f);
+  ASSERT_LT(1.0f/std::sin(0.5f*t), 32.0f);
+  // The angle between the normals of the segments.
+  const float u = static_cast<float>(M_PI) - t;
+
+  Stroke(sharp, "stroke-linejoin='miter' stroke-miterlimit='32'");
+  EXPECT_NEAR(quadsArea + HALF_WIDTH*HALF_WIDTH*std::tan(0.5f*u), m_area, 1e-2f);
+  EXPECT_EQ(2*QUAD_VERTEX_COUNT + 2*3, m_vertexCount);
+
+  // Past the limit, the miter falls back to a bevel.
+  Stroke(sharp, "stroke-linejoin='miter' stroke-miterlimit='16'");
+  EXPECT_NEAR(quadsArea + 0.5f*HALF_WIDTH*HALF_WIDTH*std::sin(u), m_area, 1e-2f);
+  EXPECT_EQ(2*QUAD_VERTEX_COUNT + 3, m_vertexCount);
+  // As it does under the default limit of 4.
+  Stroke(sharp, "stroke-linejoin='miter'");
+  EXPECT_EQ(2*QUAD_VERTEX_COUNT + 3, m_vertexCount);
+}
+
+TEST_F(SVGTessellationStrokeTest, Caps) {
+  const char* const line = "M10 10 L50 10";
+  const float quadArea = 40*4;
+
+  Stroke(line, "stroke-linecap='butt'");
+  EXPECT_NEAR(quadArea, m_area, 1e-3f);
+  EXPECT_EQ(QUAD_VERTEX_COUNT, m_vertexCount);
+
+  // Each square cap extends the line by half the width.
+  Stroke(line, "stroke-linecap='square'");
+  EXPECT_NEAR(quadArea + 2*(2*HALF_WIDTH*HALF_WIDTH), m_area, 1e-3f);
+  EXPECT_EQ(QUAD_VERTEX_COUNT + 2*QUAD_VERTEX_COUNT, m_vertexCount);
+
+  // Each round cap is a semicircle, to within the tolerance.
+  const float half = static_cast<float>(M_PI);
+  Stroke(line, "stroke-linecap='round'");
+  EXPECT_NEAR(quadArea + 2*ArcArea(half), m_area, 1e-3f);
+  EXPECT_LE(m_area - quadArea, half*HALF_WIDTH*HALF_WIDTH);
+  EXPECT_GE(m_area - quadArea, half*HALF_WIDTH*HALF_WIDTH - 2*TOLERANCE*HALF_WIDTH*half);
+  EXPECT_EQ(QUAD_VERTEX_COUNT + 2*3*ArcSegmentCount(half), m_vertexCount);
+}
+
+TEST_F(SVGTessellationStrokeTest, ZeroLengthPaths) {
+  const char* const dot = "M30 30 L30 30";
+
+  // Only the caps are visible, and butt caps have no area.
+  Stroke(dot, "stroke-linecap='butt'");
+  EXPECT_EQ(0u, m_vertexCount);
+
+  // Two square caps make a square the width of the stroke.
+  Stroke(dot, "stroke-linecap='square'");
+  EXPECT_NEAR(4.0f*HALF_WIDTH*HALF_WIDTH, m_area, 1e-3f);
+  EXPECT_EQ(2*QUAD_VERTEX_COUNT, m_vertexCount);
+
+  // Two round caps make a circle.
+  const float half = static_cast<float>(M_PI);
+  Stroke(dot, "stroke-linecap='round'");
+  EXPECT_NEAR(2*ArcArea(half), m_area, 1e-3f);
+  EXPECT_LE(m_area, 2*half*HALF_WIDTH*HALF_WIDTH);
+  EXPECT_EQ(2*3*ArcSegmentCount(half), m_vertexCount);
+}
+
+TEST_F(SVGTessellationStrokeTest, ClosedAndReturningPaths) {
+  const float quadsArea = 4*40*4;
+  const float miterArea = HALF_WIDTH*HALF_WIDTH;
+
+  // A closed square joins all four corners.
+  Stroke("M10 10 L50 10 L50 50 L10 50 Z", "stroke-linejoin='miter' stroke-linecap='square'");
+  EXPECT_NEAR(quadsArea + 4*miterArea, m_area, 1e-3f);
+  EXPECT_EQ(4*QUAD_VERTEX_COUNT + 4*2*3, m_vertexCount);
+
+  // An open path which returns to its start strokes the same four sides, but joins only three
+  // corners, and caps the ends instead.
+  Stroke("M10 10 L50 10 L50 50 L10 50 L10 10", "stroke-linejoin='miter' stroke-linecap='square'");
+  EXPECT_NEAR(quadsArea + 3*miterArea + 2*(2*HALF_WIDTH*HALF_WIDTH), m_area, 1e-3f);
+  EXPECT_EQ(4*QUAD_VERTEX_COUNT + 3*2*3 + 2*QUAD_VERTEX_COUNT, m_vertexCount);
+  Stroke("M10 10 L50 10 L50 50 L10 50 L10 10", "stroke-linejoin='miter' stroke-linecap='butt'");
+  EXPECT_NEAR(quadsArea + 3*miterArea, m_area, 1e-3f);
+  EXPECT_EQ(4*QUAD_VERTEX_COUNT + 3*2*3, m_vertexCount);
+}
+
+// Fills whose subpaths overlap or cross, which the sweep triangulator can't handle, so they're
+// ear clipped instead.  The fill must still cover the union of the subpaths, less the holes
+// nested inside them, which is checked by sampling.
+class SVGTessellationFillTest : public testing::Test {
+protected:
+
+  void Fill(const std::string& path, const std::string& attributes = "") {
+    m_triangles.clear();
+    SVGTessellation tessellation;
+    ASSERT_TRUE(tessellation.Tessellate("<svg xmlns='http://www.w3.org/2000/svg' width='100' height='100'><path d='" + path +
+                                        "' fill='red' " + attributes + "/></svg>"));
+    ASSERT_EQ(1u, tessellation.Meshes().size());
+    ASSERT_EQ(SVGTessellation::MeshType::FILL, tessellation.Meshes()[0].type);
+    m_triangles = tessellation.Meshes()[0].points;
+    ASSERT_EQ(0u, m_triangles.size() % 3);
+  }
+
+  bool IsCovered(float x, float y) const {
+    const Point p(x, y);
+    for (size_t i = 0; i < m_triangles.size(); i += 3) {
+      const Point& a = m_triangles[i];
+      const Point& b = m_triangles[i + 1];
+      const Point& c = m_triangles[i + 2];
+      const float ab = (b - a).x()*(p - a).y() - (b - a).y()*(p - a).x();
+      const float bc = (c - b).x()*(p - b).y() - (c - b).y()*(p - b).x();
+      const float ca = (a - c).x()*(p - c).y() - (a - c).y()*(p - c).x();
+      if ((ab >= 0 && bc >= 0 && ca >= 0) || (ab <= 0 && bc <= 0 && ca <= 0)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Samples the centers of a grid of 2 unit cells over the canvas, none of which lie on the
+  // (even) coordinates of the paths' edges.
+  template <typename Inside>
+  void ExpectCoverage(Inside inside) const {
+    for (float y = 1; y < 100; y += 2) {
+      for (float x = 1; x < 100; x += 2) {
+        EXPECT_EQ(inside(x, y), IsCovered(x, y)) << "at (" << x << ", " << y << ")";
+      }
+    }
+  }
+
+  static bool InRect(float x, float y, float x0, float y0, float x1, float y1) {
+    return x > x0 && x < x1 && y > y0 && y < y1;
+  }
+
+  std::vector<Point> m_triangles;
+};
+
+TEST_F(SVGTessellationFillTest, OverlappingSubpaths) {
+  // Two squares wound the same way, overlapping at a corner.
+  const char* const squares = "M0 0 H60 V60 H0 Z M30 30 H90 V90 H30 Z";
+  Fill(squares);
+  ExpectCoverage([](float x, float y) { return InRect(x, y, 0, 0, 60, 60) || InRect(x, y, 30, 30, 90, 90); });
+}
+
+TEST_F(SVGTessellationFillTest, CrossingSubpaths) {
+  // A plus sign made of two bars, neither of which contains a vertex of the other.
+  Fill("M40 10 H60 V90 H40 Z M10 40 H90 V60 H10 Z");
+  ExpectCoverage([](float x, float y) { return InRect(x, y, 40, 10, 60, 90) || InRect(x, y, 10, 40, 90, 60); });
+}
+
+TEST_F(SVGTessellationFillTest, HoleInAnOverlappingSubpath) {
+  // A square with a hole wound the other way, and a bar crossing the square's edge.
+  const auto squareWithHoleOrBar = [](float x, float y) {
+    return (InRect(x, y, 0, 0, 60, 60) && !InRect(x, y, 20, 20, 40, 40)) || InRect(x, y, 50, 24, 90, 36);
+  };
+  Fill("M0 0 H60 V60 H0 Z M20 20 V40 H40 V20 Z M50 24 H90 V36 H50 Z");
+  ExpectCoverage(squareWithHoleOrBar);
+
+  // Under the even-odd rule, the hole may be wound either way.
+  Fill("M0 0 H60 V60 H0 Z M20 20 H40 V40 H20 Z M50 24 H90 V36 H50 Z", "fill-rule='evenodd'");
+  ExpectCoverage(squareWithHoleOrBar);
+}
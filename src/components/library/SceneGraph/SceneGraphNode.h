@@ -2,8 +2,11 @@
 
 #include "EigenTypes.h"
 #include <memory>
+#include "SceneGraphNodeIterator.h"
 #include "SceneGraphNodeProperties.h"
+#include <type_traits>
 #include <unordered_set>
+#include <vector>
 
 // This class contains base functionality common to all primitives:
 // - translation
@@ -61,12 +64,12 @@
 // - Name: operation is concatenation with '/' separators and the inverse operation
 //   is application with the local name ".." (just as in ordinary file systems).
 //
-// Traversal of a scene graph could be done via the iterator pattern.  A well-defined
-// traversal order gives a linear order on the nodes.  An iterator would point to the
-// "current" node and that node's global properties.  The iteration procedure would
-// perform the stack operations necessary to compute and provide each node's global
-// property values.  Probably for now all we care about is doing depth-first traversal,
-// though other orders could be implemented relatively easily as an orthogonal feature.
+// Traversal of a scene graph is done via the iterator pattern (see SceneGraphNodeIterator).
+// A well-defined traversal order gives a linear order on the nodes.  An iterator points to
+// the "current" node and that node's global properties.  The iteration procedure performs
+// the stack operations necessary to compute and provide each node's global property values.
+// Depth-first pre-order and post-order traversal are implemented; other orders could be
+// implemented relatively easily as an orthogonal feature.
 //
 // Another feature that is required by our use cases is a "property application mode" which
 // would allow different types of property application.  Let $ indicate the application
@@ -75,6 +78,17 @@
 //   child's global property = parent's global property $ child's local property
 // - REPLACE:
 //   child's global property = child's local property
+//
+// Caching of global properties
+// ----------------------------
+// Each node caches its global properties, along with a "dirty" flag indicating that the cache
+// must be recomputed.  Modifying a node's local properties (i.e. calling the non-const
+// LocalProperties accessor) or changing its parent marks it and its whole subtree dirty.  The
+// invariant is that every descendant of a dirty node is also dirty, so marking stops at nodes
+// that are already dirty, and a clean node's ancestors are all clean.  Querying the global
+// properties of a clean node is O(1); a dirty node recomputes only its dirty ancestors.  Note
+// that a reference obtained from the non-const LocalProperties accessor must not be held on to
+// and modified later, since that would bypass the dirty marking.  The cache is not thread-safe.
 
 // see http://en.wikipedia.org/wiki/Scene_graph
 // The Properties type must have a default constructor that initializes all member
@@ -85,12 +99,18 @@ template <typename Properties>
 class SceneGraphNode : public std::enable_shared_from_this<SceneGraphNode<Properties>> {
 public:
 
+  typedef Properties PropertiesType;
   typedef std::vector<std::shared_ptr<SceneGraphNode>,
     Eigen::aligned_allocator<std::shared_ptr<SceneGraphNode>>
   > ChildSet;
 
+  typedef SceneGraphNodeIterator<SceneGraphNode,TraversalOrder::PRE_ORDER> PreOrderIterator;
+  typedef SceneGraphNodeIterator<const SceneGraphNode,TraversalOrder::PRE_ORDER> ConstPreOrderIterator;
+  typedef SceneGraphNodeIterator<SceneGraphNode,TraversalOrder::POST_ORDER> PostOrderIterator;
+  typedef SceneGraphNodeIterator<const SceneGraphNode,TraversalOrder::POST_ORDER> ConstPostOrderIterator;
+
   // This initializes all local properties to their respective identity values.
-  SceneGraphNode() { }
+  SceneGraphNode() : m_global_properties_dirty(true) { }
   virtual ~SceneGraphNode() { }
 
   using std::enable_shared_from_this<SceneGraphNode>::shared_from_this;
@@ -108,11 +128,16 @@ public:
     } catch (const std::bad_weak_ptr&) {
       child->m_parent.reset(); // Unable to obtain weak pointer (parent most likely isn't a shared pointer)
     }
+    child->MarkSubtreeDirty();
   }
   virtual void RemoveChild(std::shared_ptr<SceneGraphNode> child) {
     auto found = std::find(std::begin(m_children), std::end(m_children), child);
     if (found != std::end(m_children)) {
       m_children.erase(found);
+      if (child->m_parent.lock().get() == this) {
+        child->m_parent.reset();
+      }
+      child->MarkSubtreeDirty();
     }
   }
   virtual void RemoveFromParent() {
@@ -125,14 +150,58 @@ public:
     }
   }
 
-  // TODO: make iterator-based traversal
+  // Iterators over the subtree rooted at this node.  The global properties of this node are
+  // computed from parent_global_properties, as in DepthFirstTraverse.  Only the end iterator
+  // is default-constructed, so these compare equal to any iterator which has run off the end.
+  PreOrderIterator BeginPreOrder (const Properties &parent_global_properties = Properties()) {
+    return PreOrderIterator(*this, parent_global_properties);
+  }
+  ConstPreOrderIterator BeginPreOrder (const Properties &parent_global_properties = Properties()) const {
+    return ConstPreOrderIterator(*this, parent_global_properties);
+  }
+  PreOrderIterator EndPreOrder () { return PreOrderIterator(); }
+  ConstPreOrderIterator EndPreOrder () const { return ConstPreOrderIterator(); }
+  PostOrderIterator BeginPostOrder (const Properties &parent_global_properties = Properties()) {
+    return PostOrderIterator(*this, parent_global_properties);
+  }
+  ConstPostOrderIterator BeginPostOrder (const Properties &parent_global_properties = Properties()) const {
+    return ConstPostOrderIterator(*this, parent_global_properties);
+  }
+  PostOrderIterator EndPostOrder () { return PostOrderIterator(); }
+  ConstPostOrderIterator EndPostOrder () const { return ConstPostOrderIterator(); }
+
+  // Non-recursive depth-first (pre-order) traversal calling visitor(node, global_properties) on
+  // each node, where node is cast to DerivedNode.  Unlike DepthFirstTraverse, the visitor is a
+  // template parameter rather than a std::function, so the call can be inlined.
+  template <typename DerivedNode, typename Visitor_>
+  void DepthFirstVisit (Visitor_ &&visitor, const Properties &parent_global_properties = Properties()) const {
+    for (ConstPreOrderIterator it(*this, parent_global_properties); !it.IsEnd(); ++it) {
+      assert(dynamic_cast<const DerivedNode *>(&*it) != nullptr && "node isn't actually of the requested DerivedNode type");
+      visitor(static_cast<const DerivedNode &>(*it), it.GlobalProperties());
+    }
+  }
+  template <typename DerivedNode, typename Visitor_>
+  void DepthFirstVisit (Visitor_ &&visitor, const Properties &parent_global_properties = Properties()) {
+    for (PreOrderIterator it(*this, parent_global_properties); !it.IsEnd(); ++it) {
+      assert(dynamic_cast<DerivedNode *>(&*it) != nullptr && "node isn't actually of the requested DerivedNode type");
+      visitor(static_cast<DerivedNode &>(*it), it.GlobalProperties());
+    }
+  }
+
+  // Recursive traversal with a std::function callback.  See also DepthFirstVisit and the iterators.
+  // If this node is a root and parent_global_properties is the identity, the cached global
+  // properties are used (and refreshed where dirty), so an unchanged graph isn't recomputed.
   template <typename DerivedNode>
   void DepthFirstTraverse (const std::function<void(const DerivedNode &node,
                                                     const Properties &global_properties)> &callback,
                            const Properties &parent_global_properties = Properties()) const {
+    if (m_parent.expired() && parent_global_properties == Properties()) {
+      DepthFirstTraverseCached<const DerivedNode>(callback);
+      return;
+    }
     // Using the parent's global properties, compute this node's global properties.
     Properties global_properties(parent_global_properties);
-    global_properties.Apply(LocalProperties(), Operate::ON_RIGHT);
+    global_properties.Apply(m_local_properties, Operate::ON_RIGHT);
     assert(dynamic_cast<const DerivedNode *>(this) != nullptr && "this node isn't actually of the requested DerivedNode type");
     // Call the callback on this node.
     callback(*static_cast<const DerivedNode *>(this), global_properties);
@@ -147,9 +216,14 @@ public:
   void DepthFirstTraverse (const std::function<void(DerivedNode &node,
                                                     const Properties &global_properties)> &callback,
                            const Properties &parent_global_properties = Properties()) {
+    if (m_parent.expired() && parent_global_properties == Properties()) {
+      DepthFirstTraverseCached<DerivedNode>(callback);
+      return;
+    }
     // Using the parent's global properties, compute this node's global properties.
+    // Note that the const accessor is used, so that this node isn't needlessly marked dirty.
     Properties global_properties(parent_global_properties);
-    global_properties.Apply(LocalProperties(), Operate::ON_RIGHT);
+    global_properties.Apply(m_local_properties, Operate::ON_RIGHT);
     assert(dynamic_cast<DerivedNode *>(this) != nullptr && "this node isn't actually of the requested DerivedNode type");
     // Call the callback on this node.
     callback(*static_cast<DerivedNode *>(this), global_properties);
@@ -188,30 +262,32 @@ public:
   // }
 
   // The local properties give this node's properties as a "delta" to its parents'.
+  // The non-const accessor marks this node's subtree as having dirty global properties.
   const Properties &LocalProperties () const { return m_local_properties; }
-  Properties &LocalProperties () { return m_local_properties; }
-  Properties GlobalProperties () const { return PropertiesDeltaToRootNode(); }
-  // TODO: (maybe) provide GlobalProperties method which applies the ancestor property stack
+  Properties &LocalProperties () {
+    MarkSubtreeDirty();
+    return m_local_properties;
+  }
+  // Returns the (cached) global properties of this node.  This is O(1) if neither this
+  // node's local properties nor those of any of its ancestors have changed since the last
+  // query.
+  const Properties &GlobalProperties () const {
+    if (m_global_properties_dirty) {
+      RecomputeGlobalProperties();
+    }
+    return m_global_properties;
+  }
 
   // This returns the "global properties" of this node, i.e. the composition
-  // of the properties of the ancestor line of this node.
+  // of the properties of the ancestor line of this node.  This is the same as
+  // GlobalProperties, and is similarly cached.
   //
   // As an example, if one of the properties is the affine transformation giving
   // the transformation from a child's coordinate system to its parent's, then
   // the corresponding property in the return value will be the affine transformation
   // giving the transformation from this node's coordinate system to the global
   // coordinate system.
-  Properties PropertiesDeltaToRootNode () const {
-    Properties retval; // Initialized to the identity properties.
-    auto node = shared_from_this();
-    // Apply, on the left, each ancestor's local properties.  Continue
-    // until the root is reached.
-    do {
-      retval.Apply(node->LocalProperties(), Operate::ON_LEFT);
-      node = node->m_parent.lock();
-    } while (node);
-    return retval;
-  }
+  Properties PropertiesDeltaToRootNode () const { return GlobalProperties(); }
   // This returns the inverse of the PropertiesDeltaToRootNode() value.
   //
   // As an example, if one of the properties is the affine transformation giving
@@ -233,38 +309,16 @@ public:
   // the transformation from a child's coordinate system to its parent's, then
   // the delta for that property will be the affine transformation taking this
   // node's coordinate system to the other node's coordinate system.
+  //
+  // This is computed from the cached global properties of both nodes, so it is O(1)
+  // if neither node is dirty.  The two nodes must be in the same tree.
   Properties PropertiesDeltaTo (const SceneGraphNode &other) const {
-    auto closest_common_ancestor = ClosestCommonAncestor(other);
-
-    // Compute the properties of this node with respect to the common ancestor.
-    // For convenience in later comments, call this A.
-    Properties this_properties_stack;
-    this_properties_stack.SetIdentity();
-    auto traversal_node = shared_from_this();
-    while (traversal_node != closest_common_ancestor) {
-      // Because we are traversing from this node up through its ancestry,
-      // each properties must be applied on the left.
-      this_properties_stack.Apply(traversal_node->LocalProperties(), Operate::ON_LEFT);
-      traversal_node = traversal_node->m_parent.lock();
-    }
-
-    // Compute the properties of the other node with respect to the common ancestor.
-    // For convenience in later comments, call this B.
-    Properties other_properties_stack;
-    other_properties_stack.SetIdentity();
-    traversal_node = other.shared_from_this();
-    while (traversal_node != closest_common_ancestor) {
-      // Because we are traversing from the other node up through its ancestry,
-      // each properties must be applied on the left.
-      other_properties_stack.Apply(traversal_node->LocalProperties(), Operate::ON_LEFT);
-      traversal_node = traversal_node->m_parent.lock();
-    }
-
-    // The property delta is computed by first applying A and then applying B inverse
-    // i.e. B^{-1} * A.  Thus B is applied on the left of A.
-    other_properties_stack.Invert();
-    this_properties_stack.Apply(other_properties_stack, Operate::ON_LEFT);
-    return this_properties_stack;
+    // Call this node's global properties A and the other node's B.  The property
+    // delta is computed by first applying A and then applying B inverse, i.e.
+    // B^{-1} * A.  Thus B^{-1} is applied on the left of A.
+    Properties retval(GlobalProperties());
+    retval.Apply(other.GlobalProperties().Inverse(), Operate::ON_LEFT);
+    return retval;
   }
   
   // // This computes the transformation taking points in this node's coordinate
@@ -354,6 +408,92 @@ public:
 
 private:
 
+  // Marks this node and all its descendants as having dirty global properties.  Because every
+  // descendant of a dirty node is dirty, already-dirty subtrees are skipped.
+  void MarkSubtreeDirty () {
+    if (m_global_properties_dirty) {
+      return;
+    }
+    std::vector<SceneGraphNode *> stack(1, this);
+    while (!stack.empty()) {
+      SceneGraphNode *node = stack.back();
+      stack.pop_back();
+      node->m_global_properties_dirty = true;
+      for (auto it = node->m_children.begin(); it != node->m_children.end(); ++it) {
+        assert(bool(*it));
+        if (!(*it)->m_global_properties_dirty) {
+          stack.push_back(it->get());
+        }
+      }
+    }
+  }
+  // Recomputes the global properties of this node and of each of its dirty ancestors, root-down.
+  void RecomputeGlobalProperties () const {
+    // Collect the dirty line of ancestry, ending with the first clean ancestor (if any).
+    std::vector<const SceneGraphNode *> dirty_nodes(1, this);
+    std::shared_ptr<const SceneGraphNode> parent(m_parent.lock());
+    std::shared_ptr<const SceneGraphNode> clean_ancestor;
+    while (parent) {
+      if (!parent->m_global_properties_dirty) {
+        clean_ancestor = parent;
+        break;
+      }
+      dirty_nodes.push_back(parent.get());
+      parent = parent->m_parent.lock();
+    }
+    // Apply the local properties on the right, going down from the root, exactly as
+    // DepthFirstTraverse does.
+    const SceneGraphNode *parent_node = clean_ancestor.get();
+    for (auto it = dirty_nodes.rbegin(); it != dirty_nodes.rend(); ++it) {
+      const SceneGraphNode &node = **it;
+      node.UpdateGlobalPropertiesFromParent(parent_node);
+      parent_node = &node;
+    }
+  }
+  // Computes this node's global properties from the given parent's (clean) global properties,
+  // or from the identity if there is no parent.
+  void UpdateGlobalPropertiesFromParent (const SceneGraphNode *parent) const {
+    assert((!parent || !parent->m_global_properties_dirty) && "the parent's global properties must be up to date");
+    if (parent) {
+      m_global_properties = parent->m_global_properties;
+    } else {
+      m_global_properties.SetIdentity();
+    }
+    m_global_properties.Apply(m_local_properties, Operate::ON_RIGHT);
+    m_global_properties_dirty = false;
+  }
+  // Traversal for the root node, which refreshes and passes along the cached global properties.
+  // NodeType_ is either DerivedNode or const DerivedNode, matching the callback's parameter.
+  template <typename NodeType_, typename Callback_>
+  void DepthFirstTraverseCached (const Callback_ &callback) const {
+    if (m_global_properties_dirty) {
+      UpdateGlobalPropertiesFromParent(nullptr);
+    }
+    DepthFirstTraverseCachedSubtree<NodeType_>(callback);
+  }
+  template <typename NodeType_, typename Callback_>
+  void DepthFirstTraverseCachedSubtree (const Callback_ &callback) const {
+    assert(dynamic_cast<const NodeType_ *>(this) != nullptr && "this node isn't actually of the requested DerivedNode type");
+    callback(*static_cast<NodeType_ *>(const_cast<SceneGraphNode *>(this)), m_global_properties);
+    // If the callback modified this node's local properties, the children can't be cached against
+    // this node's global properties, so fall back to uncached traversal (using the global properties
+    // computed before the callback, as the uncached traversal does).
+    const bool this_is_dirty = m_global_properties_dirty;
+    for (auto it = m_children.begin(); it != m_children.end(); ++it) {
+      assert(bool(*it));
+      SceneGraphNode &child = **it;
+      if (this_is_dirty) {
+        static_cast<typename std::conditional<std::is_const<NodeType_>::value,const SceneGraphNode &,SceneGraphNode &>::type>(child)
+          .DepthFirstTraverse(callback, m_global_properties);
+        continue;
+      }
+      if (child.m_global_properties_dirty) {
+        child.UpdateGlobalPropertiesFromParent(this);
+      }
+      child.template DepthFirstTraverseCachedSubtree<NodeType_>(callback);
+    }
+  }
+
   // //Silly function call wrapper that allows you to also pass nullptr as a function if you want.
   // template<class _Fn, typename... _Args>
   // static void CallFunction(_Fn function, _Args&& ... args) { function(args...); }
@@ -378,6 +518,9 @@ private:
   // Transform m_transform;
 
   Properties m_local_properties;
+  // The cached global properties, which are only valid if m_global_properties_dirty is false.
+  mutable Properties m_global_properties;
+  mutable bool m_global_properties_dirty;
 
   // This uses a weak_ptr to avoid a cycle of shared_ptrs which would then be indestructible.
   std::weak_ptr<SceneGraphNode> m_parent;
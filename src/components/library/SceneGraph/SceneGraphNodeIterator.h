@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+#include "EigenTypes.h"
+#include "SceneGraphNodeProperty.h"
+
+// Defines the order in which SceneGraphNodeIterator visits the nodes of a subtree.
+// - PRE_ORDER visits a node before any of its children (the order DepthFirstTraverse uses).
+// - POST_ORDER visits a node after all of its children.
+enum class TraversalOrder { PRE_ORDER, POST_ORDER };
+
+// A non-recursive, depth-first iterator over the subtree rooted at a scene graph node.  It keeps
+// an explicit stack containing the line of ancestry of the current node (relative to the subtree
+// root), and along with each node, that node's global properties, so the iteration performs the
+// stack operations necessary to compute each node's global properties (as described in the design
+// notes in SceneGraphNode.h).  Because the traversal state lives in the iterator, traversal can be
+// paused and resumed, and subtrees can be skipped (pre-order only).
+//
+// Node_ is a SceneGraphNode type, or a const SceneGraphNode type for read-only traversal.  The
+// global properties of the subtree root are computed from the "parent global properties" passed
+// to the constructor (by default the identity), exactly as in DepthFirstTraverse.
+//
+// Modifying the children of any node on the stack invalidates the iterator.
+template <typename Node_, TraversalOrder ORDER_>
+class SceneGraphNodeIterator {
+public:
+
+  typedef typename std::remove_const<Node_>::type::PropertiesType Properties;
+
+  typedef std::forward_iterator_tag iterator_category;
+  typedef Node_ value_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef Node_ *pointer;
+  typedef Node_ &reference;
+
+  // Constructs the end iterator.
+  SceneGraphNodeIterator () : m_depth(0), m_skip_subtree(false) { }
+  // Constructs an iterator pointing at the first node (in the given order) of the subtree rooted at root.
+  explicit SceneGraphNodeIterator (Node_ &root, const Properties &parent_global_properties = Properties())
+    :
+    m_depth(0),
+    m_skip_subtree(false)
+  {
+    Reset(root, parent_global_properties);
+  }
+
+  // Restarts the traversal at the given subtree root.  The stack storage is kept, so reusing one
+  // iterator for repeated traversals (e.g. once per frame) avoids reallocating it each time.
+  void Reset (Node_ &root, const Properties &parent_global_properties = Properties()) {
+    m_depth = 0;
+    m_skip_subtree = false;
+    Push(root, parent_global_properties);
+    if (ORDER_ == TraversalOrder::POST_ORDER) {
+      DescendToFirstLeaf();
+    }
+  }
+
+  bool IsEnd () const { return m_depth == 0; }
+
+  Node_ &operator * () const { assert(!IsEnd()); return *Top().m_node; }
+  Node_ *operator -> () const { assert(!IsEnd()); return Top().m_node; }
+  // The global properties of the current node.
+  const Properties &GlobalProperties () const { assert(!IsEnd()); return Top().m_global_properties; }
+  // The depth of the current node, relative to the subtree root (which has depth 0).
+  size_t Depth () const { assert(!IsEnd()); return m_depth - 1; }
+
+  // Causes the next increment to skip the children of the current node.  Only meaningful
+  // for pre-order traversal, since in post-order the children have already been visited.
+  void SkipSubtree () {
+    static_assert(ORDER_ == TraversalOrder::PRE_ORDER, "SkipSubtree is only meaningful for pre-order traversal");
+    m_skip_subtree = true;
+  }
+
+  SceneGraphNodeIterator &operator ++ () {
+    assert(!IsEnd() && "can't increment the end iterator");
+    if (ORDER_ == TraversalOrder::PRE_ORDER) {
+      if (m_skip_subtree) {
+        Top().m_next_child = Top().m_node->Children().size();
+        m_skip_subtree = false;
+      }
+      // Go to the next unvisited child of the deepest node which has one.
+      while (m_depth > 0) {
+        if (PushNextChild()) {
+          break;
+        }
+        --m_depth;
+      }
+    } else {
+      // The current node's children have all been visited, so it's done.  Its parent's
+      // remaining children (and their descendants) come before the parent.
+      --m_depth;
+      if (m_depth > 0) {
+        DescendToFirstLeaf();
+      }
+    }
+    return *this;
+  }
+  SceneGraphNodeIterator operator ++ (int) {
+    SceneGraphNodeIterator retval(*this);
+    ++*this;
+    return retval;
+  }
+
+  bool operator == (const SceneGraphNodeIterator &other) const {
+    if (IsEnd() || other.IsEnd()) {
+      return IsEnd() == other.IsEnd();
+    }
+    return Top().m_node == other.Top().m_node && m_depth == other.m_depth;
+  }
+  bool operator != (const SceneGraphNodeIterator &other) const { return !(*this == other); }
+
+private:
+
+  struct Frame {
+    Node_ *m_node;
+    // The index of the next child of m_node to visit.
+    size_t m_next_child;
+    Properties m_global_properties;
+  };
+
+  const Frame &Top () const { return m_stack[m_depth-1]; }
+  Frame &Top () { return m_stack[m_depth-1]; }
+
+  // Frames above m_depth are kept (rather than popped) so that pushing doesn't construct
+  // and destroy a Properties value each time.
+  void Push (Node_ &node, const Properties &parent_global_properties) {
+    if (m_depth == m_stack.size()) {
+      m_stack.resize(m_depth + 1);
+    }
+    ++m_depth;
+    Frame &frame = Top();
+    frame.m_node = &node;
+    frame.m_next_child = 0;
+    frame.m_global_properties = parent_global_properties;
+    frame.m_global_properties.Apply(static_cast<const Node_ &>(node).LocalProperties(), Operate::ON_RIGHT);
+  }
+  // Pushes the next unvisited child of the node on top of the stack, returning false if there is none.
+  bool PushNextChild () {
+    Frame &frame = Top();
+    auto &children = frame.m_node->Children();
+    if (frame.m_next_child >= children.size()) {
+      return false;
+    }
+    Node_ &child = *children[frame.m_next_child++];
+    // Growing the stack may reallocate it, so grow it before referring to the parent's frame.
+    if (m_depth == m_stack.size()) {
+      m_stack.resize(m_depth + 1);
+    }
+    Push(child, Top().m_global_properties);
+    return true;
+  }
+  void DescendToFirstLeaf () {
+    while (PushNextChild()) { }
+  }
+
+  std::vector<Frame,Eigen::aligned_allocator<Frame>> m_stack;
+  // The number of frames in m_stack which are in use; the current node is in the last of them.
+  size_t m_depth;
+  bool m_skip_subtree;
+};
@@ -0,0 +1,224 @@
+#include <chrono>
+#include <gtest/gtest.h>
+#include <iostream>
+#include "SceneGraphNode.h"
+#include "SceneGraphNodeValues.h"
+
+// These tests report timings for operations on large synthetic scene graphs, comparing the
+// cached global properties against recomputing them up the line of ancestry (which is what
+// PropertiesDeltaToRootNode used to do), and the recursive traversal against the iterators.
+// They only fail if the results disagree.
+
+class SceneGraphNodeBenchmark : public testing::Test {
+protected:
+
+  typedef ParticularSceneGraphNodeProperties<double,3,float> Props;
+  typedef SceneGraphNode<Props> Node;
+  typedef std::shared_ptr<Node> NodeRef;
+
+  // The nodes of a synthetic graph, along with each node's parent index (-1 for the root).
+  struct Graph {
+    std::vector<NodeRef> nodes;
+    std::vector<int> parents;
+  };
+
+  static NodeRef MakeNode (size_t index) {
+    NodeRef node(new Node());
+    node->LocalProperties().AffineTransform().translate(EigenTypes::Vector3(1.0, 0.5, 0.25));
+    node->LocalProperties().AffineTransform().rotate(Eigen::AngleAxis<double>(0.001*index, EigenTypes::Vector3::UnitZ()));
+    node->LocalProperties().AlphaMask() = 0.999f;
+    return node;
+  }
+  static void AddNode (Graph &graph, int parent) {
+    graph.nodes.push_back(MakeNode(graph.nodes.size()));
+    graph.parents.push_back(parent);
+    if (parent >= 0) {
+      graph.nodes[parent]->AddChild(graph.nodes.back());
+    }
+  }
+  // A single chain of nodes.
+  static Graph MakeDeepGraph (size_t depth) {
+    Graph graph;
+    for (size_t i = 0; i < depth; ++i) {
+      AddNode(graph, static_cast<int>(i) - 1);
+    }
+    return graph;
+  }
+  // A complete tree with the given branching factor and number of levels.
+  static Graph MakeWideGraph (size_t branching, size_t levels) {
+    Graph graph;
+    AddNode(graph, -1);
+    size_t level_begin = 0;
+    for (size_t level = 1; level < levels; ++level) {
+      size_t level_end = graph.nodes.size();
+      for (size_t parent = level_begin; parent < level_end; ++parent) {
+        for (size_t i = 0; i < branching; ++i) {
+          AddNode(graph, static_cast<int>(parent));
+        }
+      }
+      level_begin = level_end;
+    }
+    return graph;
+  }
+  // Recomputes the global properties by walking the line of ancestry.
+  static Props UncachedGlobalProperties (const Graph &graph, int index) {
+    Props retval;
+    for (; index >= 0; index = graph.parents[index]) {
+      retval.Apply(graph.nodes[index]->LocalProperties(), Operate::ON_LEFT);
+    }
+    return retval;
+  }
+  static bool AreClose (const Props &a, const Props &b) {
+    return a.AffineTransform().affine().isApprox(b.AffineTransform().affine(), 1e-9) &&
+           std::abs(float(a.AlphaMask()) - float(b.AlphaMask())) < 1e-5f;
+  }
+
+  typedef std::chrono::high_resolution_clock Clock;
+  static double MillisecondsSince (const Clock::time_point &start) {
+    return std::chrono::duration<double,std::milli>(Clock::now() - start).count();
+  }
+
+  // Times querying the global properties of every node, uncached, then cached on a cold cache
+  // (after the root was modified), and then cached on an unchanged graph.
+  static void BenchmarkQueries (const std::string &description, const Graph &graph, size_t repetitions) {
+    const Graph &g = graph;
+    double checksum = 0.0;
+    Clock::time_point start = Clock::now();
+    for (size_t r = 0; r < repetitions; ++r) {
+      for (size_t i = 0; i < g.nodes.size(); ++i) {
+        checksum += UncachedGlobalProperties(g, static_cast<int>(i)).AffineTransform().translation().x();
+      }
+    }
+    double uncached_ms = MillisecondsSince(start);
+
+    double cold_ms = 0.0;
+    double warm_ms = 0.0;
+    for (size_t r = 0; r < repetitions; ++r) {
+      g.nodes[0]->LocalProperties().AlphaMask() = 0.999f; // Dirties the whole graph.
+      start = Clock::now();
+      for (size_t i = 0; i < g.nodes.size(); ++i) {
+        checksum -= g.nodes[i]->GlobalProperties().AffineTransform().translation().x();
+      }
+      cold_ms += MillisecondsSince(start);
+      start = Clock::now();
+      for (size_t i = 0; i < g.nodes.size(); ++i) {
+        checksum += g.nodes[i]->GlobalProperties().AffineTransform().translation().x();
+      }
+      warm_ms += MillisecondsSince(start);
+    }
+
+    for (size_t i = 0; i < g.nodes.size(); ++i) {
+      EXPECT_TRUE(AreClose(UncachedGlobalProperties(g, static_cast<int>(i)), g.nodes[i]->GlobalProperties()));
+    }
+    std::cout << description << " (" << g.nodes.size() << " nodes, " << repetitions << " repetitions): "
+              << "uncached " << uncached_ms << " ms, "
+              << "cached after root change " << cold_ms << " ms, "
+              << "cached unchanged " << warm_ms << " ms "
+              << "(checksum " << checksum << ")\n";
+  }
+};
+
+TEST_F(SceneGraphNodeBenchmark, DeepGraphGlobalPropertyQueries) {
+  BenchmarkQueries("deep graph", MakeDeepGraph(1000), 10);
+}
+
+TEST_F(SceneGraphNodeBenchmark, WideGraphGlobalPropertyQueries) {
+  BenchmarkQueries("wide graph", MakeWideGraph(8, 5), 10);
+}
+
+TEST_F(SceneGraphNodeBenchmark, WideGraphTraversal) {
+  Graph graph(MakeWideGraph(8, 5));
+  const size_t repetitions = 10;
+  double sum = 0.0;
+  std::function<void(const Node &, const Props &)> accumulate = [&sum](const Node &, const Props &global_properties) {
+    sum += global_properties.AffineTransform().translation().x();
+  };
+  // A non-root starting node with an explicit parent_global_properties uses the uncached traversal.
+  Props identity;
+  const Node &root = *graph.nodes[0];
+  Clock::time_point start = Clock::now();
+  for (size_t r = 0; r < repetitions; ++r) {
+    for (auto it = root.Children().begin(); it != root.Children().end(); ++it) {
+      const Node &child = static_cast<const Node &>(**it);
+      child.DepthFirstTraverse<Node>(accumulate, root.LocalProperties());
+    }
+  }
+  double uncached_ms = MillisecondsSince(start);
+  start = Clock::now();
+  for (size_t r = 0; r < repetitions; ++r) {
+    root.DepthFirstTraverse<Node>(accumulate, identity);
+  }
+  double cached_ms = MillisecondsSince(start);
+  std::cout << "wide graph traversal (" << graph.nodes.size() << " nodes, " << repetitions << " repetitions): "
+            << "uncached " << uncached_ms << " ms, cached " << cached_ms << " ms (checksum " << sum << ")\n";
+}
+
+// Compares the recursive std::function traversal against the non-recursive iterators and the
+// template visitor.  A non-identity parent_global_properties is used so that all of them compute
+// the global properties during the traversal (rather than the recursive one using the cache).
+TEST_F(SceneGraphNodeBenchmark, IteratorTraversal) {
+  const size_t repetitions = 100;
+  Props offset;
+  offset.AffineTransform().translate(EigenTypes::Vector3(0.0, 0.0, 1.0));
+  Graph graphs[] = { MakeDeepGraph(1000), MakeWideGraph(8, 5) };
+  for (const Graph &graph : graphs) {
+    const Node &root = *graph.nodes[0];
+    double recursive_sum = 0.0;
+    std::function<void(const Node &, const Props &)> accumulate = [&recursive_sum](const Node &, const Props &global_properties) {
+      recursive_sum += global_properties.AffineTransform().translation().x();
+    };
+    Clock::time_point start = Clock::now();
+    for (size_t r = 0; r < repetitions; ++r) {
+      root.DepthFirstTraverse<Node>(accumulate, offset);
+    }
+    double recursive_ms = MillisecondsSince(start);
+
+    double pre_order_sum = 0.0;
+    start = Clock::now();
+    for (size_t r = 0; r < repetitions; ++r) {
+      for (auto it = root.BeginPreOrder(offset); !it.IsEnd(); ++it) {
+        pre_order_sum += it.GlobalProperties().AffineTransform().translation().x();
+      }
+    }
+    double pre_order_ms = MillisecondsSince(start);
+
+    double reused_sum = 0.0;
+    Node::ConstPreOrderIterator reused;
+    start = Clock::now();
+    for (size_t r = 0; r < repetitions; ++r) {
+      for (reused.Reset(root, offset); !reused.IsEnd(); ++reused) {
+        reused_sum += reused.GlobalProperties().AffineTransform().translation().x();
+      }
+    }
+    double reused_ms = MillisecondsSince(start);
+
+    double post_order_sum = 0.0;
+    start = Clock::now();
+    for (size_t r = 0; r < repetitions; ++r) {
+      for (auto it = root.BeginPostOrder(offset); !it.IsEnd(); ++it) {
+        post_order_sum += it.GlobalProperties().AffineTransform().translation().x();
+      }
+    }
+    double post_order_ms = MillisecondsSince(start);
+
+    double visitor_sum = 0.0;
+    start = Clock::now();
+    for (size_t r = 0; r < repetitions; ++r) {
+      root.DepthFirstVisit<Node>([&visitor_sum](const Node &, const Props &global_properties) {
+        visitor_sum += global_properties.AffineTransform().translation().x();
+      }, offset);
+    }
+    double visitor_ms = MillisecondsSince(start);
+
+    EXPECT_NEAR(recursive_sum, pre_order_sum, 1e-6*std::abs(recursive_sum));
+    EXPECT_NEAR(recursive_sum, reused_sum, 1e-6*std::abs(recursive_sum));
+    EXPECT_NEAR(recursive_sum, post_order_sum, 1e-6*std::abs(recursive_sum));
+    EXPECT_NEAR(recursive_sum, visitor_sum, 1e-6*std::abs(recursive_sum));
+    std::cout << "traversal (" << graph.nodes.size() << " nodes, " << repetitions << " repetitions): "
+              << "recursive " << recursive_ms << " ms, "
+              << "pre-order iterator " << pre_order_ms << " ms, "
+              << "reused pre-order iterator " << reused_ms << " ms, "
+              << "post-order iterator " << post_order_ms << " ms, "
+              << "template visitor " << visitor_ms << " ms\n";
+  }
+}
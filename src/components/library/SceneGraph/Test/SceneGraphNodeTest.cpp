@@ -141,3 +141,136 @@ TEST_F(SceneGraphNodeTest, PropertyDeltas) {
   }
 }
 
+
+TEST_F(SceneGraphNodeTest, CachedGlobalPropertiesFollowChanges) {
+  typedef AllSceneGraphNodeProperties<float,2,float> Props;
+  typedef SceneGraphNode<Props> Node;
+
+  auto A = std::shared_ptr<Node>(new Node());
+  auto B = std::shared_ptr<Node>(new Node());
+  auto C = std::shared_ptr<Node>(new Node());
+  auto D = std::shared_ptr<Node>(new Node());
+  A->LocalProperties().AffineTransform().translate(EigenTypes::Vector2f(1.0f, 0.0f));
+  B->LocalProperties().AffineTransform().translate(EigenTypes::Vector2f(0.0f, 2.0f));
+  C->LocalProperties().AffineTransform().scale(2.0f);
+  D->LocalProperties().AffineTransform().translate(EigenTypes::Vector2f(4.0f, 4.0f));
+
+  //      A
+  //      |
+  //      B   D
+  //      |
+  //      C
+
+  A->AddChild(B);
+  B->AddChild(C);
+
+  EXPECT_EQ(A->LocalProperties()*B->LocalProperties()*C->LocalProperties(), C->GlobalProperties());
+
+  // Changing an ancestor's local properties must be reflected in the descendants.
+  A->LocalProperties().AlphaMask() = 0.5f;
+  A->LocalProperties().AffineTransform().translate(EigenTypes::Vector2f(0.0f, 8.0f));
+  EXPECT_EQ(0.5f, float(C->GlobalProperties().AlphaMask()));
+  EXPECT_EQ(A->LocalProperties()*B->LocalProperties()*C->LocalProperties(), C->GlobalProperties());
+
+  // Querying a descendant first, and then the ancestor, must give consistent results.
+  B->LocalProperties().AffineTransform().scale(0.5f);
+  EXPECT_EQ(A->LocalProperties()*B->LocalProperties()*C->LocalProperties(), C->GlobalProperties());
+  EXPECT_EQ(A->LocalProperties()*B->LocalProperties(), B->GlobalProperties());
+
+  // Reparenting must be reflected as well.
+  D->AddChild(C);
+  B->RemoveChild(C);
+  EXPECT_EQ(D->LocalProperties()*C->LocalProperties(), C->GlobalProperties());
+  C->RemoveFromParent();
+  EXPECT_EQ(C->LocalProperties(), C->GlobalProperties());
+
+  // Traversal from the root must give the same global properties as querying each node.
+  D->AddChild(C);
+  A->AddChild(D);
+  A->DepthFirstTraverse<Node>([](const Node &node, const Props &global_properties) {
+    EXPECT_EQ(node.GlobalProperties(), global_properties);
+  });
+}
+
+TEST_F(SceneGraphNodeTest, IteratorTraversal) {
+  typedef AllSceneGraphNodeProperties<float,2,float> Props;
+  typedef SceneGraphNode<Props> Node;
+
+  auto A = std::shared_ptr<Node>(new Node());
+  auto B = std::shared_ptr<Node>(new Node());
+  auto C = std::shared_ptr<Node>(new Node());
+  auto D = std::shared_ptr<Node>(new Node());
+  auto E = std::shared_ptr<Node>(new Node());
+  A->LocalProperties().AffineTransform().translate(EigenTypes::Vector2f(1.0f, 0.0f));
+  B->LocalProperties().AffineTransform().scale(2.0f);
+  C->LocalProperties().AffineTransform().translate(EigenTypes::Vector2f(0.0f, 3.0f));
+  D->LocalProperties().AlphaMask() = 0.5f;
+  E->LocalProperties().AffineTransform().translate(EigenTypes::Vector2f(4.0f, 4.0f));
+
+  //  A
+  //  |-B
+  //  | |-C
+  //  | `-D
+  //  `-E
+
+  A->AddChild(B);
+  A->AddChild(E);
+  B->AddChild(C);
+  B->AddChild(D);
+
+  std::vector<const Node *> visited;
+
+  // Pre-order, with the global properties computed along the way.
+  for (auto it = A->BeginPreOrder(); it != A->EndPreOrder(); ++it) {
+    visited.push_back(&*it);
+    EXPECT_EQ(it->GlobalProperties(), it.GlobalProperties());
+  }
+  EXPECT_EQ((std::vector<const Node *>{ A.get(), B.get(), C.get(), D.get(), E.get() }), visited);
+
+  // Skipping a subtree.
+  visited.clear();
+  for (auto it = A->BeginPreOrder(); !it.IsEnd(); ++it) {
+    visited.push_back(&*it);
+    if (&*it == B.get()) {
+      it.SkipSubtree();
+    }
+  }
+  EXPECT_EQ((std::vector<const Node *>{ A.get(), B.get(), E.get() }), visited);
+
+  // Post-order, including depth.
+  visited.clear();
+  std::vector<size_t> depths;
+  const Node &const_A = *A;
+  for (auto it = const_A.BeginPostOrder(); it != const_A.EndPostOrder(); ++it) {
+    visited.push_back(&*it);
+    depths.push_back(it.Depth());
+    EXPECT_EQ(it->GlobalProperties(), it.GlobalProperties());
+  }
+  EXPECT_EQ((std::vector<const Node *>{ C.get(), D.get(), B.get(), E.get(), A.get() }), visited);
+  EXPECT_EQ((std::vector<size_t>{ 2, 2, 1, 1, 0 }), depths);
+
+  // Traversal of a subtree, relative to its parent's global properties, and pausing in the middle.
+  auto it = B->BeginPreOrder(A->GlobalProperties());
+  ++it;
+  auto paused = it;
+  EXPECT_EQ(C.get(), &*paused);
+  ++it;
+  EXPECT_EQ(D.get(), &*it);
+  EXPECT_EQ(D->GlobalProperties(), it.GlobalProperties());
+  EXPECT_EQ(C->GlobalProperties(), paused.GlobalProperties());
+  ++it;
+  EXPECT_TRUE(it == B->EndPreOrder());
+
+  // The template visitor gives the same results as the recursive traversal.
+  std::vector<const Node *> traversed;
+  visited.clear();
+  const_A.DepthFirstTraverse<Node>([&traversed](const Node &node, const Props &global_properties) {
+    traversed.push_back(&node);
+    EXPECT_EQ(node.GlobalProperties(), global_properties);
+  }, Props());
+  const_A.DepthFirstVisit<Node>([&visited](const Node &node, const Props &global_properties) {
+    visited.push_back(&node);
+    EXPECT_EQ(node.GlobalProperties(), global_properties);
+  });
+  EXPECT_EQ(traversed, visited);
+}
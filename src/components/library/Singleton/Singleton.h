@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <mutex>
 #include <stdexcept>
 
 /// @brief Custom exception class specifically for Singleton<T>.
@@ -26,6 +28,9 @@ public:
 /// create or destroy the singleton.  SafeRef will create the singleton if it doesn't
 /// already exist. This is essentially used as a really shitty single-context version
 /// of autowiring at this point, and should be replaced with it.
+///
+/// Creation and destruction are serialized, so SafeRef may be called from several threads
+/// (e.g. resource loaders running on worker threads) without creating the singleton twice.
 
 template <typename T>
 class Singleton {
@@ -37,6 +42,7 @@ public:
   /// parameters before being used.
   template<typename... Arguments>
   static void CreateInstance(Arguments... params) {
+    std::lock_guard<std::mutex> lock(CreationMutex());
     if (s_inst != nullptr) {
       throw SingletonExceptionOfType<T>("Singleton of this type already exists");
     }
@@ -46,20 +52,24 @@ public:
   /// @details Allocates the singleton on the heap via new with no arguments.
   static void EnsureInstanceExists() {
     if (s_inst == nullptr){
-      s_inst = new T();
+      std::lock_guard<std::mutex> lock(CreationMutex());
+      if (s_inst == nullptr) {
+        s_inst = new T();
+      }
     }
   }
   /// @brief Explicitly destroy the T singleton if it exists.
   /// @details Deallocates the singleton via delete.
   static void DestroyInstance () {
+    std::lock_guard<std::mutex> lock(CreationMutex());
     if (s_inst != nullptr) {
-      delete s_inst;
+      delete s_inst.load();
       s_inst = nullptr;
     }
   }
 
   /// @brief Returns true iff the T singleton has been created and currently exists.
-  static bool Exists () { return s_inst; }
+  static bool Exists () { return s_inst != nullptr; }
   /// @brief Returns a pointer to the T singleton.  Will be nullptr if the singleton
   /// doesn't exist (i.e. if Exists returns false).
   static T *Ptr () { return s_inst; }
@@ -69,20 +79,26 @@ public:
     if (s_inst == nullptr) {
       throw SingletonExceptionOfType<T>("can't return reference to singleton that hasn't been created yet");
     }
-    return *s_inst;
+    return *s_inst.load();
   }
   /// @brief Returns a reference to the T singleton.  Will create the T singleton if
   /// it doesn't already exist.
   static T &SafeRef () { 
     EnsureInstanceExists();
-    return *s_inst;
+    return *s_inst.load();
   }
 
 private:
 
-  static T *s_inst; ///< A pointer to the T singleton.  Is nullptr iff the singleton doesn't exist.
+  /// @brief Guards creation and destruction of the singleton.
+  static std::mutex &CreationMutex () {
+    static std::mutex s_mutex;
+    return s_mutex;
+  }
+
+  static std::atomic<T *> s_inst; ///< A pointer to the T singleton.  Is nullptr iff the singleton doesn't exist.
 };
 
 /// @brief Definition of the static singleton pointer.
 template<class T>
-T *Singleton<T>::s_inst = nullptr;
+std::atomic<T *> Singleton<T>::s_inst(nullptr);
@@ -0,0 +1,136 @@
+#include "MappedFile.h"
+
+#include <stdexcept>
+
+#if _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile ()
+  :
+  m_data(nullptr),
+  m_size(0)
+#if _WIN32
+  ,
+  m_file_handle(INVALID_HANDLE_VALUE),
+  m_mapping_handle(nullptr)
+#endif
+{ }
+
+void MappedFile::Open (const std::string &path) {
+  if (path.empty()) {
+    throw std::invalid_argument("MappedFile: must specify a nonempty path to open");
+  }
+  if (!TryOpen(path)) {
+    throw std::domain_error("MappedFile: error encountered while attempting to map file \"" + path + "\"");
+  }
+}
+
+#if _WIN32
+
+bool MappedFile::TryOpen (const std::string &path) {
+  Close();
+  if (path.empty()) {
+    return false;
+  }
+  // Paths are UTF-8 encoded (as in ResourceManager), so convert to UTF-16 for the wide API.
+  const int length = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+  if (length <= 0) {
+    return false;
+  }
+  std::wstring wide_path(static_cast<size_t>(length), L'\0');
+  MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &wide_path[0], length);
+
+  HANDLE file = CreateFileW(wide_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size)) {
+    CloseHandle(file);
+    return false;
+  }
+  m_file_handle = file;
+  m_path = path;
+  if (size.QuadPart == 0) {
+    // Empty files can't be mapped, but there's nothing to map anyway.
+    return true;
+  }
+  m_mapping_handle = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (m_mapping_handle != nullptr) {
+    m_data = static_cast<const uint8_t *>(MapViewOfFile(m_mapping_handle, FILE_MAP_READ, 0, 0, 0));
+  }
+  if (m_data == nullptr) {
+    Close();
+    return false;
+  }
+  m_size = static_cast<size_t>(size.QuadPart);
+  return true;
+}
+
+void MappedFile::Close () {
+  if (m_data != nullptr) {
+    UnmapViewOfFile(m_data);
+  }
+  if (m_mapping_handle != nullptr) {
+    CloseHandle(m_mapping_handle);
+  }
+  if (m_file_handle != INVALID_HANDLE_VALUE) {
+    CloseHandle(m_file_handle);
+  }
+  m_data = nullptr;
+  m_size = 0;
+  m_mapping_handle = nullptr;
+  m_file_handle = INVALID_HANDLE_VALUE;
+  m_path.clear();
+}
+
+#else
+
+bool MappedFile::TryOpen (const std::string &path) {
+  Close();
+  if (path.empty()) {
+    return false;
+  }
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat status;
+  if (fstat(fd, &status) != 0) {
+    close(fd);
+    return false;
+  }
+  const size_t size = static_cast<size_t>(status.st_size);
+  if (size > 0) {
+    void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      close(fd);
+      return false;
+    }
+    m_data = static_cast<const uint8_t *>(data);
+    m_size = size;
+  }
+  // The mapping keeps its own reference to the file, so the descriptor is no longer needed.
+  close(fd);
+  m_path = path;
+  return true;
+}
+
+void MappedFile::Close () {
+  if (m_data != nullptr) {
+    munmap(const_cast<uint8_t *>(m_data), m_size);
+  }
+  m_data = nullptr;
+  m_size = 0;
+  m_path.clear();
+}
+
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// A read-only memory mapping of the entire contents of a file.  Reading from the mapping avoids
+// copying the file into an intermediate buffer, and pages which are never touched are never read.
+// The mapping stays valid until Close is called or the MappedFile is destroyed.
+class MappedFile {
+public:
+
+  MappedFile ();
+  // Throws std::domain_error if the file can't be opened or mapped.
+  MappedFile (const std::string &path) : MappedFile() { Open(path); }
+  ~MappedFile () { Close(); }
+
+  bool IsOpen () const { return !m_path.empty(); }
+  const std::string &Path () const { return m_path; }
+  // The contents of the file.  This is nullptr (and Size is 0) for an empty file.
+  const uint8_t *Data () const { return m_data; }
+  size_t Size () const { return m_size; }
+
+  // Maps the given file, closing any previously mapped one.  Throws std::domain_error upon failure.
+  void Open (const std::string &path);
+  // As Open, but returns false upon failure (e.g. if the file doesn't exist) instead of throwing.
+  bool TryOpen (const std::string &path);
+  void Close ();
+
+private:
+
+  MappedFile (const MappedFile &) = delete;
+  MappedFile &operator = (const MappedFile &) = delete;
+
+  std::string m_path;
+  const uint8_t *m_data;
+  size_t m_size;
+#if _WIN32
+  void *m_file_handle;
+  void *m_mapping_handle;
+#endif
+};
@@ -8,6 +8,13 @@ template <>
 struct ResourceLoader<TextFile> {
   static const bool exists = true;
   static std::shared_ptr<TextFile> LoadResource (const std::string &name, ResourceManager<TextFile> &calling_manager) {
+    return DecodeResource(name, calling_manager);
+  }
+
+  // Reading the file doesn't need the render thread, so asynchronous loads do it on a worker,
+  // and the finishing stage has nothing left to do.
+  typedef TextFile Decoded;
+  static std::shared_ptr<TextFile> DecodeResource (const std::string &name, ResourceManager<TextFile> &calling_manager) {
     // TODO: do real filesystem path lookup, or have some sort of configuration singleton that has this path
     try {
       return std::make_shared<TextFile>(calling_manager.GetBasePath() + name);
@@ -16,4 +23,11 @@ struct ResourceLoader<TextFile> {
       throw ResourceExceptionOfType<TextFile>(e.what());
     }
   }
+  static std::shared_ptr<TextFile> FinishResource (const std::shared_ptr<TextFile> &decoded, const std::string &name, ResourceManager<TextFile> &calling_manager) {
+    return decoded;
+  }
+
+  static ResourceByteCount ByteCount (const TextFile &resource) {
+    return ResourceByteCount(resource.Contents().size(), 0);
+  }
 };
@@ -0,0 +1,66 @@
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <vector>
+
+class ThreadPoolTest : public testing::Test { };
+
+TEST_F(ThreadPoolTest, ReturnsResults) {
+  ThreadPool pool(4);
+  EXPECT_EQ(4u, pool.ThreadCount());
+
+  std::vector<std::future<int>> results;
+  for (int i = 0; i < 100; ++i) {
+    results.push_back(pool.Submit([i](){ return i*i; }));
+  }
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(i*i, results[i].get());
+  }
+}
+
+TEST_F(ThreadPoolTest, RunsTasksConcurrently) {
+  ThreadPool pool(2);
+  // Each task waits for the other to start, which can only happen if they run on different threads.
+  std::atomic<int> started(0);
+  auto task = [&started](){
+    ++started;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (started.load() < 2 && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::yield();
+    }
+    return started.load();
+  };
+  std::future<int> a(pool.Submit(task));
+  std::future<int> b(pool.Submit(task));
+  EXPECT_EQ(2, a.get());
+  EXPECT_EQ(2, b.get());
+}
+
+TEST_F(ThreadPoolTest, PropagatesExceptions) {
+  ThreadPool pool(1);
+  std::future<void> result(pool.Submit([](){ throw std::runtime_error("task failed"); }));
+  EXPECT_THROW(result.get(), std::runtime_error);
+  // The worker must survive the exception.
+  EXPECT_EQ(42, pool.Submit([](){ return 42; }).get());
+}
+
+TEST_F(ThreadPoolTest, DestructorRunsQueuedTasks) {
+  std::atomic<int> completed(0);
+  {
+    ThreadPool pool(1);
+    for (int i = 0; i < 50; ++i) {
+      pool.Submit([&completed](){
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        ++completed;
+      });
+    }
+  }
+  EXPECT_EQ(50, completed.load());
+}
+
+TEST_F(ThreadPoolTest, RejectsZeroThreads) {
+  EXPECT_THROW(ThreadPool(0), std::invalid_argument);
+}
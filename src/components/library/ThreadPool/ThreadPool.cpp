@@ -0,0 +1,74 @@
+#include "ThreadPool.h"
+
+#include <stdexcept>
+
+size_t ThreadPool::DefaultThreadCount () {
+  const unsigned int hardware_threads = std::thread::hardware_concurrency();
+  return hardware_threads > 2 ? static_cast<size_t>(hardware_threads - 1) : 1;
+}
+
+ThreadPool::ThreadPool (size_t thread_count)
+  :
+  m_stopping(false)
+{
+  if (thread_count == 0) {
+    throw std::invalid_argument("ThreadPool must have at least one thread");
+  }
+  m_threads.reserve(thread_count);
+  for (size_t i = 0; i < thread_count; ++i) {
+    m_threads.emplace_back(&ThreadPool::RunWorker, this);
+  }
+}
+
+ThreadPool::~ThreadPool () {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+  }
+  m_task_available.notify_all();
+  for (std::thread &thread : m_threads) {
+    thread.join();
+  }
+}
+
+ThreadPool &ThreadPool::Shared () {
+  // This is deliberately never destroyed, since joining threads during static destruction can
+  // deadlock (e.g. on Windows, where it happens under the loader lock).  The idle workers are
+  // simply terminated with the process.
+  static ThreadPool *s_pool = new ThreadPool();
+  return *s_pool;
+}
+
+size_t ThreadPool::QueuedTaskCount () const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_tasks.size();
+}
+
+void ThreadPool::Enqueue (std::function<void()> &&task) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_stopping) {
+      throw std::logic_error("ThreadPool: can't submit tasks while the pool is being destroyed");
+    }
+    m_tasks.emplace_back(std::move(task));
+  }
+  m_task_available.notify_one();
+}
+
+void ThreadPool::RunWorker () {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_task_available.wait(lock, [this](){ return m_stopping || !m_tasks.empty(); });
+      // Queued tasks are still run when stopping, so that no future is left without a value.
+      if (m_tasks.empty()) {
+        return;
+      }
+      task = std::move(m_tasks.front());
+      m_tasks.pop_front();
+    }
+    // Exceptions are captured by the packaged_task and delivered through its future.
+    task();
+  }
+}
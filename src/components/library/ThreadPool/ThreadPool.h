@@ -0,0 +1,62 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// A fixed set of worker threads which run submitted tasks in FIFO order.  This is for CPU work
+// which would otherwise stall the thread it's called from (e.g. tessellating or decoding assets
+// on the render thread).  Tasks must not make GL calls, since the workers have no GL context;
+// the usual pattern is to produce CPU-side data on a worker and upload it on the render thread
+// once the returned future is ready.
+//
+// Destroying the pool runs any tasks which are still queued, then joins the workers.
+class ThreadPool {
+public:
+
+  // One fewer than the number of hardware threads (leaving one for the calling thread), but at least one.
+  static size_t DefaultThreadCount ();
+
+  explicit ThreadPool (size_t thread_count = DefaultThreadCount());
+  ~ThreadPool ();
+
+  // A process-wide pool with DefaultThreadCount() workers, created upon first use.
+  static ThreadPool &Shared ();
+
+  // Queues the given callable to be run on a worker thread.  The returned future provides the
+  // callable's return value, or rethrows any exception it threw.
+  template <typename Function_>
+  std::future<typename std::result_of<Function_()>::type> Submit (Function_ &&function) {
+    typedef typename std::result_of<Function_()>::type Result;
+    // std::function must be copyable, so the (move-only) packaged_task is held by a shared_ptr.
+    auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Function_>(function));
+    std::future<Result> result(task->get_future());
+    Enqueue([task](){ (*task)(); });
+    return result;
+  }
+
+  size_t ThreadCount () const { return m_threads.size(); }
+  // The number of tasks which have been submitted but not yet started.
+  size_t QueuedTaskCount () const;
+
+private:
+
+  ThreadPool (const ThreadPool &) = delete;
+  ThreadPool &operator = (const ThreadPool &) = delete;
+
+  void Enqueue (std::function<void()> &&task);
+  void RunWorker ();
+
+  std::vector<std::thread> m_threads;
+  std::deque<std::function<void()>> m_tasks;
+  mutable std::mutex m_mutex;
+  std::condition_variable m_task_available;
+  bool m_stopping;
+};
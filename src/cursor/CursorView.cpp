@@ -67,13 +67,6 @@ CursorView::CursorView() :
   m_scrollFingerRight->Set(scrollFingerLeftFile->Contents());
   m_disabledCursor->Set(disabledCursorFile->Contents());
 
-  // Calulate the offsets to the svg primitive centers.
-  m_scrollBodyOffset = m_scrollBody->Origin() - (m_scrollBody->Size()/2.0);
-  m_scrollLineOffset = m_scrollLine->Origin() - (m_scrollLine->Size()/2.0);
-  m_scrollFingerLeftOffset = m_scrollFingerLeft->Origin() - (m_scrollFingerLeft->Size()/2.0);
-  m_scrollFingerRightOffset = m_scrollFingerRight->Origin() - (m_scrollFingerRight->Size()/2.0);
-  m_disabledCursorOffset = m_disabledCursor->Origin() - (m_disabledCursor->Size()/2.0);
-
   AutoCurrentContext()->AddTeardownListener([this](){
     RemoveFromParent();
   });
@@ -243,6 +236,14 @@ void CursorView::AnimationUpdate(const RenderFrame &frame) {
 
   m_handCursor->LocalProperties().AlphaMask() = m_diskAlpha;
 
+  // Calulate the offsets to the svg primitive centers.  The SVGs may be tessellated asynchronously,
+  // in which case their bounds are provisional until the first draw after they're ready.
+  m_scrollBodyOffset = m_scrollBody->Origin() - (m_scrollBody->Size()/2.0);
+  m_scrollLineOffset = m_scrollLine->Origin() - (m_scrollLine->Size()/2.0);
+  m_scrollFingerLeftOffset = m_scrollFingerLeft->Origin() - (m_scrollFingerLeft->Size()/2.0);
+  m_scrollFingerRightOffset = m_scrollFingerRight->Origin() - (m_scrollFingerRight->Size()/2.0);
+  m_disabledCursorOffset = m_disabledCursor->Origin() - (m_disabledCursor->Size()/2.0);
+
   // Snapped Scrolling Cursor Positioning
   m_scrollBody->Translation() = EigenTypes::Vector3(m_scrollBodyOffset.x(), m_scrollBodyOffset.y()+ m_bodyOffset, 0.0f);
   m_scrollLine->Translation() = EigenTypes::Vector3(m_scrollLineOffset.x(), m_scrollLineOffset.y(), 0.0f);
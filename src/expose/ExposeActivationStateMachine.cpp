@@ -28,7 +28,6 @@ ExposeActivationStateMachine::ExposeActivationStateMachine() :
   // Setup SVG
   Resource<TextFile> exposeIconFile("expose-icon-01.svg");
   m_exposeIcon->Set(exposeIconFile->Contents());
-  m_exposeIconOffset = m_exposeIcon->Origin() - (m_exposeIcon->Size() / 2.0f);
 
   AutoCurrentContext()->AddTeardownListener([this](){
     RemoveFromParent();
@@ -144,6 +143,10 @@ void ExposeActivationStateMachine::AnimationUpdate(const RenderFrame &renderFram
   m_pusherBar->SetSize(EigenTypes::Vector2(barWidth, PUSHER_BOTTOM_Y));
   m_goalStrip->SetSize(EigenTypes::Vector2(barWidth, GOAL_BOTTOM_Y));
 
+  // The icon may be tessellated asynchronously, in which case its bounds are provisional until
+  // the first draw after it's ready.
+  m_exposeIconOffset = m_exposeIcon->Origin() - (m_exposeIcon->Size() / 2.0f);
+
   m_pusherBar->Translation() = EigenTypes::Vector3(screenMiddle, pusherStripY, 0.0f);
   m_goalStrip->Translation() = EigenTypes::Vector3(screenMiddle, goalStripY, 0.0f);
   m_exposeIcon->Translation() = EigenTypes::Vector3(m_exposeIconOffset.x() + screenMiddle, m_exposeIconOffset.y() + pusherStripY + ICON_Y_OFFSET, 0.0f);
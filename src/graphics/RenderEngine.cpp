@@ -13,7 +13,9 @@
 #include "GLShaderLoader.h"
 
 #include "Resource.h"
+#include "ResourceFinishQueue.h"
 #include "PrimitiveBase.h"
+#include "SVGPrimitive.h"
 
 #include <vector>
 #include <memory>
@@ -30,6 +32,11 @@ RenderEngine::RenderEngine() :
 
   m_shader = Resource<GLShader>("material");
 
+  // Tessellate icons on worker threads, so that new icons don't stall the render thread.
+  SVGPrimitive::SetDefaultTessellationMode(SVGPrimitive::TessellationMode::ASYNCHRONOUS);
+  // Draw each icon from a single buffer, rather than a node per path.
+  SVGPrimitive::SetDefaultGeometryMode(SVGPrimitive::GeometryMode::MERGED);
+
   // set light position
   const EigenTypes::Vector3f lightPos(0, 10, 10);
   m_shader->Bind();
@@ -45,6 +52,10 @@ void RenderEngine::Tick(std::chrono::duration<double> deltaT) {
   // Active the window for OpenGL rendering
   m_renderWindow->SetActive(true);
 
+  // Finish resources whose asynchronous loads have been decoded (e.g. compile shaders and upload
+  // textures), within a budget, so that a burst of loads doesn't stall this frame.
+  ResourceFinishQueue::Shared().RunFor(ResourceFinishQueue::DEFAULT_FRAME_BUDGET);
+
   // Clear window
   ::glClearColor(0, 0, 0, 0);
   ::glClear(GL_COLOR_BUFFER_BIT);
@@ -29,11 +29,7 @@ VolumeSliderView::VolumeSliderView() :
   m_plusIcon->Set(plusIconFile->Contents());
   m_minusIcon->Set(minusIconFile->Contents());
 
-  // Calulate the offsets to the svg primitive centers.
-  m_sliderNotchOffset = m_sliderNotchBodyActive->Origin() - (m_sliderNotchBodyActive->Size()/2.0);
-  m_volumeIconOffset = m_volumeIcon->Origin() - (m_volumeIcon->Size()/2.0);
-  m_plusIconOffset = m_plusIcon->Origin() - (m_plusIcon->Size()/2.0);
-  m_minusIconOffset = m_minusIcon->Origin() - (m_minusIcon->Size()/2.0);
+  UpdateIconOffsets();
 
   //Setup Rectangle Bars
   m_sliderActivePart->SetSize(EigenTypes::Vector2(0.0f, m_height));
@@ -91,9 +87,19 @@ EigenTypes::Vector2 VolumeSliderView::GetNotchOffset() const {
   return EigenTypes::Vector2(notchPosition.x(), notchPosition.y());
 }
 
+void VolumeSliderView::UpdateIconOffsets() {
+  // Calulate the offsets to the svg primitive centers.  The SVGs may be tessellated asynchronously,
+  // in which case their bounds are provisional until the first draw after they're ready.
+  m_sliderNotchOffset = m_sliderNotchBodyActive->Origin() - (m_sliderNotchBodyActive->Size()/2.0);
+  m_volumeIconOffset = m_volumeIcon->Origin() - (m_volumeIcon->Size()/2.0);
+  m_plusIconOffset = m_plusIcon->Origin() - (m_plusIcon->Size()/2.0);
+  m_minusIconOffset = m_minusIcon->Origin() - (m_minusIcon->Size()/2.0);
+}
+
 void VolumeSliderView::Update(const RenderFrame& frame) {
   //Update Smoothed Values
   m_activationAmount.Update(static_cast<float>(frame.deltaT.count()));
+  UpdateIconOffsets();
 
   //Calculate bar positions
   float meterLeftEdge = -(m_width / 2.0f);
@@ -45,6 +45,9 @@ public:
   void DrawContents(RenderState &render_state) const override;
 
 private:
+  // Recomputes the icon offsets from the bounds of the SVGs, which aren't final until they're tessellated.
+  void UpdateIconOffsets();
+
   const Color INACTIVE_PART_COLOR = Color(0.4f, 0.425f, 0.45f, 0.75f);
   const Color ACTIVE_PART_COLOR = Color(0.505f, 0.831f, 0.114f, 0.95f);
   const float ICON_Y_OFFSET = 45.0f;